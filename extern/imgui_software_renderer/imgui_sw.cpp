@@ -10,14 +10,35 @@
 #include "imgui_sw.hpp"
 
 #include <algorithm>
+#include <float.h>
 #include <math.h>
+#include <string.h>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <SDL.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define IMGUI_SW_SSE2
+#include <emmintrin.h>
+#endif
+
+// the framebuffer is split into tiles of this size.
+// each tile is painted independently (and possibly on another thread).
+#define SW_TILE_SIZE 64
+// draw commands are split into batches of at most this many indices before binning.
+// must be a multiple of 6 so that quads are not split.
+#define SW_BATCH_SIZE 768
+
+struct SwTileRenderer;
+
 struct ImGui_ImplSW_Data
 {
     SDL_Window*  Window;
     SWTexture*   FontTexture;
+    SwTileRenderer* Tiles;
 
     ImGui_ImplSW_Data() { memset((void*)this, 0, sizeof(*this)); }
 };
@@ -33,11 +54,15 @@ static ImGui_ImplSW_Data* ImGui_ImplSW_GetBackendData()
     return ImGui::GetCurrentContext() ? (ImGui_ImplSW_Data*)ImGui::GetIO().BackendRendererUserData : nullptr;
 }
 
+// pixels outside of [min_x, max_x) and [min_y, max_y) are never touched.
+// this is used to restrict painting to a single tile.
 struct PaintTarget
 {
   uint32_t *pixels;
   int width;
   int height;
+  int min_x, min_y;
+  int max_x, max_y;
 };
 
 // ----------------------------------------------------------------------------
@@ -94,6 +119,56 @@ static inline uint32_t blend(const ColorInt &target, const ColorInt &source)
   );
 }
 
+// blends a uniform color over a span of pixels.
+// color.a must not be 0 or 255 (these are handled by callers).
+// the SSE2 path produces exactly the same results as blend().
+static inline void blend_span(uint32_t* pixels, int count, const ColorInt& color)
+{
+  const unsigned char ia=255-color.a;
+#ifdef IMGUI_SW_SSE2
+  if (count>=4) {
+    const __m128i zero=_mm_setzero_si128();
+    // lanes are in BGRA order. alpha is kept from the target.
+    const __m128i srcTerm=_mm_setr_epi16(
+      color.b*color.a+255,color.g*color.a+255,color.r*color.a+255,0,
+      color.b*color.a+255,color.g*color.a+255,color.r*color.a+255,0
+    );
+    const __m128i invAlpha=_mm_setr_epi16(ia,ia,ia,0,ia,ia,ia,0);
+    const __m128i alphaMask=_mm_set1_epi32(0xff000000);
+    for (; count>=4; count-=4, pixels+=4) {
+      __m128i t=_mm_loadu_si128((const __m128i*)pixels);
+      __m128i lo=_mm_unpacklo_epi8(t,zero);
+      __m128i hi=_mm_unpackhi_epi8(t,zero);
+      lo=_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo,invAlpha),srcTerm),8);
+      hi=_mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi,invAlpha),srcTerm),8);
+      __m128i out=_mm_packus_epi16(lo,hi);
+      out=_mm_or_si128(_mm_andnot_si128(alphaMask,out),_mm_and_si128(alphaMask,t));
+      _mm_storeu_si128((__m128i*)pixels,out);
+    }
+  }
+#endif
+  // We often blend the same colors over and over again, so optimize for this:
+  uint32_t last_target_pixel=0;
+  uint32_t last_output=0;
+  bool has_last=false;
+  for (; count>0; count--, pixels++) {
+    if (has_last && *pixels==last_target_pixel) {
+      *pixels=last_output;
+      continue;
+    }
+    last_target_pixel=*pixels;
+    const ColorInt* colorRef=(const ColorInt*)pixels;
+    *pixels=(
+      (colorRef->a << 24u) |
+      (((color.r * color.a + colorRef->r * ia + 255) >> 8) << 16u) |
+      (((color.g * color.a + colorRef->g * ia + 255) >> 8) << 8u) |
+      (((color.b * color.a + colorRef->b * ia + 255) >> 8) << 0u)
+    );
+    last_output=*pixels;
+    has_last=true;
+  }
+}
+
 // ----------------------------------------------------------------------------
 // Used for interpolating vertex attributes (color and texture coordinates) in a triangle.
 
@@ -225,39 +300,21 @@ static void paint_uniform_rectangle(const PaintTarget &target,
   int max_y_i = (int)(max_f.y + 0.5f);
 
   // Clamp to render target:
-  min_x_i = std::max(min_x_i, 0);
-  min_y_i = std::max(min_y_i, 0);
-  max_x_i = std::min(max_x_i, target.width);
-  max_y_i = std::min(max_y_i, target.height);
+  min_x_i = std::max(min_x_i, target.min_x);
+  min_y_i = std::max(min_y_i, target.min_y);
+  max_x_i = std::min(max_x_i, target.max_x);
+  max_y_i = std::min(max_y_i, target.max_y);
+
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
 
   if (color.a==255) {
     // fast path if alpha blending is not necessary
     for (int y = min_y_i; y < max_y_i; ++y) {
-      uint32_t* target_pixel = &target.pixels[y * target.width + min_x_i - 1];
-      for (int x = min_x_i; x < max_x_i; ++x) {
-        ++target_pixel;
-        *target_pixel = color.u32;
-      }
+      std::fill_n(&target.pixels[y * target.width + min_x_i], max_x_i - min_x_i, color.u32);
     }
   } else {
-    // We often blend the same colors over and over again, so optimize for this (saves 25% total cpu):
-    uint32_t last_target_pixel = target.pixels[min_y_i * target.width + min_x_i];
-    const ColorInt* lastColorRef = (const ColorInt*)(&last_target_pixel);
-    uint32_t last_output = blend(*lastColorRef, color);
-
     for (int y = min_y_i; y < max_y_i; ++y) {
-      uint32_t* target_pixel = &target.pixels[y * target.width + min_x_i - 1];
-      for (int x = min_x_i; x < max_x_i; ++x) {
-        ++target_pixel;
-        if (*target_pixel == last_target_pixel) {
-          *target_pixel = last_output;
-          continue;
-        }
-        last_target_pixel = *target_pixel;
-        const ColorInt* colorRef = (const ColorInt*)(target_pixel);
-        *target_pixel = blend(*colorRef, color);
-        last_output = *target_pixel;
-      }
+      blend_span(&target.pixels[y * target.width + min_x_i], max_x_i - min_x_i, color);
     }
   }
 }
@@ -293,7 +350,8 @@ static void paint_uniform_textured_rectangle(const PaintTarget &target,
   int max_x_i = (int)(max_x_f + 1.0f);
   int max_y_i = (int)(max_y_f + 1.0f);
 
-  // Clip against render target:
+  // Clip against the whole render target first, so that texel stepping
+  // does not depend on which tile is being painted:
   min_x_i = std::max(min_x_i, 0);
   min_y_i = std::max(min_y_i, 0);
   max_x_i = std::min(max_x_i, target.width);
@@ -317,13 +375,28 @@ static void paint_uniform_textured_rectangle(const PaintTarget &target,
   if (startY<0) startY=0;
   if (startY>texture.height-1) startY=texture.height-1;
 
-  int currentX = startX;
-  int currentY = startY * texture.width;
-
   float deltaX = delta_uv_per_pixel.x * texture.width;
   float deltaY = delta_uv_per_pixel.y * texture.height;
 
+  // Now clip against the tile, skipping texels as if we stepped through them:
+  if (target.min_x > min_x_i) {
+    if (deltaX != 0) startX = std::min(startX + (target.min_x - min_x_i), texture.width - 1);
+    min_x_i = target.min_x;
+  }
+  if (target.min_y > min_y_i) {
+    if (deltaY != 0) startY = std::min(startY + (target.min_y - min_y_i), texture.height - 1);
+    min_y_i = target.min_y;
+  }
+  max_x_i = std::min(max_x_i, target.max_x);
+  max_y_i = std::min(max_y_i, target.max_y);
+
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
+
+  int currentX = startX;
+  int currentY = startY * texture.width;
+
   const ColorInt colorRef = ColorInt::bgra(min_v.col);
+  const bool opaque = (colorRef.a == 255);
 
   for (int y = min_y_i; y < max_y_i; ++y) {
     currentX = startX;
@@ -339,7 +412,7 @@ static void paint_uniform_textured_rectangle(const PaintTarget &target,
         // The font texture is all black or all white, so optimize for this:
         // anti-aliasing will be lost, but it doesn't matter
         if (texel & 0x80) {
-          *target_pixel = blend(*targetColorRef, colorRef);
+          *target_pixel = opaque ? colorRef.u32 : blend(*targetColorRef, colorRef);
         }
         continue;
 
@@ -402,10 +475,12 @@ static void paint_triangle(const PaintTarget &target,
   int max_y_i = (int)(max_y_f + 1.0f);
 
   // Clip against render target:
-  min_x_i = std::max(min_x_i, 0);
-  min_y_i = std::max(min_y_i, 0);
-  max_x_i = std::min(max_x_i, target.width);
-  max_y_i = std::min(max_y_i, target.height);
+  min_x_i = std::max(min_x_i, target.min_x);
+  min_y_i = std::max(min_y_i, target.min_y);
+  max_x_i = std::min(max_x_i, target.max_x);
+  max_y_i = std::min(max_y_i, target.max_y);
+
+  if (min_x_i >= max_x_i || min_y_i >= max_y_i) return;
 
   // ------------------------------------------------------------------------
   // Set up interpolation of barycentric coordinates:
@@ -542,6 +617,7 @@ static void paint_triangle(const PaintTarget &target,
 static void paint_draw_cmd(const PaintTarget &target,
   const ImDrawVert *vertices,
   const ImDrawIdx *idx_buffer,
+  unsigned int elem_count,
   const ImDrawCmd &pcmd,
   const SwOptions &options,
   const ImVec2& white_uv)
@@ -549,14 +625,14 @@ static void paint_draw_cmd(const PaintTarget &target,
   const SWTexture* texture = (const SWTexture*)(pcmd.TextureId);
   IM_ASSERT(texture);
 
-  for (unsigned int i = 0; i + 3 <= pcmd.ElemCount;) {
+  for (unsigned int i = 0; i + 3 <= elem_count;) {
     ImDrawVert v0 = vertices[idx_buffer[i + 0]];
     ImDrawVert v1 = vertices[idx_buffer[i + 1]];
     ImDrawVert v2 = vertices[idx_buffer[i + 2]];
 
     // Text is common, and is made of textured rectangles. So let's optimize for it.
     // This assumes the ImGui way to layout text does not change.
-    if (options.optimize_text && i + 6 <= pcmd.ElemCount && idx_buffer[i + 3] == idx_buffer[i + 0]
+    if (options.optimize_text && i + 6 <= elem_count && idx_buffer[i + 3] == idx_buffer[i + 0]
         && idx_buffer[i + 4] == idx_buffer[i + 2]) {
       ImDrawVert v3 = vertices[idx_buffer[i + 5]];
 
@@ -576,7 +652,7 @@ static void paint_draw_cmd(const PaintTarget &target,
 
     // A lot of the big stuff are uniformly colored rectangles,
     // so we can save a lot of CPU by detecting them:
-    if (options.optimize_rectangles && i + 6 <= pcmd.ElemCount) {
+    if (options.optimize_rectangles && i + 6 <= elem_count) {
       ImDrawVert v3 = vertices[idx_buffer[i + 3]];
       ImDrawVert v4 = vertices[idx_buffer[i + 4]];
       ImDrawVert v5 = vertices[idx_buffer[i + 5]];
@@ -624,31 +700,299 @@ static void paint_draw_cmd(const PaintTarget &target,
   }
 }
 
-static void paint_draw_list(const PaintTarget &target, const ImDrawList *cmd_list, const SwOptions &options)
+// ----------------------------------------------------------------------------
+// Tiled rendering:
+// draw commands are split into batches, and each batch is binned into the
+// tiles its bounding box touches. tiles are then painted in parallel, each
+// one only running the batches in its bin (in submission order).
+// a hash of every tile's contents is kept, so that tiles which look exactly
+// like in the previous frame are not repainted.
+
+struct SwBatch
 {
-  const ImDrawIdx *idx_buffer = &cmd_list->IdxBuffer[0];
-  const ImDrawVert *vertices = cmd_list->VtxBuffer.Data;
-  const ImVec2 white_uv = cmd_list->_Data->TexUvWhitePixel;
+  const ImDrawVert* vertices;
+  const ImDrawIdx* idx_buffer;
+  unsigned int elem_count;
+  const ImDrawCmd* pcmd;
+  ImVec2 white_uv;
+  uint64_t hash;
+};
 
-  for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.size(); cmd_i++) {
-    const ImDrawCmd &pcmd = cmd_list->CmdBuffer[cmd_i];
-    if (pcmd.UserCallback) {
-      pcmd.UserCallback(cmd_list, &pcmd);
-    } else {
-      paint_draw_cmd(target, vertices, idx_buffer, pcmd, options, white_uv);
+static inline uint64_t hash_mix(uint64_t h, uint64_t v)
+{
+  // FNV-1a on 64-bit words
+  h ^= v;
+  h *= 0x100000001b3ULL;
+  return h;
+}
+
+static inline uint64_t hash_float(uint64_t h, float v)
+{
+  uint32_t u;
+  memcpy(&u, &v, sizeof(u));
+  return hash_mix(h, u);
+}
+
+struct SwTileRenderer
+{
+  std::vector<SwBatch> batches;
+  std::vector<std::vector<unsigned int>> bins;
+  std::vector<uint64_t> tileHash;
+  std::vector<int> dirtyTiles;
+
+  PaintTarget target;
+  SwOptions options;
+  uint32_t clearColor;
+  bool clearSet, clearTiles, forceRedraw;
+  int tilesX, tilesY;
+  void* lastPixels;
+
+  // worker threads
+  std::vector<std::thread*> workers;
+  std::mutex lock;
+  std::condition_variable notify;
+  std::condition_variable notifyDone;
+  unsigned int frame;
+  bool quit;
+  std::atomic<int> nextTile;
+  std::atomic<int> busyWorkers;
+
+  void paintTile(int tile);
+  void paintDirtyTiles();
+  void paintBins(bool all, bool clear);
+  void workerLoop();
+  void setThreads(int count);
+  void render(uint32_t* pixels, ImDrawData* drawData, int fb_width, int fb_height);
+
+  SwTileRenderer():
+    target({NULL, 0, 0, 0, 0, 0, 0}),
+    clearColor(0),
+    clearSet(false),
+    clearTiles(false),
+    forceRedraw(false),
+    tilesX(0),
+    tilesY(0),
+    lastPixels(NULL),
+    frame(0),
+    quit(false),
+    nextTile(0),
+    busyWorkers(0) {}
+  ~SwTileRenderer() {
+    setThreads(1);
+  }
+};
+
+void SwTileRenderer::paintTile(int tile)
+{
+  PaintTarget tileTarget = target;
+  tileTarget.min_x = (tile % tilesX) * SW_TILE_SIZE;
+  tileTarget.min_y = (tile / tilesX) * SW_TILE_SIZE;
+  tileTarget.max_x = std::min(tileTarget.min_x + SW_TILE_SIZE, target.width);
+  tileTarget.max_y = std::min(tileTarget.min_y + SW_TILE_SIZE, target.height);
+
+  if (clearTiles) {
+    for (int y = tileTarget.min_y; y < tileTarget.max_y; y++) {
+      std::fill_n(&target.pixels[y * target.width + tileTarget.min_x], tileTarget.max_x - tileTarget.min_x, clearColor);
     }
-    idx_buffer += pcmd.ElemCount;
   }
+
+  for (unsigned int i: bins[tile]) {
+    const SwBatch& b = batches[i];
+    paint_draw_cmd(tileTarget, b.vertices, b.idx_buffer, b.elem_count, *b.pcmd, options, b.white_uv);
   }
+}
 
-static void paint_imgui(uint32_t *pixels, ImDrawData *drawData, int fb_width, int fb_height, const SwOptions &options = {})
+void SwTileRenderer::paintDirtyTiles()
+{
+  int i;
+  while ((i = nextTile++) < (int)dirtyTiles.size()) {
+    paintTile(dirtyTiles[i]);
+  }
+}
+
+void SwTileRenderer::workerLoop()
+{
+  unsigned int seenFrame = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> l(lock);
+      notify.wait(l, [&] { return quit || frame != seenFrame; });
+      if (quit) return;
+      seenFrame = frame;
+    }
+    paintDirtyTiles();
+    if (--busyWorkers == 0) {
+      std::unique_lock<std::mutex> l(lock);
+      notifyDone.notify_one();
+    }
+  }
+}
+
+void SwTileRenderer::setThreads(int count)
+{
+  // the calling thread paints as well, so one less worker is needed
+  if (count < 1) count = 1;
+  if ((int)workers.size() == count - 1) return;
+
+  if (!workers.empty()) {
+    {
+      std::unique_lock<std::mutex> l(lock);
+      quit = true;
+      notify.notify_all();
+    }
+    for (std::thread* i: workers) {
+      i->join();
+      delete i;
+    }
+    workers.clear();
+    quit = false;
+  }
+
+  for (int i = 1; i < count; i++) {
+    workers.push_back(new std::thread(&SwTileRenderer::workerLoop, this));
+  }
+}
+
+void SwTileRenderer::paintBins(bool all, bool clear)
+{
+  // find out which tiles changed
+  dirtyTiles.clear();
+  for (int i = 0; i < tilesX * tilesY; i++) {
+    // nothing to paint on top of a previous pass
+    if (!clear && bins[i].empty()) continue;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_mix(hash, clearSet ? clearColor : 0x100000000ULL);
+    for (unsigned int j: bins[i]) {
+      hash = hash_mix(hash, batches[j].hash);
+    }
+    if (all || hash != tileHash[i]) {
+      tileHash[i] = hash;
+      dirtyTiles.push_back(i);
+    }
+  }
+  if (dirtyTiles.empty()) return;
+  clearTiles = clear && clearSet;
+
+  // paint
+  nextTile = 0;
+  if (workers.empty() || dirtyTiles.size() < 2) {
+    paintDirtyTiles();
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> l(lock);
+    busyWorkers = workers.size();
+    frame++;
+    notify.notify_all();
+  }
+  paintDirtyTiles();
+  {
+    std::unique_lock<std::mutex> l(lock);
+    notifyDone.wait(l, [&] { return busyWorkers == 0; });
+  }
+}
+
+void SwTileRenderer::render(uint32_t* pixels, ImDrawData* drawData, int fb_width, int fb_height)
 {
   if (fb_width <= 0 || fb_height <= 0) return;
 
-  PaintTarget target{ pixels, fb_width, fb_height };
+  // the whole framebuffer is invalid if it has been reallocated or resized
+  const bool fullRedraw = (forceRedraw || pixels != lastPixels || fb_width != target.width || fb_height != target.height);
+  forceRedraw = false;
+  lastPixels = pixels;
+  target = PaintTarget{ pixels, fb_width, fb_height, 0, 0, fb_width, fb_height };
+
+  tilesX = (fb_width + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+  tilesY = (fb_height + SW_TILE_SIZE - 1) / SW_TILE_SIZE;
+  const int tileCount = tilesX * tilesY;
+  if ((int)bins.size() != tileCount) {
+    bins.resize(tileCount);
+    tileHash.resize(tileCount);
+  }
+  for (std::vector<unsigned int>& i: bins) i.clear();
+  batches.clear();
+
+  // user callbacks split the frame into passes, so that they run at their point in the draw order
+  bool split = false;
+
+  // split draw commands into batches and bin them
+  for (int l = 0; l < drawData->CmdListsCount; ++l) {
+    const ImDrawList* cmd_list = drawData->CmdLists[l];
+    const ImDrawIdx *idx_buffer = &cmd_list->IdxBuffer[0];
+    const ImDrawVert *vertices = cmd_list->VtxBuffer.Data;
+    const ImVec2 white_uv = cmd_list->_Data->TexUvWhitePixel;
+
+    for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.size(); cmd_i++) {
+      const ImDrawCmd &pcmd = cmd_list->CmdBuffer[cmd_i];
+      if (pcmd.UserCallback) {
+        // paint everything before the callback
+        paintBins(true, !split);
+        split = true;
+        for (std::vector<unsigned int>& i: bins) i.clear();
+        batches.clear();
+
+        pcmd.UserCallback(cmd_list, &pcmd);
+        idx_buffer += pcmd.ElemCount;
+        continue;
+      }
+      const SWTexture* texture = (const SWTexture*)(pcmd.TextureId);
+
+      for (unsigned int start = 0; start < pcmd.ElemCount; start += SW_BATCH_SIZE) {
+        const unsigned int count = std::min((unsigned int)SW_BATCH_SIZE, pcmd.ElemCount - start);
+        const ImDrawIdx* idx = idx_buffer + start;
+
+        // bounding box and hash of this batch
+        float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        hash = hash_mix(hash, (uint64_t)(uintptr_t)texture);
+        hash = hash_mix(hash, texture ? texture->generation : 0);
+        hash = hash_float(hash, pcmd.ClipRect.x);
+        hash = hash_float(hash, pcmd.ClipRect.y);
+        hash = hash_float(hash, pcmd.ClipRect.z);
+        hash = hash_float(hash, pcmd.ClipRect.w);
+        for (unsigned int i = 0; i < count; i++) {
+          const ImDrawVert& v = vertices[idx[i]];
+          if (v.pos.x < min_x) min_x = v.pos.x;
+          if (v.pos.y < min_y) min_y = v.pos.y;
+          if (v.pos.x > max_x) max_x = v.pos.x;
+          if (v.pos.y > max_y) max_y = v.pos.y;
+          hash = hash_float(hash, v.pos.x);
+          hash = hash_float(hash, v.pos.y);
+          hash = hash_float(hash, v.uv.x);
+          hash = hash_float(hash, v.uv.y);
+          hash = hash_mix(hash, v.col);
+        }
+
+        // conservative pixel bounds (the painters round in different ways)
+        int x0 = (int)floorf(std::max(min_x, pcmd.ClipRect.x)) - 1;
+        int y0 = (int)floorf(std::max(min_y, pcmd.ClipRect.y)) - 1;
+        int x1 = (int)ceilf(std::min(max_x, pcmd.ClipRect.z)) + 1;
+        int y1 = (int)ceilf(std::min(max_y, pcmd.ClipRect.w)) + 1;
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, fb_width);
+        y1 = std::min(y1, fb_height);
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        const unsigned int batchIndex = batches.size();
+        batches.push_back(SwBatch{ vertices, idx, count, &pcmd, white_uv, hash });
+
+        for (int ty = y0 / SW_TILE_SIZE; ty <= (y1 - 1) / SW_TILE_SIZE; ty++) {
+          for (int tx = x0 / SW_TILE_SIZE; tx <= (x1 - 1) / SW_TILE_SIZE; tx++) {
+            bins[ty * tilesX + tx].push_back(batchIndex);
+          }
+        }
+      }
+      idx_buffer += pcmd.ElemCount;
+    }
+  }
 
-  for (int i = 0; i < drawData->CmdListsCount; ++i) {
-    paint_draw_list(target, drawData->CmdLists[i], options);
+  if (split) {
+    paintBins(true, false);
+    // tile hashes don't describe a frame painted in several passes
+    forceRedraw = true;
+  } else {
+    paintBins(fullRedraw, true);
   }
 }
 
@@ -664,6 +1008,7 @@ bool ImGui_ImplSW_Init(SDL_Window* win) {
 
   ImGui_ImplSW_Data* bd = IM_NEW(ImGui_ImplSW_Data)();
   bd->Window = win;
+  bd->Tiles = new SwTileRenderer;
   io.BackendRendererUserData = (void*)bd;
   io.BackendRendererName = "imgui_sw";
 
@@ -676,6 +1021,7 @@ void ImGui_ImplSW_Shutdown() {
   ImGuiIO& io = ImGui::GetIO();
 
   ImGui_ImplSW_DestroyDeviceObjects();
+  delete bd->Tiles;
   io.BackendRendererName = nullptr;
   io.BackendRendererUserData = nullptr;
   IM_DELETE(bd);
@@ -701,13 +1047,45 @@ void ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data) {
   if (mustLock) {
     if (SDL_LockSurface(surf)!=0) return;
   }
-  paint_imgui((uint32_t*)surf->pixels,draw_data,surf->w,surf->h);
+  bd->Tiles->render((uint32_t*)surf->pixels,draw_data,surf->w,surf->h);
   // 0xAARRGGBB
   if (mustLock) {
     SDL_UnlockSurface(surf);
   }
 }
 
+void ImGui_ImplSW_SetThreads(int threads) {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  if (threads<=0) {
+    threads=std::thread::hardware_concurrency();
+    if (threads>16) threads=16;
+  }
+  bd->Tiles->setThreads(threads);
+}
+
+void ImGui_ImplSW_SetClearColor(uint32_t color) {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  bd->Tiles->clearColor = color;
+  bd->Tiles->clearSet = true;
+}
+
+void ImGui_ImplSW_InvalidateFrame() {
+  ImGui_ImplSW_Data* bd = ImGui_ImplSW_GetBackendData();
+  IM_ASSERT(bd != nullptr);
+
+  bd->Tiles->forceRedraw = true;
+}
+
+uint64_t ImGui_ImplSW_NextGeneration() {
+  // shared by all textures, so that a texture re-created at the same address never matches an old one
+  static std::atomic<uint64_t> generation(0);
+  return ++generation;
+}
+
 /// CREATE OBJECTS
 
 bool ImGui_ImplSW_CreateFontsTexture() {
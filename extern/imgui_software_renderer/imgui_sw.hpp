@@ -6,6 +6,8 @@
 // WHAT:
 //   This is a software renderer for Dear ImGui.
 //   It is decently fast, but has a lot of room for optimization.
+//   The framebuffer is split into tiles which are painted in parallel, and
+//   tiles which did not change since the last frame are not repainted.
 //   The goal was to get something fast and decently accurate in not too many lines of code.
 // LIMITATIONS:
 //   * It is not pixel-perfect, but it is good enough for must use cases.
@@ -19,22 +21,33 @@
 struct SDL_Window;
 struct ImDrawData;
 
+// returns a new, process-wide unique texture generation
+IMGUI_IMPL_API uint64_t ImGui_ImplSW_NextGeneration();
+
 struct SWTexture
 {
   uint32_t* pixels;
   int width;
   int height;
+  // must be renewed with touch() whenever pixels change, so that dirty tiles are detected
+  uint64_t generation;
   bool managed, isAlpha;
 
+  void touch() {
+    generation=ImGui_ImplSW_NextGeneration();
+  }
+
   SWTexture(uint32_t* pix, int w, int h, bool a=false):
     pixels(pix),
     width(w),
     height(h),
+    generation(ImGui_ImplSW_NextGeneration()),
     managed(false),
     isAlpha(a) {}
   SWTexture(int w, int h, bool a=false):
     width(w),
     height(h),
+    generation(ImGui_ImplSW_NextGeneration()),
     managed(true),
     isAlpha(a) {
     pixels=new uint32_t[width*height];
@@ -49,6 +62,15 @@ IMGUI_IMPL_API void     ImGui_ImplSW_Shutdown();
 IMGUI_IMPL_API bool     ImGui_ImplSW_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplSW_RenderDrawData(ImDrawData* draw_data);
 
+// Tiled rendering options
+// threads: number of threads used for painting tiles (0 = auto, 1 = no threading)
+IMGUI_IMPL_API void     ImGui_ImplSW_SetThreads(int threads);
+// the framebuffer is cleared to this color (0xAARRGGBB) while painting each tile.
+// unchanged tiles are not repainted, so do not clear the framebuffer yourself.
+IMGUI_IMPL_API void     ImGui_ImplSW_SetClearColor(uint32_t color);
+// forces every tile to be repainted in the next frame
+IMGUI_IMPL_API void     ImGui_ImplSW_InvalidateFrame();
+
 // Called by Init/NewFrame/Shutdown
 IMGUI_IMPL_API bool     ImGui_ImplSW_CreateFontsTexture();
 IMGUI_IMPL_API void     ImGui_ImplSW_DestroyFontsTexture();
@@ -0,0 +1,152 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "allocTrack.h"
+
+#ifdef HAVE_ALLOC_TRACKING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+static thread_local const char* allocTrackWhere=NULL;
+
+void allocTrackBegin(const char* where) {
+  allocTrackWhere=where;
+}
+
+void allocTrackEnd() {
+  allocTrackWhere=NULL;
+}
+
+const char* allocTrackRegion() {
+  return allocTrackWhere;
+}
+
+static void allocTrackCheck(const char* what, size_t size) {
+  if (allocTrackWhere==NULL) return;
+  const char* where=allocTrackWhere;
+  // printing may allocate
+  allocTrackWhere=NULL;
+  // not logE(), since the log would not be written out before abort()
+  fprintf(stderr,"%s of %d bytes in %s! aborting.\n",what,(int)size,where);
+  abort();
+}
+
+static void allocTrackCheckFree(void* ptr) {
+  if (ptr==NULL || allocTrackWhere==NULL) return;
+  const char* where=allocTrackWhere;
+  allocTrackWhere=NULL;
+  fprintf(stderr,"free in %s! aborting.\n",where);
+  abort();
+}
+
+// on glibc the C allocator is replaced as well, so that malloc()/free() calls
+// (from C code, or from libraries) are caught too.
+// the glibc allocator remains available through the __libc_ functions.
+#ifdef __GLIBC__
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t count, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void __libc_free(void* ptr);
+
+  void* malloc(size_t size) {
+    allocTrackCheck("malloc()",size);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(size_t count, size_t size) {
+    allocTrackCheck("calloc()",count*size);
+    return __libc_calloc(count,size);
+  }
+
+  void* realloc(void* ptr, size_t size) {
+    allocTrackCheck("realloc()",size);
+    return __libc_realloc(ptr,size);
+  }
+
+  void free(void* ptr) {
+    allocTrackCheckFree(ptr);
+    __libc_free(ptr);
+  }
+}
+
+#define ALLOC_TRACK_MALLOC __libc_malloc
+#define ALLOC_TRACK_FREE __libc_free
+#else
+#define ALLOC_TRACK_MALLOC malloc
+#define ALLOC_TRACK_FREE free
+#endif
+
+static void* allocTrackAlloc(size_t size) {
+  allocTrackCheck("allocation",size);
+  void* ret=ALLOC_TRACK_MALLOC(size?size:1);
+  if (ret==NULL) throw std::bad_alloc();
+  return ret;
+}
+
+static void allocTrackDelete(void* ptr) {
+  allocTrackCheckFree(ptr);
+  ALLOC_TRACK_FREE(ptr);
+}
+
+void* operator new(size_t size) {
+  return allocTrackAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return allocTrackAlloc(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  allocTrackCheck("allocation",size);
+  return ALLOC_TRACK_MALLOC(size?size:1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  allocTrackCheck("allocation",size);
+  return ALLOC_TRACK_MALLOC(size?size:1);
+}
+
+void operator delete(void* ptr) noexcept {
+  allocTrackDelete(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  allocTrackDelete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  allocTrackDelete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  allocTrackDelete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  allocTrackDelete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  allocTrackDelete(ptr);
+}
+
+#endif
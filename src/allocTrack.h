@@ -0,0 +1,65 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _ALLOC_TRACK_H
+#define _ALLOC_TRACK_H
+
+// allocation tracking (debug builds with WITH_ALLOC_TRACKING).
+// while a thread is inside a tracked region, any call to operator new/delete (and on glibc,
+// to malloc()/calloc()/realloc()/free()) aborts with a message naming the region.
+// this is used to certify that the audio render path (DivEngine::nextBuf()) does not allocate.
+
+#ifdef HAVE_ALLOC_TRACKING
+
+#include <stddef.h>
+
+// begin a tracked region on this thread.
+void allocTrackBegin(const char* where);
+// end the tracked region on this thread.
+void allocTrackEnd();
+// returns the name of the tracked region this thread is in, or NULL.
+const char* allocTrackRegion();
+
+// suspends tracking on this thread while in scope (for code that is allowed to allocate).
+struct AllocTrackSuspend {
+  const char* prev;
+  AllocTrackSuspend():
+    prev(allocTrackRegion()) {
+    allocTrackEnd();
+  }
+  ~AllocTrackSuspend() {
+    if (prev!=NULL) allocTrackBegin(prev);
+  }
+};
+
+#define ALLOC_TRACK_BEGIN(x) allocTrackBegin(x)
+#define ALLOC_TRACK_END allocTrackEnd()
+#define ALLOC_TRACK_SUSPEND AllocTrackSuspend _allocTrackSuspend
+#define ALLOC_TRACK_REGION allocTrackRegion()
+
+#else
+
+#define ALLOC_TRACK_BEGIN(x)
+#define ALLOC_TRACK_END
+#define ALLOC_TRACK_SUSPEND
+#define ALLOC_TRACK_REGION NULL
+
+#endif
+
+#endif
@@ -33,6 +33,10 @@ void TAAudio::setCallback(void (*callback)(void*,float**,float**,int,int,unsigne
   audioProcCallbackUser=user;
 }
 
+unsigned int TAAudio::getXRunCount() {
+  return xrunCount;
+}
+
 void* TAAudio::getContext() {
   return NULL;
 }
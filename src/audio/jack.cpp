@@ -33,6 +33,12 @@ int taJACKonBufferSize(jack_nframes_t bufsize, void* inst) {
   return 0;
 }
 
+int taJACKonXRun(void* inst) {
+  TAAudioJACK* in=(TAAudioJACK*)inst;
+  in->onXRun();
+  return 0;
+}
+
 int taJACKProcess(jack_nframes_t nframes, void* inst) {
   TAAudioJACK* in=(TAAudioJACK*)inst;
   in->onProcess(nframes);
@@ -51,6 +57,10 @@ void TAAudioJACK::onBufferSize(jack_nframes_t bufsize) {
   }
 }
 
+void TAAudioJACK::onXRun() {
+  xrunCount++;
+}
+
 void TAAudioJACK::onProcess(jack_nframes_t nframes) {
   for (int i=0; i<desc.inChans; i++) {
     iInBufs[i]=(float*)jack_port_get_buffer(ai[i],nframes);
@@ -225,6 +235,7 @@ bool TAAudioJACK::init(TAAudioDesc& request, TAAudioDesc& response) {
   jack_set_sample_rate_callback(ac,taJACKonSampleRate,this);
   jack_set_buffer_size_callback(ac,taJACKonBufferSize,this);
   jack_set_process_callback(ac,taJACKProcess,this);
+  jack_set_xrun_callback(ac,taJACKonXRun,this);
 
   jack_nframes_t count=jack_get_buffer_size(ac);
   desc.bufsize=count;
@@ -34,6 +34,7 @@ class TAAudioJACK: public TAAudio {
     void onSampleRate(jack_nframes_t rate);
     void onBufferSize(jack_nframes_t bufsize);
     void onProcess(jack_nframes_t nframes);
+    void onXRun();
 
     void* getContext();
     bool quit();
@@ -31,6 +31,9 @@ int taPAProcess(const void* in, void* out, unsigned long nframes, const PaStream
 }
 
 int TAAudioPA::onProcess(const void* in, void* out, unsigned long nframes, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags flags) {
+  if (flags&(paOutputUnderflow|paOutputOverflow|paInputUnderflow|paInputOverflow)) {
+    xrunCount++;
+  }
   for (int i=0; i<desc.inChans; i++) {
     if (nframes>desc.bufsize) {
       delete[] inBufs[i];
@@ -21,6 +21,7 @@
 #define _TAAUDIO_H
 #include "../ta-utils.h"
 #include <memory>
+#include <atomic>
 #include "../fixedQueue.h"
 #include "../pch.h"
 
@@ -164,6 +165,8 @@ class TAAudio {
     void* audioProcCallbackUser;
     void (*sampleRateChanged)(SampleRateChangeEvent);
     void (*bufferSizeChanged)(BufferSizeChangeEvent);
+    // incremented by backends which are able to report underruns/overruns
+    std::atomic<unsigned int> xrunCount;
   public:
     TAMidiIn* midiIn;
     TAMidiOut* midiOut;
@@ -172,6 +175,9 @@ class TAAudio {
 
     void setCallback(void (*callback)(void*,float**,float**,int,int,unsigned int), void* user);
 
+    // get the number of underruns/overruns since the device was opened (0 if not supported)
+    unsigned int getXRunCount();
+
     virtual void* getContext();
     virtual bool quit();
     virtual bool setRun(bool run);
@@ -190,6 +196,7 @@ class TAAudio {
       audioProcCallbackUser(NULL),
       sampleRateChanged(NULL),
       bufferSizeChanged(NULL),
+      xrunCount(0),
       midiIn(NULL),
       midiOut(NULL) {}
 
@@ -0,0 +1,376 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "backupStore.h"
+#include "safeReader.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <zlib.h>
+#include <fmt/printf.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include "../utfutils.h"
+#else
+#include <dirent.h>
+#endif
+
+#define CHUNKS_DIR "chunks"
+
+// MurmurHash3 (x64, 128-bit variant)
+static inline uint64_t rotl64(uint64_t x, int r) {
+  return (x<<r)|(x>>(64-r));
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+  k^=k>>33;
+  k*=0xff51afd7ed558ccdULL;
+  k^=k>>33;
+  k*=0xc4ceb9fe1a85ec53ULL;
+  k^=k>>33;
+  return k;
+}
+
+static void hashChunk(const unsigned char* data, size_t len, unsigned char* out) {
+  const uint64_t c1=0x87c37b91114253d5ULL;
+  const uint64_t c2=0x4cf5ad432745937fULL;
+  uint64_t h1=0;
+  uint64_t h2=0;
+  size_t blocks=len/16;
+
+  for (size_t i=0; i<blocks; i++) {
+    uint64_t k1, k2;
+    memcpy(&k1,data+i*16,8);
+    memcpy(&k2,data+i*16+8,8);
+
+    k1*=c1; k1=rotl64(k1,31); k1*=c2; h1^=k1;
+    h1=rotl64(h1,27); h1+=h2; h1=h1*5+0x52dce729;
+    k2*=c2; k2=rotl64(k2,33); k2*=c1; h2^=k2;
+    h2=rotl64(h2,31); h2+=h1; h2=h2*5+0x38495ab5;
+  }
+
+  const unsigned char* tail=data+blocks*16;
+  uint64_t k1=0;
+  uint64_t k2=0;
+  size_t tailLen=len&15;
+  for (size_t i=tailLen; i>8; i--) {
+    k2^=((uint64_t)tail[i-1])<<((i-9)*8);
+  }
+  if (tailLen>8) {
+    k2*=c2; k2=rotl64(k2,33); k2*=c1; h2^=k2;
+  }
+  for (size_t i=MIN(tailLen,(size_t)8); i>0; i--) {
+    k1^=((uint64_t)tail[i-1])<<((i-1)*8);
+  }
+  if (tailLen>0) {
+    k1*=c1; k1=rotl64(k1,31); k1*=c2; h1^=k1;
+  }
+
+  h1^=len; h2^=len;
+  h1+=h2; h2+=h1;
+  h1=fmix64(h1);
+  h2=fmix64(h2);
+  h1+=h2; h2+=h1;
+
+  for (int i=0; i<8; i++) {
+    out[i]=h1>>(i*8);
+    out[8+i]=h2>>(i*8);
+  }
+}
+
+static void listFiles(const String& dir, const char* ext, std::vector<String>& out) {
+#ifdef _WIN32
+  String findPath=dir+String(DIR_SEPARATOR_STR)+String("*")+String(ext);
+  WIN32_FIND_DATAW next;
+  HANDLE d=FindFirstFileW(utf8To16(findPath.c_str()).c_str(),&next);
+  if (d!=INVALID_HANDLE_VALUE) {
+    do {
+      out.push_back(utf16To8(next.cFileName));
+    } while (FindNextFileW(d,&next)!=0);
+    FindClose(d);
+  }
+#else
+  DIR* d=opendir(dir.c_str());
+  if (d==NULL) return;
+  size_t extLen=strlen(ext);
+  while (true) {
+    struct dirent* next=readdir(d);
+    if (next==NULL) break;
+    size_t nameLen=strlen(next->d_name);
+    if (nameLen<extLen) continue;
+    if (strcmp(next->d_name+nameLen-extLen,ext)!=0) continue;
+    out.push_back(String(next->d_name));
+  }
+  closedir(d);
+#endif
+}
+
+static String hashToString(const unsigned char* hash) {
+  String ret;
+  for (int i=0; i<16; i++) {
+    ret+=fmt::sprintf("%.2x",hash[i]);
+  }
+  return ret;
+}
+
+String DivBackupStore::chunkFileName(const DivBackupChunk& chunk) {
+  return chunkPath+String(DIR_SEPARATOR_STR)+hashToString(chunk.hash)+String(".bin");
+}
+
+bool DivBackupStore::isManifest(const unsigned char* data, size_t len) {
+  if (len<16) return false;
+  return memcmp(data,DIV_BACKUP_MAGIC,16)==0;
+}
+
+bool DivBackupStore::writeChunk(const DivBackupChunk& chunk, const unsigned char* data, size_t& written) {
+  String fileName=chunkFileName(chunk);
+  // already stored
+  if (fileExists(fileName.c_str())==1) return true;
+
+  uLongf compLen=compressBound(chunk.len);
+  unsigned char* comp=new unsigned char[compLen];
+  if (compress(comp,&compLen,data,chunk.len)!=Z_OK) {
+    logW("backup: could not compress chunk!");
+    delete[] comp;
+    return false;
+  }
+
+  // write to a temporary file first, so that an interrupted backup never leaves a broken chunk
+  String tempName=fileName+String(".tmp");
+  FILE* f=ps_fopen(tempName.c_str(),"wb");
+  if (f==NULL) {
+    logW("backup: could not open chunk file: %s!",strerror(errno));
+    delete[] comp;
+    return false;
+  }
+  bool success=(fwrite(comp,1,compLen,f)==compLen);
+  fclose(f);
+  delete[] comp;
+  if (!success) {
+    logW("backup: could not write chunk: %s!",strerror(errno));
+    deleteFile(tempName.c_str());
+    return false;
+  }
+  if (!moveFiles(tempName.c_str(),fileName.c_str())) {
+    logW("backup: could not rename chunk!");
+    deleteFile(tempName.c_str());
+    return false;
+  }
+  written+=compLen;
+  ownChunks.insert(hashToString(chunk.hash)+String(".bin"));
+  return true;
+}
+
+bool DivBackupStore::save(SafeWriter* w, const String& manifestPath) {
+  const unsigned char* buf=w->getFinalBuf();
+  size_t len=w->size();
+
+  if (!dirExists(chunkPath.c_str())) {
+    if (!makeDir(chunkPath.c_str())) {
+      logW("backup: could not create chunk directory!");
+      return false;
+    }
+  }
+
+  // split the file into blocks.
+  // each block is preceded by a 4-byte ID and its length, and blocks are placed back to back after the header.
+  std::vector<size_t> bounds;
+  bounds.push_back(0);
+  size_t pos=MIN(len,(size_t)32);
+  bounds.push_back(pos);
+  while (pos+8<=len) {
+    unsigned int blockLen=buf[pos+4]|(buf[pos+5]<<8)|(buf[pos+6]<<16)|((unsigned int)buf[pos+7]<<24);
+    if (blockLen>len-pos-8) break;
+    pos+=8+blockLen;
+    bounds.push_back(pos);
+  }
+  if (pos<len) bounds.push_back(len);
+
+  SafeWriter manifest;
+  manifest.init();
+  manifest.write(DIV_BACKUP_MAGIC,16);
+  manifest.writeS(DIV_BACKUP_VERSION);
+  manifest.writeS(0);
+  manifest.writeI(bounds.size()-1);
+  manifest.writeL(len);
+
+  size_t written=0;
+  for (size_t i=0; i+1<bounds.size(); i++) {
+    DivBackupChunk chunk;
+    chunk.len=bounds[i+1]-bounds[i];
+    hashChunk(buf+bounds[i],chunk.len,chunk.hash);
+    if (!writeChunk(chunk,buf+bounds[i],written)) {
+      manifest.finish();
+      return false;
+    }
+    manifest.write(chunk.hash,16);
+    manifest.writeI(chunk.len);
+  }
+
+  // the manifest goes through a temporary file as well, so that a half-written one is never listed
+  String tempName=manifestPath+String(".tmp");
+  FILE* f=ps_fopen(tempName.c_str(),"wb");
+  if (f==NULL) {
+    logW("backup: could not open manifest: %s!",strerror(errno));
+    manifest.finish();
+    return false;
+  }
+  bool success=(fwrite(manifest.getFinalBuf(),1,manifest.size(),f)==manifest.size());
+  fclose(f);
+  if (!success) {
+    logW("backup: could not write manifest: %s!",strerror(errno));
+    deleteFile(tempName.c_str());
+  } else if (!moveFiles(tempName.c_str(),manifestPath.c_str())) {
+    logW("backup: could not rename manifest!");
+    deleteFile(tempName.c_str());
+    success=false;
+  }
+  logD("backup: %d blocks, %d bytes written (song is %d bytes)",(int)bounds.size()-1,(int)(written+manifest.size()),(int)len);
+  manifest.finish();
+  return success;
+}
+
+bool DivBackupStore::readManifest(const unsigned char* data, size_t len, std::vector<DivBackupChunk>& chunks) {
+  if (!isManifest(data,len)) return false;
+  SafeReader reader(data,len);
+  try {
+    reader.seek(16,SEEK_SET);
+    short version=reader.readS();
+    if (version>DIV_BACKUP_VERSION) {
+      logW("backup: manifest is from a newer version!");
+      return false;
+    }
+    reader.readS(); // reserved
+    unsigned int count=reader.readI();
+    reader.readL(); // total length
+    if (count>(len/20)) return false;
+    chunks.reserve(count);
+    for (unsigned int i=0; i<count; i++) {
+      DivBackupChunk chunk;
+      reader.read(chunk.hash,16);
+      chunk.len=reader.readI();
+      chunks.push_back(chunk);
+    }
+  } catch (EndOfFileException& e) {
+    logW("backup: manifest is truncated!");
+    return false;
+  }
+  return true;
+}
+
+unsigned char* DivBackupStore::restore(const unsigned char* data, size_t len, size_t& outLen) {
+  std::vector<DivBackupChunk> chunks;
+  if (!readManifest(data,len,chunks)) return NULL;
+
+  outLen=0;
+  for (DivBackupChunk& i: chunks) {
+    outLen+=i.len;
+  }
+  if (outLen==0) return NULL;
+
+  unsigned char* ret=new unsigned char[outLen];
+  size_t pos=0;
+  for (DivBackupChunk& i: chunks) {
+    String fileName=chunkFileName(i);
+    FILE* f=ps_fopen(fileName.c_str(),"rb");
+    if (f==NULL) {
+      logE("backup: chunk %s is missing!",hashToString(i.hash));
+      delete[] ret;
+      return NULL;
+    }
+    std::vector<unsigned char> comp;
+    unsigned char readBuf[4096];
+    while (true) {
+      size_t got=fread(readBuf,1,4096,f);
+      if (got==0) break;
+      comp.insert(comp.end(),readBuf,readBuf+got);
+    }
+    fclose(f);
+
+    uLongf destLen=i.len;
+    if (uncompress(ret+pos,&destLen,comp.data(),comp.size())!=Z_OK || destLen!=i.len) {
+      logE("backup: chunk %s is corrupt!",hashToString(i.hash));
+      delete[] ret;
+      return NULL;
+    }
+    unsigned char check[16];
+    hashChunk(ret+pos,i.len,check);
+    if (memcmp(check,i.hash,16)!=0) {
+      logE("backup: chunk %s does not match its hash!",hashToString(i.hash));
+      delete[] ret;
+      return NULL;
+    }
+    pos+=i.len;
+  }
+  return ret;
+}
+
+void DivBackupStore::collectGarbage() {
+  std::vector<String> manifests;
+  std::unordered_set<String> used;
+  listFiles(path,DIV_BACKUP_EXT,manifests);
+
+  for (String& i: manifests) {
+    String fileName=path+String(DIR_SEPARATOR_STR)+i;
+    FILE* f=ps_fopen(fileName.c_str(),"rb");
+    if (f==NULL) continue;
+    std::vector<unsigned char> data;
+    unsigned char readBuf[4096];
+    while (true) {
+      size_t got=fread(readBuf,1,4096,f);
+      if (got==0) break;
+      data.insert(data.end(),readBuf,readBuf+got);
+    }
+    fclose(f);
+
+    std::vector<DivBackupChunk> chunks;
+    if (!readManifest(data.data(),data.size(),chunks)) {
+      // not a manifest (e.g. a restored song saved under this name). it can't reference chunks we wrote
+      logV("backup: %s is not a manifest.",i);
+      continue;
+    }
+    for (DivBackupChunk& j: chunks) {
+      used.insert(hashToString(j.hash)+String(".bin"));
+    }
+  }
+
+  int deleted=0;
+  for (auto i=ownChunks.begin(); i!=ownChunks.end();) {
+    if (used.find(*i)!=used.end()) {
+      ++i;
+      continue;
+    }
+    String fileName=chunkPath+String(DIR_SEPARATOR_STR)+(*i);
+    if (deleteFile(fileName.c_str())) deleted++;
+    i=ownChunks.erase(i);
+  }
+  if (deleted>0) logD("backup: deleted %d unused chunks.",deleted);
+}
+
+void DivBackupStore::setPath(const String& dir) {
+  if (dir==path) return;
+  path=dir;
+  chunkPath=dir+String(DIR_SEPARATOR_STR)+String(CHUNKS_DIR);
+  ownChunks.clear();
+}
+
+DivBackupStore::DivBackupStore(const String& dir):
+  path(dir),
+  chunkPath(dir+String(DIR_SEPARATOR_STR)+String(CHUNKS_DIR)) {
+}
@@ -0,0 +1,98 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _BACKUPSTORE_H
+#define _BACKUPSTORE_H
+
+#include "safeWriter.h"
+#include "../ta-utils.h"
+#include <unordered_set>
+
+#define DIV_BACKUP_MAGIC "-Furnace backup-"
+#define DIV_BACKUP_VERSION 1
+#define DIV_BACKUP_EXT ".furb"
+
+struct DivBackupChunk {
+  unsigned char hash[16];
+  unsigned int len;
+  DivBackupChunk():
+    len(0) {
+    memset(hash,0,16);
+  }
+};
+
+/**
+ * a content-addressed store for song backups.
+ *
+ * a backup is a small manifest (.furb) listing the blocks of a .fur file.
+ * every block (instrument, sample, pattern, sub-song...) is stored once under
+ * its hash in the chunks directory, so unchanged blocks are not written again.
+ */
+class DivBackupStore {
+  String path;
+  String chunkPath;
+  // chunks written by this store. other chunks may belong to another instance which is still writing its manifest
+  std::unordered_set<String> ownChunks;
+
+  String chunkFileName(const DivBackupChunk& chunk);
+  bool writeChunk(const DivBackupChunk& chunk, const unsigned char* data, size_t& written);
+  bool readManifest(const unsigned char* data, size_t len, std::vector<DivBackupChunk>& chunks);
+
+  public:
+    /**
+     * check whether data is a backup manifest.
+     */
+    static bool isManifest(const unsigned char* data, size_t len);
+
+    /**
+     * store a song.
+     * @param w a SafeWriter containing an uncompressed .fur file.
+     * @param manifestPath where to write the manifest.
+     * @return whether the backup was successful.
+     */
+    bool save(SafeWriter* w, const String& manifestPath);
+
+    /**
+     * reassemble the .fur file referenced by a manifest.
+     * @param data the manifest.
+     * @param len its length.
+     * @param outLen the length of the result.
+     * @return a buffer which shall be freed with delete[], or NULL on error.
+     */
+    unsigned char* restore(const unsigned char* data, size_t len, size_t& outLen);
+
+    /**
+     * delete chunks which were written by this store and are not referenced by any manifest.
+     */
+    void collectGarbage();
+
+    /**
+     * set the directory where manifests are located.
+     * this forgets which chunks were written if the directory changes.
+     */
+    void setPath(const String& dir);
+
+    /**
+     * @param dir the directory where manifests are located.
+     */
+    DivBackupStore(const String& dir);
+    DivBackupStore() {}
+};
+
+#endif
@@ -250,6 +250,41 @@ int blip_read_samples( blip_t* m, short out [], int count, int stereo )
 	return count;
 }
 
+int blip_read_samples_int( blip_t* m, int out [], int count )
+{
+	assert( count >= 0 );
+	
+	if ( count > m->avail )
+		count = m->avail;
+	
+	if ( count )
+	{
+		buf_t const* in  = SAMPLES( m );
+		buf_t const* end = in + count;
+		int sum = m->integrator;
+		do
+		{
+			/* Eliminate fraction */
+			int s = ARITH_SHIFT( sum, delta_bits );
+			
+			sum += *in++;
+			
+			*out++ = s;
+			
+			/* High-pass filter */
+			if (m->hipass) {
+				sum -= s << (delta_bits - bass_shift);
+			}
+		}
+		while ( in != end );
+		m->integrator = sum;
+		
+		remove_samples( m, count );
+	}
+	
+	return count;
+}
+
 /* Things that didn't help performance on x86:
 	__attribute__((aligned(128)))
 	#define short int
@@ -350,3 +385,111 @@ void blip_add_delta_fast( blip_t* m, unsigned time, int delta )
 	out [7] += delta * delta_unit - delta2;
 	out [8] += delta2;
 }
+
+/* The multi-buffer versions work out the kernel for the phase once and then
+apply it to each buffer. With SSE2, the taps of the two phases are paired
+with delta and delta2 so that pmaddwd does both multiplies and the add; this
+needs both deltas to fit in 16 bits, which is almost always the case. The
+results are identical to blip_add_delta(). */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define BLIP_SSE2 1
+#endif
+
+void blip_add_delta_multi( blip_t* const* m, int count, unsigned time, int const* deltas )
+{
+	unsigned fixed = (unsigned) ((time * m[0]->factor + m[0]->offset) >> pre_shift);
+	int pos = m[0]->avail + (fixed >> frac_bits);
+	
+	int const phase_shift = frac_bits - phase_bits;
+	int phase = fixed >> phase_shift & (phase_count - 1);
+	short const* in  = bl_step [phase];
+	short const* rev = bl_step [phase_count - phase];
+	
+	int interp = fixed >> (phase_shift - delta_bits) & (delta_unit - 1);
+	int i, k;
+	
+#ifdef BLIP_SSE2
+	/* (in[k], in[half_width+k]) pairs for taps 0-7, then (rev[k],
+	rev[k-half_width]) pairs in reverse order for taps 8-15 */
+	__m128i const a  = _mm_loadu_si128( (__m128i const*) in );
+	__m128i const a2 = _mm_loadu_si128( (__m128i const*) (in + half_width) );
+	__m128i r  = _mm_loadu_si128( (__m128i const*) rev );
+	__m128i r2 = _mm_loadu_si128( (__m128i const*) (rev - half_width) );
+	__m128i kernel [4];
+	r  = _mm_shufflehi_epi16( _mm_shufflelo_epi16( _mm_shuffle_epi32( r,  0x4e ), 0x1b ), 0x1b );
+	r2 = _mm_shufflehi_epi16( _mm_shufflelo_epi16( _mm_shuffle_epi32( r2, 0x4e ), 0x1b ), 0x1b );
+	kernel [0] = _mm_unpacklo_epi16( a, a2 );
+	kernel [1] = _mm_unpackhi_epi16( a, a2 );
+	kernel [2] = _mm_unpacklo_epi16( r, r2 );
+	kernel [3] = _mm_unpackhi_epi16( r, r2 );
+#endif
+	
+	for ( i = 0; i < count; i++ )
+	{
+		int delta = deltas [i];
+		int delta2;
+		buf_t* out;
+		if ( !delta )
+			continue;
+		
+		/* Fails if buffers don't share the same time frame */
+		assert( m[i]->factor == m[0]->factor && m[i]->offset == m[0]->offset && m[i]->avail == m[0]->avail );
+		
+		out = SAMPLES( m[i] ) + pos;
+		delta2 = (delta * interp) >> delta_bits;
+		delta -= delta2;
+		
+		/* Fails if buffer size was exceeded */
+		assert( out <= &SAMPLES( m[i] ) [m[i]->size + end_frame_extra] );
+		
+#ifdef BLIP_SSE2
+		if ( (short) delta == delta && (short) delta2 == delta2 )
+		{
+			__m128i const d = _mm_set1_epi32( (delta & 0xFFFF) | ((unsigned) delta2 << 16) );
+			for ( k = 0; k < 4; k++ )
+			{
+				__m128i* o = (__m128i*) (out + k*4);
+				_mm_storeu_si128( o, _mm_add_epi32( _mm_loadu_si128( o ), _mm_madd_epi16( kernel [k], d ) ) );
+			}
+			continue;
+		}
+#endif
+		for ( k = 0; k < half_width; k++ )
+		{
+			out [k] += in[k]*delta + in[half_width+k]*delta2;
+			out [half_width*2-1-k] += rev[k]*delta + rev[k-half_width]*delta2;
+		}
+	}
+}
+
+void blip_add_delta_fast_multi( blip_t* const* m, int count, unsigned time, int const* deltas )
+{
+	unsigned fixed = (unsigned) ((time * m[0]->factor + m[0]->offset) >> pre_shift);
+	int pos = m[0]->avail + (fixed >> frac_bits);
+	
+	int interp = fixed >> (frac_bits - delta_bits) & (delta_unit - 1);
+	int i;
+	
+	for ( i = 0; i < count; i++ )
+	{
+		int delta = deltas [i];
+		int delta2;
+		buf_t* out;
+		if ( !delta )
+			continue;
+		
+		/* Fails if buffers don't share the same time frame */
+		assert( m[i]->factor == m[0]->factor && m[i]->offset == m[0]->offset && m[i]->avail == m[0]->avail );
+		
+		out = SAMPLES( m[i] ) + pos;
+		delta2 = delta * interp;
+		
+		/* Fails if buffer size was exceeded */
+		assert( out <= &SAMPLES( m[i] ) [m[i]->size + end_frame_extra] );
+		
+		out [7] += delta * delta_unit - delta2;
+		out [8] += delta2;
+	}
+}
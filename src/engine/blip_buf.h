@@ -7,6 +7,7 @@ Sample buffer that resamples from input clock rate to output sample rate */
 
 // MODIFIED by tildearrow:
 // - add option to disable high-pass filter
+// - add multi-buffer delta functions and 32-bit output
 
 #ifdef __cplusplus
 	extern "C" {
@@ -41,6 +42,15 @@ void blip_add_delta( blip_t*, unsigned int clock_time, int delta );
 /** Same as blip_add_delta(), but uses faster, lower-quality synthesis. */
 void blip_add_delta_fast( blip_t*, unsigned int clock_time, int delta );
 
+/** Adds deltas[i] into buffer m[i] for each of the count buffers at the
+specified clock time. The buffers must share rates and time frames (as the
+outputs of one chip do), so that the time and phase are computed only once.
+Zero deltas are skipped. */
+void blip_add_delta_multi( blip_t* const* m, int count, unsigned int clock_time, int const* deltas );
+
+/** Same as blip_add_delta_multi(), but uses faster, lower-quality synthesis. */
+void blip_add_delta_fast_multi( blip_t* const* m, int count, unsigned int clock_time, int const* deltas );
+
 /** Length of time frame, in clocks, needed to make sample_count additional
 samples available. */
 int blip_clocks_needed( const blip_t*, int sample_count );
@@ -64,6 +74,10 @@ interleaving of two buffers into a stereo sample stream. Outputs 16-bit signed
 samples. Returns number of samples actually read.  */
 int blip_read_samples( blip_t*, short out [], int count, int stereo );
 
+/** Same as blip_read_samples(), but outputs 32-bit samples which are not
+clamped to 16-bit. */
+int blip_read_samples_int( blip_t*, int out [], int count );
+
 /** Frees buffer. No effect if NULL is passed. */
 void blip_delete( blip_t* );
 
@@ -118,25 +118,32 @@ bool DivCSPlayer::tick() {
         case 0xf7:
           command=stream.readC();
           break;
+        // calls push the address of the next instruction
         case 0xf8: {
           unsigned int callAddr=chan[i].readPos+2+stream.readS();
+          chan[i].readPos=stream.tell();
           if (!chan[i].doCall(callAddr)) {
             logE("%d: (callb16) stack error!",i);
           }
+          mustTell=false;
           break;
         }
         case 0xf6: {
           unsigned int callAddr=chan[i].readPos+4+stream.readI();
+          chan[i].readPos=stream.tell();
           if (!chan[i].doCall(callAddr)) {
             logE("%d: (callb32) stack error!",i);
           }
+          mustTell=false;
           break;
         }
         case 0xf5: {
           unsigned int callAddr=stream.readI();
+          chan[i].readPos=stream.tell();
           if (!chan[i].doCall(callAddr)) {
             logE("%d: (call) stack error!",i);
           }
+          mustTell=false;
           break;
         }
         case 0xf4: {
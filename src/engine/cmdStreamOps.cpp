@@ -19,6 +19,8 @@
 
 #include "engine.h"
 #include "../ta-log.h"
+#include <map>
+#include <algorithm>
 
 #define WRITE_TICK(x) \
   if (!wroteTick[x]) { \
@@ -198,6 +200,300 @@ void writePackedCommandValues(SafeWriter* w, const DivCommand& c) {
   }
 }
 
+// subroutine compression
+// repeated instruction sequences (within a channel and across channels) are moved to
+// subroutines at the end of the file and replaced by calls.
+#define CS_CALL_SIZE 3
+#define CS_MAX_DEPTH 8
+#define CS_CANDIDATES 64
+#define CS_MAX_PASSES 512
+
+struct CSToken {
+  // instruction bytes (empty for calls)
+  std::vector<unsigned char> data;
+  // subroutine index if this is a call, or -1
+  int sub;
+  // not allowed in a subroutine (stop)
+  bool unique;
+  CSToken(const std::vector<unsigned char>& d, int s, bool u):
+    data(d),
+    sub(s),
+    unique(u) {}
+};
+
+struct CSSubroutine {
+  std::vector<int> body;
+  int depth;
+};
+
+struct CSCandidate {
+  std::vector<int> pattern;
+  int estimate;
+};
+
+struct CSCompressor {
+  std::vector<CSToken> tokens;
+  std::map<std::vector<unsigned char>,int> tokenMap;
+  std::vector<std::vector<int>> streams;
+  std::vector<CSSubroutine> subs;
+
+  int getToken(const std::vector<unsigned char>& data) {
+    auto it=tokenMap.find(data);
+    if (it!=tokenMap.end()) return it->second;
+    int ret=(int)tokens.size();
+    tokens.push_back(CSToken(data,-1,data.size()==1 && data[0]==0xff));
+    tokenMap[data]=ret;
+    return ret;
+  }
+
+  int tokenLen(int t) {
+    if (tokens[t].sub>=0) return CS_CALL_SIZE;
+    return (int)tokens[t].data.size();
+  }
+
+  bool isRepeatable(int t) {
+    if (tokens[t].unique) return false;
+    if (tokens[t].sub>=0) {
+      if (subs[tokens[t].sub].depth>=CS_MAX_DEPTH) return false;
+    }
+    return true;
+  }
+
+  // find candidates using a suffix array over all streams
+  void findCandidates(std::vector<CSCandidate>& out) {
+    std::vector<int> text;
+    std::vector<int> pre;
+    int uniq=(int)tokens.size();
+    pre.push_back(0);
+    for (std::vector<int>& i: streams) {
+      for (int j: i) {
+        text.push_back(isRepeatable(j)?j:uniq++);
+        pre.push_back(pre.back()+tokenLen(j));
+      }
+      // separator
+      text.push_back(uniq++);
+      pre.push_back(pre.back());
+    }
+    int n=(int)text.size();
+    if (n<2) return;
+
+    // prefix doubling
+    std::vector<int> sa(n), rank(n), tmp(n);
+    for (int i=0; i<n; i++) {
+      sa[i]=i;
+      rank[i]=text[i];
+    }
+    for (int k=1;; k<<=1) {
+      auto cmp=[&rank,k,n](int a, int b) {
+        if (rank[a]!=rank[b]) return rank[a]<rank[b];
+        int ra=(a+k<n)?rank[a+k]:-1;
+        int rb=(b+k<n)?rank[b+k]:-1;
+        return ra<rb;
+      };
+      std::sort(sa.begin(),sa.end(),cmp);
+      tmp[sa[0]]=0;
+      for (int i=1; i<n; i++) {
+        tmp[sa[i]]=tmp[sa[i-1]]+(cmp(sa[i-1],sa[i])?1:0);
+      }
+      rank=tmp;
+      if (rank[sa[n-1]]==n-1) break;
+    }
+
+    // LCP (Kasai)
+    std::vector<int> lcp(n+1,0);
+    int h=0;
+    for (int i=0; i<n; i++) {
+      if (rank[i]>0) {
+        int j=sa[rank[i]-1];
+        while (i+h<n && j+h<n && text[i+h]==text[j+h]) h++;
+        lcp[rank[i]]=h;
+        if (h>0) h--;
+      } else {
+        h=0;
+      }
+    }
+
+    // enumerate LCP intervals
+    std::vector<CSCandidate> cands;
+    std::vector<std::pair<int,int>> stack; // lcp, left bound
+    stack.push_back(std::pair<int,int>(0,0));
+    for (int i=1; i<=n; i++) {
+      int lb=i-1;
+      int cur=lcp[i];
+      while (cur<stack.back().first) {
+        std::pair<int,int> top=stack.back();
+        stack.pop_back();
+        lb=top.second;
+        int count=i-lb;
+        int pos=sa[lb];
+        int bytes=pre[pos+top.first]-pre[pos];
+        int estimate=(count-1)*bytes-count*CS_CALL_SIZE-1;
+        if (estimate>0) {
+          CSCandidate c;
+          c.pattern.assign(text.begin()+pos,text.begin()+pos+top.first);
+          c.estimate=estimate;
+          cands.push_back(c);
+        }
+      }
+      if (cur>stack.back().first) {
+        stack.push_back(std::pair<int,int>(cur,lb));
+      }
+    }
+
+    if (cands.size()>CS_CANDIDATES) {
+      std::nth_element(cands.begin(),cands.begin()+CS_CANDIDATES,cands.end(),[](const CSCandidate& a, const CSCandidate& b) {
+        return a.estimate>b.estimate;
+      });
+      cands.resize(CS_CANDIDATES);
+    }
+    std::sort(cands.begin(),cands.end(),[](const CSCandidate& a, const CSCandidate& b) {
+      return a.estimate>b.estimate;
+    });
+    out=cands;
+  }
+
+  bool matches(const std::vector<int>& s, size_t pos, const std::vector<int>& pattern) {
+    if (pos+pattern.size()>s.size()) return false;
+    for (size_t i=0; i<pattern.size(); i++) {
+      if (s[pos+i]!=pattern[i]) return false;
+    }
+    return true;
+  }
+
+  // replace non-overlapping occurrences of a pattern with a call if it saves space
+  bool apply(const std::vector<int>& pattern) {
+    int depth=1;
+    int bytes=0;
+    for (int i: pattern) {
+      if (!isRepeatable(i)) return false;
+      if (tokens[i].sub>=0) {
+        depth=MAX(depth,subs[tokens[i].sub].depth+1);
+      }
+      bytes+=tokenLen(i);
+    }
+    if (depth>CS_MAX_DEPTH) return false;
+
+    int count=0;
+    for (std::vector<int>& s: streams) {
+      for (size_t i=0; i<s.size();) {
+        if (matches(s,i,pattern)) {
+          count++;
+          i+=pattern.size();
+        } else {
+          i++;
+        }
+      }
+    }
+    if (count<2) return false;
+    if ((count-1)*bytes-count*CS_CALL_SIZE-1<=0) return false;
+
+    CSSubroutine sub;
+    sub.body=pattern;
+    sub.depth=depth;
+    subs.push_back(sub);
+    int call=(int)tokens.size();
+    tokens.push_back(CSToken(std::vector<unsigned char>(),(int)subs.size()-1,false));
+
+    for (std::vector<int>& s: streams) {
+      std::vector<int> next;
+      next.reserve(s.size());
+      for (size_t i=0; i<s.size();) {
+        if (matches(s,i,pattern)) {
+          next.push_back(call);
+          i+=pattern.size();
+        } else {
+          next.push_back(s[i]);
+          i++;
+        }
+      }
+      s=next;
+    }
+    return true;
+  }
+
+  void run() {
+    std::vector<CSCandidate> cands;
+    for (int pass=0; pass<CS_MAX_PASSES; pass++) {
+      cands.clear();
+      findCandidates(cands);
+      bool applied=false;
+      for (CSCandidate& i: cands) {
+        if (apply(i.pattern)) applied=true;
+      }
+      if (!applied) break;
+    }
+  }
+
+  // lay out channel streams followed by subroutines, and write them.
+  // calls use 0xf8 (16-bit offset) when in range, or 0xf6 (32-bit offset) otherwise.
+  void write(SafeWriter* w, unsigned int* chanOff) {
+    // sections: channel streams, then subroutines (with a trailing return)
+    std::vector<std::vector<int>*> sections;
+    for (std::vector<int>& i: streams) sections.push_back(&i);
+    for (CSSubroutine& i: subs) sections.push_back(&i.body);
+
+    std::vector<std::vector<unsigned char>> callSize(sections.size());
+    std::vector<size_t> sectionOff(sections.size());
+    for (size_t i=0; i<sections.size(); i++) {
+      callSize[i].resize(sections[i]->size(),CS_CALL_SIZE);
+    }
+
+    size_t base=w->tell();
+    bool changed=true;
+    while (changed) {
+      changed=false;
+      size_t pos=base;
+      for (size_t i=0; i<sections.size(); i++) {
+        sectionOff[i]=pos;
+        for (size_t j=0; j<sections[i]->size(); j++) {
+          int t=(*sections[i])[j];
+          pos+=(tokens[t].sub>=0)?callSize[i][j]:tokens[t].data.size();
+        }
+        if (i>=streams.size()) pos++; // return
+      }
+      for (size_t i=0; i<sections.size(); i++) {
+        size_t p=sectionOff[i];
+        for (size_t j=0; j<sections[i]->size(); j++) {
+          int t=(*sections[i])[j];
+          if (tokens[t].sub>=0) {
+            if (callSize[i][j]==3) {
+              long long off=(long long)sectionOff[streams.size()+tokens[t].sub]-(long long)p-2;
+              if (off<-32768 || off>32767) {
+                callSize[i][j]=5;
+                changed=true;
+              }
+            }
+            p+=callSize[i][j];
+          } else {
+            p+=tokens[t].data.size();
+          }
+        }
+      }
+    }
+
+    for (size_t i=0; i<sections.size(); i++) {
+      if (i<streams.size()) chanOff[i]=w->tell();
+      for (size_t j=0; j<sections[i]->size(); j++) {
+        int t=(*sections[i])[j];
+        if (tokens[t].sub>=0) {
+          size_t p=w->tell();
+          size_t target=sectionOff[streams.size()+tokens[t].sub];
+          if (callSize[i][j]==3) {
+            w->writeC(0xf8);
+            w->writeS((short)(target-p-2));
+          } else {
+            w->writeC(0xf6);
+            w->writeI((int)(target-p-4));
+          }
+        } else {
+          w->write(tokens[t].data.data(),tokens[t].data.size());
+        }
+      }
+      if (i>=streams.size()) w->writeC(0xf9);
+    }
+  }
+};
+
 SafeWriter* DivEngine::saveCommand() {
   stop();
   repeatPattern=false;
@@ -261,7 +557,7 @@ SafeWriter* DivEngine::saveCommand() {
 
   memset(lastTick,0,DIV_MAX_CHANS*sizeof(int));
   while (!done) {
-    if (nextTick(false,true) || !playing) {
+    if (nextTick() || !playing) {
       done=true;
       break;
     }
@@ -273,7 +569,8 @@ SafeWriter* DivEngine::saveCommand() {
       chanStream[0]->writeC(0xfb);
       chanStream[0]->writeI((int)(curDivider*65536));
     }
-    for (DivCommand& i: cmdStream) {
+    for (size_t j=0; j<cmdStream.size(); j++) {
+      DivCommand& i=cmdStream[j];
       switch (i.cmd) {
         // strip away hinted/useless commands
         case DIV_CMD_GET_VOLUME:
@@ -346,6 +643,9 @@ SafeWriter* DivEngine::saveCommand() {
     sortPos++;
   }
 
+  CSCompressor compressor;
+  size_t sizeBefore=0;
+
   for (int i=0; i<chans; i++) {
     chanStream[i]->writeC(0xff);
     // optimize stream
@@ -353,6 +653,7 @@ SafeWriter* DivEngine::saveCommand() {
     SafeReader* reader=oldStream->toReader();
     chanStream[i]=new SafeWriter;
     chanStream[i]->init();
+    std::vector<size_t> insEnd;
 
     while (1) {
       try {
@@ -450,6 +751,7 @@ SafeWriter* DivEngine::saveCommand() {
             chanStream[i]->writeC(next);
             break;
         }
+        insEnd.push_back(chanStream[i]->tell());
       } catch (EndOfFileException& e) {
         break;
       }
@@ -457,16 +759,29 @@ SafeWriter* DivEngine::saveCommand() {
 
     oldStream->finish();
     delete oldStream;
-  }
 
-  for (int i=0; i<chans; i++) {
-    chanStreamOff[i]=w->tell();
-    logI("- %d: off %x size %ld",i,chanStreamOff[i],chanStream[i]->size());
-    w->write(chanStream[i]->getFinalBuf(),chanStream[i]->size());
+    // split into instructions for the compressor
+    std::vector<int> stream;
+    unsigned char* buf=chanStream[i]->getFinalBuf();
+    size_t insStart=0;
+    for (size_t j: insEnd) {
+      stream.push_back(compressor.getToken(std::vector<unsigned char>(buf+insStart,buf+j)));
+      insStart=j;
+    }
+    compressor.streams.push_back(stream);
+    sizeBefore+=chanStream[i]->size();
     chanStream[i]->finish();
     delete chanStream[i];
   }
 
+  compressor.run();
+  size_t dataStart=w->tell();
+  compressor.write(w,chanStreamOff);
+  for (int i=0; i<chans; i++) {
+    logI("- %d: off %x",i,chanStreamOff[i]);
+  }
+  logI("command stream: %d subroutines, %d bytes -> %d bytes (%.1f%%)",(int)compressor.subs.size(),(int)sizeBefore,(int)(w->tell()-dataStart),sizeBefore?(100.0*(double)(w->tell()-dataStart)/(double)sizeBefore):100.0);
+
   w->seek(8,SEEK_SET);
   for (int i=0; i<chans; i++) {
     w->writeI(chanStreamOff[i]);
@@ -288,6 +288,12 @@ struct DivCommand {
     dis(ch),
     value(0),
     value2(0) {}
+  DivCommand():
+    cmd(DIV_CMD_NOTE_OFF),
+    chan(0),
+    dis(0),
+    value(0),
+    value2(0) {}
 };
 
 struct DivPitchTable {
@@ -313,11 +319,6 @@ struct DivPitchTable {
   }
 };
 
-struct DivDelayedCommand {
-  int ticks;
-  DivCommand cmd;
-};
-
 struct DivRegWrite {
   /**
    * an address of 0xffffxx00 indicates a Furnace specific command.
@@ -510,6 +511,12 @@ class DivDispatch {
      * please honor these variables if needed.
      */
     bool skipRegisterWrites, dumpWrites;
+    /**
+     * whether per-channel oscilloscope data shall be written.
+     * this is false in renders which don't display it (export, benchmark).
+     * chips may honor it by using an acquire variant with oscilloscope writes compiled out.
+     */
+    bool oscCapture;
   public:
     /**
      * the rate the samples are provided.
@@ -524,6 +531,12 @@ class DivDispatch {
      */
     int chipClock;
 
+    /**
+     * the number of register writes since the engine last read it.
+     * the rWrite macros of most chips increase this. the engine resets it after every buffer.
+     */
+    unsigned int regWriteCount;
+
     /**
      * fill a buffer with sound data.
      * @param buf pointers to output buffers.
@@ -553,7 +566,7 @@ class DivDispatch {
 
     /**
      * ticks this dispatch.
-     * @param sysTick whether the engine has ticked (if not then this may be a sub-tick used in low-latency mode).
+     * @param sysTick whether the engine has ticked (if not then this is a low-latency input sub-tick which only applies pending notes).
      */
     virtual void tick(bool sysTick=true);
 
@@ -744,6 +757,11 @@ class DivDispatch {
      */
     virtual void setSkipRegisterWrites(bool value);
 
+    /**
+     * enable or disable per-channel oscilloscope capture.
+     */
+    virtual void setOscCapture(bool enable);
+
     /**
      * notify instrument change.
      */
@@ -847,6 +865,15 @@ class DivDispatch {
      */
     virtual void renderSamples(int sysID);
 
+    /**
+     * Update a single sample in sample memory without rebuilding the rest.
+     * only possible when the sample keeps its size and placement.
+     * @param sysID the chip's index in the chip list.
+     * @param sample the sample index.
+     * @return true if the sample was updated in place, or false if renderSamples() must be called instead.
+     */
+    virtual bool renderSample(int sysID, int sample);
+
     /**
      * tell this DivDispatch that the tuning and/or pitch linearity has changed, and therefore the pitch table must be regenerated.
      */
@@ -867,6 +894,9 @@ class DivDispatch {
      */
     virtual void quit();
 
+    DivDispatch():
+      oscCapture(true),
+      regWriteCount(0) {}
     virtual ~DivDispatch();
 };
 
@@ -141,9 +141,9 @@ void DivDispatchContainer::grow(size_t size) {
       blip_set_rates(bb[i],dispatch->rate,rateMemory); \
  \
       if (bbIn[i]==NULL) bbIn[i]=new short[bbInLen]; \
-      if (bbOut[i]==NULL) bbOut[i]=new short[bbInLen]; \
+      if (bbOut[i]==NULL) bbOut[i]=new int[bbInLen]; \
       memset(bbIn[i],0,bbInLen*sizeof(short)); \
-      memset(bbOut[i],0,bbInLen*sizeof(short)); \
+      memset(bbOut[i],0,bbInLen*sizeof(int)); \
       mustClear=true; \
     } \
   } \
@@ -163,7 +163,9 @@ void DivDispatchContainer::acquire(size_t offset, size_t count) {
       }
     }
   }
+  std::chrono::steady_clock::time_point ts_begin=std::chrono::steady_clock::now();
   dispatch->acquire(bbInMapped,count);
+  acquireTime+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-ts_begin).count();
 }
 
 void DivDispatchContainer::flush(size_t count) {
@@ -171,7 +173,7 @@ void DivDispatchContainer::flush(size_t count) {
 
   for (int i=0; i<outs; i++) {
     if (bb[i]==NULL) continue;
-    blip_read_samples(bb[i],bbOut[i],count,0);
+    blip_read_samples_int(bb[i],bbOut[i],count);
   }
 }
 
@@ -187,7 +189,43 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
       }
     }
   }
-  if (lowQuality) {
+
+  // outputs of a chip share the same clock, so when there are several, the
+  // deltas of each clock are added together to compute time and phase once
+  blip_buffer_t* multiBuf[DIV_MAX_OUTPUTS];
+  short* multiIn[DIV_MAX_OUTPUTS];
+  int multiIndex[DIV_MAX_OUTPUTS];
+  int multiCount=0;
+  for (int i=0; i<outs; i++) {
+    if (bbIn[i]==NULL) continue;
+    if (bb[i]==NULL) continue;
+    multiBuf[multiCount]=bb[i];
+    multiIn[multiCount]=bbIn[i];
+    multiIndex[multiCount]=i;
+    multiCount++;
+  }
+
+  if (multiCount>1) {
+    int deltas[DIV_MAX_OUTPUTS];
+    for (size_t j=0; j<runtotal; j++) {
+      bool anyDelta=false;
+      for (int k=0; k<multiCount; k++) {
+        const int i=multiIndex[k];
+        deltas[k]=0;
+        if (multiIn[k][j]==temp[i]) continue;
+        temp[i]=multiIn[k][j];
+        deltas[k]=temp[i]-prevSample[i];
+        prevSample[i]=temp[i];
+        anyDelta=true;
+      }
+      if (!anyDelta) continue;
+      if (lowQuality) {
+        blip_add_delta_fast_multi(multiBuf,multiCount,j,deltas);
+      } else {
+        blip_add_delta_multi(multiBuf,multiCount,j,deltas);
+      }
+    }
+  } else if (lowQuality) {
     for (int i=0; i<outs; i++) {
       if (bbIn[i]==NULL) continue;
       if (bb[i]==NULL) continue;
@@ -215,7 +253,7 @@ void DivDispatchContainer::fillBuf(size_t runtotal, size_t offset, size_t size)
     if (bbOut[i]==NULL) continue;
     if (bb[i]==NULL) continue;
     blip_end_frame(bb[i],runtotal);
-    blip_read_samples(bb[i],bbOut[i]+offset,size,0);
+    blip_read_samples_int(bb[i],bbOut[i]+offset,size);
   }
   /*if (totalRead<(int)size && totalRead>0) {
     for (size_t i=totalRead; i<size; i++) {
@@ -786,9 +824,9 @@ void DivDispatchContainer::init(DivSystem sys, DivEngine* eng, int chanCount, do
     }
 
     bbIn[i]=new short[bbInLen];
-    bbOut[i]=new short[bbInLen];
+    bbOut[i]=new int[bbInLen];
     memset(bbIn[i],0,bbInLen*sizeof(short));
-    memset(bbOut[i],0,bbInLen*sizeof(short));
+    memset(bbOut[i],0,bbInLen*sizeof(int));
     blip_set_dc(bb[i],hiPass);
   }
 }
@@ -0,0 +1,79 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "editQueue.h"
+#include "engine.h"
+
+void DivSampleSwapEdit::apply(DivEngine* e) {
+  if (index<0 || index>=e->song.sampleLen) return;
+  // only pointers are exchanged here. chips with sample memory are handled by editSample() under the lock
+  e->song.sample[index]->swapData(sample);
+  if (e->sPreview.sample==index) {
+    e->sPreview.pos=0;
+    e->sPreview.dir=false;
+  }
+}
+
+DivSampleSwapEdit::~DivSampleSwapEdit() {
+  delete sample;
+}
+
+bool DivEditQueue::push(DivEdit* edit) {
+  if (stagePos-freePos>=DIV_EDIT_QUEUE_SIZE) return false;
+  slots[stagePos%DIV_EDIT_QUEUE_SIZE]=edit;
+  stagePos++;
+  return true;
+}
+
+void DivEditQueue::commit() {
+  writePos.store(stagePos,std::memory_order_release);
+}
+
+size_t DivEditQueue::collect() {
+  size_t applied=readPos.load(std::memory_order_acquire);
+  size_t ret=applied-freePos;
+  while (freePos!=applied) {
+    delete slots[freePos%DIV_EDIT_QUEUE_SIZE];
+    freePos++;
+  }
+  return ret;
+}
+
+bool DivEditQueue::pending() {
+  return readPos.load(std::memory_order_acquire)!=writePos.load(std::memory_order_acquire);
+}
+
+size_t DivEditQueue::apply(DivEngine* e) {
+  size_t pos=readPos.load(std::memory_order_relaxed);
+  size_t end=writePos.load(std::memory_order_acquire);
+  size_t ret=end-pos;
+  while (pos!=end) {
+    slots[pos%DIV_EDIT_QUEUE_SIZE]->apply(e);
+    pos++;
+  }
+  readPos.store(pos,std::memory_order_release);
+  return ret;
+}
+
+DivEditQueue::~DivEditQueue() {
+  while (freePos!=stagePos) {
+    delete slots[freePos%DIV_EDIT_QUEUE_SIZE];
+    freePos++;
+  }
+}
@@ -0,0 +1,116 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _EDITQUEUE_H
+#define _EDITQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+#define DIV_EDIT_QUEUE_SIZE 256
+
+class DivEngine;
+struct DivSample;
+
+/**
+ * a song edit which is prepared by the GUI and applied by the audio thread.
+ * edits are always created and destroyed by the thread that posts them, so
+ * apply() should not allocate or free memory.
+ */
+struct DivEdit {
+  /**
+   * apply this edit.
+   * this is called with the engine lock held, usually from the audio thread
+   * between two buffers.
+   * @param e the engine.
+   */
+  virtual void apply(DivEngine* e)=0;
+  virtual ~DivEdit() {}
+};
+
+/**
+ * replaces the contents of a sample with an already rendered copy.
+ * after being applied, the copy holds the old data and is freed along with
+ * the edit.
+ */
+struct DivSampleSwapEdit: DivEdit {
+  int index;
+  DivSample* sample;
+  void apply(DivEngine* e);
+  DivSampleSwapEdit(int i, DivSample* s):
+    index(i),
+    sample(s) {}
+  ~DivSampleSwapEdit();
+};
+
+/**
+ * a lock-free single-producer single-consumer queue of edits.
+ * the producer (GUI) pushes and frees edits; the consumer (audio thread)
+ * applies them.
+ * slots go through three states: staged (pushed but not committed), pending
+ * (committed but not applied) and applied (waiting to be freed).
+ */
+class DivEditQueue {
+  DivEdit* slots[DIV_EDIT_QUEUE_SIZE];
+  std::atomic<size_t> writePos, readPos;
+  size_t stagePos, freePos;
+  public:
+    /**
+     * stage an edit. it won't be visible to the consumer until commit().
+     * producer only.
+     * @param edit the edit.
+     * @return false if the queue is full.
+     */
+    bool push(DivEdit* edit);
+
+    /**
+     * publish all staged edits at once.
+     * producer only.
+     */
+    void commit();
+
+    /**
+     * free edits which have been applied.
+     * producer only.
+     * @return how many edits were freed.
+     */
+    size_t collect();
+
+    /**
+     * check whether there are committed edits which haven't been applied yet.
+     */
+    bool pending();
+
+    /**
+     * apply all committed edits.
+     * consumer only. the engine lock must be held.
+     * @param e the engine.
+     * @return how many edits were applied.
+     */
+    size_t apply(DivEngine* e);
+
+    DivEditQueue():
+      writePos(0),
+      readPos(0),
+      stagePos(0),
+      freePos(0) {}
+    ~DivEditQueue();
+};
+
+#endif
@@ -39,6 +39,7 @@
 #include "../audio/pipe.h"
 #include <math.h>
 #include <float.h>
+#include <zlib.h>
 #include <fmt/printf.h>
 
 void process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size) {
@@ -228,6 +229,60 @@ double DivEngine::benchmarkPlayback() {
   return t;
 }
 
+bool DivEngine::benchmarkRender(DivBenchResult& result, double maxLength) {
+  float* outBuf[2];
+  outBuf[0]=new float[EXPORT_BUFSIZE];
+  outBuf[1]=new float[EXPORT_BUFSIZE];
+  unsigned char* hashBuf=new unsigned char[EXPORT_BUFSIZE*4];
+
+  result=DivBenchResult();
+  result.rate=got.rate;
+  result.chips=song.systemLen;
+  size_t maxSamples=(size_t)(maxLength*got.rate);
+  unsigned long hash=crc32(0,NULL,0);
+
+  curOrder=0;
+  prevOrder=0;
+  remainingLoops=1;
+  playSub(false);
+
+  std::chrono::high_resolution_clock::time_point timeStart=std::chrono::high_resolution_clock::now();
+
+  while (playing && result.samples<maxSamples) {
+    nextBuf(NULL,outBuf,0,2,EXPORT_BUFSIZE);
+    for (int i=0; i<song.systemLen; i++) {
+      result.chipTime[i]+=disCont[i].acquireTime;
+    }
+    for (int i=0; i<EXPORT_BUFSIZE; i++) {
+      for (int j=0; j<2; j++) {
+        float s=outBuf[j][i];
+        if (s<-1.0f) s=-1.0f;
+        if (s>1.0f) s=1.0f;
+        short s16=(short)(s*32767.0f);
+        hashBuf[(i<<2)|(j<<1)]=s16&0xff;
+        hashBuf[((i<<2)|(j<<1))+1]=(s16>>8)&0xff;
+      }
+    }
+    hash=crc32(hash,hashBuf,EXPORT_BUFSIZE*4);
+    result.samples+=EXPORT_BUFSIZE;
+  }
+
+  std::chrono::high_resolution_clock::time_point timeEnd=std::chrono::high_resolution_clock::now();
+  bool finished=!playing;
+  if (playing) {
+    logW("song did not end after %g seconds",maxLength);
+    stop();
+  }
+
+  delete[] outBuf[0];
+  delete[] outBuf[1];
+  delete[] hashBuf;
+
+  result.renderTime=(double)(std::chrono::duration_cast<std::chrono::microseconds>(timeEnd-timeStart).count())/1000000.0;
+  result.hash=hash;
+  return finished;
+}
+
 double DivEngine::benchmarkSeek() {
   double t[20];
   curOrder=curSubSong->ordersLen-1;
@@ -368,7 +423,7 @@ void DivEngine::renderSamplesP(int whichSample) {
   BUSY_END;
 }
 
-void DivEngine::renderSamples(int whichSample) {
+void DivEngine::renderSamples(int whichSample, bool preRendered) {
   sPreview.sample=-1;
   sPreview.pos=0;
   sPreview.dir=false;
@@ -376,15 +431,12 @@ void DivEngine::renderSamples(int whichSample) {
   logD("rendering samples...");
 
   // step 0: make sample format mask
-  unsigned int formatMask=1U<<16; // 16-bit is always on
-  for (int i=0; i<song.systemLen; i++) {
-    const DivSysDef* s=getSystemDef(song.system[i]);
-    if (s==NULL) continue;
-    formatMask|=s->sampleFormatMask;
-  }
+  unsigned int formatMask=getSampleFormatMask();
 
   // step 1: render samples
-  if (whichSample==-1) {
+  if (preRendered) {
+    // already done by the caller
+  } else if (whichSample==-1) {
     for (int i=0; i<song.sampleLen; i++) {
       song.sample[i]->render(formatMask);
     }
@@ -393,8 +445,12 @@ void DivEngine::renderSamples(int whichSample) {
   }
 
   // step 2: render samples to dispatch
+  // if only one sample changed, try to update it in place first
   for (int i=0; i<song.systemLen; i++) {
     if (disCont[i].dispatch!=NULL) {
+      if (whichSample>=0 && whichSample<song.sampleLen) {
+        if (disCont[i].dispatch->renderSample(i,whichSample)) continue;
+      }
       disCont[i].dispatch->renderSamples(i);
     }
   }
@@ -795,6 +851,41 @@ int DivEngine::duplicateSubSong(int index) {
   return song.subsong.size()-1;
 }
 
+DivSong* DivEngine::makeSongSnapshot() {
+  BUSY_BEGIN;
+  saveLock.lock();
+  // copies everything but the pointers, which are replaced below
+  DivSong* ret=new DivSong(song);
+
+  for (size_t i=0; i<ret->ins.size(); i++) {
+    ret->ins[i]=new DivInstrument(*song.ins[i]);
+  }
+  for (size_t i=0; i<ret->wave.size(); i++) {
+    ret->wave[i]=new DivWavetable(*song.wave[i]);
+  }
+  for (size_t i=0; i<ret->sample.size(); i++) {
+    DivSample* copy=song.sample[i]->makeEditCopy();
+    if (copy==NULL) copy=new DivSample;
+    copy->name=song.sample[i]->name;
+    ret->sample[i]=copy;
+  }
+  for (size_t i=0; i<ret->subsong.size(); i++) {
+    DivSubSong* theOrig=song.subsong[i];
+    DivSubSong* theCopy=new DivSubSong(*theOrig);
+    for (int j=0; j<DIV_MAX_CHANS; j++) {
+      memset(theCopy->pat[j].data,0,DIV_MAX_PATTERNS*sizeof(void*));
+      for (int k=0; k<DIV_MAX_PATTERNS; k++) {
+        if (theOrig->pat[j].data[k]==NULL) continue;
+        theOrig->pat[j].data[k]->copyOn(theCopy->pat[j].getPattern(k,true));
+      }
+    }
+    ret->subsong[i]=theCopy;
+  }
+  saveLock.unlock();
+  BUSY_END;
+  return ret;
+}
+
 bool DivEngine::removeSubSong(int index) {
   if (song.subsong.size()<=1) return false;
   stop();
@@ -1450,7 +1541,6 @@ String DivEngine::getPlaybackDebugInfo() {
     "curRow: %d\n"
     "prevRow: %d\n"
     "ticks: %d\n"
-    "subticks: %d\n"
     "totalLoops: %d\n"
     "lastLoopPos: %d\n"
     "nextSpeed: %d\n"
@@ -1475,11 +1565,14 @@ String DivEngine::getPlaybackDebugInfo() {
     "extValue: %d\n"
     "tempoAccum: %d\n"
     "totalProcessed: %d\n"
-    "bufferPos: %d\n",
-    curOrder,prevOrder,curRow,prevRow,ticks,subticks,totalLoops,lastLoopPos,nextSpeed,divider,cycles,clockDrift,
+    "bufferPos: %d\n"
+    "cmdStreamOverflow: %d\n"
+    "renderBufGrowths: %d\n",
+    curOrder,prevOrder,curRow,prevRow,ticks,totalLoops,lastLoopPos,nextSpeed,divider,cycles,clockDrift,
     midiClockCycles,midiClockDrift,midiTimeCycles,midiTimeDrift,changeOrd,changePos,totalSeconds,totalTicks,
     totalTicksR,curMidiClock,curMidiTime,totalCmds,lastCmds,cmdsPerSecond,globalPitch,
-    (int)extValue,(int)tempoAccum,(int)totalProcessed,(int)bufferPos
+    (int)extValue,(int)tempoAccum,(int)totalProcessed,(int)bufferPos,
+    cmdStreamOverflow,renderBufGrowths
   );
 }
 
@@ -1590,8 +1683,8 @@ void DivEngine::getCommandStream(std::vector<DivCommand>& where) {
   BUSY_BEGIN;
   where.clear();
   where.reserve(cmdStream.size());
-  for (DivCommand& i: cmdStream) {
-    where.push_back(i);
+  for (size_t i=0; i<cmdStream.size(); i++) {
+    where.push_back(cmdStream[i]);
   }
   cmdStream.clear();
   BUSY_END;
@@ -1709,7 +1802,6 @@ void DivEngine::playSub(bool preserveDrift, int goalRow) {
   }
   if (!preserveDrift) {
     ticks=1;
-    subticks=1;
     prevOrder=curOrder;
     prevRow=curRow;
     tempoAccum=0;
@@ -2333,14 +2425,30 @@ float DivEngine::getGain(int ch, int vol) {
 }
 
 unsigned char DivEngine::getOrder() {
+  int order, row;
+  if (renderAheadOut!=NULL) {
+    if (renderAheadOut->getAudiblePos(order,row)) return order;
+  }
   return prevOrder;
 }
 
 int DivEngine::getRow() {
+  int order, row;
+  if (renderAheadOut!=NULL) {
+    if (renderAheadOut->getAudiblePos(order,row)) return row;
+  }
   return prevRow;
 }
 
 void DivEngine::getPlayPos(int& order, int& row) {
+  // when rendering ahead, report what is being heard rather than what is being rendered
+  if (renderAheadOut!=NULL) {
+    if (renderAheadOut->getAudiblePos(order,row)) return;
+  }
+  getRenderPos(order,row);
+}
+
+void DivEngine::getRenderPos(int& order, int& row) {
   playPosLock.lock();
   order=prevOrder;
   row=prevRow;
@@ -2359,6 +2467,11 @@ size_t DivEngine::getCurrentSubSong() {
   return curSubSongIndex;
 }
 
+DivSongTimeline* DivEngine::getTimeline() {
+  timeline.update(&song,curSubSongIndex,chans);
+  return &timeline;
+}
+
 const DivGroovePattern& DivEngine::getSpeeds() {
   return speeds;
 }
@@ -3603,6 +3716,84 @@ void DivEngine::lockEngine(const std::function<void()>& what) {
   BUSY_END;
 }
 
+void DivEngine::postEdit(DivEdit* edit, bool commit) {
+  editQueue.collect();
+  if (!editQueue.push(edit)) {
+    // queue is full - wait for the audio thread to catch up
+    editQueue.commit();
+    syncEdits();
+    if (!editQueue.push(edit)) {
+      logE("edit queue is full!");
+      delete edit;
+      return;
+    }
+  }
+  if (!commit) return;
+  editQueue.commit();
+
+  // nobody is going to call nextBuf() - apply the edit now
+  if (output==NULL && !exporting) {
+    BUSY_BEGIN;
+    editQueue.apply(this);
+    BUSY_END;
+    editQueue.collect();
+  }
+}
+
+void DivEngine::syncEdits() {
+  // wait up to ~250ms (a few buffers at worst)
+  for (int i=0; i<250; i++) {
+    if (!editQueue.pending()) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (editQueue.pending()) {
+    logW("audio thread did not apply edits in time. applying them now.");
+    BUSY_BEGIN;
+    editQueue.apply(this);
+    BUSY_END;
+  }
+  editQueue.collect();
+}
+
+bool DivEngine::editSample(int index, const std::function<bool(DivSample*)>& what) {
+  if (index<0 || index>=song.sampleLen) return false;
+  // the GUI is the only writer of sample data, so it can be read without locking
+  DivSample* copy=song.sample[index]->makeEditCopy();
+  if (copy==NULL) return false;
+
+  saveLock.lock();
+  if (!what(copy)) {
+    saveLock.unlock();
+    delete copy;
+    return false;
+  }
+  copy->render(getSampleFormatMask());
+
+  // updating chip sample memory is too expensive for the audio thread
+  bool inChipMemory=false;
+  for (int i=0; i<song.systemLen; i++) {
+    if (disCont[i].dispatch!=NULL && disCont[i].dispatch->getSampleMemCapacity(0)>0) {
+      inChipMemory=true;
+      break;
+    }
+  }
+  if (inChipMemory) {
+    BUSY_BEGIN;
+    song.sample[index]->swapData(copy);
+    renderSamples(index,true);
+    BUSY_END;
+    delete copy;
+    saveLock.unlock();
+    return true;
+  }
+
+  // the swap is done by the audio thread. wait for it so that the GUI sees the new data afterwards
+  postEdit(new DivSampleSwapEdit(index,copy));
+  syncEdits();
+  saveLock.unlock();
+  return true;
+}
+
 TAAudioDesc& DivEngine::getAudioDescWant() {
   return want;
 }
@@ -3611,6 +3802,26 @@ TAAudioDesc& DivEngine::getAudioDescGot() {
   return got;
 }
 
+size_t DivEngine::getPerfHistory(DivPerfSample* dest, size_t max) {
+  // the audio thread writes a slot and then advances perfPos.
+  // slots which may have been overwritten while copying are discarded afterwards.
+  size_t end=perfPos.load(std::memory_order_acquire);
+  size_t count=MIN(max,MIN(end,(size_t)DIV_PERF_HISTORY-1));
+  size_t begin=end-count;
+  for (size_t i=0; i<count; i++) {
+    dest[i]=perfHistory[(begin+i)%DIV_PERF_HISTORY];
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  size_t after=perfPos.load(std::memory_order_relaxed);
+  if (after+1>begin+DIV_PERF_HISTORY) {
+    size_t stale=after+1-(begin+DIV_PERF_HISTORY);
+    if (stale>=count) return 0;
+    memmove(dest,dest+stale,(count-stale)*sizeof(DivPerfSample));
+    count-=stale;
+  }
+  return count;
+}
+
 std::vector<String>& DivEngine::getAudioDevices() {
   return audioDevs;
 }
@@ -3652,6 +3863,7 @@ void DivEngine::initDispatch(bool isRender) {
 
   for (int i=0; i<song.systemLen; i++) {
     disCont[i].init(song.system[i],this,getChannelCount(song.system[i]),got.rate,song.systemFlags[i],isRender);
+    disCont[i].dispatch->setOscCapture(oscCapture);
     disCont[i].setRates(got.rate);
     disCont[i].setQuality(lowQuality,dcHiPass);
   }
@@ -3664,6 +3876,15 @@ void DivEngine::initDispatch(bool isRender) {
   BUSY_END;
 }
 
+void DivEngine::setOscCapture(bool enable) {
+  BUSY_BEGIN;
+  oscCapture=enable;
+  for (int i=0; i<song.systemLen; i++) {
+    if (disCont[i].dispatch!=NULL) disCont[i].dispatch->setOscCapture(enable);
+  }
+  BUSY_END;
+}
+
 void DivEngine::quitDispatch() {
   BUSY_BEGIN;
   logV("terminating dispatch...");
@@ -3699,6 +3920,7 @@ void DivEngine::quitDispatch() {
   curMidiTimePiece=0;
   totalCmds=0;
   lastCmds=0;
+  perfLastCmds=0;
   cmdsPerSecond=0;
   for (int i=0; i<DIV_MAX_CHANS; i++) {
     isMuted[i]=0;
@@ -3710,6 +3932,19 @@ void DivEngine::quitDispatch() {
   BUSY_END;
 }
 
+void DivEngine::reserveRenderBuffers(unsigned int size) {
+  if (metroBufLen<size || metroBuf==NULL) {
+    if (metroBuf!=NULL) delete[] metroBuf;
+    metroBuf=new float[size];
+    metroBufLen=size;
+  }
+  if (metroTickLen<size || metroTick==NULL) {
+    if (metroTick!=NULL) delete[] metroTick;
+    metroTick=new unsigned char[size];
+    metroTickLen=size;
+  }
+}
+
 bool DivEngine::initAudioBackend() {
   // load values
   logI("initializing audio.");
@@ -3747,6 +3982,8 @@ bool DivEngine::initAudioBackend() {
   if (previewVol<0.0f) previewVol=0.0f;
   if (previewVol>1.0f) previewVol=1.0f;
   renderPoolThreads=getConfInt("renderPoolThreads",0);
+  renderAheadBlocks=getConfInt("renderAhead",0);
+  if (renderAheadBlocks>DIV_RENDER_AHEAD_MAX) renderAheadBlocks=DIV_RENDER_AHEAD_MAX;
 
   if (lowLatency) logI("using low latency mode.");
 
@@ -3817,17 +4054,35 @@ bool DivEngine::initAudioBackend() {
   if (want.outChans>16) want.outChans=16;
 
   logV("setting callback");
-  output->setCallback(process,this);
+  if (renderAheadBlocks>0) {
+    renderAheadOut=new DivRenderAhead(this);
+    output->setCallback(DivRenderAhead::process,renderAheadOut);
+  } else {
+    output->setCallback(process,this);
+  }
 
   logV("calling init");
   if (!output->init(want,got)) {
     logE("error while initializing audio!");
     delete output;
     output=NULL;
+    if (renderAheadOut!=NULL) {
+      delete renderAheadOut;
+      renderAheadOut=NULL;
+    }
     audioEngine=DIV_AUDIO_NULL;
     return false;
   }
 
+  if (renderAheadOut!=NULL) {
+    if (!renderAheadOut->start(got.outChans,got.bufsize,renderAheadBlocks)) {
+      logW("could not start render-ahead thread! rendering in the audio callback.");
+      output->setCallback(process,this);
+      delete renderAheadOut;
+      renderAheadOut=NULL;
+    }
+  }
+
   logV("allocating oscBuf...");
   for (int i=0; i<got.outChans; i++) {
     if (oscBuf[i]==NULL) {
@@ -3836,6 +4091,9 @@ bool DivEngine::initAudioBackend() {
     memset(oscBuf[i],0,32768*sizeof(float));
   }
 
+  // so that nextBuf() doesn't allocate
+  reserveRenderBuffers(got.bufsize);
+
   logI("initializing MIDI.");
   if (output->initMidi(false)) {
     midiIns=output->midiIn->listDevices();
@@ -3876,6 +4134,11 @@ bool DivEngine::deinitAudioBackend(bool dueToSwitchMaster) {
   if (output!=NULL) {
     logI("closing audio output.");
     output->quit();
+    if (renderAheadOut!=NULL) {
+      renderAheadOut->stop();
+      delete renderAheadOut;
+      renderAheadOut=NULL;
+    }
     if (output->midiIn) {
       if (output->midiIn->isDeviceOpen()) {
         logI("closing MIDI input.");
@@ -4018,8 +4281,7 @@ bool DivEngine::init() {
   samp_bbIn=new short[32768];
   samp_bbInLen=32768;
 
-  metroBuf=new float[8192];
-  metroBufLen=8192;
+  reserveRenderBuffers(8192);
 
   logV("setting blip rate of samp_bb (%f)",got.rate);
   
@@ -4061,6 +4323,30 @@ bool DivEngine::init() {
   return true;
 }
 
+bool DivEngine::initRender(DivEngine* source, unsigned char* data, size_t len, DivConfig* overrides) {
+  // use the configuration of the source engine, but don't open any device
+  conf=source->conf;
+  configPath=source->configPath;
+  configLoaded=true;
+  conf.set("midiInDevice","");
+  conf.set("midiOutDevice","");
+  conf.set("renderAhead",0);
+  conf.set("renderPoolThreads",0);
+  if (overrides!=NULL) {
+    for (auto& i: overrides->configMap()) {
+      conf.set(i.first,i.second);
+    }
+  }
+  audioEngine=DIV_AUDIO_DUMMY;
+
+  if (!load(data,len,"render.fur")) {
+    return false;
+  }
+  // nothing displays the oscilloscope here
+  oscCapture=false;
+  return init();
+}
+
 bool DivEngine::quit(bool saveConfig) {
   deinitAudioBackend();
   quitDispatch();
@@ -4077,6 +4363,11 @@ bool DivEngine::quit(bool saveConfig) {
     metroBuf=NULL;
     metroBufLen=0;
   }
+  if (metroTick!=NULL) {
+    delete[] metroTick;
+    metroTick=NULL;
+    metroTickLen=0;
+  }
   if (yrw801ROM!=NULL) delete[] yrw801ROM;
   if (tg100ROM!=NULL) delete[] tg100ROM;
   if (mu5ROM!=NULL) delete[] mu5ROM;
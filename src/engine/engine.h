@@ -28,6 +28,9 @@
 #include "dataErrors.h"
 #include "safeWriter.h"
 #include "cmdStream.h"
+#include "timeline.h"
+#include "editQueue.h"
+#include "renderAhead.h"
 #include "../audio/taAudio.h"
 #include "blip_buf.h"
 #include <functional>
@@ -36,6 +39,7 @@
 #include "../fixedQueue.h"
 
 class DivWorkPool;
+class DivOscRender;
 
 #define addWarning(x) \
   if (warnings.empty()) { \
@@ -106,6 +110,60 @@ enum DivAudioExportFormats {
   DIV_EXPORT_FORMAT_F32
 };
 
+#define DIV_PERF_HISTORY 512
+
+// per-buffer performance counters, see DivEngine::getPerfHistory().
+// times are in nanoseconds.
+struct DivPerfSample {
+  unsigned int processTime;
+  // time available for this buffer (size/rate)
+  unsigned int budget;
+  // time the render pool's threads spent waiting for other chips
+  unsigned int workerIdle;
+  unsigned int chipTime[DIV_MAX_CHIPS];
+  unsigned int size;
+  unsigned int ticks;
+  unsigned int cmds;
+  unsigned int regWrites;
+  // underruns/overruns reported by the audio backend since the previous buffer
+  unsigned int xruns;
+  int chips;
+  DivPerfSample():
+    processTime(0),
+    budget(0),
+    workerIdle(0),
+    size(0),
+    ticks(0),
+    cmds(0),
+    regWrites(0),
+    xruns(0),
+    chips(0) {
+    memset(chipTime,0,DIV_MAX_CHIPS*sizeof(unsigned int));
+  }
+};
+
+// result of DivEngine::benchmarkRender().
+struct DivBenchResult {
+  // rendered samples (at the output rate)
+  size_t samples;
+  double rate;
+  // wall-clock time in seconds
+  double renderTime;
+  // time spent in each chip, in nanoseconds
+  uint64_t chipTime[DIV_MAX_CHIPS];
+  int chips;
+  // CRC-32 of the output as 16-bit stereo
+  unsigned int hash;
+  DivBenchResult():
+    samples(0),
+    rate(0.0),
+    renderTime(0.0),
+    chips(0),
+    hash(0) {
+    memset(chipTime,0,DIV_MAX_CHIPS*sizeof(uint64_t));
+  }
+};
+
 struct DivAudioExportOptions {
   DivAudioExportModes mode;
   DivAudioExportFormats format;
@@ -115,6 +173,8 @@ struct DivAudioExportOptions {
   double fadeOut;
   int orderBegin, orderEnd;
   bool channelMask[DIV_MAX_CHANS];
+  // if set, oscilloscope video is rendered alongside audio (not in per-channel mode)
+  DivOscRender* oscRender;
   DivAudioExportOptions():
     mode(DIV_EXPORT_MODE_ONE),
     format(DIV_EXPORT_FORMAT_S16),
@@ -123,15 +183,45 @@ struct DivAudioExportOptions {
     loops(0),
     fadeOut(0.0),
     orderBegin(-1),
-    orderEnd(-1) {
+    orderEnd(-1),
+    oscRender(NULL) {
     for (int i=0; i<DIV_MAX_CHANS; i++) {
       channelMask[i]=true;
     }
   }
 };
 
+// song metadata as read by DivEngine::scanSongInfo().
+struct DivSongInfo {
+  String name, author, album, systemName;
+  short version;
+  bool compressed;
+  std::vector<DivSystem> systems;
+  int insLen, waveLen, sampleLen, patterns, subSongs;
+  // first sub-song
+  int patLen, ordersLen;
+  float hz;
+  // length of the first sub-song in seconds (up to the loop point), or -1 if not calculated
+  double duration;
+  // whether the first sub-song loops (only valid if duration is calculated)
+  bool loops;
+  String error;
+  DivSongInfo():
+    version(0),
+    compressed(false),
+    insLen(0),
+    waveLen(0),
+    sampleLen(0),
+    patterns(0),
+    subSongs(1),
+    patLen(0),
+    ordersLen(0),
+    hz(60.0f),
+    duration(-1.0),
+    loops(false) {}
+};
+
 struct DivChannelState {
-  std::vector<DivDelayedCommand> delayed;
   int note, oldNote, lastIns, pitch, portaSpeed, portaNote;
   int volume, volSpeed, cut, volCut, legatoDelay, legatoTarget, rowDelay, volMax;
   int delayOrder, delayRow, retrigSpeed, retrigTick;
@@ -249,7 +339,8 @@ struct DivDispatchContainer {
   int temp[DIV_MAX_OUTPUTS], prevSample[DIV_MAX_OUTPUTS];
   short* bbInMapped[DIV_MAX_OUTPUTS];
   short* bbIn[DIV_MAX_OUTPUTS];
-  short* bbOut[DIV_MAX_OUTPUTS];
+  // not clamped to 16-bit, so that hot chips don't clip before mixing
+  int* bbOut[DIV_MAX_OUTPUTS];
   bool lowQuality, dcOffCompensation, hiPass;
   double rateMemory;
 
@@ -257,6 +348,9 @@ struct DivDispatchContainer {
   int cycles;
   unsigned int size;
 
+  // time spent in acquire() during the current buffer (in nanoseconds)
+  uint64_t acquireTime;
+
   void setRates(double gotRate);
   void setQuality(bool lowQual, bool dcHiPass);
   void grow(size_t size);
@@ -278,13 +372,14 @@ struct DivDispatchContainer {
     hiPass(true),
     rateMemory(0.0),
     cycles(0),
-    size(0) {
+    size(0),
+    acquireTime(0) {
     memset(bb,0,DIV_MAX_OUTPUTS*sizeof(blip_buffer_t*));
     memset(temp,0,DIV_MAX_OUTPUTS*sizeof(int));
     memset(prevSample,0,DIV_MAX_OUTPUTS*sizeof(int));
     memset(bbIn,0,DIV_MAX_OUTPUTS*sizeof(short*));
     memset(bbInMapped,0,DIV_MAX_OUTPUTS*sizeof(short*));
-    memset(bbOut,0,DIV_MAX_OUTPUTS*sizeof(short*));
+    memset(bbOut,0,DIV_MAX_OUTPUTS*sizeof(int*));
   }
 };
 
@@ -432,6 +527,11 @@ enum DivChanTypes {
 
 extern const char* cmdName[];
 
+// decodes a sample of a module being imported (see fileOps/fileOpsCommon.h).
+// may run on a work thread, so it must only touch what.sample.
+struct DivSampleToDecode;
+typedef void (*DivSampleDecoder)(const unsigned char* file, size_t len, DivSampleToDecode& what);
+
 class DivEngine {
   DivDispatchContainer disCont[DIV_MAX_CHIPS];
   TAAudio* output;
@@ -464,7 +564,8 @@ class DivEngine {
   bool midiIsDirect;
   bool midiIsDirectProgram;
   bool lowLatency;
-  bool systemsRegistered;
+  bool oscCapture;
+  static bool systemsRegistered;
   bool hasLoadedSomething;
   bool midiOutClock;
   bool midiOutTime;
@@ -473,7 +574,7 @@ class DivEngine {
   int midiOutTimeRate;
   float midiVolExp;
   int softLockCount;
-  int subticks, ticks, curRow, curOrder, prevRow, prevOrder, remainingLoops, totalLoops, lastLoopPos, exportLoopCount, nextSpeed, elapsedBars, elapsedBeats, curSpeed;
+  int ticks, curRow, curOrder, prevRow, prevOrder, remainingLoops, totalLoops, lastLoopPos, exportLoopCount, nextSpeed, elapsedBars, elapsedBeats, curSpeed;
   size_t curSubSongIndex;
   size_t bufferPos;
   double divider;
@@ -498,13 +599,24 @@ class DivEngine {
   DivAudioExportFormats exportFormat;
   double exportFadeOut;
   int exportOutputs;
+  int exportPass, exportPasses;
+  double exportLength;
   bool exportChannelMask[DIV_MAX_CHANS];
+  DivOscRender* exportOscRender;
   DivConfig conf;
+  DivSongTimeline timeline;
   FixedQueue<DivNoteEvent,8192> pendingNotes;
+  // commands captured by dispatchCmd() for the GUI and command stream export
+  FixedQueue<DivCommand,2048> cmdStream;
+  // number of commands dropped because cmdStream was full
+  unsigned int cmdStreamOverflow;
+  // number of times nextBuf() had to grow its buffers (see reserveRenderBuffers())
+  unsigned int renderBufGrowths;
   // bitfield
   unsigned char walked[8192];
   bool isMuted[DIV_MAX_CHANS];
   std::mutex isBusy, saveLock, playPosLock;
+  DivEditQueue editQueue;
   String configPath;
   String configFile;
   String lastError;
@@ -512,7 +624,6 @@ class DivEngine {
   std::vector<String> audioDevs;
   std::vector<String> midiIns;
   std::vector<String> midiOuts;
-  std::vector<DivCommand> cmdStream;
   std::vector<DivInstrumentType> possibleInsTypes;
   std::vector<DivEffectContainer> effectInst;
   static DivSysDef* sysDefs[DIV_MAX_CHIP_DEFS];
@@ -568,8 +679,17 @@ class DivEngine {
   size_t totalProcessed;
 
   unsigned int renderPoolThreads;
+  unsigned int renderAheadBlocks;
+  DivRenderAhead* renderAheadOut;
   DivWorkPool* renderPool;
 
+  // performance counters (written by nextBuf() only)
+  DivPerfSample perfHistory[DIV_PERF_HISTORY];
+  std::atomic<size_t> perfPos;
+  int perfLastCmds;
+  std::atomic<size_t> loadDecoded, loadToDecode;
+  unsigned int perfLastXRuns;
+
   // MIDI stuff
   std::function<int(const TAMidiMessage&)> midiCallback=[](const TAMidiMessage&) -> int {return -2;};
 
@@ -577,9 +697,15 @@ class DivEngine {
   void processRow(int i, bool afterDelay);
   void nextOrder();
   void nextRow();
-  void performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, size_t bankOffset, bool directStream);
+  void performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, unsigned short* sampleBlock, size_t bankOffset, bool directStream);
+  // grows the metronome buffers used by nextBuf() to hold at least size samples.
+  void reserveRenderBuffers(unsigned int size);
+  // applies queued note on/off events.
+  void processPendingNotes();
+  // runs a low-latency input sub-tick, which applies pending notes between ticks.
+  void nextInputTick();
   // returns true if end of song.
-  bool nextTick(bool noAccum=false, bool inhibitLowLat=false);
+  bool nextTick(bool noAccum=false);
   bool perSystemEffect(int ch, unsigned char effect, unsigned char effectVal);
   bool perSystemPostEffect(int ch, unsigned char effect, unsigned char effectVal);
   bool perSystemPreEffect(int ch, unsigned char effect, unsigned char effectVal);
@@ -603,6 +729,9 @@ class DivEngine {
   bool loadTFMv1(unsigned char* file, size_t len);
   bool loadTFMv2(unsigned char* file, size_t len);
 
+  // decode the samples of a module being imported, in parallel if worth it
+  void decodeSamples(std::vector<DivSampleToDecode>& samples, DivSampleDecoder decoder, const unsigned char* file, size_t len);
+
   void loadDMP(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
   void loadTFI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
   void loadVGI(SafeReader& reader, std::vector<DivInstrument*>& ret, String& stripPath);
@@ -649,11 +778,18 @@ class DivEngine {
 
   // read/write asset dir
   void putAssetDirData(SafeWriter* w, std::vector<DivAssetDir>& dir);
+  // serialize a song as .fur (see saveFur())
+  SafeWriter* saveFurSong(DivSong& song, int chans, bool notPrimary, bool newPatternFormat);
   DivDataErrors readAssetDirData(SafeReader& reader, std::vector<DivAssetDir>& dir);
 
+  // get the position of the last rendered buffer, regardless of render-ahead
+  void getRenderPos(int& order, int& row);
+
   // add every export method here
   friend class DivROMExport;
   friend class DivExportAmigaValidation;
+  friend struct DivSampleSwapEdit;
+  friend class DivRenderAhead;
 
   public:
     DivSong song;
@@ -669,7 +805,8 @@ class DivEngine {
     float* oscBuf[DIV_MAX_OUTPUTS];
     float oscSize;
     int oscReadPos, oscWritePos;
-    int tickMult;
+    // whether the current tick is a low-latency input sub-tick (see nextInputTick()).
+    bool inputTick;
     int lastNBIns, lastNBOuts, lastNBSize;
     std::atomic<size_t> processTime;
 
@@ -686,6 +823,11 @@ class DivEngine {
     void createNewFromDefaults();
     // load a file.
     bool load(unsigned char* f, size_t length, const char* nameHint=NULL);
+    // read the metadata of a Furnace module without loading it.
+    // only the beginning of the file is decompressed, unless the duration is requested,
+    // in which case patterns (but not instruments or samples) are decoded as well.
+    // this may be called from any thread after preInit().
+    bool scanSongInfo(const char* path, DivSongInfo& info, bool calcDuration=false);
     // play a binary command stream.
     bool playStream(unsigned char* f, size_t length);
     // get the playing stream.
@@ -696,7 +838,12 @@ class DivEngine {
     SafeWriter* saveDMF(unsigned char version);
     // save as .fur.
     // if notPrimary is true then the song will not be altered
-    SafeWriter* saveFur(bool notPrimary=false, bool newPatternFormat=true);
+    // if from is not NULL, that song (usually a snapshot) is saved instead of the current one
+    SafeWriter* saveFur(bool notPrimary=false, bool newPatternFormat=true, DivSong* from=NULL);
+    // make a copy of the song, so that it can be saved on another thread while it is being edited.
+    // call this from the thread which edits the song. the engine is only locked while copying.
+    // free the copy with unload() and delete.
+    DivSong* makeSongSnapshot();
     // build a ROM file (TODO).
     // specify system to build ROM for.
     std::vector<DivROMExportOutput> buildROM(DivROMExportOptions sys);
@@ -706,7 +853,8 @@ class DivEngine {
     // - x to add x+1 ticks of trailing
     // - -1 to auto-determine trailing
     // - -2 to add a whole loop of trailing
-    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1);
+    // set optimize to remove redundant register writes and data blocks.
+    SafeWriter* saveVGM(bool* sysToExport=NULL, bool loop=true, int version=0x171, bool patternHints=false, bool directStream=false, int trailingTicks=-1, bool optimize=true);
     // dump to ZSM.
     SafeWriter* saveZSM(unsigned int zsmrate=60, bool loop=true, bool optimize=true);
     // dump to TIunA.
@@ -746,6 +894,9 @@ class DivEngine {
     // benchmark (returns time in seconds)
     double benchmarkPlayback();
     double benchmarkSeek();
+    // render the current sub-song once as fast as possible (up to maxLength seconds),
+    // measuring time and hashing the output. used by the benchmark suite.
+    bool benchmarkRender(DivBenchResult& result, double maxLength=600.0);
 
     // returns the minimum VGM version which may carry the specified system, or 0 if none.
     int minVGMVersion(DivSystem which);
@@ -991,6 +1142,16 @@ class DivEngine {
     // is exporting
     bool isExporting();
 
+    // get export progress (0 to 1), or -1 if unknown
+    float getExportProgress();
+
+    // get sample decoding progress of the module being loaded (0 to 1), or -1 if not decoding
+    // may be called from another thread while load() runs
+    float getLoadProgress();
+
+    // get the timeline of the current sub-song, updating it if the song changed
+    DivSongTimeline* getTimeline();
+
     // add instrument
     int addInstrument(int refChan=0, DivInstrumentType fallbackType=DIV_INS_STD);
 
@@ -1160,6 +1321,10 @@ class DivEngine {
     // set the console mode.
     void setConsoleMode(bool enable, bool statusOut=true);
 
+    // enable or disable oscilloscope capture (in chips and in the master buffer).
+    // renders that don't display it (export, benchmark) may disable it.
+    void setOscCapture(bool enable);
+
     // get metronome
     bool getMetronome();
 
@@ -1194,7 +1359,8 @@ class DivEngine {
     unsigned int getSampleFormatMask();
 
     // UNSAFE render samples - only execute when locked
-    void renderSamples(int whichSample=-1);
+    // if preRendered is true, the sample formats are assumed to be up to date and only chip sample memory is updated
+    void renderSamples(int whichSample=-1, bool preRendered=false);
 
     // public render samples
     // values for whichSample
@@ -1300,12 +1466,48 @@ class DivEngine {
     // perform secure/sync song operation (and lock audio too)
     void lockEngine(const std::function<void()>& what);
 
+    /**
+     * post an edit, to be applied by the audio thread before the next buffer.
+     * if audio is not running, the edit is applied immediately.
+     * the engine takes ownership of the edit.
+     * @warning only call this from one thread (the GUI thread).
+     * @param edit the edit.
+     * @param commit whether to publish the edit now. pass false to group several edits so that they are applied in the same buffer.
+     */
+    void postEdit(DivEdit* edit, bool commit=true);
+
+    /**
+     * wait until all posted edits have been applied.
+     * if the audio thread doesn't pick them up in time, they are applied under the engine lock.
+     */
+    void syncEdits();
+
+    /**
+     * edit a sample without blocking the audio thread.
+     * the operation runs on a copy of the sample, which is then rendered and swapped in between two buffers.
+     * if a chip keeps the sample in its own memory, that memory is rebuilt under the engine lock instead.
+     * only do this for sample data/loop edits - use lockEngine() for anything that resizes the sample list.
+     * @param index the sample index.
+     * @param what the operation. return false to discard the copy.
+     * @return whether the sample was changed.
+     */
+    bool editSample(int index, const std::function<bool(DivSample*)>& what);
+
     // get audio desc want
     TAAudioDesc& getAudioDescWant();
 
     // get audio desc
     TAAudioDesc& getAudioDescGot();
 
+    /**
+     * get the most recent per-buffer performance counters.
+     * this does not lock the engine and may be called from any thread.
+     * @param dest where to write the samples to (oldest first).
+     * @param max the maximum number of samples to retrieve.
+     * @return the number of samples written.
+     */
+    size_t getPerfHistory(DivPerfSample* dest, size_t max);
+
     // init dispatch
     void initDispatch(bool isRender=false);
 
@@ -1321,6 +1523,13 @@ class DivEngine {
     // initialize the engine.
     bool init();
 
+    // initialize as a render-only copy of another engine (for exporting in the background).
+    // the configuration of source is used (without audio/MIDI devices), and the song is
+    // loaded from data, which is taken over.
+    // settings in overrides (if any) replace those of source.
+    // call quit(false) when done.
+    bool initRender(DivEngine* source, unsigned char* data, size_t len, DivConfig* overrides=NULL);
+
     // confirm that the engine is running (delete safe mode file).
     void everythingOK();
 
@@ -1360,7 +1569,7 @@ class DivEngine {
       midiIsDirect(false),
       midiIsDirectProgram(false),
       lowLatency(false),
-      systemsRegistered(false),
+      oscCapture(true),
       hasLoadedSomething(false),
       midiOutClock(false),
       midiOutTime(false),
@@ -1369,7 +1578,6 @@ class DivEngine {
       midiOutTimeRate(0),
       midiVolExp(2.0f), // General MIDI standard
       softLockCount(0),
-      subticks(0),
       ticks(0),
       curRow(0),
       curOrder(0),
@@ -1418,6 +1626,12 @@ class DivEngine {
       exportFormat(DIV_EXPORT_FORMAT_S16),
       exportFadeOut(0.0),
       exportOutputs(2),
+      exportPass(0),
+      exportPasses(1),
+      exportLength(0.0),
+      exportOscRender(NULL),
+      cmdStreamOverflow(0),
+      renderBufGrowths(0),
       cmdStreamInt(NULL),
       midiBaseChan(0),
       midiPoly(true),
@@ -1440,14 +1654,21 @@ class DivEngine {
       previewVol(1.0f),
       totalProcessed(0),
       renderPoolThreads(0),
+      renderAheadBlocks(0),
+      renderAheadOut(NULL),
       renderPool(NULL),
+      perfPos(0),
+      perfLastCmds(0),
+      loadDecoded(0),
+      loadToDecode(0),
+      perfLastXRuns(0),
       curOrders(NULL),
       curPat(NULL),
       tempIns(NULL),
       oscSize(1),
       oscReadPos(0),
       oscWritePos(0),
-      tickMult(1),
+      inputTick(false),
       lastNBIns(0),
       lastNBOuts(0),
       lastNBSize(0),
@@ -1466,16 +1687,10 @@ class DivEngine {
       memset(reversePitchTable,0,4096*sizeof(int));
       memset(pitchTable,0,4096*sizeof(int));
       memset(effectSlotMap,-1,4096*sizeof(short));
-      memset(sysDefs,0,DIV_MAX_CHIP_DEFS*sizeof(void*));
       memset(walked,0,8192);
       memset(oscBuf,0,DIV_MAX_OUTPUTS*(sizeof(float*)));
       memset(exportChannelMask,1,DIV_MAX_CHANS*sizeof(bool));
 
-      for (int i=0; i<DIV_MAX_CHIP_DEFS; i++) {
-        sysFileMapFur[i]=DIV_SYSTEM_NULL;
-        sysFileMapDMF[i]=DIV_SYSTEM_NULL;
-      }
-
       changeSong(0);
     }
 };
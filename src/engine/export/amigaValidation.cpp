@@ -101,7 +101,7 @@ std::vector<DivROMExportOutput> DivExportAmigaValidation::go(DivEngine* e) {
         //writeLoop=true;
       }
     }
-    if (e->nextTick(false,true)) {
+    if (e->nextTick()) {
       done=true;
       amiga->getRegisterWrites().clear();
       if (lastTick!=songTick) {
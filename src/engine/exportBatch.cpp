@@ -0,0 +1,223 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "exportBatch.h"
+#include "parallelDeflate.h"
+#include "workPool.h"
+#include "../fileutils.h"
+#include "../ta-log.h"
+#include <map>
+
+void DivExportBatch::add(const DivExportJob& job) {
+  jobs.push_back(job);
+}
+
+const std::vector<DivExportJob>& DivExportBatch::getJobs() {
+  return jobs;
+}
+
+int DivExportBatch::getProgress() {
+  return jobsDone;
+}
+
+String DivExportBatch::subSongPath(const String& path, int subSong) {
+  size_t extPos=path.rfind('.');
+  size_t sepPos=path.find_last_of("/\\");
+  if (extPos==String::npos || (sepPos!=String::npos && extPos<sepPos)) {
+    return fmt::sprintf("%s_%.2d",path,subSong+1);
+  }
+  return fmt::sprintf("%s_%.2d%s",path.substr(0,extPos),subSong+1,path.substr(extPos));
+}
+
+bool DivExportBatch::runJob(DivEngine* e, DivExportJob& job) {
+  if (job.subSong<0 || job.subSong>=(int)e->song.subsong.size()) {
+    job.error="invalid sub-song";
+    return false;
+  }
+  e->changeSongP(job.subSong);
+
+  SafeWriter* w=NULL;
+  switch (job.format) {
+    case DIV_EXPORT_JOB_AUDIO:
+      job.audio.oscRender=NULL;
+      if (!e->saveAudio(job.path.c_str(),job.audio)) {
+        job.error="could not export audio";
+        return false;
+      }
+      e->waitAudioFile();
+      job.ok=true;
+      return true;
+    case DIV_EXPORT_JOB_VGM: {
+      w=e->saveVGM(NULL,job.vgmLoop,job.vgmVersion,job.vgmPatternHints,job.vgmDirectStream,job.vgmTrailingTicks,job.vgmOptimize);
+      String ext=(job.path.size()>=4)?job.path.substr(job.path.size()-4):"";
+      for (char& i: ext) {
+        if (i>='A' && i<='Z') i+='a'-'A';
+      }
+      if (w!=NULL && ext==".vgz") {
+        SafeWriter* zw=deflateParallel(w->getFinalBuf(),w->size(),Z_BEST_COMPRESSION,1,true);
+        w->finish();
+        delete w;
+        w=zw;
+      }
+      break;
+    }
+    case DIV_EXPORT_JOB_ZSM:
+      w=e->saveZSM(job.zsmRate,job.zsmLoop,job.zsmOptimize);
+      break;
+    case DIV_EXPORT_JOB_CMD:
+      w=e->saveCommand();
+      break;
+  }
+  if (w==NULL) {
+    job.error=e->getLastError();
+    return false;
+  }
+
+  FILE* f=ps_fopen(job.path.c_str(),"wb");
+  if (f==NULL) {
+    job.error=strerror(errno);
+    w->finish();
+    delete w;
+    return false;
+  }
+  if (fwrite(w->getFinalBuf(),1,w->size(),f)!=w->size()) {
+    job.error=strerror(errno);
+  } else {
+    job.ok=true;
+  }
+  fclose(f);
+  w->finish();
+  delete w;
+  return job.ok;
+}
+
+void DivExportBatch::runTask(Task& task) {
+  DivEngine* e=new DivEngine;
+  unsigned char* data=new unsigned char[songLen];
+  memcpy(data,songData,songLen);
+
+  if (!e->initRender(source,data,songLen)) {
+    for (size_t i: task.jobs) {
+      jobs[i].error=fmt::sprintf("could not load song (%s)",e->getLastError());
+      jobsDone++;
+    }
+  } else {
+    for (size_t i: task.jobs) {
+      logD("exporting %s...",jobs[i].path);
+      runJob(e,jobs[i]);
+      jobsDone++;
+    }
+  }
+
+  e->quit(false);
+  delete e;
+}
+
+void DivExportBatch::worker(void* b) {
+  DivExportBatch* batch=(DivExportBatch*)b;
+  while (true) {
+    size_t i=batch->nextTask++;
+    if (i>=batch->tasks.size()) break;
+    batch->runTask(batch->tasks[i]);
+  }
+}
+
+bool DivExportBatch::run(unsigned int threads) {
+  // audio jobs take the longest, so they go first
+  std::vector<Task> captureTasks;
+  std::map<int,size_t> captureTaskOf;
+  tasks.clear();
+  for (size_t i=0; i<jobs.size(); i++) {
+    jobs[i].ok=false;
+    jobs[i].error="";
+    if (jobs[i].format==DIV_EXPORT_JOB_AUDIO) {
+      Task t;
+      t.jobs.push_back(i);
+      tasks.push_back(t);
+      continue;
+    }
+    auto it=captureTaskOf.find(jobs[i].subSong);
+    if (it==captureTaskOf.end()) {
+      captureTaskOf[jobs[i].subSong]=captureTasks.size();
+      Task t;
+      t.jobs.push_back(i);
+      captureTasks.push_back(t);
+    } else {
+      captureTasks[it->second].jobs.push_back(i);
+    }
+  }
+  tasks.insert(tasks.end(),captureTasks.begin(),captureTasks.end());
+  if (tasks.empty()) return true;
+
+  SafeWriter* w=source->saveFur(true);
+  if (w==NULL) {
+    for (DivExportJob& i: jobs) {
+      i.error="could not serialize song";
+    }
+    return false;
+  }
+  songLen=w->size();
+  songData=new unsigned char[songLen];
+  memcpy(songData,w->getFinalBuf(),songLen);
+  w->finish();
+  delete w;
+
+  if (threads==0) threads=std::thread::hardware_concurrency();
+  if (threads>tasks.size()) threads=tasks.size();
+  if (threads<1) threads=1;
+
+  logI("exporting %d files (%d engines, %d at once)...",(int)jobs.size(),(int)tasks.size(),threads);
+  nextTask=0;
+  jobsDone=0;
+  if (threads>1) {
+    DivWorkPool* pool=new DivWorkPool(threads);
+    for (unsigned int i=0; i<threads; i++) {
+      pool->push(worker,this);
+    }
+    pool->wait();
+    delete pool;
+  } else {
+    worker(this);
+  }
+
+  delete[] songData;
+  songData=NULL;
+  songLen=0;
+
+  bool ret=true;
+  for (DivExportJob& i: jobs) {
+    if (!i.ok) {
+      logE("could not export %s! (%s)",i.path,i.error);
+      ret=false;
+    }
+  }
+  return ret;
+}
+
+DivExportBatch::DivExportBatch(DivEngine* src):
+  source(src),
+  songData(NULL),
+  songLen(0),
+  nextTask(0),
+  jobsDone(0) {
+}
+
+DivExportBatch::~DivExportBatch() {
+  if (songData!=NULL) delete[] songData;
+}
@@ -0,0 +1,126 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _EXPORTBATCH_H
+#define _EXPORTBATCH_H
+
+#include "engine.h"
+#include <atomic>
+
+enum DivExportJobFormat {
+  DIV_EXPORT_JOB_AUDIO=0,
+  DIV_EXPORT_JOB_VGM,
+  DIV_EXPORT_JOB_ZSM,
+  DIV_EXPORT_JOB_CMD
+};
+
+struct DivExportJob {
+  DivExportJobFormat format;
+  int subSong;
+  String path;
+
+  // audio (oscRender is not supported)
+  DivAudioExportOptions audio;
+  // VGM (saved as gzip if path ends in .vgz)
+  int vgmVersion;
+  bool vgmLoop, vgmPatternHints, vgmDirectStream, vgmOptimize;
+  int vgmTrailingTicks;
+  // ZSM
+  unsigned int zsmRate;
+  bool zsmLoop, zsmOptimize;
+
+  // result
+  bool ok;
+  String error;
+
+  DivExportJob(DivExportJobFormat f=DIV_EXPORT_JOB_AUDIO, int sub=0, String p=""):
+    format(f),
+    subSong(sub),
+    path(p),
+    vgmVersion(0x171),
+    vgmLoop(true),
+    vgmPatternHints(false),
+    vgmDirectStream(false),
+    vgmOptimize(true),
+    vgmTrailingTicks(-1),
+    zsmRate(60),
+    zsmLoop(true),
+    zsmOptimize(true),
+    ok(false) {}
+};
+
+/**
+ * exports several sub-songs and/or formats at once.
+ *
+ * the song is serialized once and loaded into independent render-only engines,
+ * so the engine that owns it can keep playing and jobs run in parallel.
+ * register/command capture formats (VGM, ZSM, command stream) of the same sub-song
+ * share one engine and run one after another; each audio job gets its own engine.
+ */
+class DivExportBatch {
+  struct Task {
+    std::vector<size_t> jobs;
+  };
+
+  DivEngine* source;
+  std::vector<DivExportJob> jobs;
+  std::vector<Task> tasks;
+  unsigned char* songData;
+  size_t songLen;
+  std::atomic<size_t> nextTask;
+  std::atomic<int> jobsDone;
+
+  static void worker(void* b);
+  void runTask(Task& task);
+  bool runJob(DivEngine* e, DivExportJob& job);
+
+  public:
+    /**
+     * add a job.
+     */
+    void add(const DivExportJob& job);
+
+    /**
+     * run all jobs. blocks until they are finished.
+     * @param threads number of engines running at once. 0 means one per CPU core.
+     * @return whether all jobs succeeded (see getJobs() for details).
+     */
+    bool run(unsigned int threads=0);
+
+    /**
+     * get the jobs and their results.
+     */
+    const std::vector<DivExportJob>& getJobs();
+
+    /**
+     * get the number of finished jobs.
+     */
+    int getProgress();
+
+    /**
+     * insert a sub-song number before the extension of a file name
+     * (e.g. song.vgm becomes song_02.vgm).
+     */
+    static String subSongPath(const String& path, int subSong);
+
+    DivExportBatch(DivEngine* src);
+    ~DivExportBatch();
+};
+
+#endif
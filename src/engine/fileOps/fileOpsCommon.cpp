@@ -18,6 +18,13 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../backupStore.h"
+#include "../workPool.h"
+#include <algorithm>
+#include <chrono>
+
+// below this many bytes of sample data, starting threads costs more than it saves
+#define DIV_DECODE_PARALLEL_MIN 262144
 
 bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
   unsigned char* file;
@@ -139,6 +146,32 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
     len=slen;
   }
 
+  // step 1.5: reassemble backup (see DivBackupStore)
+  if (DivBackupStore::isManifest(file,len)) {
+    String dir=".";
+    if (nameHint!=NULL) {
+      String name=nameHint;
+      size_t sepPos=name.find_last_of("/\\");
+      if (sepPos!=String::npos) dir=name.substr(0,sepPos);
+    }
+    size_t restoredLen=0;
+    DivBackupStore store(dir);
+    unsigned char* restored=store.restore(file,len,restoredLen);
+    delete[] file;
+    if (restored==NULL) {
+      lastError="could not restore backup (missing or damaged data)";
+      return false;
+    }
+    file=restored;
+    len=restoredLen;
+    if (len<16 || memcmp(file,DIV_FUR_MAGIC,16)!=0) {
+      logE("restored backup is not a Furnace song!");
+      lastError="restored backup is not a Furnace song";
+      delete[] file;
+      return false;
+    }
+  }
+
   // step 2: try loading as .fur, .dmf, or another magic-ful format
   if (memcmp(file,DIV_DMF_MAGIC,16)==0) {
     return loadDMF(file,len); 
@@ -178,3 +211,76 @@ bool DivEngine::load(unsigned char* f, size_t slen, const char* nameHint) {
   delete[] file;
   return false;
 }
+
+struct SampleDecodeQueue {
+  DivSampleToDecode* samples;
+  size_t count;
+  std::atomic<size_t> next;
+  std::atomic<size_t>* done;
+  DivSampleDecoder decoder;
+  const unsigned char* file;
+  size_t len;
+};
+
+static void sampleDecodeWorker(void* q) {
+  SampleDecodeQueue* queue=(SampleDecodeQueue*)q;
+  while (true) {
+    size_t i=queue->next++;
+    if (i>=queue->count) break;
+    queue->decoder(queue->file,queue->len,queue->samples[i]);
+    (*queue->done)++;
+  }
+}
+
+void DivEngine::decodeSamples(std::vector<DivSampleToDecode>& samples, DivSampleDecoder decoder, const unsigned char* file, size_t len) {
+  if (samples.empty()) return;
+
+  size_t totalBytes=0;
+  for (DivSampleToDecode& i: samples) {
+    totalBytes+=i.len;
+  }
+
+  // largest first, so that a big sample doesn't end up running alone at the end
+  std::stable_sort(samples.begin(),samples.end(),[](const DivSampleToDecode& a, const DivSampleToDecode& b) -> bool {
+    return a.len>b.len;
+  });
+
+  unsigned int decodeThreads=0;
+  if (samples.size()>=2 && totalBytes>=DIV_DECODE_PARALLEL_MIN) {
+    decodeThreads=MIN(std::thread::hardware_concurrency(),(unsigned int)samples.size());
+    if (decodeThreads<2) decodeThreads=0;
+  }
+
+  std::chrono::steady_clock::time_point startTime=std::chrono::steady_clock::now();
+  loadDecoded=0;
+  loadToDecode=samples.size();
+
+  SampleDecodeQueue queue;
+  queue.samples=samples.data();
+  queue.count=samples.size();
+  queue.next=0;
+  queue.done=&loadDecoded;
+  queue.decoder=decoder;
+  queue.file=file;
+  queue.len=len;
+
+  if (decodeThreads>0) {
+    DivWorkPool* decodePool=new DivWorkPool(decodeThreads);
+    for (unsigned int i=0; i<decodeThreads; i++) {
+      decodePool->push(sampleDecodeWorker,&queue);
+    }
+    decodePool->wait();
+    delete decodePool;
+  } else {
+    sampleDecodeWorker(&queue);
+  }
+
+  loadToDecode=0;
+  logD("decoded %d samples (%d bytes) on %d threads in %dms",(int)samples.size(),(int)totalBytes,MAX(1,(int)decodeThreads),(int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-startTime).count());
+}
+
+float DivEngine::getLoadProgress() {
+  size_t total=loadToDecode;
+  if (total==0) return -1.0f;
+  return (float)loadDecoded/(float)total;
+}
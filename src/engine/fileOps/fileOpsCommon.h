@@ -46,6 +46,23 @@ struct NotZlibException {
     what(w) {}
 };
 
+// the data of a sample, to be decoded by DivEngine::decodeSamples() once the
+// structure of the module has been read.
+// the meaning of flags and param is up to the decoder.
+struct DivSampleToDecode {
+  DivSample* sample;
+  size_t pos;
+  size_t len;
+  unsigned int flags;
+  unsigned int param;
+  DivSampleToDecode(DivSample* s, size_t p, size_t l, unsigned int f=0, unsigned int pa=0):
+    sample(s),
+    pos(p),
+    len(l),
+    flags(f),
+    param(pa) {}
+};
+
 #define DIV_DMF_MAGIC ".DelekDefleMask."
 #define DIV_FUR_MAGIC "-Furnace module-"
 #define DIV_FTM_MAGIC "FamiTracker Module"
@@ -18,6 +18,10 @@
  */
 
 #include "fileOpsCommon.h"
+#include "../workPool.h"
+#include "../timeline.h"
+#include "../../fileutils.h"
+#include <algorithm>
 
 short newFormatNotes[180]={
   12, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, // -5
@@ -63,6 +67,373 @@ struct PatToWrite {
     pat(p) {}
 };
 
+enum FurChunkTypes {
+  FUR_CHUNK_INS=0,
+  FUR_CHUNK_WAVE,
+  FUR_CHUNK_SAMPLE,
+  FUR_CHUNK_PATTERN
+};
+
+enum FurChunkResults {
+  FUR_CHUNK_SUCCESS=0,
+  FUR_CHUNK_SEEK_ERROR,
+  FUR_CHUNK_INVALID,
+  FUR_CHUNK_EOF
+};
+
+// an instrument, wavetable, sample or pattern to be decoded by readFurChunk().
+struct FurChunkToRead {
+  FurChunkTypes type;
+  int index;
+  // for patterns this points to the data after the header
+  unsigned int ptr;
+  void* obj;
+  int subs, chan;
+  bool isNewFormat;
+  FurChunkResults result;
+  size_t endPos;
+  FurChunkToRead(FurChunkTypes t, int i, unsigned int p, void* o):
+    type(t),
+    index(i),
+    ptr(p),
+    obj(o),
+    subs(0),
+    chan(0),
+    isNewFormat(false),
+    result(FUR_CHUNK_SUCCESS),
+    endPos(0) {}
+};
+
+struct FurChunkReader {
+  const unsigned char* file;
+  size_t len;
+  short version;
+  DivSong* song;
+  FurChunkToRead* chunks;
+  size_t count;
+  std::atomic<size_t> next;
+  FurChunkReader(const unsigned char* f, size_t l, short v, DivSong* s, FurChunkToRead* c, size_t n):
+    file(f),
+    len(l),
+    version(v),
+    song(s),
+    chunks(c),
+    count(n),
+    next(0) {}
+};
+
+// decode a single chunk. this only touches the chunk's own object, so it may run on any thread.
+static void readFurChunk(const unsigned char* file, size_t len, short version, DivSong* ds, FurChunkToRead& c) {
+  SafeReader reader=SafeReader(file,len);
+  try {
+    if (!reader.seek(c.ptr,SEEK_SET)) {
+      c.result=FUR_CHUNK_SEEK_ERROR;
+      return;
+    }
+    switch (c.type) {
+      case FUR_CHUNK_INS:
+        logD("reading instrument %d at %x...",c.index,c.ptr);
+        if (((DivInstrument*)c.obj)->readInsData(reader,version)!=DIV_DATA_SUCCESS) {
+          c.result=FUR_CHUNK_INVALID;
+          return;
+        }
+        break;
+      case FUR_CHUNK_WAVE:
+        logD("reading wavetable %d at %x...",c.index,c.ptr);
+        if (((DivWavetable*)c.obj)->readWaveData(reader,version)!=DIV_DATA_SUCCESS) {
+          c.result=FUR_CHUNK_INVALID;
+          return;
+        }
+        break;
+      case FUR_CHUNK_SAMPLE:
+        if (((DivSample*)c.obj)->readSampleData(reader,version)!=DIV_DATA_SUCCESS) {
+          c.result=FUR_CHUNK_INVALID;
+          return;
+        }
+        break;
+      case FUR_CHUNK_PATTERN: {
+        DivPattern* pat=(DivPattern*)c.obj;
+        DivSubSong* sub=ds->subsong[c.subs];
+        if (c.isNewFormat) {
+          pat->name=reader.readString();
+
+          // read new pattern
+          for (int j=0; j<sub->patLen; j++) {
+            unsigned char mask=reader.readC();
+            unsigned short effectMask=0;
+
+            if (mask==0xff) break;
+            if (mask&128) {
+              j+=(mask&127)+1;
+              continue;
+            }
+
+            if (mask&32) {
+              effectMask|=(unsigned char)reader.readC();
+            }
+            if (mask&64) {
+              effectMask|=((unsigned short)reader.readC()&0xff)<<8;
+            }
+            if (mask&8) effectMask|=1;
+            if (mask&16) effectMask|=2;
+
+            if (mask&1) { // note
+              unsigned char note=reader.readC();
+              if (note==180) {
+                pat->data[j][0]=100;
+                pat->data[j][1]=0;
+              } else if (note==181) {
+                pat->data[j][0]=101;
+                pat->data[j][1]=0;
+              } else if (note==182) {
+                pat->data[j][0]=102;
+                pat->data[j][1]=0;
+              } else if (note<180) {
+                pat->data[j][0]=newFormatNotes[note];
+                pat->data[j][1]=newFormatOctaves[note];
+              } else {
+                pat->data[j][0]=0;
+                pat->data[j][1]=0;
+              }
+            }
+            if (mask&2) { // instrument
+              pat->data[j][2]=(unsigned char)reader.readC();
+            }
+            if (mask&4) { // volume
+              pat->data[j][3]=(unsigned char)reader.readC();
+            }
+            for (unsigned char k=0; k<16; k++) {
+              if (effectMask&(1<<k)) {
+                pat->data[j][4+k]=(unsigned char)reader.readC();
+              }
+            }
+          }
+        } else {
+          for (int j=0; j<sub->patLen; j++) {
+            pat->data[j][0]=reader.readS();
+            pat->data[j][1]=reader.readS();
+            pat->data[j][2]=reader.readS();
+            pat->data[j][3]=reader.readS();
+            for (int k=0; k<sub->pat[c.chan].effectCols; k++) {
+              pat->data[j][4+(k<<1)]=reader.readS();
+              pat->data[j][5+(k<<1)]=reader.readS();
+            }
+            if (pat->data[j][0]==0 && pat->data[j][1]!=0) {
+              logD("what? %d:%d:%d note %d octave %d",c.chan,c.ptr,j,pat->data[j][0],pat->data[j][1]);
+              pat->data[j][0]=12;
+              pat->data[j][1]--;
+            }
+          }
+
+          if (version>=51) {
+            pat->name=reader.readString();
+          }
+        }
+        break;
+      }
+    }
+  } catch (EndOfFileException& e) {
+    c.result=FUR_CHUNK_EOF;
+    return;
+  }
+  c.endPos=reader.tell();
+}
+
+static void furChunkWorker(void* r) {
+  FurChunkReader* cr=(FurChunkReader*)r;
+  while (true) {
+    size_t i=cr->next++;
+    if (i>=cr->count) break;
+    readFurChunk(cr->file,cr->len,cr->version,cr->song,cr->chunks[i]);
+  }
+}
+
+// an instrument, wavetable, sample or pattern to be serialized by putFurChunk().
+struct FurChunkToWrite {
+  FurChunkTypes type;
+  int index;
+  SafeWriter* w;
+  FurChunkToWrite(FurChunkTypes t, int i):
+    type(t),
+    index(i),
+    w(NULL) {}
+};
+
+struct FurChunkWriter {
+  DivSong* song;
+  std::vector<PatToWrite>* pats;
+  bool newPatternFormat;
+  FurChunkToWrite* chunks;
+  size_t count;
+  std::atomic<size_t> next;
+};
+
+static void putFurPattern(SafeWriter* w, DivSong* song, const PatToWrite& i, bool newPatternFormat) {
+  size_t blockStartSeek, blockEndSeek;
+  DivPattern* pat=song->subsong[i.subsong]->pat[i.chan].getPattern(i.pat,false);
+
+  if (newPatternFormat) {
+    w->write("PATN",4);
+    blockStartSeek=w->tell();
+    w->writeI(0);
+
+    w->writeC(i.subsong);
+    w->writeC(i.chan);
+    w->writeS(i.pat);
+    w->writeString(pat->name,false);
+
+    unsigned char emptyRows=0;
+
+    for (int j=0; j<song->subsong[i.subsong]->patLen; j++) {
+      unsigned char mask=0;
+      unsigned char finalNote=255;
+      unsigned short effectMask=0;
+
+      if (pat->data[j][0]==100) {
+        finalNote=180;
+      } else if (pat->data[j][0]==101) { // note release
+        finalNote=181;
+      } else if (pat->data[j][0]==102) { // macro release
+        finalNote=182;
+      } else if (pat->data[j][1]==0 && pat->data[j][0]==0) {
+        finalNote=255;
+      } else {
+        int seek=(pat->data[j][0]+(signed char)pat->data[j][1]*12)+60;
+        if (seek<0 || seek>=180) {
+          finalNote=255;
+        } else {
+          finalNote=seek;
+        }
+      }
+
+      if (finalNote!=255) mask|=1; // note
+      if (pat->data[j][2]!=-1) mask|=2; // instrument
+      if (pat->data[j][3]!=-1) mask|=4; // volume
+      for (int k=0; k<song->subsong[i.subsong]->pat[i.chan].effectCols*2; k+=2) {
+        if (k==0) {
+          if (pat->data[j][4+k]!=-1) mask|=8;
+          if (pat->data[j][5+k]!=-1) mask|=16;
+        } else if (k<8) {
+          if (pat->data[j][4+k]!=-1 || pat->data[j][5+k]!=-1) mask|=32;
+        } else {
+          if (pat->data[j][4+k]!=-1 || pat->data[j][5+k]!=-1) mask|=64;
+        }
+
+        if (pat->data[j][4+k]!=-1) effectMask|=(1<<k);
+        if (pat->data[j][5+k]!=-1) effectMask|=(2<<k);
+      }
+
+      if (mask==0) {
+        emptyRows++;
+        if (emptyRows>127) {
+          w->writeC(128|(emptyRows-2));
+          emptyRows=0;
+        }
+      } else {
+        if (emptyRows>1) {
+          w->writeC(128|(emptyRows-2));
+          emptyRows=0;
+        } else if (emptyRows) {
+          w->writeC(0);
+          emptyRows=0;
+        }
+
+        w->writeC(mask);
+
+        if (mask&32) w->writeC(effectMask&0xff);
+        if (mask&64) w->writeC((effectMask>>8)&0xff);
+
+        if (mask&1) w->writeC(finalNote);
+        if (mask&2) w->writeC(pat->data[j][2]);
+        if (mask&4) w->writeC(pat->data[j][3]);
+        if (mask&8) w->writeC(pat->data[j][4]);
+        if (mask&16) w->writeC(pat->data[j][5]);
+        if (mask&32) {
+          if (effectMask&4) w->writeC(pat->data[j][6]);
+          if (effectMask&8) w->writeC(pat->data[j][7]);
+          if (effectMask&16) w->writeC(pat->data[j][8]);
+          if (effectMask&32) w->writeC(pat->data[j][9]);
+          if (effectMask&64) w->writeC(pat->data[j][10]);
+          if (effectMask&128) w->writeC(pat->data[j][11]);
+        }
+        if (mask&64) {
+          if (effectMask&256) w->writeC(pat->data[j][12]);
+          if (effectMask&512) w->writeC(pat->data[j][13]);
+          if (effectMask&1024) w->writeC(pat->data[j][14]);
+          if (effectMask&2048) w->writeC(pat->data[j][15]);
+          if (effectMask&4096) w->writeC(pat->data[j][16]);
+          if (effectMask&8192) w->writeC(pat->data[j][17]);
+          if (effectMask&16384) w->writeC(pat->data[j][18]);
+          if (effectMask&32768) w->writeC(pat->data[j][19]);
+        }
+      }
+    }
+
+    // stop
+    w->writeC(0xff);
+  } else {
+    w->write("PATR",4);
+    blockStartSeek=w->tell();
+    w->writeI(0);
+
+    w->writeS(i.chan);
+    w->writeS(i.pat);
+    w->writeS(i.subsong);
+
+    w->writeS(0); // reserved
+
+    for (int j=0; j<song->subsong[i.subsong]->patLen; j++) {
+      w->writeS(pat->data[j][0]); // note
+      w->writeS(pat->data[j][1]); // octave
+      w->writeS(pat->data[j][2]); // instrument
+      w->writeS(pat->data[j][3]); // volume
+#ifdef TA_BIG_ENDIAN
+      for (int k=0; k<song->subsong[i.subsong]->pat[i.chan].effectCols*2; k++) {
+        w->writeS(pat->data[j][4+k]);
+      }
+#else
+      w->write(&pat->data[j][4],2*song->subsong[i.subsong]->pat[i.chan].effectCols*2); // effects
+#endif
+    }
+
+    w->writeString(pat->name,false);
+  }
+
+  blockEndSeek=w->tell();
+  w->seek(blockStartSeek,SEEK_SET);
+  w->writeI(blockEndSeek-blockStartSeek-4);
+  w->seek(0,SEEK_END);
+}
+
+static void putFurChunk(SafeWriter* w, DivSong* song, std::vector<PatToWrite>& pats, bool newPatternFormat, FurChunkToWrite& c) {
+  switch (c.type) {
+    case FUR_CHUNK_INS:
+      song->ins[c.index]->putInsData2(w,false);
+      break;
+    case FUR_CHUNK_WAVE:
+      song->wave[c.index]->putWaveData(w);
+      break;
+    case FUR_CHUNK_SAMPLE:
+      song->sample[c.index]->putSampleData(w);
+      break;
+    case FUR_CHUNK_PATTERN:
+      putFurPattern(w,song,pats[c.index],newPatternFormat);
+      break;
+  }
+}
+
+static void furChunkWriteWorker(void* cw) {
+  FurChunkWriter* writer=(FurChunkWriter*)cw;
+  while (true) {
+    size_t i=writer->next++;
+    if (i>=writer->count) break;
+    FurChunkToWrite& c=writer->chunks[i];
+    c.w=new SafeWriter;
+    c.w->init();
+    putFurChunk(c.w,writer->song,*writer->pats,writer->newPatternFormat,c);
+  }
+}
+
 void DivEngine::putAssetDirData(SafeWriter* w, std::vector<DivAssetDir>& dir) {
   size_t blockStartSeek, blockEndSeek;
 
@@ -1621,82 +1992,39 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
       }
     }
 
-    // read instruments
+    // read instruments, wavetables, samples and patterns.
+    // every one of these chunks is self-contained, so they are decoded in parallel
+    // into preallocated objects.
+    std::vector<FurChunkToRead> chunks;
+    std::vector<FurChunkToRead> serialChunks;
+    chunks.reserve(ds.insLen+ds.waveLen+ds.sampleLen+patPtr.size());
+
     ds.ins.reserve(ds.insLen);
     for (int i=0; i<ds.insLen; i++) {
       DivInstrument* ins=new DivInstrument;
-      logD("reading instrument %d at %x...",i,insPtr[i]);
-      if (!reader.seek(insPtr[i],SEEK_SET)) {
-        logE("couldn't seek to instrument %d!",i);
-        lastError=fmt::sprintf("couldn't seek to instrument %d!",i);
-        ds.unload();
-        delete ins;
-        delete[] file;
-        return false;
-      }
-      
-      if (ins->readInsData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid instrument header/data!";
-        ds.unload();
-        delete ins;
-        delete[] file;
-        return false;
-      }
-
       ds.ins.push_back(ins);
+      chunks.push_back(FurChunkToRead(FUR_CHUNK_INS,i,insPtr[i],ins));
     }
 
-    // read wavetables
     ds.wave.reserve(ds.waveLen);
     for (int i=0; i<ds.waveLen; i++) {
       DivWavetable* wave=new DivWavetable;
-      logD("reading wavetable %d at %x...",i,wavePtr[i]);
-      if (!reader.seek(wavePtr[i],SEEK_SET)) {
-        logE("couldn't seek to wavetable %d!",i);
-        lastError=fmt::sprintf("couldn't seek to wavetable %d!",i);
-        ds.unload();
-        delete wave;
-        delete[] file;
-        return false;
-      }
-
-      if (wave->readWaveData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid wavetable header/data!";
-        ds.unload();
-        delete wave;
-        delete[] file;
-        return false;
-      }
-
       ds.wave.push_back(wave);
+      chunks.push_back(FurChunkToRead(FUR_CHUNK_WAVE,i,wavePtr[i],wave));
     }
 
-    // read samples
     ds.sample.reserve(ds.sampleLen);
     for (int i=0; i<ds.sampleLen; i++) {
       DivSample* sample=new DivSample;
-
-      if (!reader.seek(samplePtr[i],SEEK_SET)) {
-        logE("couldn't seek to sample %d!",i);
-        lastError=fmt::sprintf("couldn't seek to sample %d!",i);
-        ds.unload();
-        delete sample;
-        delete[] file;
-        return false;
-      }
-
-      if (sample->readSampleData(reader,ds.version)!=DIV_DATA_SUCCESS) {
-        lastError="invalid sample header/data!";
-        ds.unload();
-        delete sample;
-        delete[] file;
-        return false;
-      }
-
       ds.sample.push_back(sample);
+      chunks.push_back(FurChunkToRead(FUR_CHUNK_SAMPLE,i,samplePtr[i],sample));
     }
 
-    // read patterns
+    // pattern headers are read here, since patterns are allocated on demand.
+    // if a pattern appears more than once, its chunks are decoded in order afterwards.
+    std::vector<DivPattern*> patTargets;
+    std::vector<bool> patDuplicate;
+    patTargets.reserve(patPtr.size());
     for (unsigned int i: patPtr) {
       bool isNewFormat=false;
       if (!reader.seek(i,SEEK_SET)) {
@@ -1721,93 +2049,18 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
       }
       reader.readI();
 
+      int subs=0;
+      int chan=0;
+      int index=0;
       if (isNewFormat) {
-        int subs=(unsigned char)reader.readC();
-        int chan=(unsigned char)reader.readC();
-        int index=reader.readS();
+        subs=(unsigned char)reader.readC();
+        chan=(unsigned char)reader.readC();
+        index=reader.readS();
 
         logD("- %d, %d, %d (new)",subs,chan,index);
-
-        if (chan<0 || chan>=tchans) {
-          logE("pattern channel out of range!",i);
-          lastError="pattern channel out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
-          logE("pattern index out of range!",i);
-          lastError="pattern index out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (subs<0 || subs>=(int)ds.subsong.size()) {
-          logE("pattern subsong out of range!",i);
-          lastError="pattern subsong out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-
-        DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
-        pat->name=reader.readString();
-
-        // read new pattern
-        for (int j=0; j<ds.subsong[subs]->patLen; j++) {
-          unsigned char mask=reader.readC();
-          unsigned short effectMask=0;
-
-          if (mask==0xff) break;
-          if (mask&128) {
-            j+=(mask&127)+1;
-            continue;
-          }
-
-          if (mask&32) {
-            effectMask|=(unsigned char)reader.readC();
-          }
-          if (mask&64) {
-            effectMask|=((unsigned short)reader.readC()&0xff)<<8;
-          }
-          if (mask&8) effectMask|=1;
-          if (mask&16) effectMask|=2;
-
-          if (mask&1) { // note
-            unsigned char note=reader.readC();
-            if (note==180) {
-              pat->data[j][0]=100;
-              pat->data[j][1]=0;
-            } else if (note==181) {
-              pat->data[j][0]=101;
-              pat->data[j][1]=0;
-            } else if (note==182) {
-              pat->data[j][0]=102;
-              pat->data[j][1]=0;
-            } else if (note<180) {
-              pat->data[j][0]=newFormatNotes[note];
-              pat->data[j][1]=newFormatOctaves[note];
-            } else {
-              pat->data[j][0]=0;
-              pat->data[j][1]=0;
-            }
-          }
-          if (mask&2) { // instrument
-            pat->data[j][2]=(unsigned char)reader.readC();
-          }
-          if (mask&4) { // volume
-            pat->data[j][3]=(unsigned char)reader.readC();
-          }
-          for (unsigned char k=0; k<16; k++) {
-            if (effectMask&(1<<k)) {
-              pat->data[j][4+k]=(unsigned char)reader.readC();
-            }
-          }
-        }
       } else {
-        int chan=reader.readS();
-        int index=reader.readS();
-        int subs=0;
+        chan=reader.readS();
+        index=reader.readS();
         if (ds.version>=95) {
           subs=reader.readS();
         } else {
@@ -1816,55 +2069,120 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
         reader.readS();
 
         logD("- %d, %d, %d (old)",subs,chan,index);
+      }
 
-        if (chan<0 || chan>=tchans) {
-          logE("pattern channel out of range!",i);
-          lastError="pattern channel out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
-          logE("pattern index out of range!",i);
-          lastError="pattern index out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
-        if (subs<0 || subs>=(int)ds.subsong.size()) {
-          logE("pattern subsong out of range!",i);
-          lastError="pattern subsong out of range!";
-          ds.unload();
-          delete[] file;
-          return false;
-        }
+      if (chan<0 || chan>=tchans) {
+        logE("pattern channel out of range!",i);
+        lastError="pattern channel out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
+      if (index<0 || index>(DIV_MAX_PATTERNS-1)) {
+        logE("pattern index out of range!",i);
+        lastError="pattern index out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
+      if (subs<0 || subs>=(int)ds.subsong.size()) {
+        logE("pattern subsong out of range!",i);
+        lastError="pattern subsong out of range!";
+        ds.unload();
+        delete[] file;
+        return false;
+      }
 
-        DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
-        for (int j=0; j<ds.subsong[subs]->patLen; j++) {
-          pat->data[j][0]=reader.readS();
-          pat->data[j][1]=reader.readS();
-          pat->data[j][2]=reader.readS();
-          pat->data[j][3]=reader.readS();
-          for (int k=0; k<ds.subsong[subs]->pat[chan].effectCols; k++) {
-            pat->data[j][4+(k<<1)]=reader.readS();
-            pat->data[j][5+(k<<1)]=reader.readS();
-          }
-          if (pat->data[j][0]==0 && pat->data[j][1]!=0) {
-            logD("what? %d:%d:%d note %d octave %d",chan,i,j,pat->data[j][0],pat->data[j][1]);
-            pat->data[j][0]=12;
-            pat->data[j][1]--;
-          }
+      DivPattern* pat=ds.subsong[subs]->pat[chan].getPattern(index,true);
+      FurChunkToRead chunk(FUR_CHUNK_PATTERN,patTargets.size(),reader.tell(),pat);
+      chunk.subs=subs;
+      chunk.chan=chan;
+      chunk.isNewFormat=isNewFormat;
+      patTargets.push_back(pat);
+      chunks.push_back(chunk);
+    }
+
+    // find duplicate patterns
+    std::vector<DivPattern*> sortedTargets=patTargets;
+    std::sort(sortedTargets.begin(),sortedTargets.end());
+    bool anyDuplicate=(std::adjacent_find(sortedTargets.begin(),sortedTargets.end())!=sortedTargets.end());
+    if (anyDuplicate) {
+      std::vector<FurChunkToRead> parallelChunks;
+      parallelChunks.reserve(chunks.size());
+      for (FurChunkToRead& i: chunks) {
+        if (i.type==FUR_CHUNK_PATTERN && std::count(sortedTargets.begin(),sortedTargets.end(),(DivPattern*)i.obj)>1) {
+          serialChunks.push_back(i);
+        } else {
+          parallelChunks.push_back(i);
         }
+      }
+      chunks=parallelChunks;
+    }
 
-        if (ds.version>=51) {
-          pat->name=reader.readString();
+    unsigned int loadThreads=0;
+    if (chunks.size()>=16) {
+      loadThreads=MIN(std::thread::hardware_concurrency(),(unsigned int)chunks.size()/8);
+      if (loadThreads<2) loadThreads=0;
+    }
+    FurChunkReader chunkReader(file,len,ds.version,&ds,chunks.data(),chunks.size());
+    if (loadThreads>0) {
+      logD("decoding %d chunks on %d threads...",(int)chunks.size(),loadThreads);
+      DivWorkPool* loadPool=new DivWorkPool(loadThreads);
+      for (unsigned int i=0; i<loadThreads; i++) {
+        loadPool->push(furChunkWorker,&chunkReader);
+      }
+      loadPool->wait();
+      delete loadPool;
+    } else {
+      furChunkWorker(&chunkReader);
+    }
+    for (FurChunkToRead& i: serialChunks) {
+      readFurChunk(file,len,ds.version,&ds,i);
+      chunks.push_back(i);
+    }
+
+    // report the first error in file order
+    size_t lastEndPos=reader.tell();
+    if (!chunks.empty()) {
+      std::stable_sort(chunks.begin(),chunks.end(),[](const FurChunkToRead& a, const FurChunkToRead& b) -> bool {
+        if (a.type!=b.type) return a.type<b.type;
+        return a.index<b.index;
+      });
+      for (FurChunkToRead& i: chunks) {
+        if (i.result==FUR_CHUNK_SUCCESS) continue;
+        const char* chunkName="pattern";
+        switch (i.type) {
+          case FUR_CHUNK_INS:
+            chunkName="instrument";
+            break;
+          case FUR_CHUNK_WAVE:
+            chunkName="wavetable";
+            break;
+          case FUR_CHUNK_SAMPLE:
+            chunkName="sample";
+            break;
+          default:
+            break;
+        }
+        if (i.result==FUR_CHUNK_EOF) {
+          logE("premature end of file!");
+          lastError="incomplete file";
+        } else if (i.result==FUR_CHUNK_SEEK_ERROR) {
+          logE("couldn't seek to %s %d!",chunkName,i.index);
+          lastError=fmt::sprintf("couldn't seek to %s %d!",chunkName,i.index);
+        } else {
+          lastError=fmt::sprintf("invalid %s header/data!",chunkName);
         }
+        ds.unload();
+        delete[] file;
+        return false;
       }
+      lastEndPos=chunks.back().endPos;
     }
 
-    if (reader.tell()<reader.size()) {
-      if ((reader.tell()+1)!=reader.size()) {
-        logW("premature end of song (we are at %x, but size is %x)",reader.tell(),reader.size());
+    if (lastEndPos<reader.size()) {
+      if ((lastEndPos+1)!=reader.size()) {
+        logW("premature end of song (we are at %x, but size is %x)",lastEndPos,reader.size());
       }
     }
 
@@ -2122,7 +2440,17 @@ bool DivEngine::loadFur(unsigned char* file, size_t len, int variantID) {
   return true;
 }
 
-SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat) {
+SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat, DivSong* from) {
+  if (from==NULL) return saveFurSong(song,chans,notPrimary,newPatternFormat);
+  int fromChans=0;
+  for (int i=0; i<from->systemLen; i++) {
+    fromChans+=getChannelCount(from->system[i]);
+  }
+  return saveFurSong(*from,MIN(fromChans,DIV_MAX_CHANS),true,newPatternFormat);
+}
+
+// song and chans hide the members of the same name, so that a snapshot can be saved
+SafeWriter* DivEngine::saveFurSong(DivSong& song, int chans, bool notPrimary, bool newPatternFormat) {
   saveLock.lock();
   std::vector<int> subSongPtr;
   std::vector<int> sysFlagsPtr;
@@ -2543,167 +2871,75 @@ SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat) {
   assetDirPtr[2]=w->tell();
   putAssetDirData(w,song.sampleDir);
 
-  /// INSTRUMENT
-  insPtr.reserve(song.insLen);
+  /// INSTRUMENT, WAVETABLE, SAMPLE AND PATTERN
+  // these are independent of each other, so they are serialized in parallel
+  // into separate writers and then appended in order.
+  std::vector<FurChunkToWrite> chunks;
+  chunks.reserve(song.insLen+song.waveLen+song.sampleLen+patsToWrite.size());
   for (int i=0; i<song.insLen; i++) {
-    DivInstrument* ins=song.ins[i];
-    insPtr.push_back(w->tell());
-    ins->putInsData2(w,false);
+    chunks.push_back(FurChunkToWrite(FUR_CHUNK_INS,i));
   }
-
-  /// WAVETABLE
-  wavePtr.reserve(song.waveLen);
   for (int i=0; i<song.waveLen; i++) {
-    DivWavetable* wave=song.wave[i];
-    wavePtr.push_back(w->tell());
-    wave->putWaveData(w);
+    chunks.push_back(FurChunkToWrite(FUR_CHUNK_WAVE,i));
   }
-
-  /// SAMPLE
-  samplePtr.reserve(song.sampleLen);
   for (int i=0; i<song.sampleLen; i++) {
-    DivSample* sample=song.sample[i];
-    samplePtr.push_back(w->tell());
-    sample->putSampleData(w);
+    chunks.push_back(FurChunkToWrite(FUR_CHUNK_SAMPLE,i));
+  }
+  for (size_t i=0; i<patsToWrite.size(); i++) {
+    chunks.push_back(FurChunkToWrite(FUR_CHUNK_PATTERN,i));
   }
 
-  /// PATTERN
-  patPtr.reserve(patsToWrite.size());
-  for (PatToWrite& i: patsToWrite) {
-    DivPattern* pat=song.subsong[i.subsong]->pat[i.chan].getPattern(i.pat,false);
-    patPtr.push_back(w->tell());
-
-    if (newPatternFormat) {
-      w->write("PATN",4);
-      blockStartSeek=w->tell();
-      w->writeI(0);
-
-      w->writeC(i.subsong);
-      w->writeC(i.chan);
-      w->writeS(i.pat);
-      w->writeString(pat->name,false);
-
-      unsigned char emptyRows=0;
-
-      for (int j=0; j<song.subsong[i.subsong]->patLen; j++) {
-        unsigned char mask=0;
-        unsigned char finalNote=255;
-        unsigned short effectMask=0;
-
-        if (pat->data[j][0]==100) {
-          finalNote=180;
-        } else if (pat->data[j][0]==101) { // note release
-          finalNote=181;
-        } else if (pat->data[j][0]==102) { // macro release
-          finalNote=182;
-        } else if (pat->data[j][1]==0 && pat->data[j][0]==0) {
-          finalNote=255;
-        } else {
-          int seek=(pat->data[j][0]+(signed char)pat->data[j][1]*12)+60;
-          if (seek<0 || seek>=180) {
-            finalNote=255;
-          } else {
-            finalNote=seek;
-          }
-        }
-
-        if (finalNote!=255) mask|=1; // note
-        if (pat->data[j][2]!=-1) mask|=2; // instrument
-        if (pat->data[j][3]!=-1) mask|=4; // volume
-        for (int k=0; k<song.subsong[i.subsong]->pat[i.chan].effectCols*2; k+=2) {
-          if (k==0) {
-            if (pat->data[j][4+k]!=-1) mask|=8;
-            if (pat->data[j][5+k]!=-1) mask|=16;
-          } else if (k<8) {
-            if (pat->data[j][4+k]!=-1 || pat->data[j][5+k]!=-1) mask|=32;
-          } else {
-            if (pat->data[j][4+k]!=-1 || pat->data[j][5+k]!=-1) mask|=64;
-          }
-
-          if (pat->data[j][4+k]!=-1) effectMask|=(1<<k);
-          if (pat->data[j][5+k]!=-1) effectMask|=(2<<k);
-        }
-
-        if (mask==0) {
-          emptyRows++;
-          if (emptyRows>127) {
-            w->writeC(128|(emptyRows-2));
-            emptyRows=0;
-          }
-        } else {
-          if (emptyRows>1) {
-            w->writeC(128|(emptyRows-2));
-            emptyRows=0;
-          } else if (emptyRows) {
-            w->writeC(0);
-            emptyRows=0;
-          }
+  unsigned int saveThreads=0;
+  if (chunks.size()>=16) {
+    saveThreads=MIN(std::thread::hardware_concurrency(),(unsigned int)chunks.size()/8);
+    if (saveThreads<2) saveThreads=0;
+  }
 
-          w->writeC(mask);
-
-          if (mask&32) w->writeC(effectMask&0xff);
-          if (mask&64) w->writeC((effectMask>>8)&0xff);
-
-          if (mask&1) w->writeC(finalNote);
-          if (mask&2) w->writeC(pat->data[j][2]);
-          if (mask&4) w->writeC(pat->data[j][3]);
-          if (mask&8) w->writeC(pat->data[j][4]);
-          if (mask&16) w->writeC(pat->data[j][5]);
-          if (mask&32) {
-            if (effectMask&4) w->writeC(pat->data[j][6]);
-            if (effectMask&8) w->writeC(pat->data[j][7]);
-            if (effectMask&16) w->writeC(pat->data[j][8]);
-            if (effectMask&32) w->writeC(pat->data[j][9]);
-            if (effectMask&64) w->writeC(pat->data[j][10]);
-            if (effectMask&128) w->writeC(pat->data[j][11]);
-          }
-          if (mask&64) {
-            if (effectMask&256) w->writeC(pat->data[j][12]);
-            if (effectMask&512) w->writeC(pat->data[j][13]);
-            if (effectMask&1024) w->writeC(pat->data[j][14]);
-            if (effectMask&2048) w->writeC(pat->data[j][15]);
-            if (effectMask&4096) w->writeC(pat->data[j][16]);
-            if (effectMask&8192) w->writeC(pat->data[j][17]);
-            if (effectMask&16384) w->writeC(pat->data[j][18]);
-            if (effectMask&32768) w->writeC(pat->data[j][19]);
-          }
-        }
-      }
+  if (saveThreads>0) {
+    FurChunkWriter chunkWriter;
+    chunkWriter.song=&song;
+    chunkWriter.pats=&patsToWrite;
+    chunkWriter.newPatternFormat=newPatternFormat;
+    chunkWriter.chunks=chunks.data();
+    chunkWriter.count=chunks.size();
+    chunkWriter.next=0;
+
+    logD("serializing %d chunks on %d threads...",(int)chunks.size(),saveThreads);
+    DivWorkPool* savePool=new DivWorkPool(saveThreads);
+    for (unsigned int i=0; i<saveThreads; i++) {
+      savePool->push(furChunkWriteWorker,&chunkWriter);
+    }
+    savePool->wait();
+    delete savePool;
+  }
 
-      // stop
-      w->writeC(0xff);
+  insPtr.reserve(song.insLen);
+  wavePtr.reserve(song.waveLen);
+  samplePtr.reserve(song.sampleLen);
+  patPtr.reserve(patsToWrite.size());
+  for (FurChunkToWrite& i: chunks) {
+    switch (i.type) {
+      case FUR_CHUNK_INS:
+        insPtr.push_back(w->tell());
+        break;
+      case FUR_CHUNK_WAVE:
+        wavePtr.push_back(w->tell());
+        break;
+      case FUR_CHUNK_SAMPLE:
+        samplePtr.push_back(w->tell());
+        break;
+      case FUR_CHUNK_PATTERN:
+        patPtr.push_back(w->tell());
+        break;
+    }
+    if (i.w!=NULL) {
+      w->write(i.w->getFinalBuf(),i.w->size());
+      i.w->finish();
+      delete i.w;
+      i.w=NULL;
     } else {
-      w->write("PATR",4);
-      blockStartSeek=w->tell();
-      w->writeI(0);
-
-      w->writeS(i.chan);
-      w->writeS(i.pat);
-      w->writeS(i.subsong);
-
-      w->writeS(0); // reserved
-
-      for (int j=0; j<song.subsong[i.subsong]->patLen; j++) {
-        w->writeS(pat->data[j][0]); // note
-        w->writeS(pat->data[j][1]); // octave
-        w->writeS(pat->data[j][2]); // instrument
-        w->writeS(pat->data[j][3]); // volume
-#ifdef TA_BIG_ENDIAN
-        for (int k=0; k<song.subsong[i.subsong]->pat[i.chan].effectCols*2; k++) {
-          w->writeS(pat->data[j][4+k]);
-        }
-#else
-        w->write(&pat->data[j][4],2*song.subsong[i.subsong]->pat[i.chan].effectCols*2); // effects
-#endif
-      }
-
-      w->writeString(pat->name,false);
+      putFurChunk(w,&song,patsToWrite,newPatternFormat,i);
     }
-
-    blockEndSeek=w->tell();
-    w->seek(blockStartSeek,SEEK_SET);
-    w->writeI(blockEndSeek-blockStartSeek-4);
-    w->seek(0,SEEK_END);
   }
 
   /// POINTERS
@@ -2750,3 +2986,408 @@ SafeWriter* DivEngine::saveFur(bool notPrimary, bool newPatternFormat) {
   return w;
 }
 
+
+#define FUR_SCAN_CHUNK 16384
+
+// reads a (possibly compressed) module progressively, so that a scan may stop
+// as soon as it has what it needs.
+class FurScanStream {
+  FILE* f;
+  z_stream zl;
+  bool compressed, zInit, done;
+  unsigned char* inBuf;
+  unsigned char* outBuf;
+
+  public:
+    std::vector<unsigned char> data;
+    String error;
+
+    bool isCompressed() {
+      return compressed;
+    }
+
+    // make at least len bytes available. returns false if the file is shorter than that.
+    bool fill(size_t len) {
+      while (data.size()<len && !done) {
+        if (compressed) {
+          if (zl.avail_in==0) {
+            size_t got=fread(inBuf,1,FUR_SCAN_CHUNK,f);
+            if (got==0) {
+              done=true;
+              break;
+            }
+            zl.next_in=inBuf;
+            zl.avail_in=got;
+          }
+          zl.next_out=outBuf;
+          zl.avail_out=FUR_SCAN_CHUNK;
+          int nextErr=inflate(&zl,Z_SYNC_FLUSH);
+          if (nextErr!=Z_OK && nextErr!=Z_STREAM_END) {
+            error=(zl.msg==NULL)?"unknown decompression error":fmt::sprintf("decompression error: %s",zl.msg);
+            done=true;
+            break;
+          }
+          data.insert(data.end(),outBuf,outBuf+(FUR_SCAN_CHUNK-zl.avail_out));
+          if (nextErr==Z_STREAM_END) done=true;
+        } else {
+          size_t got=fread(outBuf,1,FUR_SCAN_CHUNK,f);
+          if (got==0) {
+            done=true;
+            break;
+          }
+          data.insert(data.end(),outBuf,outBuf+got);
+        }
+      }
+      return data.size()>=len;
+    }
+
+    bool open(const char* path) {
+      f=ps_fopen(path,"rb");
+      if (f==NULL) {
+        error=strerror(errno);
+        return false;
+      }
+      size_t got=fread(inBuf,1,FUR_SCAN_CHUNK,f);
+      if (got>=16 && (memcmp(inBuf,DIV_FUR_MAGIC,16)==0 || memcmp(inBuf,DIV_FUR_MAGIC_DS0,16)==0)) {
+        data.insert(data.end(),inBuf,inBuf+got);
+        return true;
+      }
+      memset(&zl,0,sizeof(z_stream));
+      if (inflateInit(&zl)!=Z_OK) {
+        error="could not initialize decompressor";
+        return false;
+      }
+      zInit=true;
+      compressed=true;
+      zl.next_in=inBuf;
+      zl.avail_in=got;
+      return true;
+    }
+
+    FurScanStream():
+      f(NULL),
+      compressed(false),
+      zInit(false),
+      done(false) {
+      inBuf=new unsigned char[FUR_SCAN_CHUNK];
+      outBuf=new unsigned char[FUR_SCAN_CHUNK];
+    }
+    ~FurScanStream() {
+      if (zInit) inflateEnd(&zl);
+      if (f!=NULL) fclose(f);
+      delete[] inBuf;
+      delete[] outBuf;
+    }
+};
+
+// frees the sub-songs DivSong() allocates, on every exit path
+struct FurScanSongGuard {
+  DivSong& song;
+  FurScanSongGuard(DivSong& s):
+    song(s) {}
+  ~FurScanSongGuard() {
+    song.unload();
+  }
+};
+
+bool DivEngine::scanSongInfo(const char* path, DivSongInfo& info, bool calcDuration) {
+  FurScanStream stream;
+  DivSong ds;
+  FurScanSongGuard dsGuard(ds);
+  char magic[5];
+  memset(magic,0,5);
+  info=DivSongInfo();
+
+  if (!stream.open(path)) {
+    info.error=stream.error;
+    return false;
+  }
+  info.compressed=stream.isCompressed();
+
+  try {
+    if (!stream.fill(32)) {
+      info.error=stream.error.empty()?"file is too small":stream.error;
+      return false;
+    }
+    if (memcmp(stream.data.data(),DIV_FUR_MAGIC,16)!=0 && memcmp(stream.data.data(),DIV_FUR_MAGIC_DS0,16)!=0) {
+      info.error="not a Furnace module";
+      return false;
+    }
+
+    SafeReader header=SafeReader(stream.data.data(),32);
+    header.seek(16,SEEK_SET);
+    ds.version=header.readS();
+    info.version=ds.version;
+    header.readS(); // reserved
+    unsigned int infoSeek=header.readI();
+
+    // read the INFO block and nothing else
+    if (!stream.fill((size_t)infoSeek+8)) {
+      info.error="incomplete file";
+      return false;
+    }
+    SafeReader blockHeader=SafeReader(stream.data.data(),stream.data.size());
+    blockHeader.seek(infoSeek,SEEK_SET);
+    blockHeader.read(magic,4);
+    if (strcmp(magic,"INFO")!=0) {
+      info.error="invalid info header!";
+      return false;
+    }
+    unsigned int infoLen=blockHeader.readI();
+    if (!stream.fill((size_t)infoSeek+8+infoLen)) {
+      info.error="incomplete file";
+      return false;
+    }
+
+    SafeReader reader=SafeReader(stream.data.data(),(size_t)infoSeek+8+infoLen);
+    reader.seek(infoSeek+8,SEEK_SET);
+    DivSubSong* subSong=ds.subsong[0];
+
+    if (ds.version<71) ds.ignoreJumpAtEnd=true;
+    if (ds.version<113) ds.jumpTreatment=1;
+
+    subSong->timeBase=reader.readC();
+    subSong->speeds.len=2;
+    subSong->speeds.val[0]=reader.readC();
+    subSong->speeds.val[1]=reader.readC();
+    subSong->arpLen=reader.readC();
+    subSong->hz=reader.readF();
+    subSong->patLen=reader.readS();
+    subSong->ordersLen=reader.readS();
+    subSong->hilightA=reader.readC();
+    subSong->hilightB=reader.readC();
+    ds.insLen=reader.readS();
+    ds.waveLen=reader.readS();
+    ds.sampleLen=reader.readS();
+    int numberOfPats=reader.readI();
+
+    if (subSong->patLen<0 || subSong->patLen>DIV_MAX_ROWS ||
+        subSong->ordersLen<0 || subSong->ordersLen>DIV_MAX_PATTERNS ||
+        ds.insLen<0 || ds.insLen>256 ||
+        ds.waveLen<0 || ds.waveLen>256 ||
+        ds.sampleLen<0 || ds.sampleLen>256 ||
+        numberOfPats<0) {
+      info.error="invalid info header!";
+      return false;
+    }
+
+    ds.systemLen=0;
+    for (int i=0; i<DIV_MAX_CHIPS; i++) {
+      unsigned char sysID=reader.readC();
+      ds.system[i]=systemFromFileFur(sysID);
+      if (sysID!=0 && systemToFileFur(ds.system[i])==0) {
+        info.error=fmt::sprintf("unrecognized system ID %.2x!",sysID);
+        return false;
+      }
+      if (ds.system[i]!=DIV_SYSTEM_NULL) ds.systemLen=i+1;
+    }
+    if (ds.systemLen<1) {
+      info.error="zero chips!";
+      return false;
+    }
+    int tchans=0;
+    for (int i=0; i<ds.systemLen; i++) {
+      tchans+=getChannelCount(ds.system[i]);
+    }
+    if (tchans>DIV_MAX_CHANS) tchans=DIV_MAX_CHANS;
+
+    // volume, panning and flag pointers
+    reader.seek(DIV_MAX_CHIPS*6,SEEK_CUR);
+
+    // handle compound systems
+    for (int i=0; i<DIV_MAX_CHIPS; i++) {
+      if (ds.system[i]==DIV_SYSTEM_GENESIS ||
+          ds.system[i]==DIV_SYSTEM_GENESIS_EXT ||
+          ds.system[i]==DIV_SYSTEM_ARCADE) {
+        for (int j=31; j>i; j--) {
+          ds.system[j]=ds.system[j-1];
+        }
+        if (++ds.systemLen>DIV_MAX_CHIPS) ds.systemLen=DIV_MAX_CHIPS;
+
+        if (ds.system[i]==DIV_SYSTEM_GENESIS) {
+          ds.system[i]=DIV_SYSTEM_YM2612;
+          if (i<31) ds.system[i+1]=DIV_SYSTEM_SMS;
+        }
+        if (ds.system[i]==DIV_SYSTEM_GENESIS_EXT) {
+          ds.system[i]=DIV_SYSTEM_YM2612_EXT;
+          if (i<31) ds.system[i+1]=DIV_SYSTEM_SMS;
+        }
+        if (ds.system[i]==DIV_SYSTEM_ARCADE) {
+          ds.system[i]=DIV_SYSTEM_YM2151;
+          if (i<31) ds.system[i+1]=DIV_SYSTEM_SEGAPCM_COMPAT;
+        }
+        i++;
+      }
+    }
+
+    ds.name=reader.readString();
+    ds.author=reader.readString();
+
+    // tuning and compatibility flags
+    reader.seek(4+20,SEEK_CUR);
+
+    // pointers
+    reader.seek((ds.insLen+ds.waveLen+ds.sampleLen)*4,SEEK_CUR);
+    std::vector<unsigned int> patPtr;
+    patPtr.reserve(numberOfPats);
+    for (int i=0; i<numberOfPats; i++) patPtr.push_back(reader.readI());
+
+    for (int i=0; i<tchans; i++) {
+      for (int j=0; j<subSong->ordersLen; j++) {
+        subSong->orders.ord[i][j]=reader.readC();
+      }
+    }
+    for (int i=0; i<tchans; i++) {
+      subSong->pat[i].effectCols=reader.readC();
+      if (subSong->pat[i].effectCols<1 || subSong->pat[i].effectCols>DIV_MAX_EFFECTS) {
+        info.error=fmt::sprintf("channel %d has too many effect columns! (%d)",i,subSong->pat[i].effectCols);
+        return false;
+      }
+    }
+
+    if (ds.version>=39) {
+      // channel visibility, collapse state and names
+      reader.seek(tchans*2,SEEK_CUR);
+      for (int i=0; i<tchans*2; i++) {
+        reader.readString();
+      }
+      ds.notes=reader.readString();
+    }
+
+    if (ds.version>=59) reader.readF();
+
+    if (ds.version>=70) {
+      unsigned char extFlags[28];
+      reader.read(extFlags,28);
+      if (ds.version>=71) ds.ignoreJumpAtEnd=extFlags[3];
+      if (ds.version>=113) ds.jumpTreatment=extFlags[23];
+    }
+
+    if (ds.version>=96) {
+      subSong->virtualTempoN=reader.readS();
+      subSong->virtualTempoD=reader.readS();
+    } else {
+      reader.readI();
+    }
+
+    int numberOfSubSongs=0;
+    if (ds.version>=95) {
+      subSong->name=reader.readString();
+      subSong->notes=reader.readString();
+      numberOfSubSongs=(unsigned char)reader.readC();
+      reader.seek(3+numberOfSubSongs*4,SEEK_CUR);
+    }
+
+    if (ds.version>=103) {
+      ds.systemName=reader.readString();
+      ds.category=reader.readString();
+      ds.nameJ=reader.readString();
+      ds.authorJ=reader.readString();
+      ds.systemNameJ=reader.readString();
+      ds.categoryJ=reader.readString();
+    } else {
+      ds.systemName=getSongSystemLegacyName(ds,true);
+    }
+
+    if (calcDuration) {
+      if (ds.version>=135) {
+        reader.seek(ds.systemLen*12,SEEK_CUR);
+        unsigned int conns=reader.readI();
+        reader.seek(conns*4,SEEK_CUR);
+      }
+      if (ds.version>=136) reader.readC();
+      if (ds.version>=138) reader.seek(8,SEEK_CUR);
+      if (ds.version>=139) {
+        subSong->speeds.len=reader.readC();
+        for (int i=0; i<16; i++) {
+          subSong->speeds.val[i]=reader.readC();
+        }
+        unsigned char grooveCount=reader.readC();
+        for (int i=0; i<grooveCount; i++) {
+          DivGroovePattern gp;
+          gp.len=reader.readC();
+          for (int j=0; j<16; j++) {
+            gp.val[j]=reader.readC();
+          }
+          ds.grooves.push_back(gp);
+        }
+      }
+    }
+
+    info.name=ds.name;
+    info.author=ds.author;
+    info.album=ds.category;
+    info.systemName=ds.systemName;
+    for (int i=0; i<ds.systemLen; i++) {
+      info.systems.push_back(ds.system[i]);
+    }
+    info.insLen=ds.insLen;
+    info.waveLen=ds.waveLen;
+    info.sampleLen=ds.sampleLen;
+    info.patterns=numberOfPats;
+    info.subSongs=1+numberOfSubSongs;
+    info.patLen=subSong->patLen;
+    info.ordersLen=subSong->ordersLen;
+    info.hz=subSong->hz;
+
+    if (calcDuration) {
+      // decode the patterns of the first sub-song only. pattern blocks are stored last,
+      // so the rest of the file has to be decompressed, but it is not decoded.
+      std::sort(patPtr.begin(),patPtr.end());
+      for (unsigned int i: patPtr) {
+        if (!stream.fill((size_t)i+16)) {
+          info.error="incomplete file";
+          return false;
+        }
+        SafeReader patReader=SafeReader(stream.data.data(),stream.data.size());
+        patReader.seek(i,SEEK_SET);
+        patReader.read(magic,4);
+        bool isNewFormat=(strcmp(magic,"PATN")==0 && ds.version>=157);
+        if (strcmp(magic,"PATR")!=0 && !isNewFormat) {
+          info.error="invalid pattern header!";
+          return false;
+        }
+        unsigned int patLen=patReader.readI();
+        int subs=0;
+        int chan=0;
+        int index=0;
+        if (isNewFormat) {
+          subs=(unsigned char)patReader.readC();
+          chan=(unsigned char)patReader.readC();
+          index=patReader.readS();
+        } else {
+          chan=patReader.readS();
+          index=patReader.readS();
+          subs=(ds.version>=95)?patReader.readS():0;
+          patReader.readS();
+        }
+        if (subs!=0) continue;
+        if (chan<0 || chan>=tchans || index<0 || index>(DIV_MAX_PATTERNS-1)) {
+          info.error="invalid pattern header!";
+          return false;
+        }
+        if (!stream.fill((size_t)i+8+patLen)) {
+          info.error="incomplete file";
+          return false;
+        }
+
+        FurChunkToRead chunk(FUR_CHUNK_PATTERN,0,patReader.tell(),subSong->pat[chan].getPattern(index,true));
+        chunk.chan=chan;
+        chunk.isNewFormat=isNewFormat;
+        readFurChunk(stream.data.data(),stream.data.size(),ds.version,&ds,chunk);
+        if (chunk.result!=FUR_CHUNK_SUCCESS) {
+          info.error="invalid pattern data!";
+          return false;
+        }
+      }
+      DivSongTimeline timeline;
+      timeline.update(&ds,0,tchans);
+      info.duration=timeline.getDuration();
+      info.loops=(timeline.getLoopStart()>=0.0);
+    }
+  } catch (EndOfFileException& e) {
+    info.error="incomplete file";
+    return false;
+  }
+  return true;
+}
@@ -48,6 +48,67 @@ static void readSbiOpData(sbi_t& sbi, SafeReader& reader) {
   sbi.FeedConnect = reader.readC();
 }
 
+// decodes sample data, downmixing stereo samples.
+// flags are the S3M sample flags; param is 1 if samples are signed.
+static void decodeS3MSample(const unsigned char* file, size_t len, DivSampleToDecode& what) {
+  DivSample* s=what.sample;
+  unsigned char flags=what.flags;
+  bool signedSamples=what.param;
+  SafeReader reader=SafeReader(file,len);
+  reader.seek(what.pos,SEEK_SET);
+
+  if (flags&2) {
+    // downmix stereo
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      for (unsigned int i=0; i<s->samples; i++) {
+        short l=reader.readS();
+        if (!signedSamples) {
+          l^=0x8000;
+        }
+        s->data16[i]=l;
+      }
+      for (unsigned int i=0; i<s->samples; i++) {
+        short r=reader.readS();
+        if (!signedSamples) {
+          r^=0x8000;
+        }
+        s->data16[i]=(s->data16[i]+r)>>1;
+      }
+    } else {
+      for (unsigned int i=0; i<s->samples; i++) {
+        signed char l=reader.readC();
+        if (!signedSamples) {
+          l^=0x80;
+        }
+        s->data8[i]=l;
+      }
+      for (unsigned int i=0; i<s->samples; i++) {
+        signed char r=reader.readC();
+        if (!signedSamples) {
+          r^=0x80;
+        }
+        s->data8[i]=(s->data8[i]+r)>>1;
+      }
+    }
+  } else {
+    if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data16[i]=reader.readS();
+        if (!signedSamples) {
+          s->data16[i]^=0x8000;
+        }
+      }
+    } else {
+      for (unsigned int i=0; i<s->samples; i++) {
+        s->data8[i]=reader.readC();
+        if (!signedSamples) {
+          s->data8[i]^=0x80;
+        }
+      }
+    }
+  }
+}
+
 bool DivEngine::loadS3M(unsigned char* file, size_t len) {
   struct InvalidHeaderException {};
   bool success=false;
@@ -334,6 +395,7 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
     }
 
     // load instruments/samples
+    std::vector<DivSampleToDecode> samplesToDecode;
     ds.ins.reserve(ds.insLen);
     for (int i=0; i<ds.insLen; i++) {
       logV("reading instrument %d...",i);
@@ -478,55 +540,15 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
           return false;
         }
 
-        if (flags&2) {
-          // downmix stereo
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            for (unsigned int i=0; i<s->samples; i++) {
-              short l=reader.readS();
-              if (!signedSamples) {
-                l^=0x8000;
-              }
-              s->data16[i]=l;
-            }
-            for (unsigned int i=0; i<s->samples; i++) {
-              short r=reader.readS();
-              if (!signedSamples) {
-                r^=0x8000;
-              }
-              s->data16[i]=(s->data16[i]+r)>>1;
-            }
-          } else {
-            for (unsigned int i=0; i<s->samples; i++) {
-              signed char l=reader.readC();
-              if (!signedSamples) {
-                l^=0x80;
-              }
-              s->data8[i]=l;
-            }
-            for (unsigned int i=0; i<s->samples; i++) {
-              signed char r=reader.readC();
-              if (!signedSamples) {
-                r^=0x80;
-              }
-              s->data8[i]=(s->data8[i]+r)>>1;
-            }
-          }
-        } else {
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data16[i]=reader.readS();
-              if (!signedSamples) {
-                s->data16[i]^=0x8000;
-              }
-            }
-          } else {
-            for (unsigned int i=0; i<s->samples; i++) {
-              s->data8[i]=reader.readC();
-              if (!signedSamples) {
-                s->data8[i]^=0x80;
-              }
-            }
+        // the data is decoded later, along with that of the other samples
+        if (s->samples>0) {
+          size_t dataLen=s->samples;
+          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) dataLen<<=1;
+          if (flags&2) dataLen<<=1;
+          if (dataLen>len-reader.tell()) {
+            throw EndOfFileException(&reader,len);
           }
+          samplesToDecode.push_back(DivSampleToDecode(s,reader.tell(),dataLen,flags,signedSamples?1:0));
         }
 
         ins->amiga.initSample=ds.sample.size();
@@ -611,6 +633,8 @@ bool DivEngine::loadS3M(unsigned char* file, size_t len) {
     }
     ds.sampleLen=ds.sample.size();
 
+    decodeSamples(samplesToDecode,decodeS3MSample,file,len);
+
     // scan pattern data for effect use
     for (int i=0; i<patCount; i++) {
       logV("scanning pattern %d...",i);
@@ -124,6 +124,27 @@ void readEnvelope(DivInstrument* ins, int env, unsigned char flags, unsigned cha
   }
 }
 
+// decodes delta-encoded sample data.
+static void decodeXMSample(const unsigned char* file, size_t len, DivSampleToDecode& what) {
+  DivSample* s=what.sample;
+  SafeReader reader=SafeReader(file,len);
+  reader.seek(what.pos,SEEK_SET);
+
+  if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
+    short next=0;
+    for (unsigned int i=0; i<s->samples; i++) {
+      next+=reader.readS();
+      s->data16[i]=next;
+    }
+  } else {
+    signed char next=0;
+    for (unsigned int i=0; i<s->samples; i++) {
+      next+=reader.readC();
+      s->data8[i]=next;
+    }
+  }
+}
+
 bool DivEngine::loadXM(unsigned char* file, size_t len) {
   struct InvalidHeaderException {};
   bool success=false;
@@ -458,6 +479,7 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
     }
 
     // read instruments
+    std::vector<DivSampleToDecode> samplesToDecode;
     for (int i=0; i<ds.insLen; i++) {
       short volEnv[24];
       short panEnv[48];
@@ -642,20 +664,15 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
         for (int j=0; j<sampleCount; j++) {
           DivSample* s=toAdd[j];
 
-          // load sample data
-          if (s->depth==DIV_SAMPLE_DEPTH_16BIT) {
-            short next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readS();
-              s->data16[i]=next;
-            }
-          } else {
-            signed char next=0;
-            for (unsigned int i=0; i<s->samples; i++) {
-              next+=reader.readC();
-              s->data8[i]=next;
-            }
+          // skip sample data (decoded later)
+          size_t dataLen=(s->depth==DIV_SAMPLE_DEPTH_16BIT)?(s->samples<<1):s->samples;
+          if (dataLen>reader.size()-reader.tell()) {
+            throw EndOfFileException(&reader,reader.size());
           }
+          if (dataLen>0) {
+            samplesToDecode.push_back(DivSampleToDecode(s,reader.tell(),dataLen));
+          }
+          reader.seek(dataLen,SEEK_CUR);
         }
 
         for (DivSample* i: toAdd) {
@@ -674,6 +691,8 @@ bool DivEngine::loadXM(unsigned char* file, size_t len) {
       ds.ins.push_back(ins);
     }
 
+    decodeSamples(samplesToDecode,decodeXMSample,file,len);
+
     if (!reader.seek(patBegin,SEEK_SET)) {
       logE("premature end of file!");
       lastError="incomplete file";
@@ -178,19 +178,14 @@ void DivMacroInt::next() {
   if (ins==NULL) return;
   // run macros
   // TODO: potentially get rid of list to avoid allocations
-  subTick--;
+  // input sub-ticks only start the macros of a note that was just triggered
+  bool tick=(fresh || e==NULL || !e->inputTick);
   for (size_t i=0; i<macroListLen; i++) {
     if (macroList[i]!=NULL && macroSource[i]!=NULL) {
-      macroList[i]->doMacro(*macroSource[i],released,subTick==0);
-    }
-  }
-  if (subTick<=0) {
-    if (e==NULL) {
-      subTick=1;
-    } else {
-      subTick=e->tickMult;
+      macroList[i]->doMacro(*macroSource[i],released,tick);
     }
   }
+  fresh=false;
 }
 
 #define CONSIDER(x,y) \
@@ -349,7 +344,7 @@ void DivMacroInt::init(DivInstrument* which) {
     if (macroList[i]!=NULL) macroList[i]->init();
   }
   macroListLen=0;
-  subTick=1;
+  fresh=true;
 
   hasRelease=false;
   released=false;
@@ -66,7 +66,7 @@ class DivMacroInt {
   DivMacroStruct* macroList[128];
   DivInstrumentMacro* macroSource[128];
   size_t macroListLen;
-  int subTick;
+  bool fresh;
   bool released;
   public:
     // common macro
@@ -158,7 +158,7 @@ class DivMacroInt {
       e(NULL),
       ins(NULL),
       macroListLen(0),
-      subTick(1),
+      fresh(true),
       released(false),
       vol(DIV_MACRO_VOL),
       arp(DIV_MACRO_ARP),
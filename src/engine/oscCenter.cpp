@@ -0,0 +1,105 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#define _USE_MATH_DEFINES
+#include "oscCenter.h"
+#include <float.h>
+#include <math.h>
+
+bool DivOscCenter::window(float* inBuf, const short* data, unsigned int mask, unsigned short needle, int displaySize) {
+  bool loudEnough=false;
+  for (int j=0; j<FURNACE_FFT_SIZE; j++) {
+    inBuf[j]=(float)data[(unsigned short)(needle-displaySize*2+((j*displaySize*2)/(FURNACE_FFT_SIZE)))&mask]/32768.0f;
+    if (inBuf[j]>0.001f || inBuf[j]<-0.001f) loudEnough=true;
+    inBuf[j]*=0.55f-0.45f*cosf(M_PI*(float)j/(float)(FURNACE_FFT_SIZE>>1));
+  }
+  return loudEnough;
+}
+
+void DivOscCenter::autoCorrelate(fftwf_complex* outBuf) {
+  for (int j=0; j<FURNACE_FFT_CSIZE; j++) {
+    outBuf[j][0]/=FURNACE_FFT_SIZE;
+    outBuf[j][1]/=FURNACE_FFT_SIZE;
+    outBuf[j][0]=outBuf[j][0]*outBuf[j][0]+outBuf[j][1]*outBuf[j][1];
+    outBuf[j][1]=0;
+  }
+  outBuf[0][0]=0;
+  outBuf[0][1]=0;
+  outBuf[1][0]=0;
+  outBuf[1][1]=0;
+}
+
+unsigned short DivOscCenter::findPhase(DivOscCenterResult& result, float* corrBuf, const short* data, unsigned int mask, unsigned short needle, int displaySize, bool waveCorr, float phaseOff) {
+  // window
+  for (int j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
+    corrBuf[j]*=1.0f-((float)j/(float)(FURNACE_FFT_SIZE<<1));
+  }
+
+  // find size of period
+  float waveLenCandL=FLT_MAX;
+  float waveLenCandH=FLT_MIN;
+  result.waveLen=FURNACE_FFT_SIZE-1;
+  result.waveLenBottom=0;
+  result.waveLenTop=0;
+
+  // find lowest point
+  for (int j=(FURNACE_FFT_SIZE>>2); j>2; j--) {
+    if (corrBuf[j]<waveLenCandL) {
+      waveLenCandL=corrBuf[j];
+      result.waveLenBottom=j;
+    }
+  }
+
+  // find highest point
+  for (int j=(FURNACE_FFT_SIZE>>1)-1; j>result.waveLenBottom; j--) {
+    if (corrBuf[j]>waveLenCandH) {
+      waveLenCandH=corrBuf[j];
+      result.waveLen=j;
+    }
+  }
+  result.waveLenTop=result.waveLen;
+
+  // did we find the period size?
+  if (result.waveLen<(FURNACE_FFT_SIZE-32)) {
+    // we got pitch
+    result.pitch=pow(1.0-(result.waveLen/(double)(FURNACE_FFT_SIZE>>1)),4.0);
+
+    result.waveLen*=(double)displaySize*2.0/(double)FURNACE_FFT_SIZE;
+
+    // DFT of one period (x_1)
+    double dft[2];
+    dft[0]=0.0;
+    dft[1]=0.0;
+    for (int j=needle-1-(displaySize>>1)-(int)result.waveLen, k=0; k<result.waveLen; j++, k++) {
+      double one=((double)data[j&mask]/32768.0);
+      double two=(double)k*(-2.0*M_PI)/result.waveLen;
+      dft[0]+=one*cos(two);
+      dft[1]+=one*sin(two);
+    }
+
+    // calculate and lock into phase
+    double phase=(0.5+(atan2(dft[1],dft[0])/(2.0*M_PI)));
+
+    if (waveCorr) {
+      needle-=(phase+(phaseOff*2))*result.waveLen;
+    }
+  }
+
+  return needle;
+}
@@ -0,0 +1,73 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OSC_CENTER_H
+#define _OSC_CENTER_H
+
+#include <fftw3.h>
+
+#define FURNACE_FFT_SIZE 4096
+// size of the complex half-spectrum
+#define FURNACE_FFT_CSIZE ((FURNACE_FFT_SIZE>>1)+1)
+
+struct DivOscCenterResult {
+  double waveLen;
+  int waveLenBottom, waveLenTop;
+  float pitch;
+  DivOscCenterResult():
+    waveLen(0.0),
+    waveLenBottom(0),
+    waveLenTop(0),
+    pitch(0.0f) {}
+};
+
+/**
+ * the waveform centering algorithm used by the per-channel oscilloscope.
+ *
+ * 1. FFT of windowed signal (window, then forward FFT)
+ * 2. inverse FFT of auto-correlation (autoCorrelate, then inverse FFT)
+ * 3. find size of one period (findPhase)
+ * 4. DFT of the fundamental of ONE PERIOD
+ * 5. now we can get phase information
+ *
+ * the FFTs are left to the caller, so that they can be batched.
+ * oscilloscope data is read from a ring buffer of (mask+1) samples, which
+ * must be a power of two no larger than 65536 (DivDispatchOscBuffer uses 0xffff).
+ */
+class DivOscCenter {
+  public:
+    /**
+     * fill FFT input with a windowed copy of the last displaySize*2 samples before needle.
+     * @return whether the signal is loud enough to be analyzed.
+     */
+    static bool window(float* inBuf, const short* data, unsigned int mask, unsigned short needle, int displaySize);
+
+    /**
+     * turn the output of the forward FFT into the input of the inverse one.
+     */
+    static void autoCorrelate(fftwf_complex* outBuf);
+
+    /**
+     * find the period size and phase from the output of the inverse FFT.
+     * @return the position where drawing should start.
+     */
+    static unsigned short findPhase(DivOscCenterResult& result, float* corrBuf, const short* data, unsigned int mask, unsigned short needle, int displaySize, bool waveCorr, float phaseOff);
+};
+
+#endif
@@ -0,0 +1,386 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "oscRender.h"
+#include "engine.h"
+#include "../ta-log.h"
+#include "../fileutils.h"
+#include <thread>
+
+#define Y4M_FRAME_HEADER "FRAME\n"
+
+DivOscRender::DivOscRender(DivEngine* eng):
+  e(eng),
+  f(NULL),
+  ownFile(false),
+  pool(NULL),
+  plan(NULL),
+  planI(NULL),
+  frames(NULL),
+  frameCount(0),
+  framesPending(0),
+  cols(1),
+  rows(1),
+  frameSize(0),
+  rate(44100),
+  samplesDone(0),
+  nextFrame(0),
+  framesWritten(0) {
+}
+
+DivOscRender::~DivOscRender() {
+  if (f!=NULL) finish();
+  freeFrames();
+}
+
+bool DivOscRender::open(const char* path, const DivOscRenderOptions& options) {
+  opt=options;
+  if (opt.width<16) opt.width=16;
+  if (opt.height<16) opt.height=16;
+  if (opt.fps<1) opt.fps=1;
+  if (opt.windowSize<1.0f) opt.windowSize=1.0f;
+  // 4:4:4 needs no chroma subsampling, but keep dimensions even for encoders
+  opt.width&=~1;
+  opt.height&=~1;
+
+  if (strcmp(path,"-")==0) {
+    f=stdout;
+    ownFile=false;
+  } else {
+    f=ps_fopen(path,"wb");
+    if (f==NULL) {
+      logE("could not open oscilloscope output file! (%s)",strerror(errno));
+      return false;
+    }
+    ownFile=true;
+  }
+
+  if (opt.format==DIV_OSC_RENDER_Y4M) {
+    fprintf(f,"YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",opt.width,opt.height,opt.fps);
+  }
+  return true;
+}
+
+void DivOscRender::freeFrames() {
+  if (pool!=NULL) {
+    pool->wait();
+    delete pool;
+    pool=NULL;
+  }
+  if (frames!=NULL) {
+    for (int i=0; i<frameCount; i++) {
+      DivOscRenderFrame& frame=frames[i];
+      if (frame.chans!=NULL) {
+        for (size_t j=0; j<chanList.size(); j++) {
+          delete[] frame.chans[j].data;
+        }
+        delete[] frame.chans;
+      }
+      if (frame.inBuf!=NULL) fftwf_free(frame.inBuf);
+      if (frame.outBuf!=NULL) fftwf_free(frame.outBuf);
+      if (frame.corrBuf!=NULL) fftwf_free(frame.corrBuf);
+      delete[] frame.pixels;
+      delete[] frame.out;
+    }
+    delete[] frames;
+    frames=NULL;
+  }
+  frameCount=0;
+  framesPending=0;
+  if (plan!=NULL) fftwf_destroy_plan(plan);
+  if (planI!=NULL) fftwf_destroy_plan(planI);
+  plan=NULL;
+  planI=NULL;
+}
+
+bool DivOscRender::begin(int outRate) {
+  if (f==NULL) return false;
+  freeFrames();
+
+  rate=outRate;
+  samplesDone=0;
+  nextFrame=0;
+  framesWritten=0;
+
+  // channels
+  chanList.clear();
+  ringSize.clear();
+  for (int i=0; i<e->getTotalChannelCount(); i++) {
+    if (!e->curSubSong->chanShowChanOsc[i]) continue;
+    DivDispatchOscBuffer* buf=e->getOscBuffer(i);
+    if (buf==NULL) continue;
+    // enough room for the FFT window plus centering (see DivOscCenter)
+    unsigned int needed=4*(unsigned int)((float)buf->rate*(opt.windowSize/1000.0f));
+    unsigned int size=4096;
+    while (size<needed && size<65536) size<<=1;
+    chanList.push_back(i);
+    ringSize.push_back(size);
+  }
+
+  // layout
+  cols=opt.cols;
+  if (cols<1) {
+    cols=sqrt(chanList.size());
+    if ((size_t)(cols*cols)<chanList.size()) cols++;
+  }
+  if (cols<1) cols=1;
+  rows=(chanList.size()+cols-1)/cols;
+  if (rows<1) rows=1;
+
+  // frames
+  int threads=opt.threads;
+  if (threads<1) threads=std::thread::hardware_concurrency();
+  if (threads<1) threads=1;
+  frameCount=threads*2;
+  frames=new DivOscRenderFrame[frameCount];
+  frameSize=opt.width*opt.height*3;
+  if (opt.format==DIV_OSC_RENDER_Y4M) frameSize+=strlen(Y4M_FRAME_HEADER);
+
+  size_t chans=chanList.size();
+  for (int i=0; i<frameCount; i++) {
+    DivOscRenderFrame& frame=frames[i];
+    frame.parent=this;
+    frame.pixels=new unsigned char[opt.width*opt.height*3];
+    if (opt.format==DIV_OSC_RENDER_Y4M) {
+      frame.out=new unsigned char[frameSize];
+    }
+    if (chans==0) continue;
+    frame.chans=new DivOscRenderChan[chans];
+    for (size_t j=0; j<chans; j++) {
+      frame.chans[j].data=new short[ringSize[j]];
+      frame.chans[j].mask=ringSize[j]-1;
+    }
+    frame.inBuf=(float*)fftwf_malloc(chans*FURNACE_FFT_SIZE*sizeof(float));
+    frame.outBuf=(fftwf_complex*)fftwf_malloc(chans*FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+    frame.corrBuf=(float*)fftwf_malloc(chans*FURNACE_FFT_SIZE*sizeof(float));
+    if (frame.inBuf==NULL || frame.outBuf==NULL || frame.corrBuf==NULL) {
+      logE("could not allocate oscilloscope FFT buffers!");
+      freeFrames();
+      return false;
+    }
+  }
+
+  // one plan for all channels of a frame. it is executed on every frame using the new-array interface.
+  if (chans>0) {
+    String wisdomPath=e->getConfigPath()+DIR_SEPARATOR_STR+"fftwWisdom.txt";
+    fftwf_import_wisdom_from_filename(wisdomPath.c_str());
+    int size=FURNACE_FFT_SIZE;
+    plan=fftwf_plan_many_dft_r2c(1,&size,chans,frames[0].inBuf,NULL,1,FURNACE_FFT_SIZE,frames[0].outBuf,NULL,1,FURNACE_FFT_CSIZE,FFTW_MEASURE);
+    planI=fftwf_plan_many_dft_c2r(1,&size,chans,frames[0].outBuf,NULL,1,FURNACE_FFT_CSIZE,frames[0].corrBuf,NULL,1,FURNACE_FFT_SIZE,FFTW_MEASURE);
+    if (plan==NULL || planI==NULL) {
+      logE("could not create oscilloscope FFT plans!");
+      freeFrames();
+      return false;
+    }
+    fftwf_export_wisdom_to_filename(wisdomPath.c_str());
+  }
+
+  pool=new DivWorkPool(threads>1?threads:0);
+
+  logI("rendering oscilloscope: %dx%d, %d FPS, %d channels, %d threads",opt.width,opt.height,opt.fps,(int)chans,threads);
+  return true;
+}
+
+void DivOscRender::capture(DivOscRenderFrame& frame, size_t lag) {
+  for (size_t i=0; i<chanList.size(); i++) {
+    DivOscRenderChan& c=frame.chans[i];
+    DivDispatchOscBuffer* buf=e->getOscBuffer(chanList[i]);
+    if (buf==NULL) {
+      c.displaySize=0;
+      continue;
+    }
+    c.displaySize=(float)(buf->rate)*(opt.windowSize/1000.0f);
+    if (c.displaySize>(int)(ringSize[i]>>2)) c.displaySize=ringSize[i]>>2;
+    if (c.displaySize<1) c.displaySize=1;
+
+    // position of the needle at the time of this frame
+    c.needle=buf->needle-(unsigned short)(((unsigned long long)lag*buf->rate)/rate);
+
+    unsigned short pos=c.needle-ringSize[i];
+    for (unsigned int j=0; j<ringSize[i]; j++) {
+      c.data[pos&c.mask]=buf->data[pos];
+      pos++;
+    }
+  }
+}
+
+void DivOscRender::processFrame(void* frame_v) {
+  DivOscRenderFrame* frame=(DivOscRenderFrame*)frame_v;
+  DivOscRender* r=frame->parent;
+  const DivOscRenderOptions& opt=r->opt;
+  size_t chans=r->chanList.size();
+
+  // center
+  bool anyLoud=false;
+  for (size_t i=0; i<chans; i++) {
+    DivOscRenderChan& c=frame->chans[i];
+    c.loudEnough=false;
+    if (c.displaySize==0) {
+      memset(frame->inBuf+i*FURNACE_FFT_SIZE,0,FURNACE_FFT_SIZE*sizeof(float));
+      continue;
+    }
+    c.loudEnough=DivOscCenter::window(frame->inBuf+i*FURNACE_FFT_SIZE,c.data,c.mask,c.needle,c.displaySize);
+    if (c.loudEnough) anyLoud=true;
+  }
+  if (anyLoud) {
+    fftwf_execute_dft_r2c(r->plan,frame->inBuf,frame->outBuf);
+    for (size_t i=0; i<chans; i++) {
+      if (frame->chans[i].loudEnough) {
+        DivOscCenter::autoCorrelate(frame->outBuf+i*FURNACE_FFT_CSIZE);
+      } else {
+        memset(frame->outBuf+i*FURNACE_FFT_CSIZE,0,FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+      }
+    }
+    fftwf_execute_dft_c2r(r->planI,frame->outBuf,frame->corrBuf);
+  }
+  for (size_t i=0; i<chans; i++) {
+    DivOscRenderChan& c=frame->chans[i];
+    if (c.loudEnough) {
+      DivOscCenterResult result;
+      c.needle=DivOscCenter::findPhase(result,frame->corrBuf+i*FURNACE_FFT_SIZE,c.data,c.mask,c.needle,c.displaySize,opt.waveCorr,0.0f);
+    }
+    c.needle-=c.displaySize;
+  }
+
+  // rasterize
+  const int w=opt.width;
+  const int h=opt.height;
+  unsigned char* px=frame->pixels;
+  for (int i=0; i<w*h; i++) {
+    px[i*3]=opt.bgColor>>16;
+    px[i*3+1]=opt.bgColor>>8;
+    px[i*3+2]=opt.bgColor;
+  }
+
+#define PUT_PIXEL(_x,_y,_c) { \
+  unsigned char* p=&px[((_y)*w+(_x))*3]; \
+  p[0]=(_c)>>16; \
+  p[1]=(_c)>>8; \
+  p[2]=(_c); \
+}
+
+  for (size_t i=0; i<chans; i++) {
+    const DivOscRenderChan& c=frame->chans[i];
+    int x0=((int)(i%r->cols)*w)/r->cols;
+    int x1=((int)(i%r->cols+1)*w)/r->cols;
+    int y0=((int)(i/r->cols)*h)/r->rows;
+    int y1=((int)(i/r->cols+1)*h)/r->rows;
+
+    // grid
+    for (int x=x0; x<x1; x++) PUT_PIXEL(x,y1-1,opt.gridColor);
+    for (int y=y0; y<y1; y++) PUT_PIXEL(x1-1,y,opt.gridColor);
+
+    int precision=x1-x0-2;
+    int cellH=y1-y0-2;
+    if (precision<1 || cellH<1 || c.displaySize==0) continue;
+
+    float minLevel=1.0f;
+    float maxLevel=-1.0f;
+    for (int j=0; j<precision; j++) {
+      float y=(float)c.data[(unsigned short)(c.needle+(j*c.displaySize/precision))&c.mask]/32768.0f;
+      if (minLevel>y) minLevel=y;
+      if (maxLevel<y) maxLevel=y;
+    }
+    float dcOff=(minLevel+maxLevel)*0.5f;
+
+    int prevY=-1;
+    for (int j=0; j<precision; j++) {
+      float y=(float)c.data[(unsigned short)(c.needle+(j*c.displaySize/precision))&c.mask]/32768.0f;
+      y-=dcOff;
+      if (y<-0.5f) y=-0.5f;
+      if (y>0.5f) y=0.5f;
+      y*=opt.amplify;
+      int py=y0+1+(int)((0.5f-y)*(float)(cellH-1));
+      if (py<y0+1) py=y0+1;
+      if (py>y0+cellH) py=y0+cellH;
+      int from=(prevY<0)?py:MIN(prevY,py);
+      int to=(prevY<0)?py:MAX(prevY,py);
+      for (int k=from; k<=to; k++) {
+        PUT_PIXEL(x0+1+j,k,opt.color);
+      }
+      prevY=py;
+    }
+  }
+
+#undef PUT_PIXEL
+
+  // convert
+  if (opt.format==DIV_OSC_RENDER_Y4M) {
+    size_t headerLen=strlen(Y4M_FRAME_HEADER);
+    memcpy(frame->out,Y4M_FRAME_HEADER,headerLen);
+    unsigned char* planeY=frame->out+headerLen;
+    unsigned char* planeU=planeY+w*h;
+    unsigned char* planeV=planeU+w*h;
+    for (int i=0; i<w*h; i++) {
+      int red=px[i*3];
+      int green=px[i*3+1];
+      int blue=px[i*3+2];
+      planeY[i]=((66*red+129*green+25*blue+128)>>8)+16;
+      planeU[i]=((-38*red-74*green+112*blue+128)>>8)+128;
+      planeV[i]=((112*red-94*green-18*blue+128)>>8)+128;
+    }
+  }
+}
+
+void DivOscRender::flush() {
+  if (framesPending==0) return;
+  for (int i=0; i<framesPending; i++) {
+    pool->push(processFrame,&frames[i]);
+  }
+  pool->wait();
+  for (int i=0; i<framesPending; i++) {
+    unsigned char* data=(opt.format==DIV_OSC_RENDER_Y4M)?frames[i].out:frames[i].pixels;
+    if (fwrite(data,1,frameSize,f)!=frameSize) {
+      logE("could not write oscilloscope frame!");
+    }
+  }
+  framesWritten+=framesPending;
+  framesPending=0;
+}
+
+void DivOscRender::feed(size_t samples) {
+  if (frames==NULL) return;
+  size_t end=samplesDone+samples;
+  while (true) {
+    size_t frameTime=(nextFrame*rate)/opt.fps;
+    if (frameTime>=end) break;
+    capture(frames[framesPending],end-frameTime);
+    nextFrame++;
+    if (++framesPending>=frameCount) flush();
+  }
+  samplesDone=end;
+}
+
+void DivOscRender::finish() {
+  if (frames!=NULL) flush();
+  if (f!=NULL) {
+    if (ownFile) {
+      fclose(f);
+    } else {
+      fflush(f);
+    }
+    f=NULL;
+  }
+  logI("oscilloscope: %llu frames written.",framesWritten);
+  freeFrames();
+}
+
+unsigned long long DivOscRender::getFramesWritten() {
+  return framesWritten;
+}
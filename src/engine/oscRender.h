@@ -0,0 +1,159 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OSC_RENDER_H
+#define _OSC_RENDER_H
+
+#include <stdio.h>
+#include "oscCenter.h"
+#include "workPool.h"
+#include "../pch.h"
+
+class DivEngine;
+
+enum DivOscRenderFormats {
+  // YUV4MPEG2 stream (4:4:4)
+  DIV_OSC_RENDER_Y4M=0,
+  // raw RGB24 frames
+  DIV_OSC_RENDER_RAW
+};
+
+struct DivOscRenderOptions {
+  DivOscRenderFormats format;
+  int width, height, fps;
+  // 0 means automatic (square-ish grid)
+  int cols;
+  // 0 means one per CPU core
+  int threads;
+  // window size in milliseconds
+  float windowSize;
+  float amplify;
+  bool waveCorr;
+  // 0xRRGGBB
+  unsigned int color, bgColor, gridColor;
+  DivOscRenderOptions():
+    format(DIV_OSC_RENDER_Y4M),
+    width(1280),
+    height(720),
+    fps(60),
+    cols(0),
+    threads(0),
+    windowSize(20.0f),
+    amplify(1.0f),
+    waveCorr(true),
+    color(0xffffff),
+    bgColor(0x000000),
+    gridColor(0x404040) {}
+};
+
+struct DivOscRenderChan {
+  short* data;
+  unsigned int mask;
+  unsigned short needle;
+  int displaySize;
+  bool loudEnough;
+  DivOscRenderChan():
+    data(NULL),
+    mask(0),
+    needle(0),
+    displaySize(0),
+    loudEnough(false) {}
+};
+
+class DivOscRender;
+
+struct DivOscRenderFrame {
+  DivOscRender* parent;
+  DivOscRenderChan* chans;
+  float* inBuf;
+  fftwf_complex* outBuf;
+  float* corrBuf;
+  unsigned char* pixels;
+  unsigned char* out;
+  DivOscRenderFrame():
+    parent(NULL),
+    chans(NULL),
+    inBuf(NULL),
+    outBuf(NULL),
+    corrBuf(NULL),
+    pixels(NULL),
+    out(NULL) {}
+};
+
+/**
+ * renders per-channel oscilloscope video off-screen during audio export.
+ * oscilloscope data is captured after every rendered buffer, and frames are
+ * centered (using DivOscCenter) and rasterized on a work pool.
+ */
+class DivOscRender {
+  DivEngine* e;
+  FILE* f;
+  bool ownFile;
+  DivOscRenderOptions opt;
+  DivWorkPool* pool;
+  fftwf_plan plan, planI;
+
+  std::vector<int> chanList;
+  std::vector<unsigned int> ringSize;
+  DivOscRenderFrame* frames;
+  int frameCount, framesPending;
+  int cols, rows;
+  size_t frameSize;
+
+  int rate;
+  size_t samplesDone;
+  unsigned long long nextFrame;
+  unsigned long long framesWritten;
+
+  void flush();
+  void capture(DivOscRenderFrame& frame, size_t lag);
+  void freeFrames();
+
+  public:
+    static void processFrame(void* frame);
+
+    /**
+     * open the output file.
+     * @param path a file name, or "-" for standard output.
+     */
+    bool open(const char* path, const DivOscRenderOptions& options);
+
+    /**
+     * prepare for rendering. called by the engine when export begins.
+     */
+    bool begin(int outRate);
+
+    /**
+     * capture frames after a buffer has been rendered.
+     * @param samples number of samples which were rendered.
+     */
+    void feed(size_t samples);
+
+    /**
+     * write remaining frames and close the output.
+     */
+    void finish();
+
+    unsigned long long getFramesWritten();
+
+    DivOscRender(DivEngine* eng);
+    ~DivOscRender();
+};
+
+#endif
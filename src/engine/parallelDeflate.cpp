@@ -0,0 +1,192 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "parallelDeflate.h"
+#include "workPool.h"
+#include "../ta-log.h"
+
+#define DEFLATE_DICT_SIZE 32768
+
+struct DeflateBlock {
+  const unsigned char* data;
+  size_t len;
+  // preceding data used as dictionary
+  const unsigned char* dict;
+  size_t dictLen;
+  bool last;
+  std::vector<unsigned char> out;
+  // Adler-32 (zlib) or CRC-32 (gzip) of the data
+  unsigned long check;
+  bool ok;
+};
+
+struct DeflateJob {
+  DeflateBlock* blocks;
+  size_t count;
+  int level;
+  bool gzip;
+  std::atomic<size_t> next;
+};
+
+// compress one block into a raw deflate stream which ends on a byte boundary
+// (or with the final block flag if it is the last block).
+static void deflateBlock(DeflateBlock& b, int level, bool gzip) {
+  z_stream zl;
+  memset(&zl,0,sizeof(z_stream));
+  b.ok=false;
+  if (gzip) {
+    b.check=crc32(crc32(0,NULL,0),b.data,b.len);
+  } else {
+    b.check=adler32(adler32(0,NULL,0),b.data,b.len);
+  }
+
+  if (deflateInit2(&zl,level,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY)!=Z_OK) {
+    return;
+  }
+  if (b.dictLen>0) {
+    if (deflateSetDictionary(&zl,b.dict,b.dictLen)!=Z_OK) {
+      deflateEnd(&zl);
+      return;
+    }
+  }
+
+  b.out.resize(deflateBound(&zl,b.len)+16);
+  zl.next_in=(Bytef*)b.data;
+  zl.avail_in=b.len;
+  zl.next_out=b.out.data();
+  zl.avail_out=b.out.size();
+  int flush=b.last?Z_FINISH:Z_SYNC_FLUSH;
+  while (true) {
+    int ret=deflate(&zl,flush);
+    if (ret==Z_STREAM_ERROR) {
+      deflateEnd(&zl);
+      return;
+    }
+    if (b.last) {
+      if (ret==Z_STREAM_END) break;
+    } else if (zl.avail_in==0 && zl.avail_out>0) {
+      break;
+    }
+    if (zl.avail_out==0) {
+      size_t used=b.out.size();
+      b.out.resize(used*2);
+      zl.next_out=b.out.data()+used;
+      zl.avail_out=b.out.size()-used;
+    }
+  }
+  b.out.resize(b.out.size()-zl.avail_out);
+  deflateEnd(&zl);
+  b.ok=true;
+}
+
+static void deflateWorker(void* j) {
+  DeflateJob* job=(DeflateJob*)j;
+  while (true) {
+    size_t i=job->next++;
+    if (i>=job->count) break;
+    deflateBlock(job->blocks[i],job->level,job->gzip);
+  }
+}
+
+SafeWriter* deflateParallel(const unsigned char* data, size_t len, int level, unsigned int threads, bool gzip) {
+  size_t blockCount=(len+DIV_DEFLATE_BLOCK_SIZE-1)/DIV_DEFLATE_BLOCK_SIZE;
+  if (blockCount<1) blockCount=1;
+
+  DeflateBlock* blocks=new DeflateBlock[blockCount];
+  for (size_t i=0; i<blockCount; i++) {
+    size_t start=i*DIV_DEFLATE_BLOCK_SIZE;
+    blocks[i].data=data+start;
+    blocks[i].len=MIN(len-start,(size_t)DIV_DEFLATE_BLOCK_SIZE);
+    blocks[i].dictLen=MIN(start,(size_t)DEFLATE_DICT_SIZE);
+    blocks[i].dict=data+start-blocks[i].dictLen;
+    blocks[i].last=(i==blockCount-1);
+    blocks[i].check=0;
+    blocks[i].ok=false;
+  }
+
+  if (threads==0) threads=std::thread::hardware_concurrency();
+  if (threads>blockCount) threads=blockCount;
+
+  DeflateJob job;
+  job.blocks=blocks;
+  job.count=blockCount;
+  job.level=level;
+  job.gzip=gzip;
+  job.next=0;
+  if (threads>1) {
+    logV("compressing %d blocks on %d threads...",(int)blockCount,threads);
+    DivWorkPool* pool=new DivWorkPool(threads);
+    for (unsigned int i=0; i<threads; i++) {
+      pool->push(deflateWorker,&job);
+    }
+    pool->wait();
+    delete pool;
+  } else {
+    deflateWorker(&job);
+  }
+
+  SafeWriter* w=new SafeWriter;
+  w->init();
+
+  if (gzip) {
+    // gzip header (deflate, no name, no time, unknown OS)
+    const unsigned char header[10]={0x1f,0x8b,0x08,0x00,0,0,0,0,0x00,0xff};
+    w->write(header,10);
+  } else {
+    // zlib header (32K window, deflate) with a level hint
+    unsigned char header[2];
+    header[0]=0x78;
+    if (level==Z_DEFAULT_COMPRESSION || level==6) {
+      header[1]=0x9c;
+    } else if (level>=7) {
+      header[1]=0xda;
+    } else if (level>=2) {
+      header[1]=0x5e;
+    } else {
+      header[1]=0x01;
+    }
+    w->write(header,2);
+  }
+
+  unsigned long check=gzip?crc32(0,NULL,0):adler32(0,NULL,0);
+  for (size_t i=0; i<blockCount; i++) {
+    if (!blocks[i].ok) {
+      logE("could not compress block %d!",(int)i);
+      w->finish();
+      delete w;
+      delete[] blocks;
+      return NULL;
+    }
+    w->write(blocks[i].out.data(),blocks[i].out.size());
+    if (gzip) {
+      check=crc32_combine(check,blocks[i].check,blocks[i].len);
+    } else {
+      check=adler32_combine(check,blocks[i].check,blocks[i].len);
+    }
+  }
+  if (gzip) {
+    w->writeI((unsigned int)check);
+    w->writeI((unsigned int)len);
+  } else {
+    w->writeI_BE((unsigned int)check);
+  }
+
+  delete[] blocks;
+  return w;
+}
@@ -0,0 +1,44 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _PARALLELDEFLATE_H
+#define _PARALLELDEFLATE_H
+
+#include "safeWriter.h"
+#include <zlib.h>
+
+// size of each independently compressed block
+#define DIV_DEFLATE_BLOCK_SIZE 131072
+
+/**
+ * compress data into a standard zlib stream using several threads.
+ *
+ * the input is split into blocks which are compressed independently (each one
+ * primed with the last 32KB of the previous block, so the ratio barely suffers)
+ * and then joined into a single stream that any zlib decoder can read.
+ * @param data the data to compress.
+ * @param len its length.
+ * @param level compression level (0-9 or Z_DEFAULT_COMPRESSION).
+ * @param threads number of threads. 0 means one per CPU core.
+ * @param gzip whether to write a gzip file (e.g. .vgz) instead of a zlib stream.
+ * @return a SafeWriter containing the stream, or NULL on error.
+ */
+SafeWriter* deflateParallel(const unsigned char* data, size_t len, int level=Z_DEFAULT_COMPRESSION, unsigned int threads=0, bool gzip=false);
+
+#endif
@@ -147,6 +147,10 @@ void DivDispatch::setSkipRegisterWrites(bool value) {
   skipRegisterWrites=value;
 }
 
+void DivDispatch::setOscCapture(bool enable) {
+  oscCapture=enable;
+}
+
 void DivDispatch::notifyInsChange(int ins) {
 
 }
@@ -170,6 +174,9 @@ void DivDispatch::forceIns() {
 
 void DivDispatch::toggleRegisterDump(bool enable) {
   dumpWrites=enable;
+  // sub-chips (the SSG in OPN/OPNA/OPNB) dump their writes on every tick,
+  // so make room beforehand rather than growing the list on the audio thread
+  if (enable) regWrites.reserve(256);
 }
 
 std::vector<DivRegWrite>& DivDispatch::getRegisterWrites() {
@@ -217,6 +224,10 @@ void DivDispatch::renderSamples(int sysID) {
   
 }
 
+bool DivDispatch::renderSample(int sysID, int sample) {
+  return false;
+}
+
 void DivDispatch::notifyPitchTable() {
 }
 
@@ -928,7 +928,7 @@ const DivMemoryComposition* DivPlatformAmiga::getMemCompo(int index) {
 }
 
 void DivPlatformAmiga::renderSamples(int sysID) {
-  memset(sampleMem,0,2097152);
+  sampleMem=sampleMemory->beginWrite();
   memset(sampleOff,0,256*sizeof(unsigned int));
   memset(sampleLoaded,0,256*sizeof(bool));
 
@@ -991,7 +991,9 @@ int DivPlatformAmiga::init(DivEngine* p, int channels, int sugRate, const DivCon
     }
   }
 
-  sampleMem=new unsigned char[2097152];
+  // not shared: wavetables are written to this memory while playing
+  sampleMemory=new DivSampleMemory(2097152);
+  sampleMem=sampleMemory->get();
   sampleMemLen=0;
 
   setFlags(flags);
@@ -1000,7 +1002,9 @@ int DivPlatformAmiga::init(DivEngine* p, int channels, int sugRate, const DivCon
 }
 
 void DivPlatformAmiga::quit() {
-  delete[] sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
   for (int i=0; i<4; i++) {
     delete oscBuf[i];
   }
@@ -21,6 +21,7 @@
 #define _AMIGA_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
 #include "../../fixedQueue.h"
 #include "../waveSynth.h"
 
@@ -115,6 +116,7 @@ class DivPlatformAmiga: public DivDispatch {
 
   DivMemoryComposition memCompo;
 
+  DivSampleMemory* sampleMemory;
   unsigned char* sampleMem;
   size_t sampleMemLen;
 
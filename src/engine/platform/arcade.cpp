@@ -51,7 +51,7 @@ const char** DivPlatformArcade::getRegisterSheet() {
   return regCheatSheetOPM;
 }
 
-void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
+template<bool osc> void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
   thread_local int o[2];
 
   for (size_t h=0; h<len; h++) {
@@ -75,9 +75,11 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
       OPM_Clock(&fm,o,NULL,NULL,NULL);
     }
 
-    for (int i=0; i<8; i++) {
-      int chOut=(int16_t)fm.ch_out[i];
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+    if (osc) {
+      for (int i=0; i<8; i++) {
+        int chOut=(int16_t)fm.ch_out[i];
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+      }
     }
 
     if (o[0]<-32768) o[0]=-32768;
@@ -91,7 +93,7 @@ void DivPlatformArcade::acquire_nuked(short** buf, size_t len) {
   }
 }
 
-void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
+template<bool osc> void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
   thread_local int os[2];
 
   ymfm::ym2151::fm_engine* fme=fm_ymfm->debug_engine();
@@ -111,9 +113,11 @@ void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
 
     fm_ymfm->generate(&out_ymfm);
 
-    for (int i=0; i<8; i++) {
-      int chOut=fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1);
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
+    if (osc) {
+      for (int i=0; i<8; i++) {
+        int chOut=fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1);
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
+      }
     }
 
     os[0]=out_ymfm.data[0];
@@ -131,9 +135,17 @@ void DivPlatformArcade::acquire_ymfm(short** buf, size_t len) {
 
 void DivPlatformArcade::acquire(short** buf, size_t len) {
   if (useYMFM) {
-    acquire_ymfm(buf,len);
+    if (oscCapture) {
+      acquire_ymfm<true>(buf,len);
+    } else {
+      acquire_ymfm<false>(buf,len);
+    }
   } else {
-    acquire_nuked(buf,len);
+    if (oscCapture) {
+      acquire_nuked<true>(buf,len);
+    } else {
+      acquire_nuked<false>(buf,len);
+    }
   }
 }
 
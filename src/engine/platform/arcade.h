@@ -58,8 +58,8 @@ class DivPlatformArcade: public DivPlatformOPM {
     int toFreq(int freq);
     void commitState(int ch, DivInstrument* ins);
 
-    void acquire_nuked(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
+    template<bool osc> void acquire_nuked(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm(short** buf, size_t len);
 
     friend void putDispatchChan(void*,int,int);
     friend void putDispatchChip(void*,int);
@@ -25,7 +25,7 @@
 
 #define CHIP_FREQBASE 65536
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetBifurcator[]={
   "CHx_State", "x*8+0",
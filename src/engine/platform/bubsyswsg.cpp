@@ -23,7 +23,7 @@
 
 #define CHIP_DIVIDER 32
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; regPool[a]=v; if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetBubSysWSG[]={
   // K005289 timer
@@ -19,12 +19,13 @@
 
 #include "c140.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include <math.h>
 
 #define CHIP_FREQBASE (is219?74448896:12582912)
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetC140[]={
   "CHx_RVol", "00+x*10",
@@ -600,129 +601,143 @@ const DivMemoryComposition* DivPlatformC140::getMemCompo(int index) {
   return &memCompo;
 }
 
-void DivPlatformC140::renderSamples(int sysID) {
-  memset(sampleMem,0,is219?524288:16777216);
-  memset(sampleOff,0,256*sizeof(unsigned int));
-  memset(sampleLoaded,0,256*sizeof(bool));
-
-  memCompo=DivMemoryComposition();
-  memCompo.name="Sample ROM";
-
-  size_t memPos=0;
-  for (int i=0; i<parent->song.sampleLen; i++) {
-    DivSample* s=parent->song.sample[i];
-    if (!s->renderOn[0][sysID]) {
-      sampleOff[i]=0;
-      continue;
-    }
-
-    if (is219) { // C219 (8-bit)
-      unsigned int length=s->length8+4;
-      // fit sample size to single bank size
-      if (length>131072) {
-        length=131072;
-      }
-      if (length&1) length++;
-      if ((memPos&0xfe0000)!=((memPos+length)&0xfe0000)) {
-        memPos=((memPos+0x1ffff)&0xfe0000);
-      }
-      logV("%d",length);
-      if (memPos>=(getSampleMemCapacity())) {
-        logW("out of C219 memory for sample %d!",i);
-        break;
-      }
-      if (memPos+length>=(getSampleMemCapacity())) {
-        length=getSampleMemCapacity()-memPos;
-        logW("out of C219 memory for sample %d!",i);
-      }
-      if (s->depth==DIV_SAMPLE_DEPTH_C219) {
-        unsigned char next=0;
-        unsigned int sPos=0;
-        for (unsigned int i=0; i<length; i++) {
-          if (sPos<s->lengthC219) {
-            next=s->dataC219[sPos++];
-            if (s->isLoopable()) {
-              if ((int)sPos>=s->loopEnd) {
-                sPos=s->loopStart;
-              }
+unsigned int DivPlatformC140::getSampleRenderLen(DivSample* s) {
+  unsigned int length=is219?(s->length8+4):(s->length16+4);
+  // fit sample size to single bank size
+  if (length>131072) {
+    length=131072;
+  }
+  if (is219 && (length&1)) length++;
+  return length;
+}
+
+void DivPlatformC140::copySample(DivSample* s, size_t memPos, unsigned int length) {
+  if (is219) { // C219 (8-bit)
+    if (s->depth==DIV_SAMPLE_DEPTH_C219) {
+      unsigned char next=0;
+      unsigned int sPos=0;
+      for (unsigned int i=0; i<length; i++) {
+        if (sPos<s->lengthC219) {
+          next=s->dataC219[sPos++];
+          if (s->isLoopable()) {
+            if ((int)sPos>=s->loopEnd) {
+              sPos=s->loopStart;
             }
           }
-          sampleMem[(memPos+i)^1]=next;
         }
-      } else {
-        signed char next=0;
-        unsigned int sPos=0;
-        for (unsigned int i=0; i<length; i++) {
-          if (sPos<s->length8) {
-            next=s->data8[sPos++];
-            if (s->isLoopable()) {
-              if ((int)sPos>=s->loopEnd) {
-                sPos=s->loopStart;
-              }
+        sampleMem[(memPos+i)^1]=next;
+      }
+    } else {
+      signed char next=0;
+      unsigned int sPos=0;
+      for (unsigned int i=0; i<length; i++) {
+        if (sPos<s->length8) {
+          next=s->data8[sPos++];
+          if (s->isLoopable()) {
+            if ((int)sPos>=s->loopEnd) {
+              sPos=s->loopStart;
             }
           }
-          sampleMem[(memPos+i)^1]=next;
         }
+        sampleMem[(memPos+i)^1]=next;
       }
-      sampleOff[i]=memPos>>1;
-      sampleLoaded[i]=true;
-      memCompo.entries.push_back(DivMemoryEntry((DivMemoryEntryType)(DIV_MEMORY_BANK0+((memPos>>17)&3)),"Sample",i,memPos,memPos+length));
-      memPos+=length;
-    } else { // C140 (16-bit)
-      unsigned int length=s->length16+4;
-      // fit sample size to single bank size
-      if (length>(131072)) {
-        length=131072;
-      }
-      if ((memPos&0xfe0000)!=((memPos+length)&0xfe0000)) {
-        memPos=((memPos+0x1ffff)&0xfe0000);
-      }
-      if (memPos>=(getSampleMemCapacity())) {
-        logW("out of C140 memory for sample %d!",i);
-        break;
-      }
-      // why is C140 not G.711-compliant? this weird bit mangling had me puzzled for 3 hours...
-      if (memPos+length>=(getSampleMemCapacity())) {
-        length=getSampleMemCapacity()-memPos;
-        logW("out of C140 memory for sample %d!",i);
+    }
+  } else { // C140 (16-bit)
+    // why is C140 not G.711-compliant? this weird bit mangling had me puzzled for 3 hours...
+    if (s->depth==DIV_SAMPLE_DEPTH_MULAW) {
+      for (unsigned int i=0; i<length; i+=2) {
+        if ((i>>1)>=s->lengthMuLaw) break;
+        unsigned char x=s->dataMuLaw[i>>1]^0xff;
+        if (x&0x80) x^=15;
+        unsigned char c140Mu=(x&0x80)|((x&15)<<3)|((x&0x70)>>4);
+        sampleMem[i+memPos]=0;
+        sampleMem[1+i+memPos]=c140Mu;
       }
-      if (s->depth==DIV_SAMPLE_DEPTH_MULAW) {
-        for (unsigned int i=0; i<length; i+=2) {
-          if ((i>>1)>=s->lengthMuLaw) break;
-          unsigned char x=s->dataMuLaw[i>>1]^0xff;
-          if (x&0x80) x^=15;
-          unsigned char c140Mu=(x&0x80)|((x&15)<<3)|((x&0x70)>>4);
-          sampleMem[i+memPos]=0;
-          sampleMem[1+i+memPos]=c140Mu;
-        }
-      } else {
-        short next=0;
-        unsigned int sPos=0;
-        for (unsigned int i=0; i<length; i+=2) {
-          if (sPos<s->samples) {
-            next=s->data16[sPos++];
-            if (s->isLoopable()) {
-              if ((int)sPos>=s->loopEnd) {
-                sPos=s->loopStart;
-              }
+    } else {
+      short next=0;
+      unsigned int sPos=0;
+      for (unsigned int i=0; i<length; i+=2) {
+        if (sPos<s->samples) {
+          next=s->data16[sPos++];
+          if (s->isLoopable()) {
+            if ((int)sPos>=s->loopEnd) {
+              sPos=s->loopStart;
             }
           }
-          sampleMem[memPos+i]=((unsigned short)next);
-          sampleMem[memPos+i+1]=((unsigned short)next)>>8;
         }
+        sampleMem[memPos+i]=((unsigned short)next);
+        sampleMem[memPos+i+1]=((unsigned short)next)>>8;
       }
-      sampleOff[i]=memPos>>1;
-      sampleLoaded[i]=true;
-      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+length));
-      memPos+=length;
     }
   }
-  sampleMemLen=memPos+256;
+}
+
+void DivPlatformC140::updateSampleMem(unsigned char* mem) {
+  sampleMem=mem;
+  if (is219) {
+    c219.sample_mem=(signed char*)sampleMem;
+  } else {
+    c140.sample_mem=(short*)sampleMem;
+  }
+}
+
+void DivPlatformC140::renderSamples(int sysID) {
+  sampleMem=sampleMemory->beginWrite();
+  memset(sampleOff,0,256*sizeof(unsigned int));
+  memset(sampleLoaded,0,256*sizeof(bool));
+  memset(sampleRenderLen,0,256*sizeof(unsigned int));
+
+  memCompo=DivMemoryComposition();
+  memCompo.name="Sample ROM";
+
+  std::vector<DivSampleMemItem> items;
+  for (int i=0; i<parent->song.sampleLen; i++) {
+    DivSample* s=parent->song.sample[i];
+    if (!s->renderOn[0][sysID]) continue;
+    items.push_back(DivSampleMemItem(i,getSampleRenderLen(s)));
+  }
+  DivSampleMemPlanner plan(0,getSampleMemCapacity(),0x20000,2);
+  plan.plan(items);
+
+  for (DivSampleMemItem& i: items) {
+    if (!i.placed) {
+      logW("out of %s memory for sample %d!",is219?"C219":"C140",i.index);
+      continue;
+    }
+    copySample(parent->song.sample[i.index],i.pos,i.len);
+    if (is219) {
+      memCompo.entries.push_back(DivMemoryEntry((DivMemoryEntryType)(DIV_MEMORY_BANK0+((i.pos>>17)&3)),"Sample",i.index,i.pos,i.pos+i.len));
+    } else {
+      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
+    }
+    sampleOff[i.index]=i.pos>>1;
+    sampleLoaded[i.index]=true;
+    sampleRenderLen[i.index]=i.len;
+  }
+  sampleMemLen=plan.getEnd()+256;
+  updateSampleMem(sampleMemory->endWrite(sampleMemLen));
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
 }
 
+bool DivPlatformC140::renderSample(int sysID, int sample) {
+  if (sample<0 || sample>=256) return false;
+  DivSample* s=parent->song.sample[sample];
+  if (!s->renderOn[0][sysID]) return !sampleLoaded[sample];
+  if (!sampleLoaded[sample]) return false;
+
+  unsigned int length=getSampleRenderLen(s);
+  if (length!=sampleRenderLen[sample]) return false;
+
+  size_t memPos=(size_t)sampleOff[sample]<<1;
+  sampleMem=sampleMemory->beginWrite(false);
+  memset(sampleMem+memPos,0,length);
+  copySample(s,memPos,length);
+  updateSampleMem(sampleMemory->endWrite(sampleMemLen));
+  return true;
+}
+
 void DivPlatformC140::set219(bool is_219) {
   is219=is_219;
   totalChans=is219?16:24;
@@ -769,15 +784,14 @@ int DivPlatformC140::init(DivEngine* p, int channels, int sugRate, const DivConf
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[is219?524288:16777216];
+  sampleMemory=new DivSampleMemory(is219?524288:16777216,true);
   sampleMemLen=0;
   if (is219) {
     c219_init(&c219);
-    c219.sample_mem=(signed char*)sampleMem;
   } else {
     c140_init(&c140);
-    c140.sample_mem=(short*)sampleMem;
   }
+  updateSampleMem(sampleMemory->get());
   setFlags(flags);
   reset();
 
@@ -785,7 +799,9 @@ int DivPlatformC140::init(DivEngine* p, int channels, int sugRate, const DivConf
 }
 
 void DivPlatformC140::quit() {
-  delete[] sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
   for (int i=0; i<totalChans; i++) {
     delete oscBuf[i];
   }
@@ -21,6 +21,8 @@
 #define _C140_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
+#include "../sample.h"
 #include "sound/c140_c219.h"
 #include "../../fixedQueue.h"
 
@@ -57,11 +59,13 @@ class DivPlatformC140: public DivDispatch {
   bool isMuted[24];
   unsigned int sampleOff[256];
   bool sampleLoaded[256];
+  unsigned int sampleRenderLen[256];
   bool is219;
   int totalChans;
   unsigned char groupBank[4];
   unsigned char bankType;
 
+  DivSampleMemory* sampleMemory;
   unsigned char* sampleMem;
   size_t sampleMemLen;
   struct QueuedWrite {
@@ -81,6 +85,9 @@ class DivPlatformC140: public DivDispatch {
   friend void putDispatchChan(void*,int,int);
 
   void acquire_219(short** buf, size_t len);
+  unsigned int getSampleRenderLen(DivSample* s);
+  void copySample(DivSample* s, size_t memPos, unsigned int length);
+  void updateSampleMem(unsigned char* mem);
   void acquire_140(short** buf, size_t len);
 
   public:
@@ -111,6 +118,7 @@ class DivPlatformC140: public DivDispatch {
     bool isSampleLoaded(int index, int sample);
     const DivMemoryComposition* getMemCompo(int index);
     void renderSamples(int chipID);
+    bool renderSample(int chipID, int sample);
     int getClockRangeMin();
     int getClockRangeMax();
     void set219(bool is_219);
@@ -24,7 +24,7 @@
 #include <math.h>
 #include "../../ta-log.h"
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_FREQBASE 524288
 
@@ -100,7 +100,7 @@ short DivPlatformC64::runFakeFilter(unsigned char ch, int in) {
   return CLAMP(fout,-32768,32767);
 }
 
-void DivPlatformC64::acquire(short** buf, size_t len) {
+template<bool osc> void DivPlatformC64::acquire_sid(short** buf, size_t len) {
   int dcOff=(sidCore)?0:sid->get_dc(0);
   for (size_t i=0; i<len; i++) {
     if (!writes.empty()) {
@@ -118,7 +118,7 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
     if (sidCore==2) {
       double o=dSID_render(sid_d);
       buf[0][i]=32767*CLAMP(o,-1.0,1.0);
-      if (++writeOscBuf>=4) {
+      if (osc && ++writeOscBuf>=4) {
         writeOscBuf=0;
         oscBuf[0]->data[oscBuf[0]->needle++]=sid_d->lastOut[0];
         oscBuf[1]->data[oscBuf[1]->needle++]=sid_d->lastOut[1];
@@ -126,7 +126,7 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
       }
     } else if (sidCore==1) {
       sid_fp->clock(4,&buf[0][i]);
-      if (++writeOscBuf>=4) {
+      if (osc && ++writeOscBuf>=4) {
         writeOscBuf=0;
         oscBuf[0]->data[oscBuf[0]->needle++]=runFakeFilter(0,(sid_fp->lastChanOut[0]-dcOff)>>5);
         oscBuf[1]->data[oscBuf[1]->needle++]=runFakeFilter(1,(sid_fp->lastChanOut[1]-dcOff)>>5);
@@ -135,7 +135,7 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
     } else {
       sid->clock();
       buf[0][i]=sid->output();
-      if (++writeOscBuf>=16) {
+      if (osc && ++writeOscBuf>=16) {
         writeOscBuf=0;
         oscBuf[0]->data[oscBuf[0]->needle++]=runFakeFilter(0,(sid->last_chan_out[0]-dcOff)>>5);
         oscBuf[1]->data[oscBuf[1]->needle++]=runFakeFilter(1,(sid->last_chan_out[1]-dcOff)>>5);
@@ -145,6 +145,14 @@ void DivPlatformC64::acquire(short** buf, size_t len) {
   }
 }
 
+void DivPlatformC64::acquire(short** buf, size_t len) {
+  if (oscCapture) {
+    acquire_sid<true>(buf,len);
+  } else {
+    acquire_sid<false>(buf,len);
+  }
+}
+
 void DivPlatformC64::updateFilter() {
   rWrite(0x15,filtCut&7);
   rWrite(0x16,filtCut>>3);
@@ -94,6 +94,7 @@ class DivPlatformC64: public DivDispatch {
 
   void acquire_classic(short* bufL, short* bufR, size_t start, size_t len);
   void acquire_fp(short* bufL, short* bufR, size_t start, size_t len);
+  template<bool osc> void acquire_sid(short** buf, size_t len);
 
   void updateFilter();
   public:
@@ -19,13 +19,14 @@
 
 #include "es5506.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include <math.h>
 
 #define PITCH_OFFSET ((double)(16*2048*(chanMax+1)))
 #define NOTE_ES5506(c,note) ((amigaPitch && parent->song.linearPitch!=2)?parent->calcBaseFreq(COLOR_NTSC,chan[c].pcm.freqOffs,note,true):parent->calcBaseFreq(chipClock,chan[c].pcm.freqOffs,note,false))
 
-#define rWrite(a,...) {if(!skipRegisterWrites) {hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__)); }}
+#define rWrite(a,...) {if(!skipRegisterWrites) {regWriteCount++; hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__)); }}
 #define immWrite(a,...) {hostIntf32.push_back(QueuedHostIntf(4,(a),__VA_ARGS__));}
 #define pageWrite(p,a,...) \
   if (!skipRegisterWrites) { \
@@ -1310,58 +1311,80 @@ const DivMemoryComposition* DivPlatformES5506::getMemCompo(int index) {
   return &memCompo;
 }
 
+static unsigned int es5506SampleLen(DivSample* s) {
+  // fit sample size to single bank size
+  unsigned int length=MIN(s->length16,4194304-256);
+  // add 1 for loop
+  if (s->loop && s->loopEnd>=0 && s->loopEnd<=(int)s->samples && s->loopStart>=0 && s->loopStart<(int)s->samples && s->loopEnd>=(int)s->samples) {
+    length+=2;
+  }
+  return length;
+}
+
+void DivPlatformES5506::copySample(DivSample* s, unsigned int pos, unsigned int length) {
+  memcpy(sampleMem+(pos/sizeof(short)),s->data16,MIN(length,s->length16));
+  // inject loop sample
+  if (s->loop && s->loopEnd>=0 && s->loopEnd<=(int)s->samples && s->loopStart>=0 && s->loopStart<(int)s->samples) {
+    sampleMem[(pos/sizeof(short))+s->loopEnd]=s->data16[s->loopStart];
+  }
+}
+
 void DivPlatformES5506::renderSamples(int sysID) {
-  memset(sampleMem,0,getSampleMemCapacity());
+  sampleMem=(signed short*)sampleMemory->beginWrite();
   memset(sampleOffES5506,0,256*sizeof(unsigned int));
   memset(sampleLoaded,0,256*sizeof(bool));
+  memset(sampleRenderLen,0,256*sizeof(unsigned int));
 
   memCompo=DivMemoryComposition();
   memCompo.name="Sample Memory";
 
-  size_t memPos=128; // add silent at begin and end of each bank for reverse playback and add 1 for loop
+  // samples may not cross a 4MB boundary.
+  // leave silence at the beginning and end of each bank for reverse playback
+  std::vector<DivSampleMemItem> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
-    if (!s->renderOn[0][sysID]) {
-      sampleOffES5506[i]=0;
+    if (!s->renderOn[0][sysID]) continue;
+    items.push_back(DivSampleMemItem(i,es5506SampleLen(s)));
+  }
+  DivSampleMemPlanner plan(128,getSampleMemCapacity()-128,0x400000,2,128,128);
+  plan.plan(items);
+  for (DivSampleMemItem& i: items) {
+    if (!i.placed) {
+      logW("out of ES5506 memory for sample %d!",i.index);
       continue;
     }
-
-    unsigned int length=s->length16;
-    // fit sample size to single bank size
-    if (length>(4194304-128)) {
-      length=4194304-128;
-    }
-    if ((memPos&0xc00000)!=((memPos+length+128)&0xc00000)) {
-      memPos=((memPos+0x3fffff)&0xc00000)+128;
-    }
-    if (memPos>=(getSampleMemCapacity()-128)) {
-      logW("out of ES5506 memory for sample %d!",i);
-      break;
-    }
-    if (memPos+length>=(getSampleMemCapacity()-128)) {
-      memcpy(sampleMem+(memPos/sizeof(short)),s->data16,(getSampleMemCapacity()-128)-memPos);
-      logW("out of ES5506 memory for sample %d!",i);
-    } else {
-      memcpy(sampleMem+(memPos/sizeof(short)),s->data16,length);
-      // inject loop sample
-      if (s->loop && s->loopEnd>=0 && s->loopEnd<=(int)s->samples && s->loopStart>=0 && s->loopStart<(int)s->samples) {
-        sampleMem[(memPos/sizeof(short))+s->loopEnd]=s->data16[s->loopStart];
-        if (s->loopEnd>=(int)s->samples) length+=2;
-      }
-    }
-    sampleOffES5506[i]=memPos;
-    sampleLoaded[i]=true;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+length));
-    memPos+=length;
+    copySample(parent->song.sample[i.index],i.pos,i.len);
+    sampleOffES5506[i.index]=i.pos;
+    sampleLoaded[i.index]=true;
+    sampleRenderLen[i.index]=i.len;
+    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
   }
-  sampleMemLen=memPos+256;
+  sampleMemLen=plan.getEnd()+256;
+  sampleMem=(signed short*)sampleMemory->endWrite(sampleMemLen);
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=16777216;
 }
 
+bool DivPlatformES5506::renderSample(int sysID, int sample) {
+  if (sample<0 || sample>=256) return false;
+  DivSample* s=parent->song.sample[sample];
+  if (!s->renderOn[0][sysID]) return !sampleLoaded[sample];
+  if (!sampleLoaded[sample]) return false;
+
+  unsigned int length=es5506SampleLen(s);
+  if (length!=sampleRenderLen[sample]) return false;
+
+  sampleMem=(signed short*)sampleMemory->beginWrite(false);
+  memset(sampleMem+(sampleOffES5506[sample]/sizeof(short)),0,length);
+  copySample(s,sampleOffES5506[sample],length);
+  sampleMem=(signed short*)sampleMemory->endWrite(sampleMemLen);
+  return true;
+}
+
 int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
-  sampleMem=new signed short[getSampleMemCapacity()/sizeof(short)];
+  sampleMemory=new DivSampleMemory(getSampleMemCapacity(),true);
+  sampleMem=(signed short*)sampleMemory->get();
   sampleMemLen=0;
   parent=p;
   dumpWrites=false;
@@ -1381,7 +1404,9 @@ int DivPlatformES5506::init(DivEngine* p, int channels, int sugRate, const DivCo
 }
 
 void DivPlatformES5506::quit() {
-  delete[] sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
   for (int i=0; i<32; i++) {
     delete oscBuf[i];
   }
@@ -21,6 +21,7 @@
 #define _ES5506_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
 #include "../engine.h"
 #include "../../fixedQueue.h"
 #include "../macroInt.h"
@@ -225,10 +226,15 @@ class DivPlatformES5506: public DivDispatch, public es550x_intf {
   Channel chan[32];
   DivDispatchOscBuffer* oscBuf[32];
   bool isMuted[32];
+  DivSampleMemory* sampleMemory;
   signed short* sampleMem; // ES5506 uses 16 bit data bus for samples
   size_t sampleMemLen;
   unsigned int sampleOffES5506[256];
   bool sampleLoaded[256];
+  unsigned int sampleRenderLen[256];
+
+  void copySample(DivSample* s, unsigned int pos, unsigned int length);
+
   struct QueuedHostIntf {
       unsigned char state;
       unsigned char step;
@@ -320,6 +326,7 @@ class DivPlatformES5506: public DivDispatch, public es550x_intf {
     virtual bool isSampleLoaded(int index, int sample) override;
     virtual const DivMemoryComposition* getMemCompo(int index) override;
     virtual void renderSamples(int sysID) override;
+    virtual bool renderSample(int sysID, int sample) override;
     virtual const char** getRegisterSheet() override;
     virtual int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags) override;
     virtual void quit() override;
@@ -141,6 +141,7 @@ class DivPlatformESFM: public DivDispatch {
 
   inline void immWrite(unsigned short a, unsigned char v) {
     if (!skipRegisterWrites) {
+      regWriteCount++;
       writes.push_back(QueuedWrite(a,v));
       if (dumpWrites) {
         addWrite(a,v);
@@ -25,7 +25,7 @@
 
 #define CHIP_FREQBASE 262144
 
-#define rWrite(a,v) if (!skipRegisterWrites) {doWrite(a,v); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; doWrite(a,v); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
 
 const char* regCheatSheetFDS[]={
   "IOCtrl", "4023",
@@ -99,6 +99,7 @@ class DivPlatformFMBase: public DivDispatch {
     }
     inline void immWrite(unsigned short a, unsigned char v) {
       if (!skipRegisterWrites) {
+        regWriteCount++;
         writes.push_back(QueuedWrite(a,v));
         if (dumpWrites) {
           addWrite(a,v);
@@ -108,6 +109,7 @@ class DivPlatformFMBase: public DivDispatch {
     // only used by OPN2 for DAC writes
     inline void urgentWrite(unsigned short a, unsigned char v) {
       if (!skipRegisterWrites && !flushFirst) {
+        regWriteCount++;
         if (!writes.empty()) {
           // check for hard reset
           if (writes.front().addr==0xf0) {
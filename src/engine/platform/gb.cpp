@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
 #define immWrite(a,v) {writes.push(QueuedWrite(a,v)); regPool[(a)&0x7f]=v; if (dumpWrites) {addWrite(a,v);} }
 
 #define CHIP_DIVIDER 16
@@ -261,8 +261,8 @@ void DivPlatformGB::tick(bool sysTick) {
         }
       }
     }
-    // run hardware sequence
-    if (chan[i].active) {
+    // run hardware sequence (only start it on low-latency input sub-ticks)
+    if (chan[i].active && (sysTick || chan[i].hwSeqDelay<=0)) {
       if (--chan[i].hwSeqDelay<=0) {
         chan[i].hwSeqDelay=0;
         DivInstrument* ins=parent->getIns(chan[i].ins,DIV_INS_GB);
@@ -285,7 +285,7 @@ void DivPlatformGB::tick(bool sysTick) {
               chan[i].sweepChanged=true;
               break;
             case DivInstrumentGB::DIV_GB_HWCMD_WAIT:
-              chan[i].hwSeqDelay=(data+1)*parent->tickMult;
+              chan[i].hwSeqDelay=data+1;
               leave=true;
               break;
             case DivInstrumentGB::DIV_GB_HWCMD_WAIT_REL:
@@ -135,7 +135,7 @@ void DivPlatformGenesis::processDAC(int iRate) {
   }
 }
 
-void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
+template<bool osc> void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
   thread_local short o[2];
   thread_local int os[2];
 
@@ -185,21 +185,23 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
         os[1]+=o[1];
       }
       //OPN2_Write(&fm,0,0);
-      if (i==5) {
-        if (fm.dacen) {
-          if (softPCM) {
-            oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+      if (osc) {
+        if (i==5) {
+          if (fm.dacen) {
+            if (softPCM) {
+              oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
+              oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+            } else {
+              oscBuf[i]->data[oscBuf[i]->needle++]=((fm.dacdata^0x100)-0x100)<<6;
+              oscBuf[6]->data[oscBuf[6]->needle++]=0;
+            }
           } else {
-            oscBuf[i]->data[oscBuf[i]->needle++]=((fm.dacdata^0x100)-0x100)<<6;
+            oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm.ch_out[i]<<(chipType==2?1:6),-32768,32767);
             oscBuf[6]->data[oscBuf[6]->needle++]=0;
           }
         } else {
           oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm.ch_out[i]<<(chipType==2?1:6),-32768,32767);
-          oscBuf[6]->data[oscBuf[6]->needle++]=0;
         }
-      } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm.ch_out[i]<<(chipType==2?1:6),-32768,32767);
       }
     }
     
@@ -216,7 +218,7 @@ void DivPlatformGenesis::acquire_nuked(short** buf, size_t len) {
   }
 }
 
-void DivPlatformGenesis::acquire_ymfm(short** buf, size_t len) {
+template<bool osc> void DivPlatformGenesis::acquire_ymfm(short** buf, size_t len) {
   thread_local int os[2];
 
   ymfm::ym2612::fm_engine* fme=fm_ymfm->debug_engine();
@@ -260,25 +262,27 @@ void DivPlatformGenesis::acquire_ymfm(short** buf, size_t len) {
     os[1]=out_ymfm.data[1];
     //OPN2_Write(&fm,0,0);
 
-    for (int i=0; i<6; i++) {
-      int chOut=(fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1))<<5;
-      if (chOut<-32768) chOut=-32768;
-      if (chOut>32767) chOut=32767;
-      if (i==5) {
-        if (fm_ymfm->debug_dac_enable()) {
-          if (softPCM) {
-            oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
-            oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+    if (osc) {
+      for (int i=0; i<6; i++) {
+        int chOut=(fme->debug_channel(i)->debug_output(0)+fme->debug_channel(i)->debug_output(1))<<5;
+        if (chOut<-32768) chOut=-32768;
+        if (chOut>32767) chOut=32767;
+        if (i==5) {
+          if (fm_ymfm->debug_dac_enable()) {
+            if (softPCM) {
+              oscBuf[5]->data[oscBuf[5]->needle++]=chan[5].dacOutput<<6;
+              oscBuf[6]->data[oscBuf[6]->needle++]=chan[6].dacOutput<<6;
+            } else {
+              oscBuf[i]->data[oscBuf[i]->needle++]=((fm_ymfm->debug_dac_data()^0x100)-0x100)<<6;
+              oscBuf[6]->data[oscBuf[6]->needle++]=0;
+            }
           } else {
-            oscBuf[i]->data[oscBuf[i]->needle++]=((fm_ymfm->debug_dac_data()^0x100)-0x100)<<6;
+            oscBuf[i]->data[oscBuf[i]->needle++]=chOut;
             oscBuf[6]->data[oscBuf[6]->needle++]=0;
           }
         } else {
           oscBuf[i]->data[oscBuf[i]->needle++]=chOut;
-          oscBuf[6]->data[oscBuf[6]->needle++]=0;
         }
-      } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=chOut;
       }
     }
     
@@ -358,7 +362,7 @@ void DivPlatformGenesis::acquire276OscSub() {
 }
 
 // thanks LTVA
-void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
+template<bool osc> void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
   for (size_t h=0; h<len; h++) {
     processDAC(rate);
 
@@ -386,14 +390,14 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
         sum_l+=fm_276.out_l;
         sum_r+=fm_276.out_r;
 
-        acquire276OscSub();
+        if (osc) acquire276OscSub();
 
         fm_276.input.wr=0;
         FMOPN2_Clock(&fm_276,1);
         sum_l+=fm_276.out_l;
         sum_r+=fm_276.out_r;
 
-        acquire276OscSub();
+        if (osc) acquire276OscSub();
 
         if (chipType==2) {
           if (!o_bco && fm_276.o_bco) {
@@ -416,13 +420,13 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
           sum_l+=fm_276.out_l;
           sum_r+=fm_276.out_r;
 
-          acquire276OscSub();
+          if (osc) acquire276OscSub();
 
           FMOPN2_Clock(&fm_276,1);
           sum_l+=fm_276.out_l;
           sum_r+=fm_276.out_r;
 
-          acquire276OscSub();
+          if (osc) acquire276OscSub();
 
           if (chipType==2) {
             if (!o_bco && fm_276.o_bco) {
@@ -449,13 +453,13 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
         sum_r+=fm_276.out_r;
         fm_276.input.wr=0;
 
-        acquire276OscSub();
+        if (osc) acquire276OscSub();
 
         FMOPN2_Clock(&fm_276,1);
         sum_l+=fm_276.out_l;
         sum_r+=fm_276.out_r;
 
-        acquire276OscSub();
+        if (osc) acquire276OscSub();
 
         if (chipType==2) {
           if (!o_bco && fm_276.o_bco) {
@@ -478,13 +482,13 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
           sum_l+=fm_276.out_l;
           sum_r+=fm_276.out_r;
 
-          acquire276OscSub();
+          if (osc) acquire276OscSub();
 
           FMOPN2_Clock(&fm_276,1);
           sum_l+=fm_276.out_l;
           sum_r+=fm_276.out_r;
 
-          acquire276OscSub();
+          if (osc) acquire276OscSub();
 
           if (chipType==2) {
             if (!o_bco && fm_276.o_bco) {
@@ -533,13 +537,13 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
       sum_l+=fm_276.out_l;
       sum_r+=fm_276.out_r;
 
-      acquire276OscSub();
+      if (osc) acquire276OscSub();
 
       FMOPN2_Clock(&fm_276,1);
       sum_l+=fm_276.out_l;
       sum_r+=fm_276.out_r;
 
-      acquire276OscSub();
+      if (osc) acquire276OscSub();
 
       if (chipType==2) {
         if (!o_bco && fm_276.o_bco) {
@@ -570,11 +574,23 @@ void DivPlatformGenesis::acquire_nuked276(short** buf, size_t len) {
 
 void DivPlatformGenesis::acquire(short** buf, size_t len) {
   if (useYMFM==2) {
-    acquire_nuked276(buf,len);
+    if (oscCapture) {
+      acquire_nuked276<true>(buf,len);
+    } else {
+      acquire_nuked276<false>(buf,len);
+    }
   } else if (useYMFM==1) {
-    acquire_ymfm(buf,len);
+    if (oscCapture) {
+      acquire_ymfm<true>(buf,len);
+    } else {
+      acquire_ymfm<false>(buf,len);
+    }
   } else {
-    acquire_nuked(buf,len);
+    if (oscCapture) {
+      acquire_nuked<true>(buf,len);
+    } else {
+      acquire_nuked<false>(buf,len);
+    }
   }
 }
 
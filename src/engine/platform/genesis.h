@@ -108,9 +108,9 @@ class DivPlatformGenesis: public DivPlatformOPN {
     inline void processDAC(int iRate);
     inline void commitState(int ch, DivInstrument* ins);
     void acquire276OscSub();
-    void acquire_nuked(short** buf, size_t len);
-    void acquire_nuked276(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
+    template<bool osc> void acquire_nuked(short** buf, size_t len);
+    template<bool osc> void acquire_nuked276(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm(short** buf, size_t len);
   
     friend void putDispatchChip(void*,int);
     friend void putDispatchChan(void*,int,int);
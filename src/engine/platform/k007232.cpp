@@ -19,10 +19,11 @@
 
 #include "k007232.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v);}}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if(dumpWrites) addWrite(a,v);}}
 
 #define CHIP_DIVIDER 64
 
@@ -541,42 +542,39 @@ void DivPlatformK007232::renderSamples(int sysID) {
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
 
-  size_t memPos=0;
+  // samples (plus their end marker) may not cross a 128KB boundary
+  std::vector<DivSampleMemItem> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
-    if (!s->renderOn[0][sysID]) {
-      sampleOffK007232[i]=0;
+    if (!s->renderOn[0][sysID]) continue;
+
+    int length=MIN(s->getLoopEndPosition(DIV_SAMPLE_DEPTH_8BIT),131072-2);
+    if (length<=0) {
+      sampleLoaded[i]=true;
       continue;
     }
-
-    const int length=s->getLoopEndPosition(DIV_SAMPLE_DEPTH_8BIT);
-    int actualLength=MIN((int)(getSampleMemCapacity()-memPos)-2,length);
-    if (actualLength>0) {
-      if (actualLength>131072-2) {
-        actualLength=131072-2;
-      }
-      if ((memPos&0xfe0000)!=((memPos+actualLength+1)&0xfe0000)) {
-        memPos=(memPos+0x1ffff)&0xfe0000;
-      }
-      sampleOffK007232[i]=memPos;
-      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+actualLength+1));
-      for (int j=0; j<actualLength; j++) {
-        // convert to 7 bit unsigned
-        unsigned char val=(unsigned char)(s->data8[j])^0x80;
-        sampleMem[memPos++]=(val>>1)&0x7f;
-      }
-      // write end of sample marker
-      memset(&sampleMem[memPos],0xc0,1);
-      memPos+=1;
+    items.push_back(DivSampleMemItem(i,length+1));
+  }
+  DivSampleMemPlanner plan(0,getSampleMemCapacity()-1,0x20000);
+  plan.plan(items);
+  for (DivSampleMemItem& i: items) {
+    if (!i.placed) {
+      logW("out of K007232 PCM memory for sample %d!",i.index);
+      continue;
     }
-    if ((memPos+MAX(actualLength,0))>=(getSampleMemCapacity()-1)) {
-      logW("out of K007232 PCM memory for sample %d!",i);
-      break;
-    } else {
-      sampleLoaded[i]=true;
+    DivSample* s=parent->song.sample[i.index];
+    for (size_t j=0; j<i.len-1; j++) {
+      // convert to 7 bit unsigned
+      unsigned char val=(unsigned char)(s->data8[j])^0x80;
+      sampleMem[i.pos+j]=(val>>1)&0x7f;
     }
+    // write end of sample marker
+    sampleMem[i.pos+i.len-1]=0xc0;
+    sampleOffK007232[i.index]=i.pos;
+    sampleLoaded[i.index]=true;
+    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
   }
-  sampleMemLen=memPos;
+  sampleMemLen=plan.getEnd();
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=16777216;
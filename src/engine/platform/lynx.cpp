@@ -22,7 +22,7 @@
 #include "../bsr.h"
 #include <math.h>
 
-#define rWrite(a,v) {if (!skipRegisterWrites) {mikey->write(a,v); if (dumpWrites) {addWrite(a,v);}}}
+#define rWrite(a,v) {if (!skipRegisterWrites) {regWriteCount++; mikey->write(a,v); if (dumpWrites) {addWrite(a,v);}}}
 
 #define WRITE_VOLUME(ch,v) rWrite(0x20+(ch<<3),(v))
 #define WRITE_FEEDBACK(ch,v) rWrite(0x21+(ch<<3),(v))
@@ -490,7 +490,12 @@ int DivPlatformLynx::getRegisterPoolSize()
 }
 
 void DivPlatformLynx::reset() {
-  mikey=std::make_unique<Lynx::Mikey>(rate);
+  // reset() may be called from the audio thread when the song loops
+  if (mikey) {
+    mikey->reset(rate);
+  } else {
+    mikey=std::make_unique<Lynx::Mikey>(rate);
+  }
 
   for (int i=0; i<4; i++) {
     chan[i]=DivPlatformLynx::Channel();
@@ -19,12 +19,13 @@
 
 #include "msm6295.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include <string.h>
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
-#define rWriteDelay(a,v,d) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v,d)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWriteDelay(a,v,d) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v,d)); if (dumpWrites) {addWrite(a,v);} }
 
 #define setPhrase(c) \
   if (isBanked) { \
@@ -394,45 +395,30 @@ void DivPlatformMSM6295::renderSamples(int sysID) {
   // sample data
   size_t memPos=128*8;
   if (isBanked) {
-    int bankInd=0;
-    int phraseInd=0;
+    // samples may not cross a 64KB bank, and every bank holds 32 phrases
+    std::vector<DivSampleMemItem> items;
     for (int i=0; i<parent->song.sampleLen; i++) {
       DivSample* s=parent->song.sample[i];
-      if (!s->renderOn[0][sysID]) {
-        sampleOffVOX[i]=0;
-        continue;
-      }
-
-      int paddedLen=s->lengthVOX;
+      if (!s->renderOn[0][sysID]) continue;
       // fit to single bank size
-      if (paddedLen>65536-0x400) {
-        paddedLen=65536-0x400;
-      }
-      // 32 phrase per bank
-      if ((phraseInd>=32)||((memPos&0xff0000)!=((memPos+paddedLen)&0xff0000))) {
-        memPos=((memPos+0xffff)&0xff0000)+0x400;
-        bankInd++;
-        phraseInd=0;
-      }
-      if (memPos>=getSampleMemCapacity(0)) {
-        logW("out of ADPCM memory for sample %d!",i);
-        break;
-      }
-      if (memPos+paddedLen>=getSampleMemCapacity(0)) {
-        memcpy(adpcmMem+memPos,s->dataVOX,getSampleMemCapacity(0)-memPos);
-        logW("out of ADPCM memory for sample %d!",i);
-      } else {
-        memcpy(adpcmMem+memPos,s->dataVOX,paddedLen);
-        sampleLoaded[i]=true;
+      items.push_back(DivSampleMemItem(i,MIN(s->lengthVOX,65536-0x400)));
+    }
+    DivSampleMemPlanner plan(memPos,getSampleMemCapacity(0),0x10000,1,0x400,0,32);
+    plan.plan(items);
+    for (DivSampleMemItem& i: items) {
+      if (!i.placed) {
+        logW("out of ADPCM memory for sample %d!",i.index);
+        continue;
       }
-      sampleOffVOX[i]=memPos;
-      bankedPhrase[i].bank=bankInd;
-      bankedPhrase[i].phrase=phraseInd;
-      bankedPhrase[i].length=paddedLen;
-      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-      memPos+=paddedLen;
-      phraseInd++;
+      memcpy(adpcmMem+i.pos,parent->song.sample[i.index]->dataVOX,i.len);
+      sampleLoaded[i.index]=true;
+      sampleOffVOX[i.index]=i.pos;
+      bankedPhrase[i.index].bank=i.bank;
+      bankedPhrase[i.index].phrase=i.slot;
+      bankedPhrase[i.index].length=i.len;
+      memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
     }
+    memPos=plan.getEnd();
     adpcmMemLen=memPos+256;
 
     // phrase book
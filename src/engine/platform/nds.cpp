@@ -25,7 +25,7 @@
 #define CHIP_DIVIDER 32
 
 #define rRead8(a) (nds.read8(a))
-#define rWrite8(a,v) {if(!skipRegisterWrites) {nds.write8((a),(v)); regPool[(a)]=(v); if(dumpWrites) addWrite((a),(v)); }}
+#define rWrite8(a,v) {if(!skipRegisterWrites) {regWriteCount++; nds.write8((a),(v)); regPool[(a)]=(v); if(dumpWrites) addWrite((a),(v)); }}
 #define rWrite16(a,v) { \
   if(!skipRegisterWrites) { \
     nds.write16((a)>>1,(v)); \
@@ -521,9 +521,10 @@ const DivMemoryComposition* DivPlatformNDS::getMemCompo(int index) {
 }
 
 void DivPlatformNDS::renderSamples(int sysID) {
-  memset(sampleMem,0,16777216);
+  sampleMem=sampleMemory->beginWrite();
   memset(sampleOff,0,256*sizeof(unsigned int));
   memset(sampleLoaded,0,256*sizeof(bool));
+  memset(sampleRenderLen,0,256*sizeof(unsigned int));
 
   memCompo=DivMemoryComposition();
   memCompo.name="Main Memory";
@@ -542,6 +543,7 @@ void DivPlatformNDS::renderSamples(int sysID) {
     if (actualLength>0) {
       memcpy(&sampleMem[memPos],src,actualLength);
       sampleOff[i]=memPos;
+      sampleRenderLen[i]=actualLength;
       memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+actualLength));
       memPos+=actualLength;
     }
@@ -554,11 +556,27 @@ void DivPlatformNDS::renderSamples(int sysID) {
     sampleLoaded[i]=true;
   }
   sampleMemLen=memPos;
+  sampleMem=sampleMemory->endWrite(sampleMemLen);
 
   memCompo.capacity=(isDSi?16777216:4194304);
   memCompo.used=sampleMemLen;
 }
 
+bool DivPlatformNDS::renderSample(int sysID, int sample) {
+  if (sample<0 || sample>=256) return false;
+  DivSample* s=parent->song.sample[sample];
+  if (!s->renderOn[0][sysID]) return (sampleRenderLen[sample]==0);
+  if (!sampleLoaded[sample]) return false;
+
+  int length=MIN(16777212,s->getCurBufLen());
+  if (length!=(int)sampleRenderLen[sample]) return false;
+
+  sampleMem=sampleMemory->beginWrite(false);
+  memcpy(&sampleMem[sampleOff[sample]],s->getCurBuf(),length);
+  sampleMem=sampleMemory->endWrite(sampleMemLen);
+  return true;
+}
+
 void DivPlatformNDS::setFlags(const DivConfig& flags) {
   isDSi=flags.getBool("chipType",0);
   chipClock=33513982;
@@ -604,7 +622,9 @@ int DivPlatformNDS::init(DivEngine* p, int channels, int sugRate, const DivConfi
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[16777216];
+  // not shared: sound capture writes to this memory
+  sampleMemory=new DivSampleMemory(16777216);
+  sampleMem=sampleMemory->get();
   sampleMemLen=0;
   nds.reset();
   setFlags(flags);
@@ -614,7 +634,9 @@ int DivPlatformNDS::init(DivEngine* p, int channels, int sugRate, const DivConfi
 }
 
 void DivPlatformNDS::quit() {
-  delete[] sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
@@ -21,6 +21,7 @@
 #define _NDS_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
 #include "sound/nds.hpp"
 
 using namespace nds_sound_emu;
@@ -51,7 +52,9 @@ class DivPlatformNDS: public DivDispatch, public nds_sound_intf {
   int globalVolume;
   unsigned int sampleOff[256];
   bool sampleLoaded[256];
+  unsigned int sampleRenderLen[256];
 
+  DivSampleMemory* sampleMemory;
   unsigned char* sampleMem;
   size_t sampleMemLen;
   int coreQuality;
@@ -91,6 +94,7 @@ class DivPlatformNDS: public DivDispatch, public nds_sound_intf {
     virtual bool isSampleLoaded(int index, int sample) override;
     virtual const DivMemoryComposition* getMemCompo(int index) override;
     virtual void renderSamples(int chipID) override;
+    virtual bool renderSample(int chipID, int sample) override;
     virtual void setFlags(const DivConfig& flags) override;
     void setCoreQuality(unsigned char q);
     virtual int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags) override;
@@ -24,7 +24,7 @@
 #include <math.h>
 
 #define rWrite(a,v) if (!skipRegisterWrites) {pendingWrites[a]=v;}
-#define immWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define immWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 
 #define KVSL(x,y) ((chan[x].state.op[orderedOpsL1[ops==4][y]].kvs==2 && isOutputL[ops==4][chan[x].state.alg][y]) || chan[x].state.op[orderedOpsL1[ops==4][y]].kvs==1)
 
@@ -159,7 +159,7 @@ const int orderedOpsL[4]={
 #define ADDR_FREQH 0xb0
 #define ADDR_LR_FB_ALG 0xc0
 
-void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
   thread_local short o[4];
   thread_local int os[4];
   thread_local ymfm::ymfm_output<2> aOut;
@@ -211,54 +211,56 @@ void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
       if (!isMuted[adpcmChan]) {
         os[0]-=aOut.data[0]>>3;
         os[1]-=aOut.data[0]>>3;
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
-      } else {
+        if (osc) oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
+      } else if (osc) {
         oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=0;
       }
     }
 
-    if (fm.rhy&0x20) {
-      for (int i=0; i<melodicChans+1; i++) {
-        unsigned char ch=outChanMap[i];
-        int chOut=0;
-        if (ch==255) continue;
-        if (fm.channel[i].out[0]!=NULL) {
-          chOut+=*fm.channel[ch].out[0];
-        }
-        if (fm.channel[i].out[1]!=NULL) {
-          chOut+=*fm.channel[ch].out[1];
-        }
-        if (fm.channel[i].out[2]!=NULL) {
-          chOut+=*fm.channel[ch].out[2];
-        }
-        if (fm.channel[i].out[3]!=NULL) {
-          chOut+=*fm.channel[ch].out[3];
-        }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<(i==melodicChans?1:2),-32768,32767);
-      }
-      // special
-      oscBuf[melodicChans+1]->data[oscBuf[melodicChans+1]->needle++]=fm.slot[16].out*4;
-      oscBuf[melodicChans+2]->data[oscBuf[melodicChans+2]->needle++]=fm.slot[14].out*4;
-      oscBuf[melodicChans+3]->data[oscBuf[melodicChans+3]->needle++]=fm.slot[17].out*4;
-      oscBuf[melodicChans+4]->data[oscBuf[melodicChans+4]->needle++]=fm.slot[13].out*4;
-    } else {
-      for (int i=0; i<chans; i++) {
-        unsigned char ch=outChanMap[i];
-        int chOut=0;
-        if (ch==255) continue;
-        if (fm.channel[i].out[0]!=NULL) {
-          chOut+=*fm.channel[ch].out[0];
-        }
-        if (fm.channel[i].out[1]!=NULL) {
-          chOut+=*fm.channel[ch].out[1];
-        }
-        if (fm.channel[i].out[2]!=NULL) {
-          chOut+=*fm.channel[ch].out[2];
+    if (osc) {
+      if (fm.rhy&0x20) {
+        for (int i=0; i<melodicChans+1; i++) {
+          unsigned char ch=outChanMap[i];
+          int chOut=0;
+          if (ch==255) continue;
+          if (fm.channel[i].out[0]!=NULL) {
+            chOut+=*fm.channel[ch].out[0];
+          }
+          if (fm.channel[i].out[1]!=NULL) {
+            chOut+=*fm.channel[ch].out[1];
+          }
+          if (fm.channel[i].out[2]!=NULL) {
+            chOut+=*fm.channel[ch].out[2];
+          }
+          if (fm.channel[i].out[3]!=NULL) {
+            chOut+=*fm.channel[ch].out[3];
+          }
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<(i==melodicChans?1:2),-32768,32767);
         }
-        if (fm.channel[i].out[3]!=NULL) {
-          chOut+=*fm.channel[ch].out[3];
+        // special
+        oscBuf[melodicChans+1]->data[oscBuf[melodicChans+1]->needle++]=fm.slot[16].out*4;
+        oscBuf[melodicChans+2]->data[oscBuf[melodicChans+2]->needle++]=fm.slot[14].out*4;
+        oscBuf[melodicChans+3]->data[oscBuf[melodicChans+3]->needle++]=fm.slot[17].out*4;
+        oscBuf[melodicChans+4]->data[oscBuf[melodicChans+4]->needle++]=fm.slot[13].out*4;
+      } else {
+        for (int i=0; i<chans; i++) {
+          unsigned char ch=outChanMap[i];
+          int chOut=0;
+          if (ch==255) continue;
+          if (fm.channel[i].out[0]!=NULL) {
+            chOut+=*fm.channel[ch].out[0];
+          }
+          if (fm.channel[i].out[1]!=NULL) {
+            chOut+=*fm.channel[ch].out[1];
+          }
+          if (fm.channel[i].out[2]!=NULL) {
+            chOut+=*fm.channel[ch].out[2];
+          }
+          if (fm.channel[i].out[3]!=NULL) {
+            chOut+=*fm.channel[ch].out[3];
+          }
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<2,-32768,32767);
         }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<2,-32768,32767);
       }
     }
     
@@ -292,7 +294,7 @@ void DivPlatformOPL::acquire_nuked(short** buf, size_t len) {
   }
 }
 
-void DivPlatformOPL::acquire_ymfm1(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_ymfm1(short** buf, size_t len) {
   ymfm::ymfm_output<1> out;
 
   ymfm::ym3526::fm_engine* fme=fm_ymfm1->debug_fm_engine();
@@ -318,23 +320,25 @@ void DivPlatformOPL::acquire_ymfm1(short** buf, size_t len) {
 
     buf[0][h]=out.data[0];
 
-    if (properDrums) {
-      for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
-      }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
-    } else {
-      for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+    if (osc) {
+      if (properDrums) {
+        for (int i=0; i<7; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
+        oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
+        oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
+        oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
+        oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
+      } else {
+        for (int i=0; i<9; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
       }
     }
   }
 }
 
-void DivPlatformOPL::acquire_ymfm2(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_ymfm2(short** buf, size_t len) {
   ymfm::ymfm_output<1> out;
 
   ymfm::ym3812::fm_engine* fme=fm_ymfm2->debug_fm_engine();
@@ -360,23 +364,25 @@ void DivPlatformOPL::acquire_ymfm2(short** buf, size_t len) {
 
     buf[0][h]=out.data[0];
 
-    if (properDrums) {
-      for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
-      }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
-    } else {
-      for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+    if (osc) {
+      if (properDrums) {
+        for (int i=0; i<7; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
+        oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
+        oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
+        oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
+        oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
+      } else {
+        for (int i=0; i<9; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
       }
     }
   }
 }
 
-void DivPlatformOPL::acquire_ymfm8950(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_ymfm8950(short** buf, size_t len) {
   ymfm::ymfm_output<1> out;
 
   ymfm::y8950::fm_engine* fme=fm_ymfm8950->debug_fm_engine();
@@ -403,25 +409,27 @@ void DivPlatformOPL::acquire_ymfm8950(short** buf, size_t len) {
 
     buf[0][h]=out.data[0];
 
-    if (properDrums) {
-      for (int i=0; i<7; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
-      }
-      oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
-      oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
-      oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
-      oscBuf[11]->data[oscBuf[11]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
-    } else {
-      for (int i=0; i<9; i++) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+    if (osc) {
+      if (properDrums) {
+        for (int i=0; i<7; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
+        oscBuf[7]->data[oscBuf[7]->needle++]=CLAMP(fmChan[7]->debug_special1()<<2,-32768,32767);
+        oscBuf[8]->data[oscBuf[8]->needle++]=CLAMP(fmChan[8]->debug_special1()<<2,-32768,32767);
+        oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(fmChan[8]->debug_special2()<<2,-32768,32767);
+        oscBuf[10]->data[oscBuf[10]->needle++]=CLAMP(fmChan[7]->debug_special2()<<2,-32768,32767);
+        oscBuf[11]->data[oscBuf[11]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
+      } else {
+        for (int i=0; i<9; i++) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fmChan[i]->debug_output(0)<<2,-32768,32767);
+        }
+        oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
       }
-      oscBuf[9]->data[oscBuf[9]->needle++]=CLAMP(abe->get_last_out(0),-32768,32767);
     }
   }
 }
 
-void DivPlatformOPL::acquire_ymfm3(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_ymfm3(short** buf, size_t len) {
   ymfm::ymfm_output<4> out;
 
   ymfm::ymf262::fm_engine* fme=fm_ymfm3->debug_fm_engine();
@@ -461,46 +469,48 @@ void DivPlatformOPL::acquire_ymfm3(short** buf, size_t len) {
       buf[5][h]=0;
     }
 
-    if (properDrums) {
-      for (int i=0; i<16; i++) {
-        unsigned char ch=(i<12 && chan[i&(~1)].fourOp)?outChanMap[i^1]:outChanMap[i];
-        if (ch==255) continue;
-        int chOut=fmChan[ch]->debug_output(0);
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(1);
-        }
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(2);
-        }
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(3);
+    if (osc) {
+      if (properDrums) {
+        for (int i=0; i<16; i++) {
+          unsigned char ch=(i<12 && chan[i&(~1)].fourOp)?outChanMap[i^1]:outChanMap[i];
+          if (ch==255) continue;
+          int chOut=fmChan[ch]->debug_output(0);
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(1);
+          }
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(2);
+          }
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(3);
+          }
+          if (i==15) {
+            oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
+          } else {
+            oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
+          }
         }
-        if (i==15) {
-          oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut,-32768,32767);
-        } else {
+        oscBuf[16]->data[oscBuf[16]->needle++]=CLAMP(fmChan[7]->debug_special2()<<1,-32768,32767);
+        oscBuf[17]->data[oscBuf[17]->needle++]=CLAMP(fmChan[8]->debug_special1()<<1,-32768,32767);
+        oscBuf[18]->data[oscBuf[18]->needle++]=CLAMP(fmChan[8]->debug_special2()<<1,-32768,32767);
+        oscBuf[19]->data[oscBuf[19]->needle++]=CLAMP(fmChan[7]->debug_special1()<<1,-32768,32767);
+      } else {
+        for (int i=0; i<18; i++) {
+          unsigned char ch=outChanMap[i];
+          if (ch==255) continue;
+          int chOut=fmChan[ch]->debug_output(0);
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(1);
+          }
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(2);
+          }
+          if (chOut==0) {
+            chOut=fmChan[ch]->debug_output(3);
+          }
           oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
         }
       }
-      oscBuf[16]->data[oscBuf[16]->needle++]=CLAMP(fmChan[7]->debug_special2()<<1,-32768,32767);
-      oscBuf[17]->data[oscBuf[17]->needle++]=CLAMP(fmChan[8]->debug_special1()<<1,-32768,32767);
-      oscBuf[18]->data[oscBuf[18]->needle++]=CLAMP(fmChan[8]->debug_special2()<<1,-32768,32767);
-      oscBuf[19]->data[oscBuf[19]->needle++]=CLAMP(fmChan[7]->debug_special1()<<1,-32768,32767);
-    } else {
-      for (int i=0; i<18; i++) {
-        unsigned char ch=outChanMap[i];
-        if (ch==255) continue;
-        int chOut=fmChan[ch]->debug_output(0);
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(1);
-        }
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(2);
-        }
-        if (chOut==0) {
-          chOut=fmChan[ch]->debug_output(3);
-        }
-        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(chOut<<1,-32768,32767);
-      }
     }
   }
 }
@@ -527,7 +537,7 @@ static const int cycleMap3Drums[36]={
   17, 15, 16, 18, 6, 8, 10, 6, 8, 10, 7, 9, 11, 7, 9, 11, 12, 13
 };
 
-void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
   int chOut[11];
   thread_local ymfm::ymfm_output<2> aOut;
 
@@ -641,15 +651,17 @@ void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
       }
     }
 
-    for (int i=0; i<11; i++) {
-      if (i>=6 && properDrums) {
-        chOut[i]<<=1;
-      } else {
-        chOut[i]<<=2;
+    if (osc) {
+      for (int i=0; i<11; i++) {
+        if (i>=6 && properDrums) {
+          chOut[i]<<=1;
+        } else {
+          chOut[i]<<=2;
+        }
+        if (chOut[i]<-32768) chOut[i]=-32768;
+        if (chOut[i]>32767) chOut[i]=32767;
+        oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
       }
-      if (chOut[i]<-32768) chOut[i]=-32768;
-      if (chOut[i]>32767) chOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
     }
 
     if (chipType==8950) {
@@ -659,8 +671,8 @@ void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
 
       if (!isMuted[adpcmChan]) {
         dacOut-=aOut.data[0]>>3;
-        oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
-      } else {
+        if (osc) oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=aOut.data[0]>>1;
+      } else if (osc) {
         oscBuf[adpcmChan]->data[oscBuf[adpcmChan]->needle++]=0;
       }
     }
@@ -672,7 +684,7 @@ void DivPlatformOPL::acquire_nukedLLE2(short** buf, size_t len) {
   }
 }
 
-void DivPlatformOPL::acquire_nukedLLE3(short** buf, size_t len) {
+template<bool osc> void DivPlatformOPL::acquire_nukedLLE3(short** buf, size_t len) {
   int chOut[20];
   int ch=0;
 
@@ -772,15 +784,17 @@ void DivPlatformOPL::acquire_nukedLLE3(short** buf, size_t len) {
       }
     }
 
-    for (int i=0; i<20; i++) {
-      /*if (i>=15 && properDrums) {
-        chOut[i]<<=1;
-      } else {
-        chOut[i]<<=2;
-      }*/
-      if (chOut[i]<-32768) chOut[i]=-32768;
-      if (chOut[i]>32767) chOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
+    if (osc) {
+      for (int i=0; i<20; i++) {
+        /*if (i>=15 && properDrums) {
+          chOut[i]<<=1;
+        } else {
+          chOut[i]<<=2;
+        }*/
+        if (chOut[i]<-32768) chOut[i]=-32768;
+        if (chOut[i]>32767) chOut[i]=32767;
+        oscBuf[i]->data[oscBuf[i]->needle++]=chOut[i];
+      }
     }
 
     for (int i=0; i<MIN(4,totalOutputs); i++) {
@@ -796,29 +810,57 @@ void DivPlatformOPL::acquire(short** buf, size_t len) {
   if (emuCore==2) { // LLE
     switch (chipType) {
       case 1: case 2: case 8950:
-        acquire_nukedLLE2(buf,len);
+        if (oscCapture) {
+          acquire_nukedLLE2<true>(buf,len);
+        } else {
+          acquire_nukedLLE2<false>(buf,len);
+        }
         break;
       case 3: case 759:
-        acquire_nukedLLE3(buf,len);
+        if (oscCapture) {
+          acquire_nukedLLE3<true>(buf,len);
+        } else {
+          acquire_nukedLLE3<false>(buf,len);
+        }
         break;
     }
   } else if (emuCore==1) { // ymfm
     switch (chipType) {
       case 1:
-        acquire_ymfm1(buf,len);
+        if (oscCapture) {
+          acquire_ymfm1<true>(buf,len);
+        } else {
+          acquire_ymfm1<false>(buf,len);
+        }
         break;
       case 2:
-        acquire_ymfm2(buf,len);
+        if (oscCapture) {
+          acquire_ymfm2<true>(buf,len);
+        } else {
+          acquire_ymfm2<false>(buf,len);
+        }
         break;
       case 8950:
-        acquire_ymfm8950(buf,len);
+        if (oscCapture) {
+          acquire_ymfm8950<true>(buf,len);
+        } else {
+          acquire_ymfm8950<false>(buf,len);
+        }
         break;
       case 3: case 759:
-        acquire_ymfm3(buf,len);
+        if (oscCapture) {
+          acquire_ymfm3<true>(buf,len);
+        } else {
+          acquire_ymfm3<false>(buf,len);
+        }
         break;
     }
   } else { // OPL3
-    acquire_nuked(buf,len);
+    if (oscCapture) {
+      acquire_nuked<true>(buf,len);
+    } else {
+      acquire_nuked<false>(buf,len);
+    }
   }
 }
 
@@ -137,13 +137,13 @@ class DivPlatformOPL: public DivDispatch {
     friend void putDispatchChip(void*,int);
     friend void putDispatchChan(void*,int,int);
 
-    void acquire_nukedLLE2(short** buf, size_t len);
-    void acquire_nukedLLE3(short** buf, size_t len);
-    void acquire_nuked(short** buf, size_t len);
-    void acquire_ymfm3(short** buf, size_t len);
-    void acquire_ymfm8950(short** buf, size_t len);
-    void acquire_ymfm2(short** buf, size_t len);
-    void acquire_ymfm1(short** buf, size_t len);
+    template<bool osc> void acquire_nukedLLE2(short** buf, size_t len);
+    template<bool osc> void acquire_nukedLLE3(short** buf, size_t len);
+    template<bool osc> void acquire_nuked(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm3(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm8950(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm2(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm1(short** buf, size_t len);
   
   public:
     void acquire(short** buf, size_t len);
@@ -21,6 +21,7 @@
 #include "pcmdac.h"
 #include "../engine.h"
 #include "../filter.h"
+#include "../resampleKernels.h"
 #include <math.h>
 
 // to ease the driver, freqency register is a 8.16 counter relative to output sample rate
@@ -28,135 +29,31 @@
 
 void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
   const int depthScale=(15-outDepth);
+  const DivResampleKernels& kernels=DivResampleKernels::get();
   int output=0;
-  for (size_t h=0; h<len; h++) {
-    if (!chan[0].active) {
+  if (!chan[0].active) {
+    for (size_t h=0; h<len; h++) {
       buf[0][h]=0;
       buf[1][h]=0;
       oscBuf->data[oscBuf->needle++]=0;
-      continue;
     }
-    if (chan[0].useWave || (chan[0].sample>=0 && chan[0].sample<parent->song.sampleLen)) {
-      chan[0].audSub+=chan[0].freq;
-      if (chan[0].useWave) {
-        while (chan[0].audSub>=0x10000) {
-          chan[0].audSub-=0x10000;
-          chan[0].audPos+=((!chan[0].useWave) && chan[0].audDir)?-1:1;
-          if (chan[0].audPos>=(int)chan[0].audLen) {
-            chan[0].audPos%=chan[0].audLen;
-            chan[0].audDir=false;
-          }
-          chan[0].audDat[0]=chan[0].audDat[1];
-          chan[0].audDat[1]=chan[0].audDat[2];
-          chan[0].audDat[2]=chan[0].audDat[3];
-          chan[0].audDat[3]=chan[0].audDat[4];
-          chan[0].audDat[4]=chan[0].audDat[5];
-          chan[0].audDat[5]=chan[0].audDat[6];
-          chan[0].audDat[6]=chan[0].audDat[7];
-          chan[0].audDat[7]=(chan[0].ws.output[chan[0].audPos]-0x80)<<8;
-        }
-
-        const short s0=chan[0].audDat[0];
-        const short s1=chan[0].audDat[1];
-        const short s2=chan[0].audDat[2];
-        const short s3=chan[0].audDat[3];
-        const short s4=chan[0].audDat[4];
-        const short s5=chan[0].audDat[5];
-        const short s6=chan[0].audDat[6];
-        const short s7=chan[0].audDat[7];
+    return;
+  }
+  for (size_t base=0; base<len; base+=DIV_RESAMPLE_BLOCK) {
+    const size_t blockLen=MIN(len-base,DIV_RESAMPLE_BLOCK);
 
-        switch (interp) {
-          case 1: // linear
-            output=s6+(((int)((int)s7-(int)s6)*((chan[0].audSub>>1)&0x7fff))>>15);
-            break;
-          case 2: { // cubic
-            float* cubicTable=DivFilterTables::getCubicTable();
-            float* t=&cubicTable[((chan[0].audSub&0xffff)>>6)<<2];
-            float result=(float)s4*t[0]+(float)s5*t[1]+(float)s6*t[2]+(float)s7*t[3];
-            if (result<-32768) result=-32768;
-            if (result>32767) result=32767;
-            output=result;
-            break;
-          }
-          case 3: { // sinc
-            float* sincTable=DivFilterTables::getSincTable8();
-            float* t1=&sincTable[(8191-((chan[0].audSub&0xffff)>>3))<<2];
-            float* t2=&sincTable[((chan[0].audSub&0xffff)>>3)<<2];
-            float result=(
-              s0*t2[3]+
-              s1*t2[2]+
-              s2*t2[1]+
-              s3*t2[0]+
-              s4*t1[0]+
-              s5*t1[1]+
-              s6*t1[2]+
-              s7*t1[3]
-            );
-            if (result<-32768) result=-32768;
-            if (result>32767) result=32767;
-            output=result;
-            break;
-          }
-          default: // none
-            output=s7;
-            break;
-        }
-      } else {
-        DivSample* s=parent->getSample(chan[0].sample);
-        if (s->samples>0) {
+    // step through the sample, gathering the interpolation window of every output...
+    for (size_t h=0; h<blockLen; h++) {
+      interpHold[h]=true;
+      if (chan[0].useWave || (chan[0].sample>=0 && chan[0].sample<parent->song.sampleLen)) {
+        chan[0].audSub+=chan[0].freq;
+        if (chan[0].useWave) {
           while (chan[0].audSub>=0x10000) {
             chan[0].audSub-=0x10000;
             chan[0].audPos+=((!chan[0].useWave) && chan[0].audDir)?-1:1;
-            if (chan[0].audDir) {
-              if (s->isLoopable()) {
-                switch (s->loopMode) {
-                  case DIV_SAMPLE_LOOP_FORWARD:
-                  case DIV_SAMPLE_LOOP_PINGPONG:
-                    if (chan[0].audPos<s->loopStart) {
-                      chan[0].audPos=s->loopStart+(s->loopStart-chan[0].audPos);
-                      chan[0].audDir=false;
-                    }
-                    break;
-                  case DIV_SAMPLE_LOOP_BACKWARD:
-                    if (chan[0].audPos<s->loopStart) {
-                      chan[0].audPos=s->loopEnd-1-(s->loopStart-chan[0].audPos);
-                      chan[0].audDir=true;
-                    }
-                    break;
-                  default:
-                    if (chan[0].audPos<0) {
-                      chan[0].sample=-1;
-                    }
-                    break;
-                }
-              } else if (chan[0].audPos>=(int)s->samples) {
-                chan[0].sample=-1;
-              }
-            } else {
-              if (s->isLoopable()) {
-                switch (s->loopMode) {
-                  case DIV_SAMPLE_LOOP_FORWARD:
-                    if (chan[0].audPos>=s->loopEnd) {
-                      chan[0].audPos=(chan[0].audPos+s->loopStart)-s->loopEnd;
-                      chan[0].audDir=false;
-                    }
-                    break;
-                  case DIV_SAMPLE_LOOP_BACKWARD:
-                  case DIV_SAMPLE_LOOP_PINGPONG:
-                    if (chan[0].audPos>=s->loopEnd) {
-                      chan[0].audPos=s->loopEnd-1-(s->loopEnd-1-chan[0].audPos);
-                      chan[0].audDir=true;
-                    }
-                    break;
-                  default:
-                    if (chan[0].audPos>=(int)s->samples) {
-                      chan[0].sample=-1;
-                    }
-                    break;
-                }
-              } else if (chan[0].audPos>=(int)s->samples) {
-                chan[0].sample=-1;
-              }
+            if (chan[0].audPos>=(int)chan[0].audLen) {
+              chan[0].audPos%=chan[0].audLen;
+              chan[0].audDir=false;
             }
             chan[0].audDat[0]=chan[0].audDat[1];
             chan[0].audDat[1]=chan[0].audDat[2];
@@ -165,78 +62,141 @@ void DivPlatformPCMDAC::acquire(short** buf, size_t len) {
             chan[0].audDat[4]=chan[0].audDat[5];
             chan[0].audDat[5]=chan[0].audDat[6];
             chan[0].audDat[6]=chan[0].audDat[7];
-            if (chan[0].audPos>=0 && chan[0].audPos<(int)s->samples) {
-              chan[0].audDat[7]=s->data16[chan[0].audPos];
-            } else {
-              chan[0].audDat[7]=0;
-            }
+            chan[0].audDat[7]=(chan[0].ws.output[chan[0].audPos]-0x80)<<8;
           }
         } else {
-          chan[0].sample=-1;
-          chan[0].audSub=0;
-          chan[0].audPos=0;
-        }
-
-        const short s0=chan[0].audDat[0];
-        const short s1=chan[0].audDat[1];
-        const short s2=chan[0].audDat[2];
-        const short s3=chan[0].audDat[3];
-        const short s4=chan[0].audDat[4];
-        const short s5=chan[0].audDat[5];
-        const short s6=chan[0].audDat[6];
-        const short s7=chan[0].audDat[7];
-
-        switch (interp) {
-          case 1: // linear
-            output=s6+(((int)((int)s7-(int)s6)*((chan[0].audSub>>1)&0x7fff))>>15);
-            break;
-          case 2: { // cubic
-            float* cubicTable=DivFilterTables::getCubicTable();
-            float* t=&cubicTable[((chan[0].audSub&0xffff)>>6)<<2];
-            float result=(float)s4*t[0]+(float)s5*t[1]+(float)s6*t[2]+(float)s7*t[3];
-            if (result<-32768) result=-32768;
-            if (result>32767) result=32767;
-            output=result;
-            break;
-          }
-          case 3: { // sinc
-            float* sincTable=DivFilterTables::getSincTable8();
-            float* t1=&sincTable[(8191-((chan[0].audSub&0xffff)>>3))<<2];
-            float* t2=&sincTable[((chan[0].audSub&0xffff)>>3)<<2];
-            float result=(
-              s0*t2[3]+
-              s1*t2[2]+
-              s2*t2[1]+
-              s3*t2[0]+
-              s4*t1[0]+
-              s5*t1[1]+
-              s6*t1[2]+
-              s7*t1[3]
-            );
-            if (result<-32768) result=-32768;
-            if (result>32767) result=32767;
-            output=result;
-            break;
+          DivSample* s=parent->getSample(chan[0].sample);
+          if (s->samples>0) {
+            while (chan[0].audSub>=0x10000) {
+              chan[0].audSub-=0x10000;
+              chan[0].audPos+=((!chan[0].useWave) && chan[0].audDir)?-1:1;
+              if (chan[0].audDir) {
+                if (s->isLoopable()) {
+                  switch (s->loopMode) {
+                    case DIV_SAMPLE_LOOP_FORWARD:
+                    case DIV_SAMPLE_LOOP_PINGPONG:
+                      if (chan[0].audPos<s->loopStart) {
+                        chan[0].audPos=s->loopStart+(s->loopStart-chan[0].audPos);
+                        chan[0].audDir=false;
+                      }
+                      break;
+                    case DIV_SAMPLE_LOOP_BACKWARD:
+                      if (chan[0].audPos<s->loopStart) {
+                        chan[0].audPos=s->loopEnd-1-(s->loopStart-chan[0].audPos);
+                        chan[0].audDir=true;
+                      }
+                      break;
+                    default:
+                      if (chan[0].audPos<0) {
+                        chan[0].sample=-1;
+                      }
+                      break;
+                  }
+                } else if (chan[0].audPos>=(int)s->samples) {
+                  chan[0].sample=-1;
+                }
+              } else {
+                if (s->isLoopable()) {
+                  switch (s->loopMode) {
+                    case DIV_SAMPLE_LOOP_FORWARD:
+                      if (chan[0].audPos>=s->loopEnd) {
+                        chan[0].audPos=(chan[0].audPos+s->loopStart)-s->loopEnd;
+                        chan[0].audDir=false;
+                      }
+                      break;
+                    case DIV_SAMPLE_LOOP_BACKWARD:
+                    case DIV_SAMPLE_LOOP_PINGPONG:
+                      if (chan[0].audPos>=s->loopEnd) {
+                        chan[0].audPos=s->loopEnd-1-(s->loopEnd-1-chan[0].audPos);
+                        chan[0].audDir=true;
+                      }
+                      break;
+                    default:
+                      if (chan[0].audPos>=(int)s->samples) {
+                        chan[0].sample=-1;
+                      }
+                      break;
+                  }
+                } else if (chan[0].audPos>=(int)s->samples) {
+                  chan[0].sample=-1;
+                }
+              }
+              chan[0].audDat[0]=chan[0].audDat[1];
+              chan[0].audDat[1]=chan[0].audDat[2];
+              chan[0].audDat[2]=chan[0].audDat[3];
+              chan[0].audDat[3]=chan[0].audDat[4];
+              chan[0].audDat[4]=chan[0].audDat[5];
+              chan[0].audDat[5]=chan[0].audDat[6];
+              chan[0].audDat[6]=chan[0].audDat[7];
+              if (chan[0].audPos>=0 && chan[0].audPos<(int)s->samples) {
+                chan[0].audDat[7]=s->data16[chan[0].audPos];
+              } else {
+                chan[0].audDat[7]=0;
+              }
+            }
+          } else {
+            chan[0].sample=-1;
+            chan[0].audSub=0;
+            chan[0].audPos=0;
           }
-          default: // none
-            output=s7;
-            break;
         }
+        for (int i=0; i<8; i++) {
+          interpWin[i*DIV_RESAMPLE_BLOCK+h]=chan[0].audDat[i];
+        }
+        interpPos[h]=chan[0].audSub&0xffff;
+        interpHold[h]=false;
       }
     }
-    if (isMuted) {
-      output=0;
-    } else {
-      output=((output*MIN(volMax,chan[0].vol)*MIN(chan[0].envVol,64))>>6)/volMax;
+
+    // ...then interpolate the whole block at once
+    switch (interp) {
+      case 1: // linear
+        for (size_t h=0; h<blockLen; h++) {
+          interpPos[h]=(interpPos[h]>>1)&0x7fff;
+        }
+        kernels.linear(&interpWin[6*DIV_RESAMPLE_BLOCK],DIV_RESAMPLE_BLOCK,interpPos,interpOut,blockLen);
+        break;
+      case 2: // cubic
+        for (size_t h=0; h<blockLen; h++) {
+          interpPos[h]>>=6;
+        }
+        kernels.cubic(&interpWin[4*DIV_RESAMPLE_BLOCK],DIV_RESAMPLE_BLOCK,interpPos,interpOut,blockLen);
+        break;
+      case 3: // sinc
+        for (size_t h=0; h<blockLen; h++) {
+          interpPos[h]>>=3;
+        }
+        kernels.sinc8(interpWin,DIV_RESAMPLE_BLOCK,interpPos,interpOut,blockLen);
+        break;
+      default: // none
+        for (size_t h=0; h<blockLen; h++) {
+          interpOut[h]=interpWin[7*DIV_RESAMPLE_BLOCK+h];
+        }
+        break;
     }
-    oscBuf->data[oscBuf->needle++]=((output>>depthScale)<<depthScale)>>1;
-    if (outStereo) {
-      buf[0][h]=((output*chan[0].panL)>>(depthScale+8))<<depthScale;
-      buf[1][h]=((output*chan[0].panR)>>(depthScale+8))<<depthScale;
-    } else {
-      output=(output>>depthScale)<<depthScale;
-      buf[0][h]=output;
-      buf[1][h]=output;
+
+    for (size_t h=0; h<blockLen; h++) {
+      // if the sample ended, the last output is held
+      if (!interpHold[h]) {
+        float result=interpOut[h];
+        if (result<-32768) result=-32768;
+        if (result>32767) result=32767;
+        output=result;
+      }
+      if (isMuted) {
+        output=0;
+      } else {
+        output=((output*MIN(volMax,chan[0].vol)*MIN(chan[0].envVol,64))>>6)/volMax;
+      }
+      oscBuf->data[oscBuf->needle++]=((output>>depthScale)<<depthScale)>>1;
+      if (outStereo) {
+        buf[0][base+h]=((output*chan[0].panL)>>(depthScale+8))<<depthScale;
+        buf[1][base+h]=((output*chan[0].panR)>>(depthScale+8))<<depthScale;
+      } else {
+        output=(output>>depthScale)<<depthScale;
+        buf[0][base+h]=output;
+        buf[1][base+h]=output;
+      }
     }
   }
 }
@@ -553,6 +513,9 @@ int DivPlatformPCMDAC::init(DivEngine* p, int channels, int sugRate, const DivCo
   skipRegisterWrites=false;
   oscBuf=new DivDispatchOscBuffer;
   isMuted=false;
+  // pick the resampling kernels now, since that builds the filter tables
+  // and acquire() runs on the audio thread
+  DivResampleKernels::get();
   setFlags(flags);
   reset();
   return 1;
@@ -22,6 +22,7 @@
 
 #include "../dispatch.h"
 #include "../waveSynth.h"
+#include "../resampleKernels.h"
 
 class DivPlatformPCMDAC: public DivDispatch {
   struct Channel: public SharedChannel<int> {
@@ -65,6 +66,13 @@ class DivPlatformPCMDAC: public DivDispatch {
   int volMax;
   bool outStereo;
 
+  // acquire() gathers a block of interpolation windows (one row per tap)
+  // and positions here before running the kernel on all of them
+  short interpWin[8*DIV_RESAMPLE_BLOCK];
+  unsigned short interpPos[DIV_RESAMPLE_BLOCK];
+  float interpOut[DIV_RESAMPLE_BLOCK];
+  bool interpHold[DIV_RESAMPLE_BLOCK];
+
   friend void putDispatchChip(void*,int);
   friend void putDispatchChan(void*,int,int);
 
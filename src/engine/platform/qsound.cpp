@@ -19,13 +19,14 @@
 
 #include "qsound.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include <math.h>
 
 #define CHIP_DIVIDER (1248*2)
 #define QS_NOTE_FREQUENCY(x) parent->calcBaseFreq(440,4096,(x)-3,false)
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v); }}
 #define immWrite(a,v) {qsound_write_data(&chip,a,v); if(dumpWrites) addWrite(a,v);}
 
 const char* regCheatSheetQSound[]={
@@ -761,79 +762,59 @@ void DivPlatformQSound::renderSamples(int sysID) {
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
 
-  size_t memPos=0;
+  memset(offPCM,0,256*sizeof(unsigned int));
+  memset(offBS,0,256*sizeof(unsigned int));
+
+  // PCM samples may not cross a 64KB boundary. each one is followed by 16 bytes of silence
+  std::vector<DivSampleMemItem> items;
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
-    if (!s->renderOn[0][sysID]) {
-      offPCM[i]=0;
+    if (!s->renderOn[0][sysID]) continue;
+    items.push_back(DivSampleMemItem(i,MIN(s->length8,65536-16)+16));
+  }
+  DivSampleMemPlanner planPCM(0,getSampleMemCapacity(),0x10000);
+  planPCM.plan(items);
+  for (DivSampleMemItem& i: items) {
+    if (!i.placed) {
+      logW("out of QSound PCM memory for sample %d!",i.index);
       continue;
     }
-
-    int length=s->length8;
-    if (length>65536-16) {
-      length=65536-16;
-    }
-    if ((memPos&0xff0000)!=((memPos+length)&0xff0000)) {
-      memPos=(memPos+0xffff)&0xff0000;
-    }
-    if (memPos>=getSampleMemCapacity()) {
-      logW("out of QSound PCM memory for sample %d!",i);
-      break;
-    }
-    if (memPos+length>=getSampleMemCapacity()) {
-      for (unsigned int i=0; i<getSampleMemCapacity()-(memPos+length); i++) {
-        sampleMem[(memPos+i)^0x8000]=s->data8[i];
-      }
-      logW("out of QSound PCM memory for sample %d!",i);
-    } else {
-      for (int i=0; i<length; i++) {
-        sampleMem[(memPos+i)^0x8000]=s->data8[i];
-      }
-      sampleLoaded[i]=true;
+    DivSample* s=parent->song.sample[i.index];
+    for (size_t j=0; j<i.len-16; j++) {
+      sampleMem[(i.pos+j)^0x8000]=s->data8[j];
     }
-    offPCM[i]=memPos^0x8000;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"PCM",i,memPos,memPos+length));
-    memPos+=length+16;
+    sampleLoaded[i.index]=true;
+    offPCM[i.index]=i.pos^0x8000;
+    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"PCM",i.index,i.pos,i.pos+i.len-16));
   }
-  sampleMemLen=memPos+256;
+  sampleMemLen=planPCM.getEnd()+256;
 
-  memPos=(memPos+0xffff)&0xff0000;
+  // ADPCM samples go after PCM ones, starting at the next bank
+  size_t memPos=(planPCM.getEnd()+0xffff)&0xff0000;
   sampleMemUsage=memPos;
 
+  items.clear();
   for (int i=0; i<parent->song.sampleLen; i++) {
     DivSample* s=parent->song.sample[i];
-    if (!s->renderOn[1][sysID]) {
-      offBS[i]=0;
+    if (!s->renderOn[1][sysID]) continue;
+    items.push_back(DivSampleMemItem(i,MIN(s->lengthQSoundA,65536-16)+16));
+  }
+  DivSampleMemPlanner planBS(memPos,getSampleMemCapacity(),0x10000);
+  planBS.plan(items);
+  for (DivSampleMemItem& i: items) {
+    if (!i.placed) {
+      logW("out of QSound ADPCM memory for sample %d!",i.index);
       continue;
     }
-
-    int length=s->lengthQSoundA;
-    if (length>65536) {
-      length=65536;
-    }
-    if ((memPos&0xff0000)!=((memPos+length)&0xff0000)) {
-      memPos=(memPos+0xffff)&0xff0000;
-    }
-    if (memPos>=getSampleMemCapacity()) {
-      logW("out of QSound ADPCM memory for sample %d!",i);
-      break;
-    }
-    if (memPos+length>=getSampleMemCapacity()) {
-      for (unsigned int i=0; i<getSampleMemCapacity()-(memPos+length); i++) {
-        sampleMem[(memPos+i)]=s->dataQSoundA[i];
-      }
-      logW("out of QSound ADPCM memory for sample %d!",i);
-    } else {
-      for (int i=0; i<length; i++) {
-        sampleMem[(memPos+i)]=s->dataQSoundA[i];
-      }
-      sampleLoadedBS[i]=true;
+    DivSample* s=parent->song.sample[i.index];
+    for (size_t j=0; j<i.len-16; j++) {
+      sampleMem[i.pos+j]=s->dataQSoundA[j];
     }
-    offBS[i]=memPos;
-    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE_ALT1,"ADPCM",i,memPos,memPos+length));
-    memPos+=length+16;
+    sampleLoadedBS[i.index]=true;
+    offBS[i.index]=i.pos;
+    memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE_ALT1,"ADPCM",i.index,i.pos,i.pos+i.len-16));
   }
-  sampleMemLenBS=memPos+256;
+  sampleMemLenBS=planBS.getEnd()+256;
 
   memCompo.used=sampleMemLenBS;
   memCompo.capacity=getSampleMemCapacity(0);
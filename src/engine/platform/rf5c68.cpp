@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if(!skipRegisterWrites) {rf5c68.rf5c68_w(a,v); regPool[a]=v; if(dumpWrites) addWrite(a,v);}}
+#define rWrite(a,v) {if(!skipRegisterWrites) {regWriteCount++; rf5c68.rf5c68_w(a,v); regPool[a]=v; if(dumpWrites) addWrite(a,v);}}
 
 #define CHIP_FREQBASE 786432
 
@@ -378,7 +378,7 @@ void DivPlatformRF5C68::setFlags(const DivConfig& flags) {
     oscBuf[i]->rate=rate;
   }
   rf5c68=(chipType==1)?rf5c164_device():rf5c68_device();
-  rf5c68.device_start(sampleMem);
+  rf5c68.device_start(sampleMem,256);
 }
 
 void DivPlatformRF5C68::poke(unsigned int addr, unsigned short val) {
@@ -23,7 +23,7 @@
 
 #define CHIP_DIVIDER 16
 
-#define rWrite(a,v) {if (!skipRegisterWrites) {scc->scc_w(true,a,v); regPool[a]=v; if (dumpWrites) addWrite(a,v); }}
+#define rWrite(a,v) {if (!skipRegisterWrites) {regWriteCount++; scc->scc_w(true,a,v); regPool[a]=v; if (dumpWrites) addWrite(a,v); }}
 
 const char* regCheatSheetSCC[]={
   "Ch1_Wave", "00",
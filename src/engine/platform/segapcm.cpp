@@ -23,7 +23,7 @@
 #include <string.h>
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 #define chWrite(c,a,v) rWrite(((c)<<3)+(a),v)
 
 void DivPlatformSegaPCM::acquire(short** buf, size_t len) {
@@ -500,7 +500,7 @@ const DivMemoryComposition* DivPlatformSegaPCM::getMemCompo(int index) {
 void DivPlatformSegaPCM::renderSamples(int sysID) {
   size_t memPos=0;
 
-  memset(sampleMem,0,2097152);
+  sampleMem=sampleMemory->beginWrite();
   memset(sampleLoaded,0,256*sizeof(bool));
   memset(sampleOffSegaPCM,0,256*sizeof(unsigned int));
   memset(sampleEndSegaPCM,0,256);
@@ -536,6 +536,7 @@ void DivPlatformSegaPCM::renderSamples(int sysID) {
     if (memPos>=2097152) break;
   }
   sampleMemLen=memPos;
+  sampleMem=sampleMemory->endWrite(sampleMemLen);
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
@@ -564,7 +565,8 @@ int DivPlatformSegaPCM::init(DivEngine* p, int channels, int sugRate, const DivC
     isMuted[i]=false;
     oscBuf[i]=new DivDispatchOscBuffer;
   }
-  sampleMem=new unsigned char[2097152];
+  sampleMemory=new DivSampleMemory(2097152,true);
+  sampleMem=sampleMemory->get();
   pcm.set_bank(segapcm_device::BANK_12M|segapcm_device::BANK_MASKF8);
   pcm.set_read([this](unsigned int addr) -> unsigned char {
     return sampleMem[addr&0x1fffff];
@@ -579,7 +581,9 @@ void DivPlatformSegaPCM::quit() {
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
-  delete sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
 }
 
 DivPlatformSegaPCM::~DivPlatformSegaPCM() {
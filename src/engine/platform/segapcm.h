@@ -21,6 +21,7 @@
 #define _SEGAPCM_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
 #include "../instrument.h"
 #include "sound/segapcm.h"
 #include "../../fixedQueue.h"
@@ -54,6 +55,7 @@ class DivPlatformSegaPCM: public DivDispatch {
     };
     Channel chan[16];
     DivDispatchOscBuffer* oscBuf[16];
+    DivSampleMemory* sampleMemory;
     unsigned char* sampleMem;
     size_t sampleMemLen;
     struct QueuedWrite {
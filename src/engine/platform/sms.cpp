@@ -22,7 +22,7 @@
 #include "../../ta-log.h"
 #include <math.h>
 
-#define rWrite(a,v) {if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
+#define rWrite(a,v) {if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}}
 
 const char* regCheatSheetSN[]={
   "DATA", "0",
@@ -60,7 +60,7 @@ void DivPlatformSMS::poolWrite(unsigned short a, unsigned char v) {
   }
 }
 
-void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
+template<bool osc> void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
   int oL=0;
   int oR=0;
   for (size_t h=0; h<len; h++) {
@@ -99,17 +99,19 @@ void DivPlatformSMS::acquire_nuked(short** buf, size_t len) {
     if (oR>32767) oR=32767;
     buf[0][h]=oL;
     if (stereo) buf[1][h]=oR;
-    for (int i=0; i<4; i++) {
-      if (isMuted[i]) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=0;
-      } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=sn_nuked.vol_table[sn_nuked.volume_out[i]]*3;
+    if (osc) {
+      for (int i=0; i<4; i++) {
+        if (isMuted[i]) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=0;
+        } else {
+          oscBuf[i]->data[oscBuf[i]->needle++]=sn_nuked.vol_table[sn_nuked.volume_out[i]]*3;
+        }
       }
     }
   }
 }
 
-void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
+template<bool osc> void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
   while (!writes.empty()) {
     QueuedWrite w=writes.front();
     if (stereo && (w.addr==1))
@@ -128,11 +130,13 @@ void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
       stereo?(&buf[1][h]):NULL
     };
     sn->sound_stream_update(outs,1);
-    for (int i=0; i<4; i++) {
-      if (isMuted[i]) {
-        oscBuf[i]->data[oscBuf[i]->needle++]=0;
-      } else {
-        oscBuf[i]->data[oscBuf[i]->needle++]=sn->get_channel_output(i)*3;
+    if (osc) {
+      for (int i=0; i<4; i++) {
+        if (isMuted[i]) {
+          oscBuf[i]->data[oscBuf[i]->needle++]=0;
+        } else {
+          oscBuf[i]->data[oscBuf[i]->needle++]=sn->get_channel_output(i)*3;
+        }
       }
     }
   }
@@ -140,9 +144,17 @@ void DivPlatformSMS::acquire_mame(short** buf, size_t len) {
 
 void DivPlatformSMS::acquire(short** buf, size_t len) {
   if (nuked) {
-    acquire_nuked(buf,len);
+    if (oscCapture) {
+      acquire_nuked<true>(buf,len);
+    } else {
+      acquire_nuked<false>(buf,len);
+    }
   } else {
-    acquire_mame(buf,len);
+    if (oscCapture) {
+      acquire_mame<true>(buf,len);
+    } else {
+      acquire_mame<false>(buf,len);
+    }
   }
 }
 
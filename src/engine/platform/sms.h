@@ -70,8 +70,8 @@ class DivPlatformSMS: public DivDispatch {
   int snCalcFreq(int ch);
   void poolWrite(unsigned short a, unsigned char v);
 
-  void acquire_nuked(short** buf, size_t len);
-  void acquire_mame(short** buf, size_t len);
+  template<bool osc> void acquire_nuked(short** buf, size_t len);
+  template<bool osc> void acquire_mame(short** buf, size_t len);
   public:
     void acquire(short** buf, size_t len);
     int dispatch(DivCommand c);
@@ -548,6 +548,19 @@ Mikey::~Mikey()
 {
 }
 
+// puts the chip back into its initial state without reallocating it
+void Mikey::reset( uint32_t sampleRate )
+{
+  *mMikey = MikeyPimpl{};
+  *mQueue = ActionQueue{};
+  mTick = 0;
+  mNextTick = 0;
+  mSampleRate = sampleRate;
+  mSamplesRemainder = 0;
+  mTicksPerSample = { 16000000 / mSampleRate, 16000000 % mSampleRate };
+  enqueueSampling();
+}
+
 void Mikey::write( uint8_t address, uint8_t value )
 {
   if ( auto action = mMikey->write( mTick, address, value ) )
@@ -20,6 +20,7 @@ public:
   Mikey( uint32_t sampleRate );
   ~Mikey();
 
+  void reset( uint32_t sampleRate );
   void write( uint8_t address, uint8_t value );
   void sampleAudio( int16_t* bufL, int16_t* bufR, size_t size, DivDispatchOscBuffer** oscb = NULL );
 
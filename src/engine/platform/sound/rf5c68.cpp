@@ -48,9 +48,12 @@ rf5c164_device::rf5c164_device()
 //  device_start - device-specific startup
 //-------------------------------------------------
 
-void rf5c68_device::device_start(u8 *ext_mem)
+void rf5c68_device::device_start(u8 *ext_mem, u32 max_samples)
 {
 	m_ext_mem = ext_mem;
+	// size the mixing buffers up front, so that sound_stream_update doesn't allocate
+	m_mixleft.resize(max_samples);
+	m_mixright.resize(max_samples);
 }
 
 void rf5c68_device::device_reset()
@@ -44,7 +44,7 @@ public:
 	u8 rf5c68_mem_r(offs_t offset);
 	void rf5c68_mem_w(offs_t offset, u8 data);
 
-	void device_start(u8 *ext_mem);
+	void device_start(u8 *ext_mem, u32 max_samples);
 	void device_reset();
 
 	void sound_stream_update(s16 **outputs, s16 **channel_outputs, u32 samples);
@@ -35,6 +35,24 @@
 
 #define YMFM_DEBUG_LOG_WAVFILES (0)
 
+// compile in the path that computes the operators of all channels in lanes
+// (see fm_lanes) instead of one channel at a time; results are identical
+// (test/ymfmLanes.cpp checks this). the lanes are computed with AVX2 when the
+// compiler targets it, and in plain loops otherwise. gathering the operator
+// state into lanes costs more than it saves on the chips measured so far, so
+// this is off by default; once compiled in, it can be toggled at runtime with
+// fm_engine_base::set_lanes
+#ifndef YMFM_LANES
+#define YMFM_LANES (0)
+#endif
+
+#if (YMFM_LANES) && defined(__AVX2__)
+#include <immintrin.h>
+#define YMFM_LANES_AVX2 (1)
+#else
+#define YMFM_LANES_AVX2 (0)
+#endif
+
 namespace ymfm
 {
 
@@ -157,6 +175,42 @@ protected:
 // forward declarations
 template<class RegisterType> class fm_engine_base;
 
+
+// ======================> fm_lanes
+
+// fm_lanes holds the operator state of up to Lanes 4-operator channels in
+// structure-of-arrays form, so that the same operator of every channel can
+// be computed at once; the results are bit-exact with
+// fm_operator::compute_volume. the arrays are padded to a multiple of 8
+// lanes, which is what an AVX2 register holds
+template<int Lanes>
+struct fm_lanes
+{
+	static constexpr uint32_t PADDED = (Lanes + 7) & ~7;
+
+	// clear the lanes from count up to PADDED, so that computing them is
+	// harmless
+	void pad();
+
+	// compute operator op (0-3) for all lanes, using opmod as the phase
+	// modulation input; the result is stored in opout[op + 1]
+	void compute(uint32_t op, uint32_t wavemask);
+
+	// compute the phase modulation input of an operator for all lanes, taking
+	// it from the opout slot selected by the algorithm bits at the given shift
+	void select_opmod(uint32_t shift, uint32_t mask);
+
+	uint32_t count;                        // number of lanes in use
+	uint16_t const *wavebase;              // waveform table of the first lane
+	uint32_t phase[4][PADDED];             // operator phase
+	uint32_t env[4][PADDED];               // envelope attenuation as 4.8 (includes AM)
+	int32_t active[4][PADDED];             // -1 if the operator produces output, 0 if its envelope is effectively off
+	int32_t wave[4][PADDED];               // waveform table, as an offset from wavebase
+	int32_t opmod[PADDED];                 // phase modulation input of the current operator
+	uint32_t algorithm[PADDED];            // algorithm descriptor (see output_4op)
+	int32_t opout[8][PADDED];              // operator outputs (see output_4op)
+};
+
 // ======================> fm_operator
 
 // fm_operator represents an FM operator (or "slot" in FM parlance), which
@@ -199,6 +253,13 @@ public:
 	// compute volume for the OPM noise channel
 	int32_t compute_noise_volume(uint32_t am_offset) const;
 
+	// is the envelope too low for compute_volume to return anything but 0?
+	bool quiet() const { return (m_env_attenuation > EG_QUIET && m_cache.eg_shift == 0); }
+
+	// gather what compute_volume needs into a lane of fm_lanes
+	template<int Lanes>
+	void prepare_lane(fm_lanes<Lanes> &lanes, uint32_t op, uint32_t lane, uint32_t am_offset) const;
+
 	// key state control
 	void keyonoff(uint32_t on, keyon_type type);
 
@@ -286,6 +347,18 @@ public:
 	void output_2op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 	void output_4op(output_data &output, uint32_t rshift, int32_t clipmax) const;
 
+	// lane-based 4-operator output: prepare_lanes gathers our operators into a
+	// lane (returning false if this channel can't use lanes), and output_lanes
+	// combines the computed operator values like output_4op does
+	template<int Lanes>
+	bool prepare_lanes(fm_lanes<Lanes> &lanes, uint32_t lane) const;
+	template<int Lanes>
+	void output_lanes(fm_lanes<Lanes> const &lanes, uint32_t lane, output_data &output, uint32_t rshift, int32_t clipmax) const;
+
+	// if all 4 operators are quiet, the output is known to be 0; output that
+	// without computing the operators and return true
+	bool output_quiet(output_data &output) const;
+
 	// compute the special OPL rhythm channel outputs
 	void output_rhythm_ch6(output_data &output, uint32_t rshift, int32_t clipmax) const;
 	void output_rhythm_ch7(uint32_t phase_select, output_data &output, uint32_t rshift, int32_t clipmax) const;
@@ -389,6 +462,12 @@ public:
 	// compute sum of channel outputs
 	void output(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
 
+	// compute sum of channel outputs using fm_lanes (non-rhythm mode only)
+	void output_lanes(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const;
+
+	// enable or disable the lane-based output (if compiled in)
+	void set_lanes(bool enable) { m_lanes = enable; }
+
 	// write to the OPN registers
 	void write(uint16_t regnum, uint8_t data);
 
@@ -464,6 +543,7 @@ protected:
 	uint32_t m_active_channels;      // mask of active channels (computed by prepare)
 	uint32_t m_modified_channels;    // mask of channels that have been modified
 	uint32_t m_prepare_count;        // counter to do periodic prepare sweeps
+	bool m_lanes;                    // use output_lanes (if compiled in)
 	RegisterType m_regs;             // register accessor
 	std::unique_ptr<fm_channel<RegisterType>> m_channel[CHANNELS]; // channel pointers
 	std::unique_ptr<fm_operator<RegisterType>> m_operator[OPERATORS]; // operator pointers
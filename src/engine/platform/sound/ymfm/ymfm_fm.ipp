@@ -78,12 +78,11 @@ inline uint32_t abs_sin_attenuation(uint32_t input)
 
 
 //-------------------------------------------------
-//  attenuation_to_volume - given a 5.8 fixed point
-//  logarithmic attenuation value, return a 13-bit
-//  linear volume
+//  power_table - return the table used by
+//  attenuation_to_volume
 //-------------------------------------------------
 
-inline uint32_t attenuation_to_volume(uint32_t input)
+inline uint16_t const *power_table()
 {
 	// the values here are 10-bit mantissas with an implied leading bit
 	// this matches the internal format of the OPN chip, extracted from the die
@@ -91,8 +90,11 @@ inline uint32_t attenuation_to_volume(uint32_t input)
 	// as a nod to performance, the implicit 0x400 bit is pre-incorporated, and
 	// the values are left-shifted by 2 so that a simple right shift is all that
 	// is needed; also the order is reversed to save a NOT on the input
+
+	// there is an extra entry at the end so that the table can be read with
+	// 32-bit gathers (see fm_lanes::compute)
 #define X(a) (((a) | 0x400) << 2)
-	static uint16_t const s_power_table[256] =
+	static uint16_t const s_power_table[256+1] =
 	{
 		X(0x3fa),X(0x3f5),X(0x3ef),X(0x3ea),X(0x3e4),X(0x3df),X(0x3da),X(0x3d4),
 		X(0x3cf),X(0x3c9),X(0x3c4),X(0x3bf),X(0x3b9),X(0x3b4),X(0x3ae),X(0x3a9),
@@ -125,12 +127,123 @@ inline uint32_t attenuation_to_volume(uint32_t input)
 		X(0x05a),X(0x057),X(0x054),X(0x051),X(0x04e),X(0x04b),X(0x048),X(0x045),
 		X(0x042),X(0x03f),X(0x03c),X(0x039),X(0x036),X(0x033),X(0x030),X(0x02d),
 		X(0x02a),X(0x028),X(0x025),X(0x022),X(0x01f),X(0x01c),X(0x019),X(0x016),
-		X(0x014),X(0x011),X(0x00e),X(0x00b),X(0x008),X(0x006),X(0x003),X(0x000)
+		X(0x014),X(0x011),X(0x00e),X(0x00b),X(0x008),X(0x006),X(0x003),X(0x000),
+		0
 	};
 #undef X
+	return s_power_table;
+}
+
+
+//-------------------------------------------------
+//  attenuation_to_volume - given a 5.8 fixed point
+//  logarithmic attenuation value, return a 13-bit
+//  linear volume
+//-------------------------------------------------
 
+inline uint32_t attenuation_to_volume(uint32_t input)
+{
 	// look up the fractional part, then shift by the whole
-	return s_power_table[input & 0xff] >> (input >> 8);
+	return power_table()[input & 0xff] >> (input >> 8);
+}
+
+
+//-------------------------------------------------
+//  fm_lanes::pad - clear the unused lanes
+//-------------------------------------------------
+
+template<int Lanes>
+void fm_lanes<Lanes>::pad()
+{
+	for (uint32_t lane = count; lane < PADDED; lane++)
+	{
+		for (uint32_t op = 0; op < 4; op++)
+		{
+			phase[op][lane] = 0;
+			env[op][lane] = 0;
+			active[op][lane] = 0;
+			wave[op][lane] = 0;
+		}
+		opmod[lane] = 0;
+		algorithm[lane] = 0;
+		opout[0][lane] = 0;
+	}
+}
+
+
+//-------------------------------------------------
+//  fm_lanes::compute - compute the 14-bit signed
+//  volume of one operator in every lane; this
+//  must match fm_operator::compute_volume
+//-------------------------------------------------
+
+template<int Lanes>
+void fm_lanes<Lanes>::compute(uint32_t op, uint32_t wavemask)
+{
+#if (YMFM_LANES_AVX2)
+	// the tables hold 16-bit values, so gather 32 bits at 16-bit offsets and
+	// keep the low half; this reads 2 bytes past the entry, which is why the
+	// power table is padded. the waveform tables are followed by the other
+	// members of the registers, so reading past them is fine too
+	__m256i const lomask = _mm256_set1_epi32(0xffff);
+	__m256i const mask = _mm256_set1_epi32(wavemask);
+	__m256i const signbit = _mm256_set1_epi32(0x8000);
+	int const *waves = reinterpret_cast<int const *>(wavebase);
+	int const *powers = reinterpret_cast<int const *>(power_table());
+	for (uint32_t lane = 0; lane < count; lane += 8)
+	{
+		// look up the sin attenuation
+		__m256i index = _mm256_add_epi32(_mm256_loadu_si256((__m256i const *)&phase[op][lane]), _mm256_loadu_si256((__m256i const *)&opmod[lane]));
+		index = _mm256_add_epi32(_mm256_loadu_si256((__m256i const *)&wave[op][lane]), _mm256_and_si256(index, mask));
+		__m256i sin_attenuation = _mm256_and_si256(_mm256_i32gather_epi32(waves, index, 2), lomask);
+
+		// combine with the envelope and convert to volume; the scalar shift
+		// only uses the low 5 bits of the amount on x86, so do the same here
+		__m256i input = _mm256_add_epi32(_mm256_andnot_si256(signbit, sin_attenuation), _mm256_loadu_si256((__m256i const *)&env[op][lane]));
+		__m256i power = _mm256_and_si256(_mm256_i32gather_epi32(powers, _mm256_and_si256(input, _mm256_set1_epi32(0xff)), 2), lomask);
+		__m256i result = _mm256_srlv_epi32(power, _mm256_and_si256(_mm256_srli_epi32(input, 8), _mm256_set1_epi32(31)));
+
+		// negate if in the negative part of the sin wave, and zero if quiet
+		__m256i negative = _mm256_cmpeq_epi32(_mm256_and_si256(sin_attenuation, signbit), signbit);
+		result = _mm256_blendv_epi8(result, _mm256_sub_epi32(_mm256_setzero_si256(), result), negative);
+		result = _mm256_and_si256(result, _mm256_loadu_si256((__m256i const *)&active[op][lane]));
+		_mm256_storeu_si256((__m256i *)&opout[op + 1][lane], result);
+	}
+#else
+	for (uint32_t lane = 0; lane < count; lane++)
+	{
+		uint32_t sin_attenuation = (wavebase + wave[op][lane])[(phase[op][lane] + opmod[lane]) & wavemask];
+		int32_t result = attenuation_to_volume((sin_attenuation & 0x7fff) + env[op][lane]);
+		result = bitfield(sin_attenuation, 15) ? -result : result;
+		opout[op + 1][lane] = result & active[op][lane];
+	}
+#endif
+}
+
+
+//-------------------------------------------------
+//  fm_lanes::select_opmod - pick the modulation
+//  input of the next operator in every lane
+//-------------------------------------------------
+
+template<int Lanes>
+void fm_lanes<Lanes>::select_opmod(uint32_t shift, uint32_t mask)
+{
+#if (YMFM_LANES_AVX2)
+	__m256i const lanemask = _mm256_set1_epi32(mask);
+	__m256i const stride = _mm256_set1_epi32(PADDED);
+	for (uint32_t lane = 0; lane < count; lane += 8)
+	{
+		// opout[slot][lane] is at slot * PADDED + lane
+		__m256i slot = _mm256_and_si256(_mm256_srli_epi32(_mm256_loadu_si256((__m256i const *)&algorithm[lane]), shift), lanemask);
+		__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(slot, stride), _mm256_setr_epi32(lane, lane + 1, lane + 2, lane + 3, lane + 4, lane + 5, lane + 6, lane + 7));
+		__m256i value = _mm256_i32gather_epi32(&opout[0][0], index, 4);
+		_mm256_storeu_si256((__m256i *)&opmod[lane], _mm256_srai_epi32(value, 1));
+	}
+#else
+	for (uint32_t lane = 0; lane < count; lane++)
+		opmod[lane] = opout[(algorithm[lane] >> shift) & mask][lane] >> 1;
+#endif
 }
 
 
@@ -496,6 +609,26 @@ int32_t fm_operator<RegisterType>::compute_volume(uint32_t phase, uint32_t am_of
 }
 
 
+//-------------------------------------------------
+//  prepare_lane - gather the operator state used
+//  by compute_volume into a lane
+//-------------------------------------------------
+
+template<class RegisterType>
+template<int Lanes>
+void fm_operator<RegisterType>::prepare_lane(fm_lanes<Lanes> &lanes, uint32_t op, uint32_t lane, uint32_t am_offset) const
+{
+	// all operators of an engine take their waveforms from the same table in
+	// the registers, so lanes store them as offsets from the first one
+	if (lane == 0 && op == 0)
+		lanes.wavebase = m_cache.waveform;
+	lanes.phase[op][lane] = phase();
+	lanes.active[op][lane] = quiet() ? 0 : -1;
+	lanes.env[op][lane] = envelope_attenuation(am_offset) << 2;
+	lanes.wave[op][lane] = int32_t(m_cache.waveform - lanes.wavebase);
+}
+
+
 //-------------------------------------------------
 //  compute_noise_volume - compute the 14-bit
 //  signed noise volume of this operator, given a
@@ -972,6 +1105,48 @@ void fm_channel<RegisterType>::output_2op(output_data &output, uint32_t rshift,
 }
 
 
+// OPM/OPN offer 8 different connection algorithms for 4 operators,
+// and OPL3 offers 4 more, which we designate here as 8-11.
+//
+// The operators are computed in order, with the inputs pulled from
+// an array of values (opout) that is populated as we go:
+//    0 = 0
+//    1 = O1
+//    2 = O2
+//    3 = O3
+//    4 = (O4)
+//    5 = O1+O2
+//    6 = O1+O3
+//    7 = O2+O3
+//
+// The s_algorithm_ops table describes the inputs and outputs of each
+// algorithm as follows:
+//
+//      ---------x use opout[x] as operator 2 input
+//      ------xxx- use opout[x] as operator 3 input
+//      ---xxx---- use opout[x] as operator 4 input
+//      --x------- include opout[1] in final sum
+//      -x-------- include opout[2] in final sum
+//      x--------- include opout[3] in final sum
+#define ALGORITHM(op2in, op3in, op4in, op1out, op2out, op3out) \
+	((op2in) | ((op3in) << 1) | ((op4in) << 4) | ((op1out) << 7) | ((op2out) << 8) | ((op3out) << 9))
+static uint16_t const s_algorithm_ops[8+4] =
+{
+	ALGORITHM(1,2,3, 0,0,0),    //  0: O1 -> O2 -> O3 -> O4 -> out (O4)
+	ALGORITHM(0,5,3, 0,0,0),    //  1: (O1 + O2) -> O3 -> O4 -> out (O4)
+	ALGORITHM(0,2,6, 0,0,0),    //  2: (O1 + (O2 -> O3)) -> O4 -> out (O4)
+	ALGORITHM(1,0,7, 0,0,0),    //  3: ((O1 -> O2) + O3) -> O4 -> out (O4)
+	ALGORITHM(1,0,3, 0,1,0),    //  4: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4)
+	ALGORITHM(1,1,1, 0,1,1),    //  5: ((O1 -> O2) + (O1 -> O3) + (O1 -> O4)) -> out (O2+O3+O4)
+	ALGORITHM(1,0,0, 0,1,1),    //  6: ((O1 -> O2) + O3 + O4) -> out (O2+O3+O4)
+	ALGORITHM(0,0,0, 1,1,1),    //  7: (O1 + O2 + O3 + O4) -> out (O1+O2+O3+O4)
+	ALGORITHM(1,2,3, 0,0,0),    //  8: O1 -> O2 -> O3 -> O4 -> out (O4)         [same as 0]
+	ALGORITHM(0,2,3, 1,0,0),    //  9: (O1 + (O2 -> O3 -> O4)) -> out (O1+O4)   [unique]
+	ALGORITHM(1,0,3, 0,1,0),    // 10: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4) [same as 4]
+	ALGORITHM(0,2,0, 1,0,1)     // 11: (O1 + (O2 -> O3) + O4) -> out (O1+O3+O4) [unique]
+};
+
+
 //-------------------------------------------------
 //  output_4op - combine 4 operators according to
 //  the specified algorithm, returning a sum
@@ -1005,46 +1180,6 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 	if (m_regs.ch_output_any(m_choffs) == 0)
 		return;
 
-	// OPM/OPN offer 8 different connection algorithms for 4 operators,
-	// and OPL3 offers 4 more, which we designate here as 8-11.
-	//
-	// The operators are computed in order, with the inputs pulled from
-	// an array of values (opout) that is populated as we go:
-	//    0 = 0
-	//    1 = O1
-	//    2 = O2
-	//    3 = O3
-	//    4 = (O4)
-	//    5 = O1+O2
-	//    6 = O1+O3
-	//    7 = O2+O3
-	//
-	// The s_algorithm_ops table describes the inputs and outputs of each
-	// algorithm as follows:
-	//
-	//      ---------x use opout[x] as operator 2 input
-	//      ------xxx- use opout[x] as operator 3 input
-	//      ---xxx---- use opout[x] as operator 4 input
-	//      --x------- include opout[1] in final sum
-	//      -x-------- include opout[2] in final sum
-	//      x--------- include opout[3] in final sum
-	#define ALGORITHM(op2in, op3in, op4in, op1out, op2out, op3out) \
-		((op2in) | ((op3in) << 1) | ((op4in) << 4) | ((op1out) << 7) | ((op2out) << 8) | ((op3out) << 9))
-	static uint16_t const s_algorithm_ops[8+4] =
-	{
-		ALGORITHM(1,2,3, 0,0,0),    //  0: O1 -> O2 -> O3 -> O4 -> out (O4)
-		ALGORITHM(0,5,3, 0,0,0),    //  1: (O1 + O2) -> O3 -> O4 -> out (O4)
-		ALGORITHM(0,2,6, 0,0,0),    //  2: (O1 + (O2 -> O3)) -> O4 -> out (O4)
-		ALGORITHM(1,0,7, 0,0,0),    //  3: ((O1 -> O2) + O3) -> O4 -> out (O4)
-		ALGORITHM(1,0,3, 0,1,0),    //  4: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4)
-		ALGORITHM(1,1,1, 0,1,1),    //  5: ((O1 -> O2) + (O1 -> O3) + (O1 -> O4)) -> out (O2+O3+O4)
-		ALGORITHM(1,0,0, 0,1,1),    //  6: ((O1 -> O2) + O3 + O4) -> out (O2+O3+O4)
-		ALGORITHM(0,0,0, 1,1,1),    //  7: (O1 + O2 + O3 + O4) -> out (O1+O2+O3+O4)
-		ALGORITHM(1,2,3, 0,0,0),    //  8: O1 -> O2 -> O3 -> O4 -> out (O4)         [same as 0]
-		ALGORITHM(0,2,3, 1,0,0),    //  9: (O1 + (O2 -> O3 -> O4)) -> out (O1+O4)   [unique]
-		ALGORITHM(1,0,3, 0,1,0),    // 10: ((O1 -> O2) + (O3 -> O4)) -> out (O2+O4) [same as 4]
-		ALGORITHM(0,2,0, 1,0,1)     // 11: (O1 + (O2 -> O3) + O4) -> out (O1+O3+O4) [unique]
-	};
 	uint32_t algorithm_ops = s_algorithm_ops[m_regs.ch_algorithm(m_choffs)];
 
 	// populate the opout table
@@ -1089,6 +1224,90 @@ void fm_channel<RegisterType>::output_4op(output_data &output, uint32_t rshift,
 }
 
 
+//-------------------------------------------------
+//  prepare_lanes - gather the state of our 4
+//  operators into a lane of fm_lanes
+//-------------------------------------------------
+
+template<class RegisterType>
+template<int Lanes>
+bool fm_channel<RegisterType>::prepare_lanes(fm_lanes<Lanes> &lanes, uint32_t lane) const
+{
+	// the OPM noise channel is left to output_4op, and so are muted channels
+	// since only their operator 1 feedback needs computing
+	if (m_regs.noise_enable() && m_choffs == 7)
+		return false;
+	if (m_regs.ch_output_any(m_choffs) == 0)
+		return false;
+
+	// AM amount is the same across all operators; compute it once
+	uint32_t am_offset = m_regs.lfo_am_offset(m_choffs);
+	for (uint32_t index = 0; index < 4; index++)
+		m_op[index]->prepare_lane(lanes, index, lane, am_offset);
+
+	// operator 1 has optional self-feedback
+	int32_t opmod = 0;
+	uint32_t feedback = m_regs.ch_feedback(m_choffs);
+	if (feedback != 0)
+		opmod = (m_feedback[0] + m_feedback[1]) >> (10 - feedback);
+	lanes.opmod[lane] = opmod;
+	lanes.algorithm[lane] = s_algorithm_ops[m_regs.ch_algorithm(m_choffs)];
+	return true;
+}
+
+
+//-------------------------------------------------
+//  output_lanes - combine the operator values
+//  computed in our lane, like output_4op
+//-------------------------------------------------
+
+template<class RegisterType>
+template<int Lanes>
+void fm_channel<RegisterType>::output_lanes(fm_lanes<Lanes> const &lanes, uint32_t lane, output_data &output, uint32_t rshift, int32_t clipmax) const
+{
+	// update the feedback
+	m_feedback_in = lanes.opout[1][lane];
+
+	uint32_t algorithm_ops = lanes.algorithm[lane];
+	int32_t result = lanes.opout[4][lane];
+	result >>= rshift;
+
+	// optionally add OP1, OP2, OP3
+	int32_t clipmin = -clipmax - 1;
+	if (bitfield(algorithm_ops, 7) != 0)
+		result = clamp(result + (lanes.opout[1][lane] >> rshift), clipmin, clipmax);
+	if (bitfield(algorithm_ops, 8) != 0)
+		result = clamp(result + (lanes.opout[2][lane] >> rshift), clipmin, clipmax);
+	if (bitfield(algorithm_ops, 9) != 0)
+		result = clamp(result + (lanes.opout[3][lane] >> rshift), clipmin, clipmax);
+
+	// add to the output
+	add_to_output(m_choffs, output, result);
+}
+
+
+//-------------------------------------------------
+//  output_quiet - skip a 4-operator channel whose
+//  operators would all compute to 0
+//-------------------------------------------------
+
+template<class RegisterType>
+bool fm_channel<RegisterType>::output_quiet(output_data &output) const
+{
+	// the OPM noise channel doesn't honor the quiet threshold
+	if (m_regs.noise_enable() && m_choffs == 7)
+		return false;
+	if (!m_op[0]->quiet() || !m_op[1]->quiet() || !m_op[2]->quiet() || !m_op[3]->quiet())
+		return false;
+	m_feedback_in = 0;
+
+	// output_4op would still add 0 to the output, which updates m_output
+	if (m_regs.ch_output_any(m_choffs) != 0)
+		add_to_output(m_choffs, output, 0);
+	return true;
+}
+
+
 //-------------------------------------------------
 //  output_rhythm_ch6 - special case output
 //  computation for OPL channel 6 in rhythm mode,
@@ -1202,7 +1421,8 @@ fm_engine_base<RegisterType>::fm_engine_base(ymfm_interface &intf) :
 	m_total_clocks(0),
 	m_active_channels(ALL_CHANNELS),
 	m_modified_channels(ALL_CHANNELS),
-	m_prepare_count(0)
+	m_prepare_count(0),
+	m_lanes(YMFM_LANES)
 {
 	// inform the interface of their engine
 	m_intf.m_engine = this;
@@ -1384,6 +1604,12 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 #endif
 			}
 	}
+	else if (YMFM_LANES && !YMFM_DEBUG_LOG_WAVFILES && m_lanes && (chanmask & (chanmask - 1)) != 0)
+	{
+		// compute all 4-operator channels together; single channel requests
+		// (such as the multiplexed OPN2 output) gain nothing from this
+		output_lanes(output, rshift, clipmax, chanmask);
+	}
 	else
 	{
 		// sum over all the desired channels
@@ -1405,6 +1631,67 @@ void fm_engine_base<RegisterType>::output(output_data &output, uint32_t rshift,
 }
 
 
+//-------------------------------------------------
+//  output_lanes - compute the sum of channel
+//  outputs, evaluating each operator slot of all
+//  4-operator channels at once
+//-------------------------------------------------
+
+template<class RegisterType>
+void fm_engine_base<RegisterType>::output_lanes(output_data &output, uint32_t rshift, int32_t clipmax, uint32_t chanmask) const
+{
+	fm_lanes<CHANNELS> lanes;
+	uint8_t lanechan[CHANNELS];
+	constexpr uint32_t wavemask = RegisterType::WAVEFORM_LENGTH - 1;
+
+	// gather the 4-operator channels; the rest are output the usual way
+	lanes.count = 0;
+	for (uint32_t chnum = 0; chnum < CHANNELS; chnum++)
+		if (bitfield(chanmask, chnum))
+		{
+			if (!m_channel[chnum]->is4op())
+				m_channel[chnum]->output_2op(output, rshift, clipmax);
+			else if (m_channel[chnum]->output_quiet(output))
+				continue;
+			else if (m_channel[chnum]->prepare_lanes(lanes, lanes.count))
+				lanechan[lanes.count++] = chnum;
+			else
+				m_channel[chnum]->output_4op(output, rshift, clipmax);
+		}
+	if (lanes.count == 0)
+		return;
+	lanes.pad();
+
+	// operator 1
+	for (uint32_t lane = 0; lane < lanes.count; lane++)
+		lanes.opout[0][lane] = 0;
+	lanes.compute(0, wavemask);
+
+	// operator 2
+	lanes.select_opmod(0, 1);
+	lanes.compute(1, wavemask);
+	for (uint32_t lane = 0; lane < lanes.count; lane++)
+		lanes.opout[5][lane] = lanes.opout[1][lane] + lanes.opout[2][lane];
+
+	// operator 3
+	lanes.select_opmod(1, 7);
+	lanes.compute(2, wavemask);
+	for (uint32_t lane = 0; lane < lanes.count; lane++)
+	{
+		lanes.opout[6][lane] = lanes.opout[1][lane] + lanes.opout[3][lane];
+		lanes.opout[7][lane] = lanes.opout[2][lane] + lanes.opout[3][lane];
+	}
+
+	// operator 4
+	lanes.select_opmod(4, 7);
+	lanes.compute(3, wavemask);
+
+	// combine according to each channel's algorithm
+	for (uint32_t lane = 0; lane < lanes.count; lane++)
+		m_channel[lanechan[lane]]->output_lanes(lanes, lane, output, rshift, clipmax);
+}
+
+
 //-------------------------------------------------
 //  write - handle writes to the OPN registers
 //-------------------------------------------------
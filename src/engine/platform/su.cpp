@@ -23,7 +23,7 @@
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);} }
 #define chWrite(c,a,v) rWrite(((c)<<5)|(a),v);
 
 #define CHIP_DIVIDER 2
@@ -135,8 +135,8 @@ void DivPlatformSoundUnit::tick(bool sysTick) {
       writeControlUpper(i);
     }
 
-    // run hardware sequence
-    if (chan[i].active) {
+    // run hardware sequence (only start it on low-latency input sub-ticks)
+    if (chan[i].active && (sysTick || chan[i].hwSeqDelay<=0)) {
       if (--chan[i].hwSeqDelay<=0) {
         chan[i].hwSeqDelay=0;
         DivInstrument* ins=parent->getIns(chan[i].ins,DIV_INS_SU);
@@ -181,7 +181,7 @@ void DivPlatformSoundUnit::tick(bool sysTick) {
               writeControlUpper(i);
               break;
             case DivInstrumentSoundUnit::DIV_SU_HWCMD_WAIT:
-              chan[i].hwSeqDelay=(val+1)*parent->tickMult;
+              chan[i].hwSeqDelay=val+1;
               leave=true;
               break;
             case DivInstrumentSoundUnit::DIV_SU_HWCMD_WAIT_REL:
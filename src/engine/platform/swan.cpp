@@ -23,7 +23,7 @@
 #include "IconsFontAwesome4.h"
 #include <math.h>
 
-#define rWrite(a,v) if (!skipRegisterWrites) {writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++; writes.push(QueuedWrite(a,v)); if (dumpWrites) {addWrite(a,v);}}
 #define postWrite(a,v) postDACWrites.push(DivRegWrite(a,v));
 
 #define CHIP_DIVIDER 32
@@ -23,7 +23,7 @@
 #include <math.h>
 
 //#define rWrite(a,v) pendingWrites[a]=v;
-#define rWrite(a,v) if (!skipRegisterWrites) { x1_010.ram_w(a,v); if (dumpWrites) { addWrite(a,v); } }
+#define rWrite(a,v) if (!skipRegisterWrites) {regWriteCount++;  x1_010.ram_w(a,v); if (dumpWrites) { addWrite(a,v); } }
 
 #define chRead(c,a) x1_010.ram_r((c<<3)|(a&7))
 #define chWrite(c,a,v) rWrite((c<<3)|(a&7),v)
@@ -1001,9 +1001,10 @@ const DivMemoryComposition* DivPlatformX1_010::getMemCompo(int index) {
 }
 
 void DivPlatformX1_010::renderSamples(int sysID) {
-  memset(sampleMem,0,16777216);
+  sampleMem=sampleMemory->beginWrite();
   memset(sampleOffX1,0,256*sizeof(unsigned int));
   memset(sampleLoaded,0,256*sizeof(bool));
+  memset(sampleRenderLen,0,256*sizeof(unsigned int));
 
   memCompo=DivMemoryComposition();
   memCompo.name="Sample ROM";
@@ -1038,15 +1039,33 @@ void DivPlatformX1_010::renderSamples(int sysID) {
       sampleLoaded[i]=true;
     }
     sampleOffX1[i]=memPos;
+    sampleRenderLen[i]=paddedLen;
     memCompo.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
     memPos+=paddedLen;
   }
   sampleMemLen=memPos+256;
+  sampleMem=sampleMemory->endWrite(sampleMemLen);
 
   memCompo.used=sampleMemLen;
   memCompo.capacity=getSampleMemCapacity(0);
 }
 
+bool DivPlatformX1_010::renderSample(int sysID, int sample) {
+  if (sample<0 || sample>=256) return false;
+  DivSample* s=parent->song.sample[sample];
+  if (!s->renderOn[0][sysID]) return (sampleRenderLen[sample]==0);
+  if (!sampleLoaded[sample]) return false;
+
+  int paddedLen=(s->length8+4095)&(~0xfff);
+  if (isBanked && paddedLen>131072) paddedLen=131072;
+  if (paddedLen!=(int)sampleRenderLen[sample]) return false;
+
+  sampleMem=sampleMemory->beginWrite(false);
+  memcpy(sampleMem+sampleOffX1[sample],s->data8,paddedLen);
+  sampleMem=sampleMemory->endWrite(sampleMemLen);
+  return true;
+}
+
 int DivPlatformX1_010::init(DivEngine* p, int channels, int sugRate, const DivConfig& flags) {
   parent=p;
   dumpWrites=false;
@@ -1057,7 +1076,8 @@ int DivPlatformX1_010::init(DivEngine* p, int channels, int sugRate, const DivCo
     oscBuf[i]=new DivDispatchOscBuffer;
   }
   setFlags(flags);
-  sampleMem=new unsigned char[16777216];
+  sampleMemory=new DivSampleMemory(16777216,true);
+  sampleMem=sampleMemory->get();
   sampleMemLen=0;
   x1_010.reset();
   reset();
@@ -1068,7 +1088,9 @@ void DivPlatformX1_010::quit() {
   for (int i=0; i<16; i++) {
     delete oscBuf[i];
   }
-  delete[] sampleMem;
+  delete sampleMemory;
+  sampleMemory=NULL;
+  sampleMem=NULL;
 }
 
 DivPlatformX1_010::~DivPlatformX1_010() {
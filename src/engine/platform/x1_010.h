@@ -21,6 +21,7 @@
 #define _X1_010_H
 
 #include "../dispatch.h"
+#include "../sampleMem.h"
 #include "../engine.h"
 #include "../waveSynth.h"
 #include "vgsound_emu/src/x1_010/x1_010.hpp"
@@ -110,6 +111,7 @@ class DivPlatformX1_010: public DivDispatch, public vgsound_emu_mem_intf {
   DivDispatchOscBuffer* oscBuf[16];
   bool isMuted[16];
   bool stereo=false;
+  DivSampleMemory* sampleMemory;
   unsigned char* sampleMem;
   size_t sampleMemLen;
   unsigned char sampleBank;
@@ -119,6 +121,7 @@ class DivPlatformX1_010: public DivDispatch, public vgsound_emu_mem_intf {
   unsigned int bankSlot[8];
   unsigned int sampleOffX1[256];
   bool sampleLoaded[256];
+  unsigned int sampleRenderLen[256];
 
   DivMemoryComposition memCompo;
 
@@ -156,6 +159,7 @@ class DivPlatformX1_010: public DivDispatch, public vgsound_emu_mem_intf {
     bool isSampleLoaded(int index, int sample);
     const DivMemoryComposition* getMemCompo(int index);
     void renderSamples(int chipID);
+    bool renderSample(int chipID, int sample);
     const char** getRegisterSheet();
     int init(DivEngine* parent, int channels, int sugRate, const DivConfig& flags);
     void quit();
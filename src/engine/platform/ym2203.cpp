@@ -158,15 +158,27 @@ const char** DivPlatformYM2203::getRegisterSheet() {
 
 void DivPlatformYM2203::acquire(short** buf, size_t len) {
   if (useCombo==2) {
-    acquire_lle(buf,len);
+    if (oscCapture) {
+      acquire_lle<true>(buf,len);
+    } else {
+      acquire_lle<false>(buf,len);
+    }
   } else if (useCombo==1) {
-    acquire_combo(buf,len);
+    if (oscCapture) {
+      acquire_combo<true>(buf,len);
+    } else {
+      acquire_combo<false>(buf,len);
+    }
   } else {
-    acquire_ymfm(buf,len);
+    if (oscCapture) {
+      acquire_ymfm<true>(buf,len);
+    } else {
+      acquire_ymfm<false>(buf,len);
+    }
   }
 }
 
-void DivPlatformYM2203::acquire_combo(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2203::acquire_combo(short** buf, size_t len) {
   thread_local int os;
   thread_local short ignored[2];
 
@@ -232,17 +244,19 @@ void DivPlatformYM2203::acquire_combo(short** buf, size_t len) {
   
     buf[0][h]=os;
     
-    for (int i=0; i<3; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm_nuked.ch_out[i]<<1,-32768,32767);
-    }
+    if (osc) {
+      for (int i=0; i<3; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm_nuked.ch_out[i]<<1,-32768,32767);
+      }
 
-    for (int i=3; i<6; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=fmout.data[i-2]<<1;
+      for (int i=3; i<6; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=fmout.data[i-2]<<1;
+      }
     }
   }
 }
 
-void DivPlatformYM2203::acquire_ymfm(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2203::acquire_ymfm(short** buf, size_t len) {
   thread_local int os;
 
   ymfm::ym2203::fm_engine* fme=fm->debug_fm_engine();
@@ -283,13 +297,15 @@ void DivPlatformYM2203::acquire_ymfm(short** buf, size_t len) {
     buf[0][h]=os;
 
     
-    for (int i=0; i<3; i++) {
-      int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(out,-32768,32767);
-    }
+    if (osc) {
+      for (int i=0; i<3; i++) {
+        int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(out,-32768,32767);
+      }
 
-    for (int i=3; i<6; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=fmout.data[i-2]<<1;
+      for (int i=3; i<6; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=fmout.data[i-2]<<1;
+      }
     }
   }
 }
@@ -298,7 +314,7 @@ static const unsigned char subCycleMap[6]={
   3, 4, 5, 0, 1, 2
 };
 
-void DivPlatformYM2203::acquire_lle(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2203::acquire_lle(short** buf, size_t len) {
   thread_local int fmOut[6];
 
   for (size_t h=0; h<len; h++) {
@@ -420,16 +436,18 @@ void DivPlatformYM2203::acquire_lle(short** buf, size_t len) {
       if (have0 && have1) break;
     }
     
-    // chan osc
-    // FM
-    for (int i=0; i<3; i++) {
-      if (fmOut[i]<-32768) fmOut[i]=-32768;
-      if (fmOut[i]>32767) fmOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=fmOut[i];
-    }
-    // SSG
-    for (int i=0; i<3; i++) {
-      oscBuf[i+3]->data[oscBuf[i+3]->needle++]=fm_lle.o_analog_ch[i]*32767;
+    if (osc) {
+      // chan osc
+      // FM
+      for (int i=0; i<3; i++) {
+        if (fmOut[i]<-32768) fmOut[i]=-32768;
+        if (fmOut[i]>32767) fmOut[i]=32767;
+        oscBuf[i]->data[oscBuf[i]->needle++]=fmOut[i];
+      }
+      // SSG
+      for (int i=0; i<3; i++) {
+        oscBuf[i+3]->data[oscBuf[i+3]->needle++]=fm_lle.o_analog_ch[i]*32767;
+      }
     }
 
     // DAC
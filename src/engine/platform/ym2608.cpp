@@ -299,15 +299,27 @@ double DivPlatformYM2608::NOTE_ADPCMB(int note) {
 
 void DivPlatformYM2608::acquire(short** buf, size_t len) {
   if (useCombo==2) {
-    acquire_lle(buf,len);
+    if (oscCapture) {
+      acquire_lle<true>(buf,len);
+    } else {
+      acquire_lle<false>(buf,len);
+    }
   } else if (useCombo==1) {
-    acquire_combo(buf,len);
+    if (oscCapture) {
+      acquire_combo<true>(buf,len);
+    } else {
+      acquire_combo<false>(buf,len);
+    }
   } else {
-    acquire_ymfm(buf,len);
+    if (oscCapture) {
+      acquire_ymfm<true>(buf,len);
+    } else {
+      acquire_ymfm<false>(buf,len);
+    }
   }
 }
 
-void DivPlatformYM2608::acquire_combo(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2608::acquire_combo(short** buf, size_t len) {
   thread_local int os[2];
   thread_local short ignored[2];
 
@@ -403,24 +415,26 @@ void DivPlatformYM2608::acquire_combo(short** buf, size_t len) {
     buf[1][h]=os[1];
 
     
-    for (int i=0; i<psgChanOffs; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm_nuked.ch_out[i]<<1,-32768,32767);
-    }
+    if (osc) {
+      for (int i=0; i<psgChanOffs; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(fm_nuked.ch_out[i]<<1,-32768,32767);
+      }
 
-    ssge->get_last_out(ssgOut);
-    for (int i=psgChanOffs; i<adpcmAChanOffs; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=ssgOut.data[i-psgChanOffs]<<1;
-    }
+      ssge->get_last_out(ssgOut);
+      for (int i=psgChanOffs; i<adpcmAChanOffs; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=ssgOut.data[i-psgChanOffs]<<1;
+      }
 
-    for (int i=adpcmAChanOffs; i<adpcmBChanOffs; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(adpcmAChan[i-adpcmAChanOffs]->get_last_out(0)+adpcmAChan[i-adpcmAChanOffs]->get_last_out(1))>>1;
-    }
+      for (int i=adpcmAChanOffs; i<adpcmBChanOffs; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=(adpcmAChan[i-adpcmAChanOffs]->get_last_out(0)+adpcmAChan[i-adpcmAChanOffs]->get_last_out(1))>>1;
+      }
 
-    oscBuf[adpcmBChanOffs]->data[oscBuf[adpcmBChanOffs]->needle++]=(abe->get_last_out(0)+abe->get_last_out(1))>>1;
+      oscBuf[adpcmBChanOffs]->data[oscBuf[adpcmBChanOffs]->needle++]=(abe->get_last_out(0)+abe->get_last_out(1))>>1;
+    }
   }
 }
 
-void DivPlatformYM2608::acquire_ymfm(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2608::acquire_ymfm(short** buf, size_t len) {
   thread_local int os[2];
 
   ymfm::ym2608::fm_engine* fme=fm->debug_fm_engine();
@@ -472,21 +486,23 @@ void DivPlatformYM2608::acquire_ymfm(short** buf, size_t len) {
     buf[0][h]=os[0];
     buf[1][h]=os[1];
 
-    for (int i=0; i<6; i++) {
-      int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
-      oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(out,-32768,32767);
-    }
+    if (osc) {
+      for (int i=0; i<6; i++) {
+        int out=(fmChan[i]->debug_output(0)+fmChan[i]->debug_output(1))<<1;
+        oscBuf[i]->data[oscBuf[i]->needle++]=CLAMP(out,-32768,32767);
+      }
 
-    ssge->get_last_out(ssgOut);
-    for (int i=6; i<9; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=ssgOut.data[i-6]<<1;
-    }
+      ssge->get_last_out(ssgOut);
+      for (int i=6; i<9; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=ssgOut.data[i-6]<<1;
+      }
 
-    for (int i=9; i<15; i++) {
-      oscBuf[i]->data[oscBuf[i]->needle++]=(adpcmAChan[i-9]->get_last_out(0)+adpcmAChan[i-9]->get_last_out(1))>>1;
-    }
+      for (int i=9; i<15; i++) {
+        oscBuf[i]->data[oscBuf[i]->needle++]=(adpcmAChan[i-9]->get_last_out(0)+adpcmAChan[i-9]->get_last_out(1))>>1;
+      }
 
-    oscBuf[15]->data[oscBuf[15]->needle++]=(abe->get_last_out(0)+abe->get_last_out(1))>>1;
+      oscBuf[15]->data[oscBuf[15]->needle++]=(abe->get_last_out(0)+abe->get_last_out(1))>>1;
+    }
   }
 }
 
@@ -494,7 +510,7 @@ static const unsigned char subCycleMap[6]={
   3, 4, 5, 0, 1, 2
 };
 
-void DivPlatformYM2608::acquire_lle(short** buf, size_t len) {
+template<bool osc> void DivPlatformYM2608::acquire_lle(short** buf, size_t len) {
   thread_local int fmOut[6];
 
   for (size_t h=0; h<len; h++) {
@@ -643,25 +659,27 @@ void DivPlatformYM2608::acquire_lle(short** buf, size_t len) {
       if (have0 && have1) break;
     }
 
-    // chan osc
-    // FM
-    for (int i=0; i<6; i++) {
-      if (fmOut[i]<-32768) fmOut[i]=-32768;
-      if (fmOut[i]>32767) fmOut[i]=32767;
-      oscBuf[i]->data[oscBuf[i]->needle++]=fmOut[i];
-    }
-    // SSG
-    for (int i=0; i<3; i++) {
-      oscBuf[i+6]->data[oscBuf[i+6]->needle++]=fm_lle.o_analog_ch[i]*32767;
-    }
-    // RSS
-    for (int i=0; i<6; i++) {
-      if (rssOut[i]<-32768) rssOut[i]=-32768;
-      if (rssOut[i]>32767) rssOut[i]=32767;
-      oscBuf[9+i]->data[oscBuf[9+i]->needle++]=rssOut[i];
+    if (osc) {
+      // chan osc
+      // FM
+      for (int i=0; i<6; i++) {
+        if (fmOut[i]<-32768) fmOut[i]=-32768;
+        if (fmOut[i]>32767) fmOut[i]=32767;
+        oscBuf[i]->data[oscBuf[i]->needle++]=fmOut[i];
+      }
+      // SSG
+      for (int i=0; i<3; i++) {
+        oscBuf[i+6]->data[oscBuf[i+6]->needle++]=fm_lle.o_analog_ch[i]*32767;
+      }
+      // RSS
+      for (int i=0; i<6; i++) {
+        if (rssOut[i]<-32768) rssOut[i]=-32768;
+        if (rssOut[i]>32767) rssOut[i]=32767;
+        oscBuf[9+i]->data[oscBuf[9+i]->needle++]=rssOut[i];
+      }
+      // ADPCM
+      oscBuf[15]->data[oscBuf[15]->needle++]=fm_lle.ac_ad_output;
     }
-    // ADPCM
-    oscBuf[15]->data[oscBuf[15]->needle++]=fm_lle.ac_ad_output;
 
     // DAC
     int accm1=(short)dacOut[1];
@@ -87,9 +87,9 @@ class DivPlatformYM2608: public DivPlatformOPN {
 
     inline void commitState(int ch, DivInstrument* ins);
 
-    void acquire_combo(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
-    void acquire_lle(short** buf, size_t len);
+    template<bool osc> void acquire_combo(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm(short** buf, size_t len);
+    template<bool osc> void acquire_lle(short** buf, size_t len);
 
   public:
     void acquire(short** buf, size_t len);
@@ -40,9 +40,9 @@ class DivPlatformYM2610: public DivPlatformYM2610Base {
 
     void commitState(int ch, DivInstrument* ins);
 
-    void acquire_combo(short** buf, size_t len);
-    void acquire_ymfm(short** buf, size_t len);
-    void acquire_lle(short** buf, size_t len);
+    template<bool osc> void acquire_combo(short** buf, size_t len);
+    template<bool osc> void acquire_ymfm(short** buf, size_t len);
+    template<bool osc> void acquire_lle(short** buf, size_t len);
     
   public:
     void acquire(short** buf, size_t len);
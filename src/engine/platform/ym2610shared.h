@@ -22,6 +22,7 @@
 
 #include "fmshared_OPN.h"
 #include "../engine.h"
+#include "../sampleMemPlanner.h"
 #include "../../ta-log.h"
 #include "ay.h"
 #include "sound/ymfm/ymfm.h"
@@ -232,68 +233,51 @@ class DivPlatformYM2610Base: public DivPlatformOPN {
       memCompoB=DivMemoryComposition();
       memCompoB.name="ADPCM-B";
 
-      size_t memPos=0;
+      // samples may not cross a 1MB boundary
+      std::vector<DivSampleMemItem> items;
       for (int i=0; i<parent->song.sampleLen; i++) {
         DivSample* s=parent->song.sample[i];
-        if (!s->renderOn[0][sysID]) {
-          sampleOffA[i]=0;
+        if (!s->renderOn[0][sysID]) continue;
+        items.push_back(DivSampleMemItem(i,(s->lengthA+255)&(~0xff)));
+      }
+      DivSampleMemPlanner planA(0,getSampleMemCapacity(0),0x100000,256);
+      planA.plan(items);
+      for (DivSampleMemItem& i: items) {
+        if (!i.placed) {
+          logW("out of ADPCM-A memory for sample %d!",i.index);
           continue;
         }
-
-        int paddedLen=(s->lengthA+255)&(~0xff);
-        if ((memPos&0xf00000)!=((memPos+paddedLen)&0xf00000)) {
-          memPos=(memPos+0xfffff)&0xf00000;
-        }
-        if (memPos>=getSampleMemCapacity(0)) {
-          logW("out of ADPCM-A memory for sample %d!",i);
-          break;
-        }
-        if (memPos+paddedLen>=getSampleMemCapacity(0)) {
-          memcpy(adpcmAMem+memPos,s->dataA,getSampleMemCapacity(0)-memPos);
-          logW("out of ADPCM-A memory for sample %d!",i);
-        } else {
-          memcpy(adpcmAMem+memPos,s->dataA,paddedLen);
-          sampleLoaded[0][i]=true;
-        }
-        sampleOffA[i]=memPos;
-        memCompoA.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-        memPos+=paddedLen;
+        memcpy(adpcmAMem+i.pos,parent->song.sample[i.index]->dataA,i.len);
+        sampleOffA[i.index]=i.pos;
+        sampleLoaded[0][i.index]=true;
+        memCompoA.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
       }
-      adpcmAMemLen=memPos+256;
+      adpcmAMemLen=planA.getEnd()+256;
 
       memCompoA.used=adpcmAMemLen;
       memCompoA.capacity=getSampleMemCapacity(0);
 
       memset(adpcmBMem,0,getSampleMemCapacity(1));
 
-      memPos=0;
+      items.clear();
       for (int i=0; i<parent->song.sampleLen; i++) {
         DivSample* s=parent->song.sample[i];
-        if (!s->renderOn[1][sysID]) {
-          sampleOffB[i]=0;
+        if (!s->renderOn[1][sysID]) continue;
+        items.push_back(DivSampleMemItem(i,(s->lengthB+255)&(~0xff)));
+      }
+      DivSampleMemPlanner planB(0,getSampleMemCapacity(1),0x100000,256);
+      planB.plan(items);
+      for (DivSampleMemItem& i: items) {
+        if (!i.placed) {
+          logW("out of ADPCM-B memory for sample %d!",i.index);
           continue;
         }
-
-        int paddedLen=(s->lengthB+255)&(~0xff);
-        if ((memPos&0xf00000)!=((memPos+paddedLen)&0xf00000)) {
-          memPos=(memPos+0xfffff)&0xf00000;
-        }
-        if (memPos>=getSampleMemCapacity(1)) {
-          logW("out of ADPCM-B memory for sample %d!",i);
-          break;
-        }
-        if (memPos+paddedLen>=getSampleMemCapacity(1)) {
-          memcpy(adpcmBMem+memPos,s->dataB,getSampleMemCapacity(1)-memPos);
-          logW("out of ADPCM-B memory for sample %d!",i);
-        } else {
-          memcpy(adpcmBMem+memPos,s->dataB,paddedLen);
-          sampleLoaded[1][i]=true;
-        }
-        sampleOffB[i]=memPos;
-        memCompoB.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i,memPos,memPos+paddedLen));
-        memPos+=paddedLen;
+        memcpy(adpcmBMem+i.pos,parent->song.sample[i.index]->dataB,i.len);
+        sampleOffB[i.index]=i.pos;
+        sampleLoaded[1][i.index]=true;
+        memCompoB.entries.push_back(DivMemoryEntry(DIV_MEMORY_SAMPLE,"Sample",i.index,i.pos,i.pos+i.len));
       }
-      adpcmBMemLen=memPos+256;
+      adpcmBMemLen=planB.getEnd()+256;
 
       memCompoB.used=adpcmBMemLen;
       memCompoB.capacity=getSampleMemCapacity(1);
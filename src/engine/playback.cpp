@@ -19,11 +19,13 @@
 
 #include "macroInt.h"
 #include <chrono>
+#include <limits.h>
 #define _USE_MATH_DEFINES
 #include "dispatch.h"
 #include "engine.h"
 #include "workPool.h"
 #include "../ta-log.h"
+#include "../allocTrack.h"
 #include <math.h>
 
 constexpr int MASTER_CLOCK_PREC=(sizeof(void*)==8)?8:0;
@@ -304,8 +306,8 @@ int DivEngine::dispatchCmd(DivCommand c) {
     }
   }
   totalCmds++;
-  if (cmdStreamEnabled && cmdStream.size()<2000) {
-    cmdStream.push_back(c);
+  if (cmdStreamEnabled) {
+    if (!cmdStream.push_back(c)) cmdStreamOverflow++;
   }
 
   if (output) if (!skipping && output->midiOut!=NULL && !isChannelMuted(c.chan)) {
@@ -930,7 +932,6 @@ void DivEngine::processRow(int i, bool afterDelay) {
         if (divider<1) divider=1;
         cycles=got.rate*pow(2,MASTER_CLOCK_PREC)/divider;
         clockDrift=0;
-        subticks=0;
         break;
       case 0xdc: // delayed mute
         if (effectVal>0 && (song.delayBehavior==2 || effectVal<nextSpeed)) {
@@ -1068,7 +1069,6 @@ void DivEngine::processRow(int i, bool afterDelay) {
         if (divider<1) divider=1;
         cycles=got.rate*pow(2,MASTER_CLOCK_PREC)/divider;
         clockDrift=0;
-        subticks=0;
         break;
       case 0xf3: // fine volume ramp up
         // tremolo and vol slides are incompatible
@@ -1456,24 +1456,7 @@ void DivEngine::nextRow() {
   firstTick=true;
 }
 
-bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
-  bool ret=false;
-  if (divider<1) divider=1;
-
-  if (lowLatency && !skipping && !inhibitLowLat) {
-    tickMult=1000/divider;
-    if (tickMult<1) tickMult=1;
-  } else {
-    tickMult=1;
-  }
-  
-  cycles=got.rate*pow(2,MASTER_CLOCK_PREC)/(divider*tickMult);
-  clockDrift+=fmod(got.rate*pow(2,MASTER_CLOCK_PREC),(double)(divider*tickMult));
-  if (clockDrift>=(divider*tickMult)) {
-    clockDrift-=(divider*tickMult);
-    cycles++;
-  }
-
+void DivEngine::processPendingNotes() {
   if (!pendingNotes.empty()) {
     bool isOn[DIV_MAX_CHANS];
     memset(isOn,0,DIV_MAX_CHANS*sizeof(bool));
@@ -1530,311 +1513,323 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
     }
     pendingNotes.pop_front();
   }
+}
+
+void DivEngine::nextInputTick() {
+  inputTick=true;
+  processPendingNotes();
+  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(false);
+  inputTick=false;
+}
+
+bool DivEngine::nextTick(bool noAccum) {
+  bool ret=false;
+  if (divider<1) divider=1;
+
+  cycles=got.rate*pow(2,MASTER_CLOCK_PREC)/divider;
+  clockDrift+=fmod(got.rate*pow(2,MASTER_CLOCK_PREC),divider);
+  if (clockDrift>=divider) {
+    clockDrift-=divider;
+    cycles++;
+  }
+
+  processPendingNotes();
 
   if (!freelance) {
-    if (--subticks<=0) {
-      subticks=tickMult;
-
-      if (stepPlay!=1) {
-        tempoAccum+=(skipping && virtualTempoN<virtualTempoD)?virtualTempoD:virtualTempoN;
-        while (tempoAccum>=virtualTempoD) {
-          tempoAccum-=virtualTempoD;
-          if (--ticks<=0) {
-            ret=endOfSong;
-            if (shallStopSched) {
-              logV("acknowledging scheduled stop");
-              shallStop=true;
-              break;
-            } else if (endOfSong) {
-              if (song.loopModality!=2) {
-                playSub(true);
-              }
-            }
-            endOfSong=false;
-            if (stepPlay==2) {
-              stepPlay=1;
-              playPosLock.lock();
-              prevOrder=curOrder;
-              prevRow=curRow;
-              playPosLock.unlock();
-            }
-            nextRow();
+    if (stepPlay!=1) {
+      tempoAccum+=(skipping && virtualTempoN<virtualTempoD)?virtualTempoD:virtualTempoN;
+      while (tempoAccum>=virtualTempoD) {
+        tempoAccum-=virtualTempoD;
+        if (--ticks<=0) {
+          ret=endOfSong;
+          if (shallStopSched) {
+            logV("acknowledging scheduled stop");
+            shallStop=true;
             break;
+          } else if (endOfSong) {
+            if (song.loopModality!=2) {
+              playSub(true);
+            }
           }
+          endOfSong=false;
+          if (stepPlay==2) {
+            stepPlay=1;
+            playPosLock.lock();
+            prevOrder=curOrder;
+            prevRow=curRow;
+            playPosLock.unlock();
+          }
+          nextRow();
+          break;
         }
-        // under no circumstances shall the accumulator become this large
-        if (tempoAccum>1023) tempoAccum=1023;
       }
-      // process stuff
-      if (!shallStop) for (int i=0; i<chans; i++) {
-        // delay effects
-        if (chan[i].rowDelay>0) {
-          if (--chan[i].rowDelay==0) {
-            processRow(i,true);
-          }
+      // under no circumstances shall the accumulator become this large
+      if (tempoAccum>1023) tempoAccum=1023;
+    }
+    // process stuff
+    if (!shallStop) for (int i=0; i<chans; i++) {
+      // delay effects
+      if (chan[i].rowDelay>0) {
+        if (--chan[i].rowDelay==0) {
+          processRow(i,true);
         }
+      }
 
-        // retrigger
-        if (chan[i].retrigSpeed) {
-          if (--chan[i].retrigTick<0) {
-            chan[i].retrigTick=chan[i].retrigSpeed-1;
-            dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
-            keyHit[i]=true;
-          }
+      // retrigger
+      if (chan[i].retrigSpeed) {
+        if (--chan[i].retrigTick<0) {
+          chan[i].retrigTick=chan[i].retrigSpeed-1;
+          dispatchCmd(DivCommand(DIV_CMD_NOTE_ON,i,DIV_NOTE_NULL));
+          keyHit[i]=true;
         }
+      }
 
-        // volume slides and tremolo
-        if (!song.noSlidesOnFirstTick || !firstTick) {
-          if (chan[i].volSpeed!=0) {
-            chan[i].volume=(chan[i].volume&0xff)|(dispatchCmd(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
-            chan[i].volume+=chan[i].volSpeed;
-            if (chan[i].volume>chan[i].volMax) {
-              chan[i].volume=chan[i].volMax;
-              chan[i].volSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-            } else if (chan[i].volume<0) {
-              chan[i].volSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
-              if (song.legacyVolumeSlides) {
-                chan[i].volume=chan[i].volMax+1;
-              } else {
-                chan[i].volume=0;
-              }
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+      // volume slides and tremolo
+      if (!song.noSlidesOnFirstTick || !firstTick) {
+        if (chan[i].volSpeed!=0) {
+          chan[i].volume=(chan[i].volume&0xff)|(dispatchCmd(DivCommand(DIV_CMD_GET_VOLUME,i))<<8);
+          chan[i].volume+=chan[i].volSpeed;
+          if (chan[i].volume>chan[i].volMax) {
+            chan[i].volume=chan[i].volMax;
+            chan[i].volSpeed=0;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+          } else if (chan[i].volume<0) {
+            chan[i].volSpeed=0;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOL_SLIDE,i,0));
+            if (song.legacyVolumeSlides) {
+              chan[i].volume=chan[i].volMax+1;
             } else {
-              dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+              chan[i].volume=0;
             }
-          } else if (chan[i].tremoloDepth>0) {
-            chan[i].tremoloPos+=chan[i].tremoloRate;
-            chan[i].tremoloPos&=127;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
+          } else {
+            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
           }
+        } else if (chan[i].tremoloDepth>0) {
+          chan[i].tremoloPos+=chan[i].tremoloRate;
+          chan[i].tremoloPos&=127;
+          dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,MAX(0,chan[i].volume-(tremTable[chan[i].tremoloPos]*chan[i].tremoloDepth))>>8));
         }
+      }
 
-        // panning slides
-        if (chan[i].panSpeed!=0) {
-          int newPanL=chan[i].panL;
-          int newPanR=chan[i].panR;
-          if (chan[i].panSpeed>0) { // right
-            if (newPanR>=0xff) {
-              newPanL-=chan[i].panSpeed;
-            } else {
-              newPanR+=chan[i].panSpeed;
-            }
-          } else { // left
-            if (newPanL>=0xff) {
-              newPanR+=chan[i].panSpeed;
-            } else {
-              newPanL-=chan[i].panSpeed;
-            }
+      // panning slides
+      if (chan[i].panSpeed!=0) {
+        int newPanL=chan[i].panL;
+        int newPanR=chan[i].panR;
+        if (chan[i].panSpeed>0) { // right
+          if (newPanR>=0xff) {
+            newPanL-=chan[i].panSpeed;
+          } else {
+            newPanR+=chan[i].panSpeed;
           }
+        } else { // left
+          if (newPanL>=0xff) {
+            newPanR+=chan[i].panSpeed;
+          } else {
+            newPanL-=chan[i].panSpeed;
+          }
+        }
 
-          if (newPanL<0) newPanL=0;
-          if (newPanL>0xff) newPanL=0xff;
-          if (newPanR<0) newPanR=0;
-          if (newPanR>0xff) newPanR=0xff;
-
-          chan[i].panL=newPanL;
-          chan[i].panR=newPanR;
+        if (newPanL<0) newPanL=0;
+        if (newPanL>0xff) newPanL=0xff;
+        if (newPanR<0) newPanR=0;
+        if (newPanR>0xff) newPanR=0xff;
 
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
-        } else if (chan[i].panDepth>0) {
-          chan[i].panPos+=chan[i].panRate;
-          chan[i].panPos&=255;
+        chan[i].panL=newPanL;
+        chan[i].panR=newPanR;
 
-          // calculate...
-          switch (chan[i].panPos&0xc0) {
-            case 0: // center -> right
-              chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
-              chan[i].panR=0xff;
-              break;
-            case 0x40: // right -> center
-              chan[i].panL=(chan[i].panPos&0x3f)<<2;
-              chan[i].panR=0xff;
-              break;
-            case 0x80: // center -> left
-              chan[i].panL=0xff;
-              chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
-              break;
-            case 0xc0: // left -> center
-              chan[i].panL=0xff;
-              chan[i].panR=(chan[i].panPos&0x3f)<<2;
-              break;
-          }
+        dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+      } else if (chan[i].panDepth>0) {
+        chan[i].panPos+=chan[i].panRate;
+        chan[i].panPos&=255;
 
-          dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+        // calculate...
+        switch (chan[i].panPos&0xc0) {
+          case 0: // center -> right
+            chan[i].panL=0xff-((chan[i].panPos&0x3f)<<2);
+            chan[i].panR=0xff;
+            break;
+          case 0x40: // right -> center
+            chan[i].panL=(chan[i].panPos&0x3f)<<2;
+            chan[i].panR=0xff;
+            break;
+          case 0x80: // center -> left
+            chan[i].panL=0xff;
+            chan[i].panR=0xff-((chan[i].panPos&0x3f)<<2);
+            break;
+          case 0xc0: // left -> center
+            chan[i].panL=0xff;
+            chan[i].panR=(chan[i].panPos&0x3f)<<2;
+            break;
         }
 
-        // vibrato
-        if (chan[i].vibratoDepth>0) {
-          chan[i].vibratoPos+=chan[i].vibratoRate;
-          while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
+        dispatchCmd(DivCommand(DIV_CMD_PANNING,i,chan[i].panL,chan[i].panR));
+      }
 
-          chan[i].vibratoPosGiant+=chan[i].vibratoRate;
-          while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
+      // vibrato
+      if (chan[i].vibratoDepth>0) {
+        chan[i].vibratoPos+=chan[i].vibratoRate;
+        while (chan[i].vibratoPos>=64) chan[i].vibratoPos-=64;
 
-          int vibratoOut=0;
-          switch (chan[i].vibratoShape) {
-            case 1: // sine, up only
-              vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 2: // sine, down only
-              vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
-              break;
-            case 3: // triangle
-              vibratoOut=(chan[i].vibratoPos&31);
-              if (chan[i].vibratoPos&16) {
-                vibratoOut=32-(chan[i].vibratoPos&31);
-              }
-              if (chan[i].vibratoPos&32) {
-                vibratoOut=-vibratoOut;
-              }
-              vibratoOut<<=3;
-              break;
-            case 4: // ramp up
-              vibratoOut=chan[i].vibratoPos<<1;
-              break;
-            case 5: // ramp down
-              vibratoOut=-chan[i].vibratoPos<<1;
-              break;
-            case 6: // square
-              vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
-              break;
-            case 7: // random (TODO: use LFSR)
-              vibratoOut=(rand()&255)-128;
-              break;
-            case 8: // square up
-              vibratoOut=(chan[i].vibratoPos>=32)?0:127;
-              break;
-            case 9: // square down
-              vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
-              break;
-            case 10: // half sine up
-              vibratoOut=vibTable[chan[i].vibratoPos>>1];
-              break;
-            case 11: // half sine down
-              vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
-              break;
-            default: // sine
-              vibratoOut=vibTable[chan[i].vibratoPos];
-              break;
-          }
-          dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
+        chan[i].vibratoPosGiant+=chan[i].vibratoRate;
+        while (chan[i].vibratoPosGiant>=512) chan[i].vibratoPosGiant-=512;
+
+        int vibratoOut=0;
+        switch (chan[i].vibratoShape) {
+          case 1: // sine, up only
+            vibratoOut=MAX(0,vibTable[chan[i].vibratoPos]);
+            break;
+          case 2: // sine, down only
+            vibratoOut=MIN(0,vibTable[chan[i].vibratoPos]);
+            break;
+          case 3: // triangle
+            vibratoOut=(chan[i].vibratoPos&31);
+            if (chan[i].vibratoPos&16) {
+              vibratoOut=32-(chan[i].vibratoPos&31);
+            }
+            if (chan[i].vibratoPos&32) {
+              vibratoOut=-vibratoOut;
+            }
+            vibratoOut<<=3;
+            break;
+          case 4: // ramp up
+            vibratoOut=chan[i].vibratoPos<<1;
+            break;
+          case 5: // ramp down
+            vibratoOut=-chan[i].vibratoPos<<1;
+            break;
+          case 6: // square
+            vibratoOut=(chan[i].vibratoPos>=32)?-127:127;
+            break;
+          case 7: // random (TODO: use LFSR)
+            vibratoOut=(rand()&255)-128;
+            break;
+          case 8: // square up
+            vibratoOut=(chan[i].vibratoPos>=32)?0:127;
+            break;
+          case 9: // square down
+            vibratoOut=(chan[i].vibratoPos>=32)?0:-127;
+            break;
+          case 10: // half sine up
+            vibratoOut=vibTable[chan[i].vibratoPos>>1];
+            break;
+          case 11: // half sine down
+            vibratoOut=vibTable[32|(chan[i].vibratoPos>>1)];
+            break;
+          default: // sine
+            vibratoOut=vibTable[chan[i].vibratoPos];
+            break;
         }
+        dispatchCmd(DivCommand(DIV_CMD_PITCH,i,chan[i].pitch+(((chan[i].vibratoDepth*vibratoOut*chan[i].vibratoFine)>>4)/15)));
+      }
 
-        // delayed legato
-        if (chan[i].legatoDelay>0) {
-          if (--chan[i].legatoDelay<1) {
-            chan[i].note+=chan[i].legatoTarget;
-            dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            chan[i].legatoDelay=-1;
-            chan[i].legatoTarget=0;
-          }
+      // delayed legato
+      if (chan[i].legatoDelay>0) {
+        if (--chan[i].legatoDelay<1) {
+          chan[i].note+=chan[i].legatoTarget;
+          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+          dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+          chan[i].legatoDelay=-1;
+          chan[i].legatoTarget=0;
         }
+      }
 
-        // portamento and pitch slides
-        if (!song.noSlidesOnFirstTick || !firstTick) {
-          if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
-            if (dispatchCmd(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.linearPitch==2?song.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.targetResetsSlides) {
-              chan[i].portaSpeed=0;
-              dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-              chan[i].oldNote=chan[i].note;
-              chan[i].note=chan[i].portaNote;
-              chan[i].inPorta=false;
-              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-              dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-            }
+      // portamento and pitch slides
+      if (!song.noSlidesOnFirstTick || !firstTick) {
+        if ((chan[i].keyOn || chan[i].keyOff) && chan[i].portaSpeed>0) {
+          if (dispatchCmd(DivCommand(DIV_CMD_NOTE_PORTA,i,chan[i].portaSpeed*(song.linearPitch==2?song.pitchSlideSpeed:1),chan[i].portaNote))==2 && chan[i].portaStop && song.targetResetsSlides) {
+            chan[i].portaSpeed=0;
+            dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+            chan[i].oldNote=chan[i].note;
+            chan[i].note=chan[i].portaNote;
+            chan[i].inPorta=false;
+            dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+            dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
           }
         }
+      }
 
-        // note cut
-        if (chan[i].cut>0) {
-          if (--chan[i].cut<1) {
-            if (chan[i].cutType==2) {
-              dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
-              chan[i].releasing=true;
-            } else {
-              chan[i].oldNote=chan[i].note;
-              //chan[i].note=-1;
-              if (chan[i].inPorta && song.noteOffResetsSlides) {
-                chan[i].keyOff=true;
-                chan[i].keyOn=false;
-                if (chan[i].stopOnOff) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                  chan[i].stopOnOff=false;
-                }
-                if (disCont[dispatchOfChan[i]].dispatch->keyOffAffectsPorta(dispatchChanOfChan[i])) {
-                  chan[i].portaNote=-1;
-                  chan[i].portaSpeed=-1;
-                  dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
-                }
-                dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
-                chan[i].scheduledSlideReset=true;
+      // note cut
+      if (chan[i].cut>0) {
+        if (--chan[i].cut<1) {
+          if (chan[i].cutType==2) {
+            dispatchCmd(DivCommand(DIV_CMD_ENV_RELEASE,i));
+            chan[i].releasing=true;
+          } else {
+            chan[i].oldNote=chan[i].note;
+            //chan[i].note=-1;
+            if (chan[i].inPorta && song.noteOffResetsSlides) {
+              chan[i].keyOff=true;
+              chan[i].keyOn=false;
+              if (chan[i].stopOnOff) {
+                chan[i].portaNote=-1;
+                chan[i].portaSpeed=-1;
+                dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
+                chan[i].stopOnOff=false;
               }
-              if (chan[i].cutType==1) {
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
-              } else {
-                dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
+              if (disCont[dispatchOfChan[i]].dispatch->keyOffAffectsPorta(dispatchChanOfChan[i])) {
+                chan[i].portaNote=-1;
+                chan[i].portaSpeed=-1;
+                dispatchCmd(DivCommand(DIV_CMD_HINT_PORTA,i,CLAMP(chan[i].portaNote,-128,127),MAX(chan[i].portaSpeed,0)));
               }
-              chan[i].releasing=true;
+              dispatchCmd(DivCommand(DIV_CMD_PRE_PORTA,i,false,0));
+              chan[i].scheduledSlideReset=true;
+            }
+            if (chan[i].cutType==1) {
+              dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF_ENV,i));
+            } else {
+              dispatchCmd(DivCommand(DIV_CMD_NOTE_OFF,i));
             }
+            chan[i].releasing=true;
           }
         }
+      }
 
-        // volume cut/mute
-        if (chan[i].volCut>0) {
-          if (--chan[i].volCut<1) {
-            chan[i].volume=0;
-            dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
-            dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
-          }
+      // volume cut/mute
+      if (chan[i].volCut>0) {
+        if (--chan[i].volCut<1) {
+          chan[i].volume=0;
+          dispatchCmd(DivCommand(DIV_CMD_VOLUME,i,chan[i].volume>>8));
+          dispatchCmd(DivCommand(DIV_CMD_HINT_VOLUME,i,chan[i].volume>>8));
         }
+      }
 
-        // arpeggio
-        if (chan[i].resetArp) {
-          dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-          dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
-          chan[i].resetArp=false;
-        }
-        if (song.rowResetsArpPos && firstTick) {
-          chan[i].arpStage=-1;
-        }
-        if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
-          if (--chan[i].arpTicks<1) {
-            chan[i].arpTicks=curSubSong->arpLen;
-            chan[i].arpStage++;
-            if (chan[i].arpStage>2) chan[i].arpStage=0;
-            switch (chan[i].arpStage) {
-              case 0:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
-                break;
-              case 1:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
-                break;
-              case 2:
-                dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
-                break;
-            }
+      // arpeggio
+      if (chan[i].resetArp) {
+        dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+        dispatchCmd(DivCommand(DIV_CMD_HINT_LEGATO,i,chan[i].note));
+        chan[i].resetArp=false;
+      }
+      if (song.rowResetsArpPos && firstTick) {
+        chan[i].arpStage=-1;
+      }
+      if (chan[i].arp!=0 && !chan[i].arpYield && chan[i].portaSpeed<1) {
+        if (--chan[i].arpTicks<1) {
+          chan[i].arpTicks=curSubSong->arpLen;
+          chan[i].arpStage++;
+          if (chan[i].arpStage>2) chan[i].arpStage=0;
+          switch (chan[i].arpStage) {
+            case 0:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note));
+              break;
+            case 1:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp>>4)));
+              break;
+            case 2:
+              dispatchCmd(DivCommand(DIV_CMD_LEGATO,i,chan[i].note+(chan[i].arp&15)));
+              break;
           }
-        } else {
-          chan[i].arpYield=false;
         }
+      } else {
+        chan[i].arpYield=false;
       }
     }
-  } else {
-    // still tick the subtick counter
-    if (--subticks<=0) {
-      subticks=tickMult;
-    }
   }
 
-  if (subticks==tickMult && cmdStreamInt) {
+  if (cmdStreamInt) {
     if (!cmdStreamInt->tick()) {
       // !!!
     }
@@ -1869,13 +1864,13 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
   }
 
   // system tick
-  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(subticks==tickMult);
+  for (int i=0; i<song.systemLen; i++) disCont[i].dispatch->tick(true);
 
   if (!freelance) {
     if (stepPlay!=1) {
       if (!noAccum) {
         totalTicksR++;
-        totalTicks+=1000000/(divider*tickMult);
+        totalTicks+=1000000/divider;
       }
       if (totalTicks>=1000000) {
         totalTicks-=1000000;
@@ -1885,7 +1880,7 @@ bool DivEngine::nextTick(bool noAccum, bool inhibitLowLat) {
       }
     }
 
-    if (consoleMode && !disableStatusOut && subticks<=1 && !skipping) fprintf(stderr,"\x1b[2K> %d:%.2d:%.2d.%.2d  %.2x/%.2x:%.3d/%.3d  %4dcmd/s\x1b[G",totalSeconds/3600,(totalSeconds/60)%60,totalSeconds%60,totalTicks/10000,curOrder,curSubSong->ordersLen,curRow,curSubSong->patLen,cmdsPerSecond);
+    if (consoleMode && !disableStatusOut && !skipping) fprintf(stderr,"\x1b[2K> %d:%.2d:%.2d.%.2d  %.2x/%.2x:%.3d/%.3d  %4dcmd/s\x1b[G",totalSeconds/3600,(totalSeconds/60)%60,totalSeconds%60,totalTicks/10000,curOrder,curSubSong->ordersLen,curRow,curSubSong->patLen,cmdsPerSecond);
   }
 
   if (haltOn==DIV_HALT_TICK) halted=true;
@@ -2074,15 +2069,30 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
   got.bufsize=size;
 
+  // from here on the render path must not allocate
+  ALLOC_TRACK_BEGIN("DivEngine::nextBuf()");
+
+  // apply edits posted by the GUI
+  editQueue.apply(this);
+
   std::chrono::steady_clock::time_point ts_processBegin=std::chrono::steady_clock::now();
 
+  // only happens on the first buffer after the chips or the audio backend have changed
   if (renderPool==NULL) {
+    ALLOC_TRACK_SUSPEND;
     unsigned int howManyThreads=song.systemLen;
     if (howManyThreads<2) howManyThreads=0;
     if (howManyThreads>renderPoolThreads) howManyThreads=renderPoolThreads;
     renderPool=new DivWorkPool(howManyThreads);
   }
 
+  // performance counters
+  unsigned int perfTicks=0;
+  uint64_t perfParallelTime=0;
+  for (int i=0; i<song.systemLen; i++) {
+    disCont[i].acquireTime=0;
+  }
+
   // process MIDI events (TODO: everything)
   if (output) if (output->midiIn) while (!output->midiIn->queue.empty()) {
     TAMidiMessage& msg=output->midiIn->queue.front();
@@ -2142,7 +2152,15 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
     //logD("%.2x",msg.type);
     output->midiIn->queue.pop();
   }
-  
+
+  // only happens if the buffer size is larger than what the audio backend reported
+  if (metroBufLen<size || metroTickLen<size) {
+    ALLOC_TRACK_SUSPEND;
+    logD("growing metronome buffers to %d",size);
+    reserveRenderBuffers(size);
+    renderBufGrowths++;
+  }
+
   // process sample/wave preview
   if ((sPreview.sample>=0 && sPreview.sample<(int)song.sample.size()) || (sPreview.wave>=0 && sPreview.wave<(int)song.wave.size())) {
     unsigned int samp_bbOff=0;
@@ -2306,19 +2324,15 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
         disCont[i].runtotal=blip_clocks_needed(disCont[i].bb[0],size-disCont[i].lastAvail);
       }
       if (disCont[i].runtotal>disCont[i].bbInLen) {
+        ALLOC_TRACK_SUSPEND;
         logD("growing dispatch %d bbIn to %d",i,disCont[i].runtotal+256);
         disCont[i].grow(disCont[i].runtotal+256);
+        renderBufGrowths++;
       }
       disCont[i].runLeft=disCont[i].runtotal;
       disCont[i].runPos=0;
     }
 
-    if (metroTickLen<size) {
-      if (metroTick!=NULL) delete[] metroTick;
-      metroTick=new unsigned char[size];
-      metroTickLen=size;
-    }
-
     memset(metroTick,0,size);
 
     int attempts=0;
@@ -2335,6 +2349,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       // 2. check whether we gonna tick
       if (cycles<=0) {
         // we have to tick
+        perfTicks++;
         if (nextTick()) {
           /*totalTicks=0;
           totalSeconds=0;*/
@@ -2359,6 +2374,9 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
           metroTick[realPos]=pendingMetroTick;
           pendingMetroTick=0;
         }
+      } else if (lowLatency && !pendingNotes.empty()) {
+        // 2b. in low-latency mode, apply input right away instead of waiting for the next tick
+        nextInputTick();
       } else {
         // 3. run MIDI clock
         int midiTotal=MIN(cycles,runLeftG);
@@ -2368,6 +2386,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
         runMidiTime(midiTotal);
 
         // 5. tick the clock and fill buffers as needed
+        std::chrono::steady_clock::time_point ts_acquireBegin=std::chrono::steady_clock::now();
         if (cycles<runLeftG) {
           for (int i=0; i<song.systemLen; i++) {
             disCont[i].cycles=cycles;
@@ -2395,6 +2414,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
           }
           renderPool->wait();
         }
+        perfParallelTime+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-ts_acquireBegin).count();
       }
     }
 
@@ -2422,13 +2442,7 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
 
   // process metronome
-  if (metroBufLen<size || metroBuf==NULL) {
-    if (metroBuf!=NULL) delete[] metroBuf;
-    metroBuf=new float[size];
-    metroBufLen=size;
-  }
-
-  memset(metroBuf,0,metroBufLen*sizeof(float));
+  memset(metroBuf,0,size*sizeof(float));
 
   if (mustPlay && metronome) {
     for (size_t i=0; i<size; i++) {
@@ -2513,12 +2527,14 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
   }
 
   // dump to oscillator buffer
-  for (unsigned int i=0; i<size; i++) {
-    for (int j=0; j<outChans; j++) {
-      if (oscBuf[j]==NULL) continue;
-      oscBuf[j][oscWritePos]=out[j][i];
+  if (oscCapture) {
+    for (unsigned int i=0; i<size; i++) {
+      for (int j=0; j<outChans; j++) {
+        if (oscBuf[j]==NULL) continue;
+        oscBuf[j][oscWritePos]=out[j][i];
+      }
+      if (++oscWritePos>=32768) oscWritePos=0;
     }
-    if (++oscWritePos>=32768) oscWritePos=0;
   }
   oscSize=size;
 
@@ -2545,9 +2561,42 @@ void DivEngine::nextBuf(float** in, float** out, int inChans, int outChans, unsi
       }
     }
   }
+  ALLOC_TRACK_END;
   isBusy.unlock();
 
   std::chrono::steady_clock::time_point ts_processEnd=std::chrono::steady_clock::now();
 
   processTime=std::chrono::duration_cast<std::chrono::nanoseconds>(ts_processEnd-ts_processBegin).count();
+
+  // record performance counters
+  DivPerfSample& perf=perfHistory[perfPos%DIV_PERF_HISTORY];
+  uint64_t perfBusyTime=0;
+  perf.processTime=MIN(processTime.load(),(size_t)UINT_MAX);
+  perf.budget=(got.rate>0)?(unsigned int)(1000000000.0*(double)size/got.rate):0;
+  perf.size=size;
+  perf.ticks=perfTicks;
+  perf.cmds=(totalCmds>=perfLastCmds)?(totalCmds-perfLastCmds):totalCmds;
+  perfLastCmds=totalCmds;
+  perf.regWrites=0;
+  perf.chips=song.systemLen;
+  for (int i=0; i<song.systemLen; i++) {
+    perf.chipTime[i]=MIN(disCont[i].acquireTime,(uint64_t)UINT_MAX);
+    perfBusyTime+=disCont[i].acquireTime;
+    if (disCont[i].dispatch!=NULL) {
+      perf.regWrites+=disCont[i].dispatch->regWriteCount;
+      disCont[i].dispatch->regWriteCount=0;
+    }
+  }
+  perfParallelTime*=MAX(1,renderPool->getThreadCount());
+  perf.workerIdle=(perfParallelTime>perfBusyTime)?MIN(perfParallelTime-perfBusyTime,(uint64_t)UINT_MAX):0;
+  if (output!=NULL) {
+    unsigned int xruns=output->getXRunCount();
+    if (renderAheadOut!=NULL) xruns+=renderAheadOut->getUnderrunCount();
+    // the counter starts from zero whenever the audio backend is re-initialized
+    perf.xruns=(xruns>=perfLastXRuns)?(xruns-perfLastXRuns):xruns;
+    perfLastXRuns=xruns;
+  } else {
+    perf.xruns=0;
+  }
+  perfPos.fetch_add(1,std::memory_order_release);
 }
@@ -0,0 +1,177 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "renderAhead.h"
+#include "engine.h"
+#include "../ta-log.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+void DivRenderAhead::process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size) {
+  ((DivRenderAhead*)u)->read(out,outChans,size);
+}
+
+void DivRenderAhead::read(float** out, int outChans, unsigned int size) {
+  unsigned int done=0;
+  while (done<size) {
+    size_t pos=readPos.load(std::memory_order_relaxed);
+    if (pos==writePos.load(std::memory_order_acquire)) {
+      // render thread is late
+      for (int i=0; i<outChans; i++) {
+        memset(&out[i][done],0,(size-done)*sizeof(float));
+      }
+      if (thread!=NULL) underruns.fetch_add(1,std::memory_order_relaxed);
+      break;
+    }
+    DivRenderAheadBlock& b=blocks[pos%count];
+    unsigned int n=MIN(blockSize-readOffset,size-done);
+    for (int i=0; i<outChans; i++) {
+      if (i<chans) {
+        memcpy(&out[i][done],&b.data[i][readOffset],n*sizeof(float));
+      } else {
+        memset(&out[i][done],0,n*sizeof(float));
+      }
+    }
+    audiblePos.store((b.order<<16)|(b.row&0xffff),std::memory_order_relaxed);
+    readOffset+=n;
+    done+=n;
+    if (readOffset>=blockSize) {
+      readOffset=0;
+      readPos.store(pos+1,std::memory_order_release);
+      // no need to take the lock - the render thread wakes up periodically anyway
+      wake.notify_one();
+    }
+  }
+}
+
+void DivRenderAhead::run() {
+#ifdef _WIN32
+  if (!SetThreadPriority(GetCurrentThread(),THREAD_PRIORITY_TIME_CRITICAL)) {
+    logW("could not raise render thread priority!");
+  }
+#else
+  sched_param param;
+  param.sched_priority=sched_get_priority_min(SCHED_FIFO);
+  if (pthread_setschedparam(pthread_self(),SCHED_FIFO,&param)!=0) {
+    logD("could not set real-time priority for render thread.");
+  }
+#endif
+
+  // sleep for a quarter of a block between checks
+  std::chrono::microseconds period((long long)blockSize*250000/MAX(1,(long long)e->getAudioDescGot().rate));
+
+  while (!quit.load()) {
+    size_t w=writePos.load(std::memory_order_relaxed);
+    size_t r=readPos.load(std::memory_order_acquire);
+    // only keep one block ahead while stopped, so that note previews aren't delayed
+    size_t target=e->isPlaying()?count:1;
+    if (w-r<target) {
+      DivRenderAheadBlock& b=blocks[w%count];
+      e->nextBuf(NULL,b.data,0,chans,blockSize);
+      e->getRenderPos(b.order,b.row);
+      writePos.store(w+1,std::memory_order_release);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(wakeLock);
+    wake.wait_for(lock,period);
+  }
+}
+
+bool DivRenderAhead::start(int outChans, unsigned int size, unsigned int ahead) {
+  if (thread!=NULL) stop();
+  if (outChans<1 || outChans>DIV_MAX_OUTPUTS || size<1) return false;
+  if (ahead<2) ahead=2;
+  if (ahead>DIV_RENDER_AHEAD_MAX) ahead=DIV_RENDER_AHEAD_MAX;
+
+  for (unsigned int i=0; i<DIV_RENDER_AHEAD_MAX; i++) {
+    for (int j=0; j<DIV_MAX_OUTPUTS; j++) {
+      if (blocks[i].data[j]!=NULL) {
+        delete[] blocks[i].data[j];
+        blocks[i].data[j]=NULL;
+      }
+    }
+  }
+  for (unsigned int i=0; i<ahead; i++) {
+    for (int j=0; j<outChans; j++) {
+      blocks[i].data[j]=new float[size];
+      memset(blocks[i].data[j],0,size*sizeof(float));
+    }
+  }
+
+  chans=outChans;
+  blockSize=size;
+  count=ahead;
+  writePos=0;
+  readPos=0;
+  readOffset=0;
+  quit=false;
+
+  logI("rendering %d blocks ahead (%d samples).",count,count*blockSize);
+  thread=new std::thread(&DivRenderAhead::run,this);
+  return true;
+}
+
+void DivRenderAhead::stop() {
+  if (thread==NULL) return;
+  quit=true;
+  wake.notify_one();
+  thread->join();
+  delete thread;
+  thread=NULL;
+}
+
+bool DivRenderAhead::getAudiblePos(int& order, int& row) {
+  int pos=audiblePos.load(std::memory_order_relaxed);
+  if (pos<0) return false;
+  order=pos>>16;
+  row=(short)(pos&0xffff);
+  return true;
+}
+
+unsigned int DivRenderAhead::getUnderrunCount() {
+  return underruns.load(std::memory_order_relaxed);
+}
+
+DivRenderAhead::DivRenderAhead(DivEngine* engine):
+  e(engine),
+  chans(0),
+  blockSize(0),
+  count(1),
+  writePos(0),
+  readPos(0),
+  audiblePos(-1),
+  underruns(0),
+  readOffset(0),
+  quit(false),
+  thread(NULL) {
+  memset(blocks,0,sizeof(blocks));
+}
+
+DivRenderAhead::~DivRenderAhead() {
+  stop();
+  for (unsigned int i=0; i<DIV_RENDER_AHEAD_MAX; i++) {
+    for (int j=0; j<DIV_MAX_OUTPUTS; j++) {
+      if (blocks[i].data[j]!=NULL) delete[] blocks[i].data[j];
+    }
+  }
+}
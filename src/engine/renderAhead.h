@@ -0,0 +1,102 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _RENDERAHEAD_H
+#define _RENDERAHEAD_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "defines.h"
+
+#define DIV_RENDER_AHEAD_MAX 8
+
+class DivEngine;
+
+struct DivRenderAheadBlock {
+  float* data[DIV_MAX_OUTPUTS];
+  // play position at the end of this block
+  int order, row;
+};
+
+/**
+ * renders audio on a separate thread, some blocks ahead of the audio device.
+ * the device callback only copies from a lock-free ring, so render spikes
+ * shorter than the buffered audio don't cause dropouts.
+ */
+class DivRenderAhead {
+  DivEngine* e;
+  DivRenderAheadBlock blocks[DIV_RENDER_AHEAD_MAX];
+  int chans;
+  unsigned int blockSize, count;
+  std::atomic<size_t> writePos, readPos;
+  std::atomic<int> audiblePos;
+  std::atomic<unsigned int> underruns;
+  // current position within the block being read
+  unsigned int readOffset;
+  std::atomic<bool> quit;
+  std::thread* thread;
+  std::mutex wakeLock;
+  std::condition_variable wake;
+
+  void run();
+
+  public:
+    /**
+     * the audio callback. pass this object as user data.
+     */
+    static void process(void* u, float** in, float** out, int inChans, int outChans, unsigned int size);
+
+    /**
+     * copy rendered audio to the output.
+     * plays silence if the render thread is late.
+     */
+    void read(float** out, int outChans, unsigned int size);
+
+    /**
+     * allocate the ring and start the render thread.
+     * @param outChans the number of output channels.
+     * @param size the block size.
+     * @param ahead the number of blocks to render ahead while playing.
+     * @return whether it succeeded.
+     */
+    bool start(int outChans, unsigned int size, unsigned int ahead);
+
+    /**
+     * stop the render thread. call this after the audio device is stopped.
+     */
+    void stop();
+
+    /**
+     * get the play position of the audio currently being heard.
+     * @return whether a position is available.
+     */
+    bool getAudiblePos(int& order, int& row);
+
+    /**
+     * get the number of blocks which were not ready in time.
+     */
+    unsigned int getUnderrunCount();
+
+    DivRenderAhead(DivEngine* engine);
+    ~DivRenderAhead();
+};
+
+#endif
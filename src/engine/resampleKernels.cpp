@@ -0,0 +1,272 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "resampleKernels.h"
+#include "filter.h"
+#include "../ta-log.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+#define DIV_RESAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+#define DIV_RESAMPLE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// the scalar kernels. the SIMD ones fall back to these for the last few
+// outputs of a block.
+
+static void linearScalar(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const short* s0=win;
+  const short* s1=win+stride;
+  for (size_t i=0; i<len; i++) {
+    out[i]=s0[i]+(((int)((int)s1[i]-(int)s0[i])*pos[i])>>15);
+  }
+}
+
+static void cubicScalar(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* cubicTable=DivFilterTables::getCubicTable();
+  for (size_t i=0; i<len; i++) {
+    const float* t=&cubicTable[pos[i]<<2];
+    out[i]=(float)win[i]*t[0]+(float)win[stride+i]*t[1]+(float)win[stride*2+i]*t[2]+(float)win[stride*3+i]*t[3];
+  }
+}
+
+static void sinc8Scalar(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable8();
+  for (size_t i=0; i<len; i++) {
+    const float* t1=&sincTable[(8191-pos[i])<<2];
+    const float* t2=&sincTable[pos[i]<<2];
+    out[i]=(
+      win[i]*t2[3]+
+      win[stride+i]*t2[2]+
+      win[stride*2+i]*t2[1]+
+      win[stride*3+i]*t2[0]+
+      win[stride*4+i]*t1[0]+
+      win[stride*5+i]*t1[1]+
+      win[stride*6+i]*t1[2]+
+      win[stride*7+i]*t1[3]
+    );
+  }
+}
+
+static void sinc16Scalar(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable();
+  for (size_t i=0; i<len; i++) {
+    const float* t1=&sincTable[(8191-pos[i])<<3];
+    const float* t2=&sincTable[pos[i]<<3];
+    float result=0;
+    for (int j=0; j<8; j++) {
+      result+=(float)win[stride*j+i]*t2[7-j];
+      result+=(float)win[stride*(8+j)+i]*t1[j];
+    }
+    out[i]=result;
+  }
+}
+
+#ifdef DIV_RESAMPLE_SSE2
+// 4 outputs at a time. SSE2 can't gather, so the table values are loaded
+// one by one; the gain comes from doing the arithmetic 4-wide.
+
+static inline __m128 loadWinSSE2(const short* w) {
+  __m128i x=_mm_loadl_epi64((const __m128i*)w);
+  return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x,x),16));
+}
+
+#define TABLE_SSE2(t,r,k) _mm_set_ps((t)[r[3]+(k)],(t)[r[2]+(k)],(t)[r[1]+(k)],(t)[r[0]+(k)])
+
+static void cubicSSE2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* cubicTable=DivFilterTables::getCubicTable();
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    unsigned int r[4];
+    for (int j=0; j<4; j++) r[j]=pos[i+j]<<2;
+    __m128 result=_mm_mul_ps(loadWinSSE2(win+i),TABLE_SSE2(cubicTable,r,0));
+    result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride+i),TABLE_SSE2(cubicTable,r,1)));
+    result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*2+i),TABLE_SSE2(cubicTable,r,2)));
+    result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*3+i),TABLE_SSE2(cubicTable,r,3)));
+    _mm_storeu_ps(out+i,result);
+  }
+  cubicScalar(win+i,stride,pos+i,out+i,len-i);
+}
+
+static void sinc8SSE2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable8();
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    unsigned int r1[4], r2[4];
+    for (int j=0; j<4; j++) {
+      r1[j]=(8191-pos[i+j])<<2;
+      r2[j]=pos[i+j]<<2;
+    }
+    __m128 result=_mm_mul_ps(loadWinSSE2(win+i),TABLE_SSE2(sincTable,r2,3));
+    for (int j=1; j<4; j++) {
+      result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*j+i),TABLE_SSE2(sincTable,r2,3-j)));
+    }
+    for (int j=0; j<4; j++) {
+      result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*(4+j)+i),TABLE_SSE2(sincTable,r1,j)));
+    }
+    _mm_storeu_ps(out+i,result);
+  }
+  sinc8Scalar(win+i,stride,pos+i,out+i,len-i);
+}
+
+static void sinc16SSE2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable();
+  size_t i=0;
+  for (; i+4<=len; i+=4) {
+    unsigned int r1[4], r2[4];
+    for (int j=0; j<4; j++) {
+      r1[j]=(8191-pos[i+j])<<3;
+      r2[j]=pos[i+j]<<3;
+    }
+    __m128 result=_mm_setzero_ps();
+    for (int j=0; j<8; j++) {
+      result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*j+i),TABLE_SSE2(sincTable,r2,7-j)));
+      result=_mm_add_ps(result,_mm_mul_ps(loadWinSSE2(win+stride*(8+j)+i),TABLE_SSE2(sincTable,r1,j)));
+    }
+    _mm_storeu_ps(out+i,result);
+  }
+  sinc16Scalar(win+i,stride,pos+i,out+i,len-i);
+}
+#endif
+
+#ifdef DIV_RESAMPLE_AVX2
+// 8 outputs at a time, with the table values gathered.
+// FMA is deliberately not enabled, as it would round differently.
+
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+AVX2_FUNC static inline __m256 loadWinAVX2(const short* w) {
+  return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)w)));
+}
+
+AVX2_FUNC static inline __m256i loadPosAVX2(const unsigned short* p) {
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p));
+}
+
+#define TABLE_AVX2(t,r,k) _mm256_i32gather_ps((t),_mm256_add_epi32((r),_mm256_set1_epi32(k)),4)
+
+AVX2_FUNC static void linearAVX2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256i s0=_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(win+i)));
+    __m256i s1=_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(win+stride+i)));
+    __m256i delta=_mm256_srai_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(s1,s0),loadPosAVX2(pos+i)),15);
+    _mm256_storeu_ps(out+i,_mm256_cvtepi32_ps(_mm256_add_epi32(s0,delta)));
+  }
+  linearScalar(win+i,stride,pos+i,out+i,len-i);
+}
+
+AVX2_FUNC static void cubicAVX2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* cubicTable=DivFilterTables::getCubicTable();
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256i r=_mm256_slli_epi32(loadPosAVX2(pos+i),2);
+    __m256 result=_mm256_mul_ps(loadWinAVX2(win+i),TABLE_AVX2(cubicTable,r,0));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride+i),TABLE_AVX2(cubicTable,r,1)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*2+i),TABLE_AVX2(cubicTable,r,2)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*3+i),TABLE_AVX2(cubicTable,r,3)));
+    _mm256_storeu_ps(out+i,result);
+  }
+  cubicScalar(win+i,stride,pos+i,out+i,len-i);
+}
+
+AVX2_FUNC static void sinc8AVX2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable8();
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256i p=loadPosAVX2(pos+i);
+    __m256i r1=_mm256_slli_epi32(_mm256_sub_epi32(_mm256_set1_epi32(8191),p),2);
+    __m256i r2=_mm256_slli_epi32(p,2);
+    __m256 result=_mm256_mul_ps(loadWinAVX2(win+i),TABLE_AVX2(sincTable,r2,3));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride+i),TABLE_AVX2(sincTable,r2,2)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*2+i),TABLE_AVX2(sincTable,r2,1)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*3+i),TABLE_AVX2(sincTable,r2,0)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*4+i),TABLE_AVX2(sincTable,r1,0)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*5+i),TABLE_AVX2(sincTable,r1,1)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*6+i),TABLE_AVX2(sincTable,r1,2)));
+    result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*7+i),TABLE_AVX2(sincTable,r1,3)));
+    _mm256_storeu_ps(out+i,result);
+  }
+  sinc8Scalar(win+i,stride,pos+i,out+i,len-i);
+}
+
+AVX2_FUNC static void sinc16AVX2(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len) {
+  const float* sincTable=DivFilterTables::getSincTable();
+  size_t i=0;
+  for (; i+8<=len; i+=8) {
+    __m256i p=loadPosAVX2(pos+i);
+    __m256i r1=_mm256_slli_epi32(_mm256_sub_epi32(_mm256_set1_epi32(8191),p),3);
+    __m256i r2=_mm256_slli_epi32(p,3);
+    __m256 result=_mm256_setzero_ps();
+    for (int j=0; j<8; j++) {
+      result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*j+i),TABLE_AVX2(sincTable,r2,7-j)));
+      result=_mm256_add_ps(result,_mm256_mul_ps(loadWinAVX2(win+stride*(8+j)+i),TABLE_AVX2(sincTable,r1,j)));
+    }
+    _mm256_storeu_ps(out+i,result);
+  }
+  sinc16Scalar(win+i,stride,pos+i,out+i,len-i);
+}
+#endif
+
+static const DivResampleKernels kernelsScalar={
+  linearScalar, cubicScalar, sinc8Scalar, sinc16Scalar, "scalar"
+};
+
+#ifdef DIV_RESAMPLE_SSE2
+static const DivResampleKernels kernelsSSE2={
+  linearScalar, cubicSSE2, sinc8SSE2, sinc16SSE2, "SSE2"
+};
+#endif
+
+#ifdef DIV_RESAMPLE_AVX2
+static const DivResampleKernels kernelsAVX2={
+  linearAVX2, cubicAVX2, sinc8AVX2, sinc16AVX2, "AVX2"
+};
+#endif
+
+static const DivResampleKernels* pickKernels() {
+  const DivResampleKernels* ret=&kernelsScalar;
+#ifdef DIV_RESAMPLE_SSE2
+  ret=&kernelsSSE2;
+#endif
+#ifdef DIV_RESAMPLE_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) ret=&kernelsAVX2;
+#endif
+  // make sure the tables exist before a kernel runs on the audio thread
+  DivFilterTables::getCubicTable();
+  DivFilterTables::getSincTable();
+  DivFilterTables::getSincTable8();
+  logD("using %s resampling kernels.",ret->name);
+  return ret;
+}
+
+const DivResampleKernels& DivResampleKernels::get() {
+  static const DivResampleKernels* kernels=pickKernels();
+  return *kernels;
+}
+
+const DivResampleKernels& DivResampleKernels::getScalar() {
+  return kernelsScalar;
+}
@@ -0,0 +1,86 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _RESAMPLEKERNELS_H
+#define _RESAMPLEKERNELS_H
+
+#include <stddef.h>
+
+// number of outputs a caller should gather before running a kernel
+#define DIV_RESAMPLE_BLOCK 256
+
+/**
+ * a resampling kernel.
+ * computes len outputs at once. the input window of output i is found at
+ * win[i], win[stride+i], win[stride*2+i] and so on (one row per tap), which
+ * lets the SIMD variants load several outputs per instruction.
+ * @param win the window rows.
+ * @param stride distance between window rows.
+ * @param pos per-output position. its meaning depends on the kernel.
+ * @param out where to write the (unclamped) results.
+ * @param len number of outputs.
+ */
+typedef void (*DivResampleKernel)(const short* win, size_t stride, const unsigned short* pos, float* out, size_t len);
+
+/**
+ * interpolation kernels shared by the PCM DAC and the sample resampler.
+ * every variant produces exactly the same results as the scalar one, as
+ * each output is still summed in the same order.
+ */
+struct DivResampleKernels {
+  /**
+   * linear interpolation between 2 taps.
+   * pos is a 15-bit fraction.
+   */
+  DivResampleKernel linear;
+  /**
+   * 4-tap cubic spline.
+   * pos is a row of DivFilterTables::getCubicTable().
+   */
+  DivResampleKernel cubic;
+  /**
+   * 8-tap windowed sinc, with the fractional position between taps 3 and 4.
+   * pos is a row of DivFilterTables::getSincTable8().
+   */
+  DivResampleKernel sinc8;
+  /**
+   * 16-tap windowed sinc, with the fractional position between taps 7 and 8.
+   * pos is a row of DivFilterTables::getSincTable().
+   */
+  DivResampleKernel sinc16;
+  /**
+   * name of the selected variant.
+   */
+  const char* name;
+
+  /**
+   * get the best kernels for this CPU.
+   * the choice is made on first call.
+   * @return the kernels.
+   */
+  static const DivResampleKernels& get();
+
+  /**
+   * get the portable scalar kernels.
+   * @return the kernels.
+   */
+  static const DivResampleKernels& getScalar();
+};
+
+#endif
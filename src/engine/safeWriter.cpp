@@ -29,6 +29,8 @@ unsigned char* SafeWriter::getFinalBuf() {
 void SafeWriter::checkSize(size_t amount) {
   while ((curSeek+amount)>=bufLen) {
     size_t newSize=WRITER_BUF_SIZE*(1+((curSeek+amount)/WRITER_BUF_SIZE));
+    // grow geometrically so that building a large file doesn't copy it over and over
+    if (newSize<(bufLen<<1)) newSize=bufLen<<1;
     if (newSize<(bufLen+WRITER_BUF_SIZE)) {
       logE("REPORT NOW: newSize is too small! case 1... %d<%d",(int)newSize,(int)(bufLen+WRITER_BUF_SIZE));
     }
@@ -36,7 +38,7 @@ void SafeWriter::checkSize(size_t amount) {
       logE("REPORT NOW: newSize is too small! case 2... %d<%d",(int)newSize,(int)(curSeek+amount));
     }
     unsigned char* newBuf=new unsigned char[newSize];
-    memcpy(newBuf,buf,bufLen);
+    memcpy(newBuf,buf,len);
     delete[] buf;
     buf=newBuf;
     bufLen=newSize;
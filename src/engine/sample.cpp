@@ -26,6 +26,7 @@
 #include "sfWrapper.h"
 #endif
 #include "filter.h"
+#include "resampleKernels.h"
 #include "bsr.h"
 
 extern "C" {
@@ -881,6 +882,82 @@ void DivSample::convert(DivSampleDepth newDepth, unsigned int formatMask) {
     delete[] oldData8; \
   }
 
+// the cubic and sinc resamplers gather a block of windows (one row per tap)
+// and run the shared kernels over it. data may be 8-bit or 16-bit.
+template<typename T> static void resampleCubicData(const T* oldData, T* data, unsigned int samples, int loopStart, int finalCount, double factor, float minVal, float maxVal) {
+  const DivResampleKernels& kernels=DivResampleKernels::get();
+  short win[4*DIV_RESAMPLE_BLOCK];
+  unsigned short pos[DIV_RESAMPLE_BLOCK];
+  float out[DIV_RESAMPLE_BLOCK];
+  const short loopValue=(loopStart>=0 && loopStart<(int)samples)?oldData[loopStart]:0;
+  double posFrac=0;
+  unsigned int posInt=0;
+
+  for (int base=0; base<finalCount; base+=DIV_RESAMPLE_BLOCK) {
+    int blockLen=MIN(finalCount-base,DIV_RESAMPLE_BLOCK);
+    for (int i=0; i<blockLen; i++) {
+      pos[i]=((unsigned int)(posFrac*1024.0))&1023;
+      win[i]=(posInt<1)?0:oldData[posInt-1];
+      win[DIV_RESAMPLE_BLOCK+i]=(posInt>=samples)?0:oldData[posInt];
+      win[DIV_RESAMPLE_BLOCK*2+i]=(posInt+1>=samples)?loopValue:oldData[posInt+1];
+      win[DIV_RESAMPLE_BLOCK*3+i]=(posInt+2>=samples)?loopValue:oldData[posInt+2];
+
+      posFrac+=factor;
+      while (posFrac>=1.0) {
+        posFrac-=1.0;
+        posInt++;
+      }
+    }
+    kernels.cubic(win,DIV_RESAMPLE_BLOCK,pos,out,blockLen);
+    for (int i=0; i<blockLen; i++) {
+      float result=out[i];
+      if (result<minVal) result=minVal;
+      if (result>maxVal) result=maxVal;
+      data[base+i]=result;
+    }
+  }
+}
+
+template<typename T> static void resampleSincData(const T* oldData, T* data, unsigned int samples, int finalCount, double factor, float minVal, float maxVal) {
+  const DivResampleKernels& kernels=DivResampleKernels::get();
+  short win[16*DIV_RESAMPLE_BLOCK];
+  unsigned short pos[DIV_RESAMPLE_BLOCK];
+  float out[DIV_RESAMPLE_BLOCK];
+  short s[16];
+  double posFrac=0;
+  unsigned int posInt=0;
+
+  memset(s,0,16*sizeof(short));
+
+  // the output is delayed by 8 samples
+  for (int base=0; base<finalCount+8; base+=DIV_RESAMPLE_BLOCK) {
+    int blockLen=MIN(finalCount+8-base,DIV_RESAMPLE_BLOCK);
+    for (int i=0; i<blockLen; i++) {
+      pos[i]=((unsigned int)(posFrac*8192.0))&8191;
+      for (int j=0; j<16; j++) {
+        win[j*DIV_RESAMPLE_BLOCK+i]=s[j];
+      }
+
+      posFrac+=factor;
+      while (posFrac>=1.0) {
+        posFrac-=1.0;
+        posInt++;
+
+        for (int j=0; j<15; j++) s[j]=s[j+1];
+        s[15]=(posInt>=samples)?0:oldData[posInt];
+      }
+    }
+    kernels.sinc16(win,DIV_RESAMPLE_BLOCK,pos,out,blockLen);
+    for (int i=0; i<blockLen; i++) {
+      if (base+i<8) continue;
+      float result=out[i];
+      if (result<minVal) result=minVal;
+      if (result>maxVal) result=maxVal;
+      data[base+i-8]=result;
+    }
+  }
+}
+
 bool DivSample::resampleNone(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
@@ -950,51 +1027,12 @@ bool DivSample::resampleLinear(double sRate, double tRate) {
 bool DivSample::resampleCubic(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
-  double posFrac=0;
-  unsigned int posInt=0;
   double factor=sRate/tRate;
-  float* cubicTable=DivFilterTables::getCubicTable();
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount; i++) {
-      unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
-      float* t=&cubicTable[n<<2];
-      float s0=(posInt<1)?0:oldData16[posInt-1];
-      float s1=(posInt>=samples)?0:oldData16[posInt];
-      float s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+1];
-      float s3=(posInt+2>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData16[loopStart]:0):oldData16[posInt+2];
-
-      float result=s0*t[0]+s1*t[1]+s2*t[2]+s3*t[3];
-      if (result<-32768) result=-32768;
-      if (result>32767) result=32767;
-      data16[i]=result;
-
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-      }
-    }
+    resampleCubicData(oldData16,data16,samples,loopStart,finalCount,factor,-32768,32767);
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount; i++) {
-      unsigned int n=((unsigned int)(posFrac*1024.0))&1023;
-      float* t=&cubicTable[n<<2];
-      float s0=(posInt<1)?0:oldData8[posInt-1];
-      float s1=(posInt>=samples)?0:oldData8[posInt];
-      float s2=(posInt+1>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+1];
-      float s3=(posInt+2>=samples)?((loopStart>=0 && loopStart<(int)samples)?oldData8[loopStart]:0):oldData8[posInt+2];
-
-      float result=s0*t[0]+s1*t[1]+s2*t[2]+s3*t[3];
-      if (result<-128) result=-128;
-      if (result>127) result=127;
-      data8[i]=result;
-
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-      }
-    }
+    resampleCubicData(oldData8,data8,samples,loopStart,finalCount,factor,-128,127);
   }
 
   RESAMPLE_END;
@@ -1088,64 +1126,12 @@ bool DivSample::resampleBlep(double sRate, double tRate) {
 bool DivSample::resampleSinc(double sRate, double tRate) {
   RESAMPLE_BEGIN;
 
-  double posFrac=0;
-  unsigned int posInt=0;
   double factor=sRate/tRate;
-  float* sincTable=DivFilterTables::getSincTable();
-  float s[16];
-
-  memset(s,0,16*sizeof(float));
 
   if (depth==DIV_SAMPLE_DEPTH_16BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
-      if (result<-32768) result=-32768;
-      if (result>32767) result=32767;
-      if (i>=8) {
-        data16[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData16[posInt];
-      }
-    }
+    resampleSincData(oldData16,data16,samples,finalCount,factor,-32768,32767);
   } else if (depth==DIV_SAMPLE_DEPTH_8BIT) {
-    for (int i=0; i<finalCount+8; i++) {
-      unsigned int n=((unsigned int)(posFrac*8192.0))&8191;
-      float result=0;
-      float* t1=&sincTable[(8191-n)<<3];
-      float* t2=&sincTable[n<<3];
-      for (int j=0; j<8; j++) {
-        result+=s[j]*t2[7-j];
-        result+=s[8+j]*t1[j];
-      }
-      if (result<-128) result=-128;
-      if (result>127) result=127;
-      if (i>=8) {
-        data8[i-8]=result;
-      }
-      
-      posFrac+=factor;
-      while (posFrac>=1.0) {
-        posFrac-=1.0;
-        posInt++;
-
-        for (int j=0; j<15; j++) s[j]=s[j+1];
-        s[15]=(posInt>=samples)?0:oldData8[posInt];
-      }
-    }
+    resampleSincData(oldData8,data8,samples,finalCount,factor,-128,127);
   }
 
   RESAMPLE_END;
@@ -1556,6 +1542,80 @@ unsigned int DivSample::getCurBufLen() {
   return 0;
 }
 
+DivSample* DivSample::makeEditCopy() {
+  DivSample* copy=new DivSample;
+  copy->depth=depth;
+  if (getCurBuf()!=NULL) {
+    if (!copy->initInternal(depth,samples)) {
+      delete copy;
+      return NULL;
+    }
+    memcpy(copy->getCurBuf(),getCurBuf(),MIN(getCurBufLen(),copy->getCurBufLen()));
+  }
+  copy->samples=samples;
+  copy->rate=rate;
+  copy->centerRate=centerRate;
+  copy->loopStart=loopStart;
+  copy->loopEnd=loopEnd;
+  copy->loop=loop;
+  copy->brrEmphasis=brrEmphasis;
+  copy->brrNoFilter=brrNoFilter;
+  copy->dither=dither;
+  copy->loopMode=loopMode;
+  memcpy(copy->renderOn,renderOn,sizeof(renderOn));
+  return copy;
+}
+
+void DivSample::swapData(DivSample* other) {
+#define SWAP_FIELD(x) { \
+  auto temp=x; \
+  x=other->x; \
+  other->x=temp; \
+}
+  SWAP_FIELD(rate);
+  SWAP_FIELD(centerRate);
+  SWAP_FIELD(loopStart);
+  SWAP_FIELD(loopEnd);
+  SWAP_FIELD(depth);
+  SWAP_FIELD(loop);
+  SWAP_FIELD(brrEmphasis);
+  SWAP_FIELD(brrNoFilter);
+  SWAP_FIELD(dither);
+  SWAP_FIELD(loopMode);
+  SWAP_FIELD(samples);
+
+  SWAP_FIELD(data8);
+  SWAP_FIELD(data16);
+  SWAP_FIELD(data1);
+  SWAP_FIELD(dataDPCM);
+  SWAP_FIELD(dataZ);
+  SWAP_FIELD(dataQSoundA);
+  SWAP_FIELD(dataA);
+  SWAP_FIELD(dataB);
+  SWAP_FIELD(dataK);
+  SWAP_FIELD(dataBRR);
+  SWAP_FIELD(dataVOX);
+  SWAP_FIELD(dataMuLaw);
+  SWAP_FIELD(dataC219);
+  SWAP_FIELD(dataIMA);
+
+  SWAP_FIELD(length8);
+  SWAP_FIELD(length16);
+  SWAP_FIELD(length1);
+  SWAP_FIELD(lengthDPCM);
+  SWAP_FIELD(lengthZ);
+  SWAP_FIELD(lengthQSoundA);
+  SWAP_FIELD(lengthA);
+  SWAP_FIELD(lengthB);
+  SWAP_FIELD(lengthK);
+  SWAP_FIELD(lengthBRR);
+  SWAP_FIELD(lengthVOX);
+  SWAP_FIELD(lengthMuLaw);
+  SWAP_FIELD(lengthC219);
+  SWAP_FIELD(lengthIMA);
+#undef SWAP_FIELD
+}
+
 DivSampleHistory* DivSample::prepareUndo(bool data, bool doNotPush) {
   DivSampleHistory* h;
   if (data) {
@@ -309,6 +309,21 @@ struct DivSample {
    */
   unsigned int getCurBufLen();
 
+  /**
+   * create a copy of this sample's parameters and data (in the current depth only) for editing.
+   * the copy has no name or undo history.
+   * @return the copy, or NULL on failure.
+   */
+  DivSample* makeEditCopy();
+
+  /**
+   * swap sample data and parameters (not name, render flags or undo history) with another sample.
+   * this doesn't allocate or copy memory.
+   * @warning do not attempt to do this outside of a synchronized block!
+   * @param other the other sample.
+   */
+  void swapData(DivSample* other);
+
   /**
    * prepare an undo step for this sample.
    * @param data whether to include sample data.
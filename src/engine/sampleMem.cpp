@@ -0,0 +1,190 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sampleMem.h"
+#include "../ta-log.h"
+#include <zlib.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+struct DivSampleMemImage {
+  unsigned char* data;
+  size_t cap, len;
+  unsigned int crc;
+  int refs;
+};
+
+static std::mutex imageLock;
+static std::vector<DivSampleMemImage*> images;
+
+// reserve address space. pages are committed on first write.
+static unsigned char* memReserve(size_t cap) {
+#ifdef _WIN32
+  void* ret=VirtualAlloc(NULL,cap,MEM_RESERVE|MEM_COMMIT,PAGE_READWRITE);
+  if (ret==NULL) throw std::bad_alloc();
+#else
+  void* ret=mmap(NULL,cap,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+  if (ret==MAP_FAILED) throw std::bad_alloc();
+#endif
+  return (unsigned char*)ret;
+}
+
+static void memRelease(unsigned char* buf, size_t cap) {
+#ifdef _WIN32
+  VirtualFree(buf,0,MEM_RELEASE);
+#else
+  munmap(buf,cap);
+#endif
+}
+
+// zero the memory and give its pages back to the OS.
+static void memDiscard(unsigned char* buf, size_t cap) {
+#ifdef _WIN32
+  VirtualFree(buf,cap,MEM_DECOMMIT);
+  if (VirtualAlloc(buf,cap,MEM_COMMIT,PAGE_READWRITE)==NULL) {
+    throw std::bad_alloc();
+  }
+#else
+  if (mmap(buf,cap,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED,-1,0)==MAP_FAILED) {
+    logE("could not discard sample memory! clearing it instead.");
+    memset(buf,0,cap);
+  }
+#endif
+}
+
+static void memProtect(unsigned char* buf, size_t cap, bool readOnly) {
+#ifdef _WIN32
+  DWORD prev;
+  VirtualProtect(buf,cap,readOnly?PAGE_READONLY:PAGE_READWRITE,&prev);
+#else
+  mprotect(buf,cap,readOnly?PROT_READ:(PROT_READ|PROT_WRITE));
+#endif
+}
+
+// must be called with imageLock held.
+static void releaseImage(DivSampleMemImage* img) {
+  if (--img->refs>0) return;
+  for (size_t i=0; i<images.size(); i++) {
+    if (images[i]==img) {
+      images.erase(images.begin()+i);
+      break;
+    }
+  }
+  memRelease(img->data,img->cap);
+  delete img;
+}
+
+unsigned char* DivSampleMemory::get() {
+  if (image!=NULL) return image->data;
+  return buf;
+}
+
+size_t DivSampleMemory::getCapacity() {
+  return cap;
+}
+
+void DivSampleMemory::unshare(bool keepContents) {
+  if (image==NULL) return;
+  std::lock_guard<std::mutex> lock(imageLock);
+  if (image->refs==1) {
+    // nobody else is using it. take it back
+    for (size_t i=0; i<images.size(); i++) {
+      if (images[i]==image) {
+        images.erase(images.begin()+i);
+        break;
+      }
+    }
+    memProtect(image->data,cap,false);
+    if (keepContents) {
+      memRelease(buf,cap);
+      buf=image->data;
+    } else {
+      memRelease(image->data,cap);
+    }
+    delete image;
+  } else {
+    if (keepContents) memcpy(buf,image->data,image->len);
+    releaseImage(image);
+  }
+  image=NULL;
+}
+
+unsigned char* DivSampleMemory::beginWrite(bool clear) {
+  unshare(!clear);
+  if (clear) memDiscard(buf,cap);
+  return buf;
+}
+
+unsigned char* DivSampleMemory::endWrite(size_t used) {
+  if (!shareable) return buf;
+  if (used>cap) used=cap;
+
+  unsigned int crc=crc32(0,buf,used);
+  std::lock_guard<std::mutex> lock(imageLock);
+  for (DivSampleMemImage* i: images) {
+    if (i->cap==cap && i->len==used && i->crc==crc) {
+      if (memcmp(i->data,buf,used)==0) {
+        i->refs++;
+        image=i;
+        memDiscard(buf,cap);
+        logV("sharing sample memory image (%d users)",i->refs);
+        return image->data;
+      }
+    }
+  }
+
+  // publish ours and get a fresh buffer for the next write
+  image=new DivSampleMemImage;
+  image->data=buf;
+  image->cap=cap;
+  image->len=used;
+  image->crc=crc;
+  image->refs=1;
+  memProtect(image->data,cap,true);
+  images.push_back(image);
+  buf=memReserve(cap);
+  return image->data;
+}
+
+DivSampleMemory::DivSampleMemory(size_t capacity, bool canShare):
+  buf(NULL),
+  cap(capacity),
+  shareable(canShare),
+  image(NULL) {
+  buf=memReserve(cap);
+}
+
+DivSampleMemory::~DivSampleMemory() {
+  if (image!=NULL) {
+    std::lock_guard<std::mutex> lock(imageLock);
+    releaseImage(image);
+    image=NULL;
+  }
+  memRelease(buf,cap);
+}
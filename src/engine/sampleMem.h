@@ -0,0 +1,75 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _SAMPLEMEM_H
+#define _SAMPLEMEM_H
+
+#include <stddef.h>
+
+struct DivSampleMemImage;
+
+/**
+ * sample memory for a chip.
+ *
+ * the address space is reserved up front but pages are only committed by the OS
+ * once they are written to, so a 16MB chip with a few samples only costs what it uses.
+ *
+ * if created as shareable, chips (in any engine of the process) whose rendered memory
+ * is byte-identical end up reading from one read-only image.
+ * chips which write to sample memory while playing must not be shareable.
+ */
+class DivSampleMemory {
+  unsigned char* buf;
+  size_t cap;
+  bool shareable;
+  DivSampleMemImage* image;
+
+  void unshare(bool keepContents);
+
+  public:
+    /**
+     * get the memory to read from.
+     * this pointer changes after endWrite().
+     */
+    unsigned char* get();
+
+    /**
+     * get the capacity.
+     */
+    size_t getCapacity();
+
+    /**
+     * prepare for writing.
+     * @param clear whether to clear the memory (full render) or keep its contents (in-place update).
+     * @return a writable pointer, valid until endWrite().
+     */
+    unsigned char* beginWrite(bool clear=true);
+
+    /**
+     * finish writing, and share the memory with an identical chip if possible.
+     * @param used the end of the used area. everything after it must be zero.
+     * @return the memory to read from (same as get()).
+     */
+    unsigned char* endWrite(size_t used);
+
+    DivSampleMemory(size_t capacity, bool canShare=false);
+    ~DivSampleMemory();
+};
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "sampleMemPlanner.h"
+#include "../ta-utils.h"
+#include <algorithm>
+
+size_t DivSampleMemPlanner::alignPos(size_t pos) {
+  return ((pos+align-1)/align)*align;
+}
+
+size_t DivSampleMemPlanner::getEnd() {
+  return end;
+}
+
+bool DivSampleMemPlanner::planSequential(std::vector<DivSampleMemItem>& items, bool partial) {
+  size_t memPos=alignPos(start);
+  int inBank=0;
+  bool ret=true;
+  end=start;
+  for (DivSampleMemItem& i: items) {
+    i.placed=false;
+    i.pos=0;
+    i.bank=-1;
+    i.slot=-1;
+  }
+  for (DivSampleMemItem& i: items) {
+    if (bankSize>0) {
+      size_t bankBegin=(memPos/bankSize)*bankSize;
+      if (memPos<bankBegin+bankReserveStart) {
+        memPos=alignPos(bankBegin+bankReserveStart);
+      }
+      size_t bankEnd=bankBegin+bankSize;
+      if ((maxPerBank>0 && inBank>=maxPerBank) || memPos+i.len>bankEnd-bankReserveEnd) {
+        memPos=alignPos(bankEnd+bankReserveStart);
+        inBank=0;
+        // too large for any bank
+        if (memPos+i.len>bankEnd+bankSize-bankReserveEnd) {
+          ret=false;
+          if (!partial) return false;
+          continue;
+        }
+      }
+    }
+    if (memPos+i.len>capacity) {
+      ret=false;
+      if (!partial) return false;
+      break;
+    }
+    i.placed=true;
+    i.pos=memPos;
+    i.bank=(bankSize>0)?(int)(memPos/bankSize):0;
+    i.slot=inBank++;
+    memPos=alignPos(memPos+i.len);
+    end=i.pos+i.len;
+  }
+  return ret;
+}
+
+struct DivSampleMemBin {
+  size_t begin, end;
+  // kept in sample order, which is the order of the final layout
+  std::vector<DivSampleMemItem*> items;
+};
+
+size_t DivSampleMemPlanner::layoutEnd(const DivSampleMemBin& bin, const DivSampleMemItem* extra) {
+  size_t memPos=bin.begin;
+  size_t ret=bin.begin;
+  bool extraDone=(extra==NULL);
+  for (size_t i=0; i<=bin.items.size(); i++) {
+    const DivSampleMemItem* next=(i<bin.items.size())?bin.items[i]:NULL;
+    if (!extraDone && (next==NULL || extra->index<next->index)) {
+      ret=memPos+extra->len;
+      memPos=alignPos(ret);
+      extraDone=true;
+    }
+    if (next==NULL) break;
+    ret=memPos+next->len;
+    memPos=alignPos(ret);
+  }
+  return ret;
+}
+
+void DivSampleMemPlanner::planPacked(std::vector<DivSampleMemItem>& items) {
+  std::vector<DivSampleMemBin> bins;
+  size_t firstPos=alignPos(start);
+  if (bankSize>0) {
+    for (size_t b=0; b*bankSize<capacity; b++) {
+      DivSampleMemBin bin;
+      bin.begin=alignPos(MAX(b*bankSize+bankReserveStart,firstPos));
+      bin.end=MIN((b+1)*bankSize-bankReserveEnd,capacity);
+      if (bin.begin>=bin.end) continue;
+      bins.push_back(bin);
+    }
+  } else {
+    DivSampleMemBin bin;
+    bin.begin=firstPos;
+    bin.end=capacity;
+    if (bin.begin<bin.end) bins.push_back(bin);
+  }
+
+  std::vector<DivSampleMemItem*> order;
+  order.reserve(items.size());
+  for (DivSampleMemItem& i: items) {
+    i.placed=false;
+    i.pos=0;
+    i.bank=-1;
+    i.slot=-1;
+    order.push_back(&i);
+  }
+  std::stable_sort(order.begin(),order.end(),[](const DivSampleMemItem* a, const DivSampleMemItem* b) -> bool {
+    return a->len>b->len;
+  });
+
+  // best fit decreasing.
+  // the fit is tested against the final layout of the bin, since the padding of a sample depends on what follows it
+  for (DivSampleMemItem* i: order) {
+    DivSampleMemBin* best=NULL;
+    size_t bestFree=0;
+    for (DivSampleMemBin& b: bins) {
+      if (maxPerBank>0 && (int)b.items.size()>=maxPerBank) continue;
+      size_t binEnd=layoutEnd(b,i);
+      if (binEnd>b.end) continue;
+      if (best==NULL || b.end-binEnd<bestFree) {
+        best=&b;
+        bestFree=b.end-binEnd;
+      }
+    }
+    if (best==NULL) continue;
+    best->items.insert(std::upper_bound(best->items.begin(),best->items.end(),i,[](const DivSampleMemItem* x, const DivSampleMemItem* y) -> bool {
+      return x->index<y->index;
+    }),i);
+    i->placed=true;
+  }
+
+  // lay out every bin in sample order
+  end=start;
+  for (DivSampleMemBin& b: bins) {
+    size_t memPos=b.begin;
+    int slot=0;
+    for (DivSampleMemItem* i: b.items) {
+      i->pos=memPos;
+      i->bank=(bankSize>0)?(int)(memPos/bankSize):0;
+      i->slot=slot++;
+      memPos=alignPos(memPos+i->len);
+      if (i->pos+i->len>end) end=i->pos+i->len;
+    }
+  }
+}
+
+bool DivSampleMemPlanner::plan(std::vector<DivSampleMemItem>& items) {
+  if (planSequential(items,false)) return true;
+
+  planPacked(items);
+  size_t packedBytes=0;
+  size_t packedEnd=end;
+  bool allPlaced=true;
+  for (DivSampleMemItem& i: items) {
+    if (i.placed) {
+      packedBytes+=i.len;
+    } else {
+      allPlaced=false;
+    }
+  }
+  if (allPlaced) return true;
+
+  // neither layout fits everything. keep whichever stores more
+  std::vector<DivSampleMemItem> packed=items;
+  planSequential(items,true);
+  size_t sequentialBytes=0;
+  for (DivSampleMemItem& i: items) {
+    if (i.placed) sequentialBytes+=i.len;
+  }
+  if (packedBytes>sequentialBytes) {
+    items=packed;
+    end=packedEnd;
+  }
+  return false;
+}
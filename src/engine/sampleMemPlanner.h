@@ -0,0 +1,101 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _SAMPLEMEMPLANNER_H
+#define _SAMPLEMEMPLANNER_H
+
+#include <stddef.h>
+#include <vector>
+
+struct DivSampleMemItem {
+  // sample index
+  int index;
+  // space taken in memory, including any padding or guard bytes after the sample
+  size_t len;
+
+  // set by DivSampleMemPlanner::plan()
+  bool placed;
+  size_t pos;
+  int bank;
+  // position of the sample within its bank (in address order)
+  int slot;
+
+  DivSampleMemItem(int i, size_t l):
+    index(i),
+    len(l),
+    placed(false),
+    pos(0),
+    bank(-1),
+    slot(-1) {}
+};
+
+struct DivSampleMemBin;
+
+/**
+ * places samples in chip memory, honoring bank boundaries.
+ *
+ * if every sample fits when laid out in song order (the way Furnace always did it),
+ * that layout is kept. otherwise samples are packed into banks (best fit, largest first),
+ * which avoids wasting the end of a bank whenever a sample doesn't fit in it.
+ */
+class DivSampleMemPlanner {
+  size_t start, capacity, bankSize, bankReserveStart, bankReserveEnd, align;
+  int maxPerBank;
+  size_t end;
+
+  size_t alignPos(size_t pos);
+  // end of a bin once laid out, optionally with another item added
+  size_t layoutEnd(const DivSampleMemBin& bin, const DivSampleMemItem* extra);
+  bool planSequential(std::vector<DivSampleMemItem>& items, bool partial);
+  void planPacked(std::vector<DivSampleMemItem>& items);
+
+  public:
+    /**
+     * plan a layout.
+     * @param items the samples to place. results are written back.
+     * @return whether all of them could be placed.
+     */
+    bool plan(std::vector<DivSampleMemItem>& items);
+
+    /**
+     * get the end of the last placed sample.
+     */
+    size_t getEnd();
+
+    /**
+     * @param s first usable address.
+     * @param cap memory capacity.
+     * @param bank bank size. samples may not cross a bank boundary. 0 means no banks.
+     * @param al alignment of sample start addresses.
+     * @param resStart reserved bytes at the beginning of every bank.
+     * @param resEnd reserved bytes at the end of every bank.
+     * @param perBank maximum number of samples in a bank (0 for no limit).
+     */
+    DivSampleMemPlanner(size_t s, size_t cap, size_t bank=0, size_t al=1, size_t resStart=0, size_t resEnd=0, int perBank=0):
+      start(s),
+      capacity(cap),
+      bankSize(bank),
+      bankReserveStart(resStart),
+      bankReserveEnd(resEnd),
+      align(al<1?1:al),
+      maxPerBank(perBank),
+      end(s) {}
+};
+
+#endif
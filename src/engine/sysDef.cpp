@@ -26,6 +26,7 @@
 DivSysDef* DivEngine::sysDefs[DIV_MAX_CHIP_DEFS];
 DivSystem DivEngine::sysFileMapFur[DIV_MAX_CHIP_DEFS];
 DivSystem DivEngine::sysFileMapDMF[DIV_MAX_CHIP_DEFS];
+bool DivEngine::systemsRegistered=false;
 
 DivSystem DivEngine::systemFromFileFur(unsigned char val) {
   return sysFileMapFur[val];
@@ -0,0 +1,373 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "timeline.h"
+#include "../ta-log.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#define SIG_ADD(x) \
+  sig^=(unsigned int)(x); \
+  sig*=16777619U;
+
+unsigned int DivSongTimeline::getOrderSig(int order) {
+  unsigned int sig=2166136261U;
+  for (int i=0; i<chans; i++) {
+    SIG_ADD(sub->orders.ord[i][order]);
+    DivPattern* p=sub->pat[i].getPattern(sub->orders.ord[i][order],false);
+    int cols=sub->pat[i].effectCols;
+    for (int j=0; j<sub->patLen; j++) {
+      for (int k=0; k<cols; k++) {
+        SIG_ADD((unsigned short)p->data[j][4+(k<<1)]);
+        SIG_ADD((unsigned short)p->data[j][5+(k<<1)]);
+      }
+    }
+  }
+  return sig;
+}
+
+unsigned int DivSongTimeline::getGlobalSig() {
+  unsigned int sig=2166136261U;
+  SIG_ADD((size_t)song);
+  SIG_ADD((size_t)sub);
+  SIG_ADD(chans);
+  SIG_ADD(sub->patLen);
+  SIG_ADD(sub->ordersLen);
+  SIG_ADD(sub->timeBase);
+  SIG_ADD(sub->virtualTempoN);
+  SIG_ADD(sub->virtualTempoD);
+  SIG_ADD((int)(sub->hz*1000.0));
+  SIG_ADD(sub->speeds.len);
+  for (int i=0; i<16; i++) {
+    SIG_ADD(sub->speeds.val[i]);
+  }
+  SIG_ADD(song->grooves.size());
+  for (const DivGroovePattern& i: song->grooves) {
+    SIG_ADD(i.len);
+    for (int j=0; j<16; j++) {
+      SIG_ADD(i.val[j]);
+    }
+  }
+  SIG_ADD(song->jumpTreatment);
+  SIG_ADD(song->ignoreJumpAtEnd);
+  SIG_ADD(song->brokenSpeedSel);
+  for (int i=0; i<chans; i++) {
+    SIG_ADD(sub->pat[i].effectCols);
+  }
+  return sig;
+}
+
+void DivSongTimeline::walk(State s) {
+  DivPattern* subPat[DIV_MAX_CHANS];
+  bool newOrder=true;
+  int timeBase=sub->timeBase+1;
+
+  loops=false;
+  loopEntry=-1;
+
+  while (true) {
+    if (s.order>=sub->ordersLen) {
+      // the song goes back to the beginning
+      s.order=0;
+      s.row=0;
+    }
+    if (s.row>=sub->patLen) s.row=0;
+
+    int pos=s.order*sub->patLen+s.row;
+    if (firstVisit[pos]>=0) {
+      loops=true;
+      loopEntry=firstVisit[pos];
+      break;
+    }
+
+    if (newOrder) {
+      s.entry=entries.size();
+      s.sig=getOrderSig(s.order);
+      states.push_back(s);
+      newOrder=false;
+    }
+    firstVisit[pos]=entries.size();
+    entries.push_back(DivTimelineEntry(s.order,s.row,s.tick,s.time));
+
+    for (int i=0; i<chans; i++) {
+      subPat[i]=sub->pat[i].getPattern(sub->orders.ord[i][s.order],false);
+    }
+
+    int nextOrder=-1;
+    int nextRow=0;
+    bool changingOrder=false;
+    bool jumpingOrder=false;
+    bool stop=false;
+    for (int i=0; i<chans; i++) {
+      for (int j=0; j<sub->pat[i].effectCols; j++) {
+        short effect=subPat[i]->data[s.row][4+(j<<1)];
+        short effectVal=subPat[i]->data[s.row][5+(j<<1)];
+        if (effectVal<0) effectVal=0;
+        effectVal&=255;
+        switch (effect) {
+          case 0x09:
+            if (song->grooves.empty()) {
+              if (effectVal>0) s.speeds.val[0]=effectVal;
+            } else if (effectVal<(short)song->grooves.size()) {
+              s.speeds=song->grooves[effectVal];
+              s.curSpeed=0;
+            }
+            break;
+          case 0x0f:
+            if (s.speeds.len==2 && song->grooves.empty()) {
+              if (effectVal>0) s.speeds.val[1]=effectVal;
+            } else {
+              if (effectVal>0) s.speeds.val[0]=effectVal;
+            }
+            break;
+          case 0xfd:
+            if (effectVal>0) s.virtualTempoN=effectVal;
+            break;
+          case 0xfe:
+            if (effectVal>0) s.virtualTempoD=effectVal;
+            break;
+          case 0xc0: case 0xc1: case 0xc2: case 0xc3:
+            s.hz=(double)(((effect&0x3)<<8)|effectVal);
+            if (s.hz<1.0) s.hz=1.0;
+            break;
+          case 0xf0:
+            s.hz=(double)effectVal*2.0/5.0;
+            if (s.hz<1.0) s.hz=1.0;
+            break;
+          case 0xff:
+            stop=true;
+            break;
+          case 0x0d:
+            if (song->jumpTreatment==2) {
+              if ((s.order<sub->ordersLen-1 || !song->ignoreJumpAtEnd)) {
+                nextOrder=s.order+1;
+                nextRow=effectVal;
+                jumpingOrder=true;
+              }
+            } else if (song->jumpTreatment==1) {
+              if (nextOrder==-1 && (s.order<sub->ordersLen-1 || !song->ignoreJumpAtEnd)) {
+                nextOrder=s.order+1;
+                nextRow=effectVal;
+                jumpingOrder=true;
+              }
+            } else {
+              if ((s.order<sub->ordersLen-1 || !song->ignoreJumpAtEnd)) {
+                if (!changingOrder) {
+                  nextOrder=s.order+1;
+                }
+                jumpingOrder=true;
+                nextRow=effectVal;
+              }
+            }
+            break;
+          case 0x0b:
+            if (nextOrder==-1 || song->jumpTreatment==0) {
+              nextOrder=effectVal;
+              if (song->jumpTreatment==1 || song->jumpTreatment==2 || !jumpingOrder) {
+                nextRow=0;
+              }
+              changingOrder=true;
+            }
+            break;
+        }
+      }
+    }
+
+    // row length in ticks (see DivEngine::nextRow())
+    int rowTicks;
+    if (s.speeds.len<1) s.speeds.len=1;
+    if (s.curSpeed>=s.speeds.len) s.curSpeed=0;
+    if (song->brokenSpeedSel) {
+      unsigned char speed2=(s.speeds.len>=2)?s.speeds.val[1]:s.speeds.val[0];
+      unsigned char speed1=s.speeds.val[0];
+      if ((sub->patLen&1) && s.order&1) {
+        rowTicks=((s.row&1)?speed2:speed1)*timeBase;
+      } else {
+        rowTicks=((s.row&1)?speed1:speed2)*timeBase;
+      }
+    } else {
+      rowTicks=s.speeds.val[s.curSpeed]*timeBase;
+      if (++s.curSpeed>=s.speeds.len) s.curSpeed=0;
+    }
+
+    // run the tempo accumulator (see DivEngine::nextTick())
+    unsigned int engineTicks=0;
+    while (rowTicks>0) {
+      engineTicks++;
+      s.tempoAccum+=s.virtualTempoN;
+      while (s.tempoAccum>=s.virtualTempoD) {
+        s.tempoAccum-=s.virtualTempoD;
+        if (--rowTicks<=0) break;
+      }
+      if (s.tempoAccum>1023) s.tempoAccum=1023;
+    }
+    s.tick+=engineTicks;
+    s.time+=(double)engineTicks/s.hz;
+
+    if (stop) break;
+    if (nextOrder!=-1) {
+      s.order=nextOrder;
+      s.row=nextRow;
+      newOrder=true;
+    } else if (++s.row>=sub->patLen) {
+      s.row=0;
+      s.order++;
+      newOrder=true;
+    }
+  }
+
+  endTick=s.tick;
+  endTime=s.time;
+}
+
+bool DivSongTimeline::update(DivSong* s, int subSong, int channels) {
+  if (s==NULL || subSong<0 || subSong>=(int)s->subsong.size()) {
+    clear();
+    return false;
+  }
+  song=s;
+  sub=s->subsong[subSong];
+  chans=MIN(MAX(channels,0),DIV_MAX_CHANS);
+
+  if (sub->ordersLen<1 || sub->patLen<1) {
+    clear();
+    return false;
+  }
+
+  unsigned int newGlobalSig=getGlobalSig();
+  if (newGlobalSig!=globalSig || states.empty()) {
+    entries.clear();
+    states.clear();
+    firstVisit.assign(sub->ordersLen*sub->patLen,-1);
+    globalSig=newGlobalSig;
+
+    State start;
+    start.entry=0;
+    start.order=0;
+    start.row=0;
+    start.speeds=sub->speeds;
+    start.curSpeed=0;
+    start.virtualTempoN=MAX(1,sub->virtualTempoN);
+    start.virtualTempoD=MAX(1,sub->virtualTempoD);
+    start.tempoAccum=0;
+    start.hz=MAX(1.0,sub->hz);
+    start.tick=0;
+    start.time=0.0;
+    start.sig=0;
+    walk(start);
+    return true;
+  }
+
+  // find the first order which changed since it was walked
+  std::vector<int> orderSig(sub->ordersLen,-1);
+  std::vector<unsigned int> orderSigVal(sub->ordersLen,0);
+  for (size_t i=0; i<states.size(); i++) {
+    int order=states[i].order;
+    if (orderSig[order]<0) {
+      orderSigVal[order]=getOrderSig(order);
+      orderSig[order]=1;
+    }
+    if (orderSigVal[order]==states[i].sig) continue;
+
+    // walk again from there
+    State resume=states[i];
+    for (size_t j=resume.entry; j<entries.size(); j++) {
+      firstVisit[entries[j].order*sub->patLen+entries[j].row]=-1;
+    }
+    entries.erase(entries.begin()+resume.entry,entries.end());
+    states.resize(i);
+    walk(resume);
+    logV("timeline: walked again from order %d",order);
+    return true;
+  }
+  return false;
+}
+
+void DivSongTimeline::clear() {
+  entries.clear();
+  states.clear();
+  firstVisit.clear();
+  globalSig=0;
+  loops=false;
+  loopEntry=-1;
+  endTick=0;
+  endTime=0.0;
+}
+
+double DivSongTimeline::getTime(int order, int row) {
+  if (sub==NULL || order<0 || row<0 || row>=sub->patLen) return -1.0;
+  size_t pos=order*sub->patLen+row;
+  if (pos>=firstVisit.size()) return -1.0;
+  if (firstVisit[pos]<0) return -1.0;
+  return entries[firstVisit[pos]].time;
+}
+
+long long DivSongTimeline::getSamplePos(int order, int row, double rate) {
+  double t=getTime(order,row);
+  if (t<0.0) return -1;
+  return (long long)(t*rate+0.5);
+}
+
+bool DivSongTimeline::getPos(double time, int& order, int& row) {
+  if (entries.empty() || time<0.0) return false;
+  if (time>=endTime) {
+    if (!loops) return false;
+    double loopStart=entries[loopEntry].time;
+    if (endTime<=loopStart) return false;
+    time=loopStart+fmod(time-loopStart,endTime-loopStart);
+  }
+  // find the last row which starts at or before this time
+  std::vector<DivTimelineEntry>::iterator i=std::upper_bound(entries.begin(),entries.end(),time,[](double t, const DivTimelineEntry& e) -> bool {
+    return t<e.time;
+  });
+  if (i==entries.begin()) return false;
+  --i;
+  order=i->order;
+  row=i->row;
+  return true;
+}
+
+double DivSongTimeline::getDuration() {
+  return endTime;
+}
+
+unsigned int DivSongTimeline::getTicks() {
+  return endTick;
+}
+
+double DivSongTimeline::getLoopStart() {
+  if (!loops || loopEntry<0) return -1.0;
+  return entries[loopEntry].time;
+}
+
+const std::vector<DivTimelineEntry>& DivSongTimeline::getEntries() {
+  return entries;
+}
+
+DivSongTimeline::DivSongTimeline():
+  song(NULL),
+  sub(NULL),
+  chans(0),
+  globalSig(0),
+  loops(false),
+  loopEntry(-1),
+  endTick(0),
+  endTime(0.0) {
+}
@@ -0,0 +1,141 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _TIMELINE_H
+#define _TIMELINE_H
+
+#include "song.h"
+#include <vector>
+
+struct DivTimelineEntry {
+  unsigned char order;
+  unsigned char row;
+  // engine ticks since the beginning of the song
+  unsigned int tick;
+  // seconds since the beginning of the song
+  double time;
+
+  DivTimelineEntry(unsigned char o, unsigned char r, unsigned int t, double s):
+    order(o),
+    row(r),
+    tick(t),
+    time(s) {}
+};
+
+/**
+ * maps every row of a sub-song to the time at which it plays.
+ *
+ * this is built by running only the sequencer and tempo logic (speeds, grooves,
+ * virtual tempo, tick rate changes and jumps), so it takes a fraction of the time
+ * needed to play the song.
+ *
+ * update() only re-walks the song from the first order whose patterns changed.
+ */
+class DivSongTimeline {
+  // sequencer state at the start of an order
+  struct State {
+    size_t entry;
+    int order, row;
+    DivGroovePattern speeds;
+    int curSpeed;
+    int virtualTempoN, virtualTempoD;
+    int tempoAccum;
+    double hz;
+    unsigned int tick;
+    double time;
+    // effect data hash of the order when it was walked
+    unsigned int sig;
+  };
+
+  DivSong* song;
+  DivSubSong* sub;
+  int chans;
+  unsigned int globalSig;
+
+  std::vector<DivTimelineEntry> entries;
+  std::vector<State> states;
+  // index into entries of the first time each row (order*patLen+row) plays, or -1
+  std::vector<int> firstVisit;
+  bool loops;
+  int loopEntry;
+  unsigned int endTick;
+  double endTime;
+
+  unsigned int getOrderSig(int order);
+  unsigned int getGlobalSig();
+  void walk(State s);
+
+  public:
+    /**
+     * bring the timeline up to date with the song.
+     * @param s the song.
+     * @param subSong the sub-song index.
+     * @param channels the number of channels in the song.
+     * @return whether anything had to be walked again.
+     */
+    bool update(DivSong* s, int subSong, int channels);
+
+    /**
+     * forget everything.
+     */
+    void clear();
+
+    /**
+     * get the time at which a row plays for the first time.
+     * @return the time in seconds, or -1 if the row is never reached.
+     */
+    double getTime(int order, int row);
+
+    /**
+     * get the position in samples at which a row plays for the first time.
+     * @return the sample offset, or -1 if the row is never reached.
+     */
+    long long getSamplePos(int order, int row, double rate);
+
+    /**
+     * find the row which plays at a given time.
+     * the time wraps around the loop if the song loops.
+     * @return whether a row was found.
+     */
+    bool getPos(double time, int& order, int& row);
+
+    /**
+     * get the length of the song, until it either loops or stops.
+     */
+    double getDuration();
+
+    /**
+     * get the length of the song in engine ticks.
+     */
+    unsigned int getTicks();
+
+    /**
+     * get the time at which the loop starts, or -1 if the song doesn't loop.
+     */
+    double getLoopStart();
+
+    /**
+     * get the list of rows in play order.
+     */
+    const std::vector<DivTimelineEntry>& getEntries();
+
+    DivSongTimeline();
+};
+
+#endif
@@ -183,7 +183,7 @@ SafeWriter* DivEngine::saveTiuna(const bool* sysToExport, const char* baseLabel,
     //     last[i].vol=-1;
     //   }
     // }
-    if (nextTick(false,true) || !playing) {
+    if (nextTick() || !playing) {
       // stopped=!playing;
       done=true;
       break;
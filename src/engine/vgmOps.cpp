@@ -21,10 +21,11 @@
 #include "../ta-log.h"
 #include "../utfutils.h"
 #include "song.h"
+#include "vgmOptimize.h"
 
 constexpr int MASTER_CLOCK_PREC=(sizeof(void*)==8)?8:0;
 
-void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, size_t bankOffset, bool directStream) {
+void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write, int streamOff, double* loopTimer, double* loopFreq, int* loopSample, bool* sampleDir, bool isSecond, int* pendingFreq, int* playingSample, int* setPos, unsigned int* sampleOff8, unsigned int* sampleLen8, unsigned short* sampleBlock, size_t bankOffset, bool directStream) {
   unsigned char baseAddr1=isSecond?0xa0:0x50;
   unsigned char baseAddr2=isSecond?0x80:0;
   unsigned short baseAddr2S=isSecond?0x8000:0;
@@ -671,7 +672,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
               } else {
                 w->writeC(0x95);
                 w->writeC(streamID);
-                w->writeS(write.val); // sample number
+                w->writeS(sampleBlock[write.val&0xff]); // block number
                 w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
               }
 
@@ -713,7 +714,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
             } else {
               w->writeC(0x95);
               w->writeC(streamID);
-              w->writeS(pendingFreq[streamID]); // sample number
+              w->writeS(sampleBlock[pendingFreq[streamID]&0xff]); // block number
               w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
             }
 
@@ -762,7 +763,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
             } else {
               w->writeC(0x95);
               w->writeC(streamID);
-              w->writeS(playingSample[streamID]); // sample number
+              w->writeS(sampleBlock[playingSample[streamID]&0xff]); // block number
               w->writeC((sample->getLoopStartPosition(DIV_SAMPLE_DEPTH_8BIT)==0 && sample->isLoopable())|(sampleDir[streamID]?0x10:0)); // flags
             }
 
@@ -1113,7 +1114,7 @@ void DivEngine::performVGMWrite(SafeWriter* w, DivSystem sys, DivRegWrite& write
   chipVol.push_back((_id)|(0x80000100)|(((unsigned int)_vol)<<16)); \
 }
 
-SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks) {
+SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool patternHints, bool directStream, int trailingTicks, bool optimize) {
   if (version<0x150) {
     lastError="VGM version is too low";
     return NULL;
@@ -1204,6 +1205,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
 
   unsigned int sampleOff8[256];
   unsigned int sampleLen8[256];
+  unsigned short sampleBlock[256];
   unsigned int sampleOffSegaPCM[256];
 
   SafeWriter* w=new SafeWriter;
@@ -2051,19 +2053,53 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   // initialize sample offsets
   memset(sampleOff8,0,256*sizeof(unsigned int));
   memset(sampleLen8,0,256*sizeof(unsigned int));
+  memset(sampleBlock,0,256*sizeof(unsigned short));
   memset(sampleOffSegaPCM,0,256*sizeof(unsigned int));
 
+  // find duplicate samples. these point to the data of the first copy
+  bool sampleDup[256];
+  int sampleDupOf[256];
+  memset(sampleDup,0,256*sizeof(bool));
+  memset(sampleDupOf,0,256*sizeof(int));
+  if (!directStream) for (int i=0; i<song.sampleLen; i++) {
+    DivSample* sample=song.sample[i];
+    for (int j=0; j<i; j++) {
+      DivSample* other=song.sample[j];
+      if (sampleDup[j]) continue;
+      if (other->length8!=sample->length8) continue;
+      if (sample->length8>0 && memcmp(other->data8,sample->data8,sample->length8)!=0) continue;
+      if (writeVOXSamples) {
+        if (other->lengthVOX!=sample->lengthVOX) continue;
+        if (sample->lengthVOX>0 && memcmp(other->dataVOX,sample->dataVOX,sample->lengthVOX)!=0) continue;
+      }
+      logD("sample %d is a duplicate of %d",i,j);
+      sampleDup[i]=true;
+      sampleDupOf[i]=j;
+      break;
+    }
+  }
+
   // write samples
+  // duplicates are not written, so the data block of a sample may not match its index
   unsigned int sampleSeek=0;
+  unsigned short blockCount=0;
   for (int i=0; i<song.sampleLen; i++) {
     DivSample* sample=song.sample[i];
+    sampleLen8[i]=sample->length8;
+    if (sampleDup[i]) continue;
     logI("setting seek to %d",sampleSeek);
     sampleOff8[i]=sampleSeek;
-    sampleLen8[i]=sample->length8;
+    sampleBlock[i]=blockCount++;
     sampleSeek+=sample->length8;
   }
+  for (int i=0; i<song.sampleLen; i++) {
+    if (!sampleDup[i]) continue;
+    sampleOff8[i]=sampleOff8[sampleDupOf[i]];
+    sampleBlock[i]=sampleBlock[sampleDupOf[i]];
+  }
 
   if (writeDACSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
+    if (sampleDup[i]) continue;
     DivSample* sample=song.sample[i];
     w->writeC(0x67);
     w->writeC(0x66);
@@ -2075,6 +2111,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   }
 
   if (writeNESSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
+    if (sampleDup[i]) continue;
     DivSample* sample=song.sample[i];
     w->writeC(0x67);
     w->writeC(0x66);
@@ -2087,6 +2124,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   }
 
   if (writePCESamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
+    if (sampleDup[i]) continue;
     DivSample* sample=song.sample[i];
     w->writeC(0x67);
     w->writeC(0x66);
@@ -2098,6 +2136,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   }
 
   if (writeVOXSamples && !directStream) for (int i=0; i<song.sampleLen; i++) {
+    if (sampleDup[i]) continue;
     DivSample* sample=song.sample[i];
     w->writeC(0x67);
     w->writeC(0x66);
@@ -2432,7 +2471,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     songTick++;
     tickPos.push_back(w->tell());
     tickSample.push_back(tickCount);
-    if (nextTick(false,true)) {
+    if (nextTick()) {
       if (trailing) beenOneLoopAlready=true;
       trailing=true;
       if (!loop) countDown=0;
@@ -2514,7 +2553,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
     for (int i=0; i<song.systemLen; i++) {
       std::vector<DivRegWrite>& writes=disCont[i].dispatch->getRegisterWrites();
       for (DivRegWrite& j: writes) {
-        performVGMWrite(w,song.system[i],j,streamIDs[i],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,bankOffset[i],directStream);
+        performVGMWrite(w,song.system[i],j,streamIDs[i],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,sampleBlock,bankOffset[i],directStream);
         writeCount++;
       }
       writes.clear();
@@ -2554,7 +2593,7 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
             lastOne=i.second.time;
           }
           // write write
-          performVGMWrite(w,song.system[i.first],i.second.write,streamIDs[i.first],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i.first],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,bankOffset[i.first],directStream);
+          performVGMWrite(w,song.system[i.first],i.second.write,streamIDs[i.first],loopTimer,loopFreq,loopSample,sampleDir,isSecond[i.first],pendingFreq,playingSample,setPos,sampleOff8,sampleLen8,sampleBlock,bankOffset[i.first],directStream);
           // handle global Furnace commands
 
           writeCount++;
@@ -2721,5 +2760,19 @@ SafeWriter* DivEngine::saveVGM(bool* sysToExport, bool loop, int version, bool p
   logI("%d register writes total.",writeCount);
 
   BUSY_END;
+
+  if (optimize) {
+    DivVGMOptimizeStats stats;
+    SafeWriter* optimized=optimizeVGM(w->getFinalBuf(),w->size(),&stats);
+    if (optimized!=NULL) {
+      logI("optimized VGM: %d->%d bytes, %d->%d register writes, %d->%d waits, %d data blocks removed.",(int)w->size(),(int)optimized->size(),(int)stats.writesIn,(int)stats.writesOut,(int)stats.waitsIn,(int)stats.waitsOut,(int)stats.blocksRemoved);
+      w->finish();
+      delete w;
+      w=optimized;
+    } else {
+      logW("could not optimize VGM!");
+    }
+  }
+
   return w;
 }
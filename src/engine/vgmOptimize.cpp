@@ -0,0 +1,261 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "vgmOptimize.h"
+#include "../ta-log.h"
+#include <string.h>
+#include <vector>
+
+// length of a VGM command (including the command byte), or 0 if unknown
+static size_t vgmCmdLen(const unsigned char* p, size_t avail) {
+  unsigned char op=p[0];
+  if (op>=0x30 && op<=0x3f) return 2;
+  if (op>=0x40 && op<=0x4e) return 3;
+  if (op==0x4f || op==0x50) return 2;
+  if (op>=0x51 && op<=0x5f) return 3;
+  if (op>=0x70 && op<=0x8f) return 1;
+  if (op>=0xa0 && op<=0xbf) return 3;
+  if (op>=0xc0 && op<=0xdf) return 4;
+  if (op>=0xe0) return 5;
+  switch (op) {
+    case 0x61:
+      return 3;
+    case 0x62: case 0x63: case 0x66:
+      return 1;
+    case 0x64:
+      return 4;
+    case 0x67: {
+      if (avail<7) return 0;
+      unsigned int size=(p[3]|(p[4]<<8)|(p[5]<<16)|((unsigned int)p[6]<<24))&0x7fffffff;
+      return 7+(size_t)size;
+    }
+    case 0x68:
+      return 12;
+    case 0x90: case 0x91: case 0x95:
+      return 5;
+    case 0x92:
+      return 6;
+    case 0x93:
+      return 11;
+    case 0x94:
+      return 2;
+  }
+  return 0;
+}
+
+// whether writes of this command can be dropped when they don't change a register,
+// and if so, whether this register has to be written anyway
+static bool vgmCanShadow(unsigned char op, unsigned char reg) {
+  // second chip
+  if (op>=0xa1 && op<=0xaf) op-=0x50;
+  switch (op) {
+    case 0x3f: case 0x4f: // GG stereo
+      return true;
+    case 0x51: // YM2413
+      return reg!=0x0f;
+    case 0x52: case 0x53: // YM2612
+      // timers, key on, DAC, frequency latches
+      if (reg>=0x20 && reg<=0x2f) return false;
+      if (reg>=0xa0 && reg<=0xaf) return false;
+      return true;
+    case 0x54: // YM2151
+      // test/LFO reset, key on, timers
+      if (reg==0x01 || reg==0x08) return false;
+      if (reg>=0x10 && reg<=0x14) return false;
+      return true;
+    case 0x55: case 0x56: case 0x58: // YM2203/YM2608/YM2610 port 0
+      // SSG envelope shape, ADPCM-B/rhythm, timers/key on/prescaler, frequency latches
+      if (reg==0x0d) return false;
+      if (reg>=0x10 && reg<=0x2f) return false;
+      if (reg>=0xa0 && reg<=0xaf) return false;
+      return true;
+    case 0x57: case 0x59: // YM2608/YM2610 port 1
+      // ADPCM control, frequency latches
+      if (reg<=0x2f) return false;
+      if (reg>=0xa0 && reg<=0xaf) return false;
+      return true;
+    case 0x5a: case 0x5b: case 0x5c: case 0x5e: case 0x5f: // OPL family
+      // test, timers, IRQ reset, CSM/keyboard split, Y8950 ADPCM, OPL3 mode
+      if (reg>=0x01 && reg<=0x12) return false;
+      return true;
+    case 0xa0: // AY-3-8910 (bit 7 of the register selects the second chip)
+      return (reg&0x7f)!=0x0d;
+  }
+  return false;
+}
+
+struct VGMBlock {
+  size_t pos, len;
+};
+
+static void writeVGMWait(SafeWriter* w, unsigned int wait, DivVGMOptimizeStats& stats) {
+  while (wait>0) {
+    stats.waitsOut++;
+    if (wait>65535) {
+      w->writeC(0x61);
+      w->writeS(65535);
+      wait-=65535;
+    } else if (wait==735) {
+      w->writeC(0x62);
+      wait=0;
+    } else if (wait==882) {
+      w->writeC(0x63);
+      wait=0;
+    } else if (wait<=16) {
+      w->writeC(0x70+wait-1);
+      wait=0;
+    } else if (wait<=32) {
+      w->writeC(0x7f);
+      wait-=16;
+    } else {
+      w->writeC(0x61);
+      w->writeS(wait);
+      wait=0;
+    }
+  }
+}
+
+SafeWriter* optimizeVGM(const unsigned char* data, size_t len, DivVGMOptimizeStats* statsOut) {
+  DivVGMOptimizeStats stats;
+  if (len<0x40 || memcmp(data,"Vgm ",4)!=0) return NULL;
+
+#define READ32(x) (data[x]|(data[(x)+1]<<8)|(data[(x)+2]<<16)|((unsigned int)data[(x)+3]<<24))
+  unsigned int version=READ32(0x08);
+  size_t gd3Pos=READ32(0x14);
+  size_t loopPos=READ32(0x1c);
+  size_t dataPos=0x40;
+  if (version>=0x150 && READ32(0x34)!=0) dataPos=0x34+READ32(0x34);
+#undef READ32
+  if (gd3Pos) gd3Pos+=0x14;
+  if (loopPos) loopPos+=0x1c;
+  if (dataPos>len) return NULL;
+
+  SafeWriter* w=new SafeWriter;
+  w->init();
+  w->write(data,dataPos);
+
+  // register shadows (-1 means unknown)
+  std::vector<short> shadow(65536,-1);
+  std::vector<VGMBlock> romBlocks;
+  unsigned int pendingWait=0;
+  size_t newLoopPos=0;
+  size_t pos=dataPos;
+  bool ended=false;
+
+  while (pos<len) {
+    if (pos==loopPos) {
+      writeVGMWait(w,pendingWait,stats);
+      pendingWait=0;
+      newLoopPos=w->tell();
+      // the state at the loop point depends on where we come from
+      for (short& i: shadow) i=-1;
+    }
+
+    const unsigned char* p=data+pos;
+    size_t cmdLen=vgmCmdLen(p,len-pos);
+    if (cmdLen==0 || pos+cmdLen>len) {
+      logW("VGM optimizer: unknown command %.2x at %x",p[0],(int)pos);
+      w->finish();
+      delete w;
+      return NULL;
+    }
+    pos+=cmdLen;
+
+    unsigned char op=p[0];
+    // waits
+    if (op==0x61) {
+      pendingWait+=p[1]|(p[2]<<8);
+      stats.waitsIn++;
+      continue;
+    }
+    if (op==0x62 || op==0x63 || (op>=0x70 && op<=0x7f)) {
+      pendingWait+=(op==0x62)?735:((op==0x63)?882:((op&15)+1));
+      stats.waitsIn++;
+      continue;
+    }
+
+    // register writes
+    if ((op>=0x51 && op<=0x5f) || (op>=0xa0 && op<=0xaf) || op==0x3f || op==0x4f) {
+      stats.writesIn++;
+      bool twoByte=(op==0x3f || op==0x4f);
+      unsigned char reg=twoByte?0:p[1];
+      unsigned char val=twoByte?p[1]:p[2];
+      if (vgmCanShadow(op,reg)) {
+        short& s=shadow[(op<<8)|reg];
+        if (s==val) continue;
+        s=val;
+      }
+      stats.writesOut++;
+    }
+
+    // ROM data blocks
+    if (op==0x67 && p[2]>=0x80 && p[2]<=0xbf) {
+      bool dup=false;
+      for (VGMBlock& i: romBlocks) {
+        if (i.len==cmdLen && memcmp(data+i.pos,p,cmdLen)==0) {
+          dup=true;
+          break;
+        }
+      }
+      if (dup) {
+        stats.blocksRemoved++;
+        continue;
+      }
+      VGMBlock b;
+      b.pos=p-data;
+      b.len=cmdLen;
+      romBlocks.push_back(b);
+    }
+
+    writeVGMWait(w,pendingWait,stats);
+    pendingWait=0;
+    w->write(p,cmdLen);
+
+    if (op==0x66) {
+      ended=true;
+      break;
+    }
+  }
+
+  if (!ended || (loopPos!=0 && newLoopPos==0) || (gd3Pos!=0 && gd3Pos<pos)) {
+    logW("VGM optimizer: couldn't parse file");
+    w->finish();
+    delete w;
+    return NULL;
+  }
+
+  // copy the rest (GD3 tag)
+  size_t tailPos=w->tell();
+  if (pos<len) w->write(data+pos,len-pos);
+
+  w->seek(0x04,SEEK_SET);
+  w->writeI(w->size()-4);
+  if (gd3Pos) {
+    w->seek(0x14,SEEK_SET);
+    w->writeI(gd3Pos-pos+tailPos-0x14);
+  }
+  if (loopPos) {
+    w->seek(0x1c,SEEK_SET);
+    w->writeI(newLoopPos-0x1c);
+  }
+  w->seek(0,SEEK_END);
+
+  if (statsOut!=NULL) *statsOut=stats;
+  return w;
+}
@@ -0,0 +1,53 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _VGMOPTIMIZE_H
+#define _VGMOPTIMIZE_H
+
+#include "safeWriter.h"
+
+struct DivVGMOptimizeStats {
+  size_t writesIn, writesOut;
+  size_t waitsIn, waitsOut;
+  size_t blocksRemoved;
+  DivVGMOptimizeStats():
+    writesIn(0),
+    writesOut(0),
+    waitsIn(0),
+    waitsOut(0),
+    blocksRemoved(0) {}
+};
+
+/**
+ * optimize the command data of a VGM file.
+ * - register writes which don't change the value of a register are dropped, unless
+ *   the register has side effects (key on, timers, envelope restart, ADPCM control...).
+ *   this is only done for chips with known rules.
+ * - consecutive waits are merged.
+ * - ROM data blocks identical to one already written to the same chip are dropped.
+ * register state is forgotten at the loop point, and the loop offset, GD3 offset and
+ * EOF offset are updated.
+ * @param data the VGM file.
+ * @param len its length.
+ * @param stats if not NULL, statistics will be written here.
+ * @return the optimized file, or NULL if it could not be parsed.
+ */
+SafeWriter* optimizeVGM(const unsigned char* data, size_t len, DivVGMOptimizeStats* stats=NULL);
+
+#endif
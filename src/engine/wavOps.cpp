@@ -21,6 +21,7 @@
 #include "../ta-log.h"
 #ifdef HAVE_SNDFILE
 #include "sfWrapper.h"
+#include "oscRender.h"
 #endif
 
 #define EXPORT_BUFSIZE 2048
@@ -33,6 +34,13 @@ bool DivEngine::isExporting() {
   return exporting;
 }
 
+float DivEngine::getExportProgress() {
+  if (!exporting || exportLength<=0.0) return -1.0f;
+  double elapsed=(double)totalSeconds+(double)totalTicks/1000000.0;
+  double passProgress=MIN(1.0,elapsed/exportLength);
+  return (float)MIN(1.0,(exportPass+passProgress)/MAX(1,exportPasses));
+}
+
 #ifdef HAVE_SNDFILE
 void DivEngine::runExportThread() {
   size_t fadeOutSamples=got.rate*exportFadeOut;
@@ -70,6 +78,14 @@ void DivEngine::runExportThread() {
       deinitAudioBackend();
       playSub(false);
 
+      if (exportOscRender!=NULL) {
+        if (!exportOscRender->begin(got.rate)) {
+          logE("could not begin oscilloscope render!");
+          exportOscRender->finish();
+          exportOscRender=NULL;
+        }
+      }
+
       logI("rendering to file...");
 
       while (playing) {
@@ -107,6 +123,7 @@ void DivEngine::runExportThread() {
           logE("error: failed to write entire buffer!");
           break;
         }
+        if (exportOscRender!=NULL) exportOscRender->feed(total);
       }
 
       delete[] outBufFinal;
@@ -117,6 +134,10 @@ void DivEngine::runExportThread() {
       if (sfWrap.doClose()!=0) {
         logE("could not close audio file!");
       }
+      if (exportOscRender!=NULL) {
+        exportOscRender->finish();
+        exportOscRender=NULL;
+      }
 
       if (initAudioBackend()) {
         for (int i=0; i<song.systemLen; i++) {
@@ -169,6 +190,14 @@ void DivEngine::runExportThread() {
       deinitAudioBackend();
       playSub(false);
 
+      if (exportOscRender!=NULL) {
+        if (!exportOscRender->begin(got.rate)) {
+          logE("could not begin oscilloscope render!");
+          exportOscRender->finish();
+          exportOscRender=NULL;
+        }
+      }
+
       logI("rendering to files...");
 
       while (playing) {
@@ -187,7 +216,10 @@ void DivEngine::runExportThread() {
                 if (disCont[i].bbOut[k]==NULL) {
                   sysBuf[i][k+(j*si[i].channels)]=0;
                 } else {
-                  sysBuf[i][k+(j*si[i].channels)]=(double)disCont[i].bbOut[k][j]*mul;
+                  double sample=(double)disCont[i].bbOut[k][j]*mul;
+                  if (sample<-32768.0) sample=-32768.0;
+                  if (sample>32767.0) sample=32767.0;
+                  sysBuf[i][k+(j*si[i].channels)]=sample;
                 }
               }
             }
@@ -201,7 +233,10 @@ void DivEngine::runExportThread() {
                 if (disCont[i].bbOut[k]==NULL) {
                   sysBuf[i][k+(j*si[i].channels)]=0;
                 } else {
-                  sysBuf[i][k+(j*si[i].channels)]=disCont[i].bbOut[k][j];
+                  int sample=disCont[i].bbOut[k][j];
+                  if (sample<-32768) sample=-32768;
+                  if (sample>32767) sample=32767;
+                  sysBuf[i][k+(j*si[i].channels)]=sample;
                 }
               }
             }
@@ -218,6 +253,12 @@ void DivEngine::runExportThread() {
             break;
           }
         }
+        if (exportOscRender!=NULL) exportOscRender->feed(total);
+      }
+
+      if (exportOscRender!=NULL) {
+        exportOscRender->finish();
+        exportOscRender=NULL;
       }
 
       delete[] outBuf[0];
@@ -244,6 +285,12 @@ void DivEngine::runExportThread() {
       break;
     }
     case DIV_EXPORT_MODE_MANY_CHAN: {
+      if (exportOscRender!=NULL) {
+        logW("oscilloscope render is not supported in per-channel export mode.");
+        exportOscRender->finish();
+        exportOscRender=NULL;
+      }
+
       // take control of audio output
       deinitAudioBackend();
 
@@ -256,6 +303,7 @@ void DivEngine::runExportThread() {
 
       logI("rendering to files...");
       
+      exportPass=0;
       for (int i=0; i<chans; i++) {
         if (!exportChannelMask[i]) continue;
         SNDFILE* sf;
@@ -341,6 +389,7 @@ void DivEngine::runExportThread() {
         if (sfWrap.doClose()!=0) {
           logE("could not close audio file!");
         }
+        exportPass++;
 
         if (getChannelType(i)==5) {
           i++;
@@ -403,6 +452,7 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
   exportFormat=options.format;
   exportFadeOut=options.fadeOut;
   memcpy(exportChannelMask,options.channelMask,DIV_MAX_CHANS*sizeof(bool));
+  exportOscRender=options.oscRender;
   if (exportMode!=DIV_EXPORT_MODE_ONE) {
     // remove extension
     String lowerCase=exportPath;
@@ -435,11 +485,34 @@ bool DivEngine::saveAudio(const char* path, DivAudioExportOptions options) {
     }
   }
 
+  // only capture oscilloscope data if it is going to be rendered
+  setOscCapture(exportOscRender!=NULL);
+
   exportOutputs=options.chans;
   if (exportOutputs<1) exportOutputs=1;
   if (exportOutputs>DIV_MAX_OUTPUTS) exportOutputs=DIV_MAX_OUTPUTS;
 
   exportLoopCount=options.loops+1;
+
+  // expected length of each pass, for the progress bar
+  exportPass=0;
+  exportPasses=1;
+  if (exportMode==DIV_EXPORT_MODE_MANY_CHAN) {
+    exportPasses=0;
+    for (int i=0; i<chans; i++) {
+      if (exportChannelMask[i]) exportPasses++;
+    }
+  }
+  exportLength=-1.0;
+  DivSongTimeline* tl=getTimeline();
+  if (tl->getDuration()>0.0) {
+    exportLength=tl->getDuration();
+    if (tl->getLoopStart()>=0.0) {
+      exportLength+=(tl->getDuration()-tl->getLoopStart())*(exportLoopCount-1);
+    }
+    exportLength+=exportFadeOut;
+  }
+
   exportThread=new std::thread(_runExportThread,this);
   return true;
 #endif
@@ -460,6 +533,7 @@ bool DivEngine::haltAudioFile() {
 }
 
 void DivEngine::finishAudioFile() {
+  setOscCapture(true);
   if (shallSwitchCores()) {
     bool isMutedBefore[DIV_MAX_CHANS];
     memcpy(isMutedBefore,isMuted,DIV_MAX_CHANS*sizeof(bool));
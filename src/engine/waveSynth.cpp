@@ -50,11 +50,10 @@ bool DivWaveSynth::activeChanged() {
 bool DivWaveSynth::tick(bool skipSubDiv) {
   bool updated=first;
   first=false;
-  if (--subDivCounter>0 && !skipSubDiv) {
+  if (e->inputTick && !skipSubDiv) {
     return updated;
   }
 
-  subDivCounter=e->tickMult;
   if (!state.enabled) return updated;
   if (width<1) return false;
 
@@ -296,7 +295,6 @@ void DivWaveSynth::init(DivInstrument* which, int w, int h, bool insChanged) {
     stage=0;
     stageDir=false;
     divCounter=0;
-    subDivCounter=0;
 
     changeWave1(state.wave1,true);
     changeWave2(state.wave2);
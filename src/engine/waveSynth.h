@@ -28,7 +28,7 @@ class DivEngine;
 class DivWaveSynth {
   DivEngine* e;
   DivInstrumentWaveSynth state;
-  int pos, stage, divCounter, width, height, subDivCounter;
+  int pos, stage, divCounter, width, height;
   bool first, activeChangedB, stageDir;
   unsigned char wave1[256];
   unsigned char wave2[256];
@@ -79,7 +79,6 @@ class DivWaveSynth {
       divCounter(0),
       width(32),
       height(31),
-      subDivCounter(0),
       first(false),
       activeChangedB(false),
       stageDir(false) {
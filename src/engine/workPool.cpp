@@ -27,9 +27,8 @@ void* _workThread(void* inst) {
 }
 
 void DivWorkThread::run() {
-  //std::unique_lock<std::mutex> unique(selfLock);
   DivPendingTask task;
-  bool setFuckingPromise=false;
+  bool notifyParent=false;
 
   logV("running work thread");
 
@@ -38,46 +37,48 @@ void DivWorkThread::run() {
     if (tasks.empty()) {
       lock.unlock();
       isBusy=false;
-      if (setFuckingPromise) {
-        parent->notify.set_value();
-        setFuckingPromise=false;
-        //std::this_thread::yield();
+      if (notifyParent) {
+        parent->notifyLock.lock();
+        parent->notify.notify_one();
+        parent->notifyLock.unlock();
+        notifyParent=false;
       }
+      std::unique_lock<std::mutex> unique(lock);
       if (terminate) {
         break;
       }
-      std::future<void> future=notify.get_future();
-      future.wait();
-      lock.lock();
-      notify=std::promise<void>();
-      promiseAlreadySet=false;
-      lock.unlock();
+      while (!started && !terminate) {
+        notify.wait(unique);
+      }
+      started=false;
       continue;
     } else {
       task=tasks.front();
       tasks.pop();
       lock.unlock();
 
+      ALLOC_TRACK_BEGIN(task.allocTrack);
       task.func(task.funcArg);
+      ALLOC_TRACK_END;
 
       int busyCount=--parent->busyCount;
       if (busyCount<0) {
         logE("oh no PROBLEM...");
       }
       if (busyCount==0) {
-        setFuckingPromise=true;
+        notifyParent=true;
       }
     }
   }
 }
 
-bool DivWorkThread::assign(void (*what)(void*), void* arg) {
+bool DivWorkThread::assign(void (*what)(void*), void* arg, const char* track) {
   lock.lock();
   if (tasks.size()>=30) {
     lock.unlock();
     return false;
   }
-  tasks.push(DivPendingTask(what,arg));
+  tasks.push(DivPendingTask(what,arg,track));
   parent->busyCount++;
   isBusy=true;
   lock.unlock();
@@ -95,11 +96,7 @@ bool DivWorkThread::busy() {
 void DivWorkThread::finish() {
   lock.lock();
   terminate=true;
-  try {
-    notify.set_value();
-  } catch (std::future_error& e) {
-    logE("future error! beware!");
-  }
+  notify.notify_one();
   lock.unlock();
   thread->join();
 }
@@ -125,7 +122,7 @@ void DivWorkPool::push(void (*what)(void*), void* arg) {
 
   for (unsigned int tryCount=0; tryCount<count; tryCount++) {
     if (pos>=count) pos=0;
-    if (workThreads[pos++].assign(what,arg)) return;
+    if (workThreads[pos++].assign(what,arg,ALLOC_TRACK_REGION)) return;
   }
 
   // all threads are busy
@@ -148,32 +145,30 @@ void DivWorkPool::wait() {
     return;
   }
 
-  std::future<void> future=notify.get_future();
-
   // start running
   for (unsigned int i=0; i<count; i++) {
-    if (!workThreads[i].promiseAlreadySet && !workThreads[i].tasks.empty()) {
-      try {
-        workThreads[i].lock.lock();
-        workThreads[i].promiseAlreadySet=true;
-        workThreads[i].notify.set_value();
-        workThreads[i].lock.unlock();
-      } catch (std::exception& e) {
-        logE("ERROR IN THREAD SYNC! %s",e.what());
-        abort();
-      }
+    workThreads[i].lock.lock();
+    if (!workThreads[i].tasks.empty()) {
+      workThreads[i].started=true;
+      workThreads[i].notify.notify_one();
     }
+    workThreads[i].lock.unlock();
   }
-  //std::this_thread::yield();
 
   // wait
-  future.wait();
-
-  notify=std::promise<void>();
+  std::unique_lock<std::mutex> unique(notifyLock);
+  while (busyCount>0) {
+    notify.wait(unique);
+  }
+  unique.unlock();
 
   pos=0;
 }
 
+unsigned int DivWorkPool::getThreadCount() {
+  return threaded?count:0;
+}
+
 DivWorkPool::DivWorkPool(unsigned int threads):
   threaded(threads>0),
   count(threads),
@@ -23,35 +23,41 @@
 #include <thread>
 #include <atomic>
 #include <functional>
-#include <future>
+#include <mutex>
+#include <condition_variable>
 
 #include "../fixedQueue.h"
+#include "../allocTrack.h"
 
 class DivWorkPool;
 
 struct DivPendingTask {
   void (*func)(void*);
   void* funcArg;
-  DivPendingTask(void (*f)(void*), void* arg):
+  // allocation tracking region of the thread that pushed this task
+  const char* allocTrack;
+  DivPendingTask(void (*f)(void*), void* arg, const char* track):
     func(f),
-    funcArg(arg) {}
+    funcArg(arg),
+    allocTrack(track) {}
   DivPendingTask():
     func(NULL),
-    funcArg(NULL) {}
+    funcArg(NULL),
+    allocTrack(NULL) {}
 };
 
 struct DivWorkThread {
   DivWorkPool* parent;
   std::mutex lock;
   std::thread* thread;
-  std::promise<void> notify;
+  std::condition_variable notify;
   FixedQueue<DivPendingTask,32> tasks;
   std::atomic<bool> isBusy;
   bool terminate;
-  bool promiseAlreadySet;
+  bool started;
 
   void run();
-  bool assign(void (*what)(void*), void* arg);
+  bool assign(void (*what)(void*), void* arg, const char* track);
   void wait();
   bool busy();
   void finish();
@@ -61,7 +67,7 @@ struct DivWorkThread {
     parent(NULL),
     isBusy(false),
     terminate(false),
-    promiseAlreadySet(false) {}
+    started(false) {}
 };
 
 /**
@@ -74,7 +80,8 @@ class DivWorkPool {
   unsigned int pos;
   DivWorkThread* workThreads;
   public:
-    std::promise<void> notify;
+    std::mutex notifyLock;
+    std::condition_variable notify;
     std::atomic<int> busyCount;
     
     /**
@@ -93,6 +100,11 @@ class DivWorkPool {
      */
     void wait();
 
+    /**
+     * get the number of work threads (0 if not threaded).
+     */
+    unsigned int getThreadCount();
+
     DivWorkPool(unsigned int threads=0);
     ~DivWorkPool();
 };
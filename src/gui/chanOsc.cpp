@@ -20,11 +20,11 @@
 #define _USE_MATH_DEFINES
 #include "gui.h"
 #include "../ta-log.h"
+#include "../engine/oscCenter.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "misc/cpp/imgui_stdlib.h"
 
-#define FURNACE_FFT_SIZE 4096
 #define FURNACE_FFT_RATE 80.0
 #define FURNACE_FFT_CUTOFF 0.1
 
@@ -86,6 +86,154 @@ float FurnaceGUI::computeGradPos(int type, int chan) {
   return 0.0f;
 }
 
+// see DivOscCenter for the algorithm.
+// the FFTs are done for a whole batch of channels at once.
+void FurnaceGUI::processChanOscBatch(void* batch_v) {
+  ChanOscBatch* batch=(ChanOscBatch*)batch_v;
+  uint64_t timeStart=SDL_GetPerformanceCounter();
+  bool anyLoud=false;
+
+  // first FFT (input)
+  for (int i=0; i<batch->count; i++) {
+    ChanOscStatus* fft=batch->chans[i];
+    DivDispatchOscBuffer* buf=fft->relatedBuf;
+    int displaySize=(float)(buf->rate)*(fft->windowSize/1000.0f);
+    fft->needle=buf->needle;
+    fft->lastNeedle=fft->needle;
+    fft->lastWindowSize=fft->windowSize;
+    fft->lastWaveCorr=fft->waveCorr;
+    fft->lastPhaseOff=fft->phaseOff;
+
+    fft->loudEnough=DivOscCenter::window(fft->inBuf,buf->data,0xffff,fft->needle,displaySize);
+    if (fft->loudEnough) anyLoud=true;
+  }
+  // clear unused slots
+  for (int i=batch->count; i<FURNACE_FFT_BATCH; i++) {
+    memset(batch->fft->inBuf+(batch->index*FURNACE_FFT_BATCH+i)*FURNACE_FFT_SIZE,0,FURNACE_FFT_SIZE*sizeof(float));
+  }
+
+  // only proceed if not quiet
+  if (anyLoud) {
+    fftwf_execute_dft_r2c(
+      batch->fft->plan,
+      batch->fft->inBuf+batch->index*FURNACE_FFT_BATCH*FURNACE_FFT_SIZE,
+      batch->fft->outBuf+batch->index*FURNACE_FFT_BATCH*FURNACE_FFT_CSIZE
+    );
+
+    // auto-correlation
+    for (int i=0; i<batch->count; i++) {
+      ChanOscStatus* fft=batch->chans[i];
+      if (!fft->loudEnough) {
+        memset(fft->outBuf,0,FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+        continue;
+      }
+      DivOscCenter::autoCorrelate(fft->outBuf);
+    }
+
+    // second FFT
+    fftwf_execute_dft_c2r(
+      batch->fft->planI,
+      batch->fft->outBuf+batch->index*FURNACE_FFT_BATCH*FURNACE_FFT_CSIZE,
+      batch->fft->corrBuf+batch->index*FURNACE_FFT_BATCH*FURNACE_FFT_SIZE
+    );
+  }
+
+  for (int i=0; i<batch->count; i++) {
+    ChanOscStatus* fft=batch->chans[i];
+    DivDispatchOscBuffer* buf=fft->relatedBuf;
+    int displaySize=(float)(buf->rate)*(fft->windowSize/1000.0f);
+
+    if (fft->loudEnough) {
+      DivOscCenterResult result;
+      result.pitch=fft->pitch;
+      fft->needle=DivOscCenter::findPhase(result,fft->corrBuf,buf->data,0xffff,fft->needle,displaySize,fft->waveCorr,fft->phaseOff);
+      fft->waveLen=result.waveLen;
+      fft->waveLenBottom=result.waveLenBottom;
+      fft->waveLenTop=result.waveLenTop;
+      fft->pitch=result.pitch;
+    }
+
+    fft->needle-=displaySize;
+  }
+
+  batch->fft->cpuTime+=((SDL_GetPerformanceCounter()-timeStart)*1000000000)/SDL_GetPerformanceFrequency();
+}
+
+bool FurnaceGUI::prepareChanOscFFT(size_t chans) {
+  size_t capacity=((chans+FURNACE_FFT_BATCH-1)/FURNACE_FFT_BATCH)*FURNACE_FFT_BATCH;
+  if (capacity<FURNACE_FFT_BATCH) capacity=FURNACE_FFT_BATCH;
+
+  if (capacity>chanOscFFT.capacity) {
+    logD(_("allocating FFT buffers for %d channels"),(int)capacity);
+    if (chanOscFFT.inBuf!=NULL) fftwf_free(chanOscFFT.inBuf);
+    if (chanOscFFT.outBuf!=NULL) fftwf_free(chanOscFFT.outBuf);
+    if (chanOscFFT.corrBuf!=NULL) fftwf_free(chanOscFFT.corrBuf);
+    chanOscFFT.inBuf=(float*)fftwf_malloc(capacity*FURNACE_FFT_SIZE*sizeof(float));
+    chanOscFFT.outBuf=(fftwf_complex*)fftwf_malloc(capacity*FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+    chanOscFFT.corrBuf=(float*)fftwf_malloc(capacity*FURNACE_FFT_SIZE*sizeof(float));
+    if (chanOscFFT.inBuf==NULL || chanOscFFT.outBuf==NULL || chanOscFFT.corrBuf==NULL) {
+      logE(_("failed to create FFT buffers"));
+      freeChanOscFFT();
+      return false;
+    }
+    memset(chanOscFFT.inBuf,0,capacity*FURNACE_FFT_SIZE*sizeof(float));
+    memset(chanOscFFT.outBuf,0,capacity*FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+    memset(chanOscFFT.corrBuf,0,capacity*FURNACE_FFT_SIZE*sizeof(float));
+    chanOscFFT.capacity=capacity;
+  }
+
+  if (chanOscFFT.plan==NULL || chanOscFFT.planI==NULL) {
+    // the plans operate on one batch. they are executed on every batch using the new-array interface.
+    // planning is measured, and the results are cached in the config directory.
+    String wisdomPath=e->getConfigPath()+DIR_SEPARATOR_STR+"fftwWisdom.txt";
+    if (!fftwf_import_wisdom_from_filename(wisdomPath.c_str())) {
+      logD(_("no FFT wisdom. planning will take longer..."));
+    }
+    int size=FURNACE_FFT_SIZE;
+    // planning with FFTW_MEASURE overwrites the buffers, but they are cleared anyway
+    chanOscFFT.plan=fftwf_plan_many_dft_r2c(1,&size,FURNACE_FFT_BATCH,chanOscFFT.inBuf,NULL,1,FURNACE_FFT_SIZE,chanOscFFT.outBuf,NULL,1,FURNACE_FFT_CSIZE,FFTW_MEASURE);
+    chanOscFFT.planI=fftwf_plan_many_dft_c2r(1,&size,FURNACE_FFT_BATCH,chanOscFFT.outBuf,NULL,1,FURNACE_FFT_CSIZE,chanOscFFT.corrBuf,NULL,1,FURNACE_FFT_SIZE,FFTW_MEASURE);
+    if (chanOscFFT.plan==NULL) {
+      logE(_("failed to create plan!"));
+      freeChanOscFFT();
+      return false;
+    }
+    if (chanOscFFT.planI==NULL) {
+      logE(_("failed to create inverse plan!"));
+      freeChanOscFFT();
+      return false;
+    }
+    memset(chanOscFFT.inBuf,0,chanOscFFT.capacity*FURNACE_FFT_SIZE*sizeof(float));
+    memset(chanOscFFT.outBuf,0,chanOscFFT.capacity*FURNACE_FFT_CSIZE*sizeof(fftwf_complex));
+    memset(chanOscFFT.corrBuf,0,chanOscFFT.capacity*FURNACE_FFT_SIZE*sizeof(float));
+    if (!fftwf_export_wisdom_to_filename(wisdomPath.c_str())) {
+      logW(_("could not save FFT wisdom!"));
+    }
+  }
+
+  return true;
+}
+
+void FurnaceGUI::freeChanOscFFT() {
+  if (chanOscFFT.plan!=NULL) fftwf_destroy_plan(chanOscFFT.plan);
+  if (chanOscFFT.planI!=NULL) fftwf_destroy_plan(chanOscFFT.planI);
+  if (chanOscFFT.inBuf!=NULL) fftwf_free(chanOscFFT.inBuf);
+  if (chanOscFFT.outBuf!=NULL) fftwf_free(chanOscFFT.outBuf);
+  if (chanOscFFT.corrBuf!=NULL) fftwf_free(chanOscFFT.corrBuf);
+  chanOscFFT.plan=NULL;
+  chanOscFFT.planI=NULL;
+  chanOscFFT.inBuf=NULL;
+  chanOscFFT.outBuf=NULL;
+  chanOscFFT.corrBuf=NULL;
+  chanOscFFT.capacity=0;
+  for (int i=0; i<DIV_MAX_CHANS; i++) {
+    chanOscChan[i].inBuf=NULL;
+    chanOscChan[i].outBuf=NULL;
+    chanOscChan[i].corrBuf=NULL;
+    chanOscChan[i].ready=false;
+  }
+}
+
 void FurnaceGUI::calcChanOsc() {
   std::vector<DivDispatchOscBuffer*> oscBufs;
   std::vector<ChanOscStatus*> oscFFTs;
@@ -412,145 +560,53 @@ void FurnaceGUI::drawChanOsc() {
         }
 
         // process
+        // channels are analyzed in batches of FURNACE_FFT_BATCH, each batch being a task.
+        // a batch is skipped if none of its channels got new samples.
+        bool fftReady=prepareChanOscFFT(oscBufs.size());
+        std::vector<ChanOscBatch> batches;
+        chanOscFFT.cpuTime=0;
+        chanOscFFT.lastProcessed=0;
         for (size_t i=0; i<oscBufs.size(); i++) {
           ChanOscStatus* fft_=oscFFTs[i];
 
           fft_->relatedBuf=oscBufs[i];
           fft_->relatedCh=oscChans[i];
+          fft_->ready=fftReady;
+          if (fftReady) {
+            fft_->inBuf=chanOscFFT.inBuf+i*FURNACE_FFT_SIZE;
+            fft_->outBuf=chanOscFFT.outBuf+i*FURNACE_FFT_CSIZE;
+            fft_->corrBuf=chanOscFFT.corrBuf+i*FURNACE_FFT_SIZE;
+          }
 
-          if (fft_->relatedBuf!=NULL) {
-            // prepare
-            if (centerSettingReset) {
-              fft_->relatedBuf->readNeedle=fft_->relatedBuf->needle;
-            }
-
-            // check FFT status existence
-            if (!fft_->ready) {
-              logD(_("creating FFT plan for channel %d"),fft_->relatedCh);
-              fft_->inBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->outBuf=(fftw_complex*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(fftw_complex));
-              fft_->corrBuf=(double*)fftw_malloc(FURNACE_FFT_SIZE*sizeof(double));
-              fft_->plan=fftw_plan_dft_r2c_1d(FURNACE_FFT_SIZE,fft_->inBuf,fft_->outBuf,FFTW_ESTIMATE);
-              fft_->planI=fftw_plan_dft_c2r_1d(FURNACE_FFT_SIZE,fft_->outBuf,fft_->corrBuf,FFTW_ESTIMATE);
-              if (fft_->plan==NULL) {
-                logE(_("failed to create plan!"));
-              } else if (fft_->planI==NULL) {
-                logE(_("failed to create inverse plan!"));
-              } else if (fft_->inBuf==NULL || fft_->outBuf==NULL || fft_->corrBuf==NULL) {
-                logE(_("failed to create FFT buffers"));
-              } else {
-                fft_->ready=true;
-              }
-            }
-
-            if (fft_->ready && e->isRunning()) {
-              fft_->windowSize=chanOscWindowSize;
-              fft_->waveCorr=chanOscWaveCorr;
-              chanOscWorkPool->push([](void* fft_v) {
-                ChanOscStatus* fft=(ChanOscStatus*)fft_v;
-                DivDispatchOscBuffer* buf=fft->relatedBuf;
-
-                // the STRATEGY
-                // 1. FFT of windowed signal
-                // 2. inverse FFT of auto-correlation
-                // 3. find size of one period
-                // 4. DFT of the fundamental of ONE PERIOD
-                // 5. now we can get phase information
-                //
-                // I have a feeling this could be simplified to two FFTs or even one...
-                // if you know how, please tell me
-
-                // initialization
-                double phase=0.0;
-                int displaySize=(float)(buf->rate)*(fft->windowSize/1000.0f);
-                fft->loudEnough=false;
-                fft->needle=buf->needle;
-
-                // first FFT
-                for (int j=0; j<FURNACE_FFT_SIZE; j++) {
-                  fft->inBuf[j]=(double)buf->data[(unsigned short)(fft->needle-displaySize*2+((j*displaySize*2)/(FURNACE_FFT_SIZE)))]/32768.0;
-                  if (fft->inBuf[j]>0.001 || fft->inBuf[j]<-0.001) fft->loudEnough=true;
-                  fft->inBuf[j]*=0.55-0.45*cos(M_PI*(double)j/(double)(FURNACE_FFT_SIZE>>1));
-                }
-
-                // only proceed if not quiet
-                if (fft->loudEnough) {
-                  fftw_execute(fft->plan);
-
-                  // auto-correlation and second FFT
-                  for (int j=0; j<FURNACE_FFT_SIZE; j++) {
-                    fft->outBuf[j][0]/=FURNACE_FFT_SIZE;
-                    fft->outBuf[j][1]/=FURNACE_FFT_SIZE;
-                    fft->outBuf[j][0]=fft->outBuf[j][0]*fft->outBuf[j][0]+fft->outBuf[j][1]*fft->outBuf[j][1];
-                    fft->outBuf[j][1]=0;
-                  }
-                  fft->outBuf[0][0]=0;
-                  fft->outBuf[0][1]=0;
-                  fft->outBuf[1][0]=0;
-                  fft->outBuf[1][1]=0;
-                  fftw_execute(fft->planI);
-
-                  // window
-                  for (int j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
-                    fft->corrBuf[j]*=1.0-((double)j/(double)(FURNACE_FFT_SIZE<<1));
-                  }
-
-                  // find size of period
-                  double waveLenCandL=DBL_MAX;
-                  double waveLenCandH=DBL_MIN;
-                  fft->waveLen=FURNACE_FFT_SIZE-1;
-                  fft->waveLenBottom=0;
-                  fft->waveLenTop=0;
-
-                  // find lowest point
-                  for (int j=(FURNACE_FFT_SIZE>>2); j>2; j--) {
-                    if (fft->corrBuf[j]<waveLenCandL) {
-                      waveLenCandL=fft->corrBuf[j];
-                      fft->waveLenBottom=j;
-                    }
-                  }
-                  
-                  // find highest point
-                  for (int j=(FURNACE_FFT_SIZE>>1)-1; j>fft->waveLenBottom; j--) {
-                    if (fft->corrBuf[j]>waveLenCandH) {
-                      waveLenCandH=fft->corrBuf[j];
-                      fft->waveLen=j;
-                    }
-                  }
-                  fft->waveLenTop=fft->waveLen;
-
-                  // did we find the period size?
-                  if (fft->waveLen<(FURNACE_FFT_SIZE-32)) {
-                    // we got pitch
-                    fft->pitch=pow(1.0-(fft->waveLen/(double)(FURNACE_FFT_SIZE>>1)),4.0);
-                    
-                    fft->waveLen*=(double)displaySize*2.0/(double)FURNACE_FFT_SIZE;
-
-                    // DFT of one period (x_1)
-                    double dft[2];
-                    dft[0]=0.0;
-                    dft[1]=0.0;
-                    for (int j=fft->needle-1-(displaySize>>1)-(int)fft->waveLen, k=0; k<fft->waveLen; j++, k++) {
-                      double one=((double)buf->data[j&0xffff]/32768.0);
-                      double two=(double)k*(-2.0*M_PI)/fft->waveLen;
-                      dft[0]+=one*cos(two);
-                      dft[1]+=one*sin(two);
-                    }
+          // prepare
+          if (centerSettingReset) {
+            fft_->relatedBuf->readNeedle=fft_->relatedBuf->needle;
+          }
 
-                    // calculate and lock into phase
-                    phase=(0.5+(atan2(dft[1],dft[0])/(2.0*M_PI)));
+          if (!fftReady || !e->isRunning()) continue;
 
-                    if (fft->waveCorr) {
-                      fft->needle-=(phase+(fft->phaseOff*2))*fft->waveLen;
-                    }
-                  }
-                }
+          fft_->windowSize=chanOscWindowSize;
+          fft_->waveCorr=chanOscWaveCorr;
 
-                fft->needle-=displaySize;
-              },fft_);
-            }
+          size_t batchIndex=i/FURNACE_FFT_BATCH;
+          if (batchIndex>=batches.size()) {
+            batches.push_back(ChanOscBatch(&chanOscFFT,batchIndex));
+          }
+          ChanOscBatch& batch=batches[batchIndex];
+          batch.chans[batch.count++]=fft_;
+          if (fft_->relatedBuf->needle!=fft_->lastNeedle ||
+              fft_->windowSize!=fft_->lastWindowSize ||
+              fft_->waveCorr!=fft_->lastWaveCorr ||
+              fft_->phaseOff!=fft_->lastPhaseOff ||
+              centerSettingReset) {
+            batch.dirty=true;
           }
         }
+        for (ChanOscBatch& i: batches) {
+          if (!i.dirty) continue;
+          chanOscFFT.lastProcessed+=i.count;
+          chanOscWorkPool->push(processChanOscBatch,&i);
+        }
         chanOscWorkPool->wait();
 
         // 0: none
@@ -621,7 +677,7 @@ void FurnaceGUI::drawChanOsc() {
                 float maxLevel=-1.0f;
                 float dcOff=0.0f;
 
-                if (debugFFT) {
+                if (debugFFT && fft->ready) {
                   // FFT debug code!
                   double maxavg=0.0;
                   for (unsigned short j=0; j<(FURNACE_FFT_SIZE>>1); j++) {
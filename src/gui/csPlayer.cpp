@@ -83,6 +83,18 @@ String disasmCmd(unsigned char* buf, size_t bufLen, unsigned int addr) {
     case 0xec: case 0xed: case 0xee: case 0xef:
       return fmt::sprintf("qwait (%d)",(int)(buf[addr]-0xe0));
       break;
+    case 0xf5:
+      return fmt::sprintf("call $%x",(unsigned int)(buf[addr+1]|(buf[addr+2]<<8)|(buf[addr+3]<<16)|(buf[addr+4]<<24)));
+      break;
+    case 0xf6:
+      return fmt::sprintf("callb32 $%x",addr+4+(int)(buf[addr+1]|(buf[addr+2]<<8)|(buf[addr+3]<<16)|(buf[addr+4]<<24)));
+      break;
+    case 0xf8:
+      return fmt::sprintf("callb16 $%x",addr+2+(short)(buf[addr+1]|(buf[addr+2]<<8)));
+      break;
+    case 0xf9:
+      return "ret";
+      break;
     case 0xfc:
       return fmt::sprintf("waits %d",(int)(buf[addr+1]|(buf[addr+2]<<8)));
       break;
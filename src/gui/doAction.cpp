@@ -920,27 +920,24 @@ void FurnaceGUI::doAction(int what) {
         if (curSample==-1) {
           showError(_("too many samples!"));
         } else {
-          e->lockEngine([this,prevSample]() {
-            DivSample* sample=e->getSample(curSample);
-            if (sample!=NULL) {
-              sample->rate=prevSample->rate;
-              sample->centerRate=prevSample->centerRate;
-              sample->name=prevSample->name;
-              sample->loopStart=prevSample->loopStart;
-              sample->loopEnd=prevSample->loopEnd;
-              sample->loop=prevSample->loop;
-              sample->loopMode=prevSample->loopMode;
-              sample->brrEmphasis=prevSample->brrEmphasis;
-              sample->brrNoFilter=prevSample->brrNoFilter;
-              sample->dither=prevSample->dither;
-              sample->depth=prevSample->depth;
-              if (sample->init(prevSample->samples)) {
-                if (prevSample->getCurBuf()!=NULL) {
-                  memcpy(sample->getCurBuf(),prevSample->getCurBuf(),prevSample->getCurBufLen());
-                }
+          e->getSample(curSample)->name=prevSample->name;
+          e->editSample(curSample,[prevSample](DivSample* sample) -> bool {
+            sample->rate=prevSample->rate;
+            sample->centerRate=prevSample->centerRate;
+            sample->loopStart=prevSample->loopStart;
+            sample->loopEnd=prevSample->loopEnd;
+            sample->loop=prevSample->loop;
+            sample->loopMode=prevSample->loopMode;
+            sample->brrEmphasis=prevSample->brrEmphasis;
+            sample->brrNoFilter=prevSample->brrNoFilter;
+            sample->dither=prevSample->dither;
+            sample->depth=prevSample->depth;
+            if (sample->init(prevSample->samples)) {
+              if (prevSample->getCurBuf()!=NULL) {
+                memcpy(sample->getCurBuf(),prevSample->getCurBuf(),prevSample->getCurBufLen());
               }
             }
-            e->renderSamples();
+            return true;
           });
           wantScrollListSample=true;
           MARK_MODIFIED;
@@ -1082,11 +1079,11 @@ void FurnaceGUI::doAction(int what) {
       sampleClipboardLen=end-start;
       memcpy(sampleClipboard,&(sample->data16[start]),sizeof(short)*(end-start));
 
-      e->lockEngine([this,sample,start,end]() {
+      e->editSample(curSample,[this,start,end](DivSample* sample) -> bool {
         sample->strip(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1120,19 +1117,19 @@ void FurnaceGUI::doAction(int what) {
       if (pos<0) pos=0;
       logV("paste position: %d",pos);
 
-      e->lockEngine([this,sample,pos]() {
+      e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
         if (!sample->insert(pos,sampleClipboardLen)) {
           showError(_("couldn't paste! make sure your sample is 8 or 16-bit."));
-        } else {
-          if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
-            for (size_t i=0; i<sampleClipboardLen; i++) {
-              sample->data8[pos+i]=sampleClipboard[i]>>8;
-            }
-          } else {
-            memcpy(&(sample->data16[pos]),sampleClipboard,sizeof(short)*sampleClipboardLen);
+          return false;
+        }
+        if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
+          for (size_t i=0; i<sampleClipboardLen; i++) {
+            sample->data8[pos+i]=sampleClipboard[i]>>8;
           }
+        } else {
+          memcpy(&(sample->data16[pos]),sampleClipboard,sizeof(short)*sampleClipboardLen);
         }
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
@@ -1150,7 +1147,7 @@ void FurnaceGUI::doAction(int what) {
       if (pos>=(int)sample->samples) pos=sample->samples-1;
       if (pos<0) pos=0;
 
-      e->lockEngine([this,sample,pos]() {
+      e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
         if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
           for (size_t i=0; i<sampleClipboardLen; i++) {
             if (pos+i>=sample->samples) break;
@@ -1162,7 +1159,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data16[pos+i]=sampleClipboard[i];
           }
         }
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
@@ -1181,7 +1178,7 @@ void FurnaceGUI::doAction(int what) {
       if (pos>=(int)sample->samples) pos=sample->samples-1;
       if (pos<0) pos=0;
 
-      e->lockEngine([this,sample,pos]() {
+      e->editSample(curSample,[this,pos](DivSample* sample) -> bool {
         if (sample->depth==DIV_SAMPLE_DEPTH_8BIT) {
           for (size_t i=0; i<sampleClipboardLen; i++) {
             if (pos+i>=sample->samples) break;
@@ -1199,7 +1196,7 @@ void FurnaceGUI::doAction(int what) {
             sample->data16[pos+i]=val;
           }
         }
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=pos;
       sampleSelEnd=pos+sampleClipboardLen;
@@ -1233,7 +1230,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
         float maxVal=0.0f;
 
@@ -1271,7 +1268,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1281,7 +1278,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1302,7 +1299,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1312,7 +1309,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1333,7 +1330,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1347,7 +1344,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1362,7 +1359,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1372,13 +1369,13 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         sample->strip(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1390,13 +1387,13 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         sample->trim(start,end);
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       sampleSelStart=-1;
       sampleSelEnd=-1;
@@ -1408,7 +1405,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1431,7 +1428,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1441,7 +1438,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1458,7 +1455,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1468,7 +1465,7 @@ void FurnaceGUI::doAction(int what) {
       DivSample* sample=e->song.sample[curSample];
       if (sample->depth!=DIV_SAMPLE_DEPTH_8BIT && sample->depth!=DIV_SAMPLE_DEPTH_16BIT) break;
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         if (sample->depth==DIV_SAMPLE_DEPTH_16BIT) {
@@ -1483,7 +1480,7 @@ void FurnaceGUI::doAction(int what) {
 
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
@@ -1608,7 +1605,7 @@ void FurnaceGUI::doAction(int what) {
       if (curSample<0 || curSample>=(int)e->song.sample.size()) break;
       DivSample* sample=e->song.sample[curSample];
       sample->prepareUndo(true);
-      e->lockEngine([this,sample]() {
+      e->editSample(curSample,[this](DivSample* sample) -> bool {
         SAMPLE_OP_BEGIN;
 
         sample->loopStart=start;
@@ -1616,7 +1613,7 @@ void FurnaceGUI::doAction(int what) {
         sample->loop=true;
         updateSampleTex=true;
 
-        e->renderSamples(curSample);
+        return true;
       });
       MARK_MODIFIED;
       break;
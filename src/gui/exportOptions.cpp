@@ -188,6 +188,14 @@ void FurnaceGUI::drawExportVGM(bool onWindow) {
       "at the cost of a massive increase in file size."
     ));
   }
+  ImGui::Checkbox(_("optimize size"),&vgmExportOptimize);
+  if (ImGui::IsItemHovered()) {
+    ImGui::SetTooltip(_(
+      "removes register writes which don't change anything,\n"
+      "merges waits and removes duplicate sample data.\n\n"
+      "save as .vgz to compress the file as well."
+    ));
+  }
   ImGui::Text(_("chips to export:"));
   bool hasOneAtLeast=false;
   for (int i=0; i<e->song.systemLen; i++) {
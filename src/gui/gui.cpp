@@ -27,6 +27,7 @@
 #include "util.h"
 #include "../ta-log.h"
 #include "../fileutils.h"
+#include "../engine/parallelDeflate.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "ImGuiFileDialog.h"
@@ -1682,7 +1683,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       }
       hasOpened=fileDialog->openLoad(
         _("Restore Backup"),
-        {_("Furnace song"), "*.fur"},
+        {_("Furnace song"), "*.furb *.fur"},
         backupPath+String(DIR_SEPARATOR_STR),
         dpiScale
       );
@@ -1910,7 +1911,7 @@ void FurnaceGUI::openFileDialog(FurnaceGUIFileDialogs type) {
       if (!dirExists(workingDirVGMExport)) workingDirVGMExport=getHomeDir();
       hasOpened=fileDialog->openSave(
         _("Export VGM"),
-        {_("VGM file"), "*.vgm"},
+        {_("VGM file"), "*.vgm *.vgz"},
         workingDirVGMExport,
         dpiScale,
         (settings.autoFillSave)?shortName:""
@@ -2173,64 +2174,25 @@ int FurnaceGUI::save(String path, int dmfVersion) {
     return 1;
   }
   if (settings.compress) {
-    unsigned char zbuf[131072];
-    int ret;
-    z_stream zl;
-    memset(&zl,0,sizeof(z_stream));
-    ret=deflateInit(&zl,Z_DEFAULT_COMPRESSION);
-    if (ret!=Z_OK) {
+    SafeWriter* zw=deflateParallel(w->getFinalBuf(),w->size());
+    if (zw==NULL) {
       logE("zlib error!");
       lastError=_("compression error");
       fclose(outFile);
       w->finish();
       return 2;
     }
-    zl.avail_in=w->size();
-    zl.next_in=w->getFinalBuf();
-    while (zl.avail_in>0) {
-      zl.avail_out=131072;
-      zl.next_out=zbuf;
-      if ((ret=deflate(&zl,Z_NO_FLUSH))==Z_STREAM_ERROR) {
-        logE("zlib stream error!");
-        lastError=_("zlib stream error");
-        deflateEnd(&zl);
-        fclose(outFile);
-        w->finish();
-        return 2;
-      }
-      size_t amount=131072-zl.avail_out;
-      if (amount>0) {
-        if (fwrite(zbuf,1,amount,outFile)!=amount) {
-          logE("did not write entirely: %s!",strerror(errno));
-          lastError=strerror(errno);
-          deflateEnd(&zl);
-          fclose(outFile);
-          w->finish();
-          return 1;
-        }
-      }
-    }
-    zl.avail_out=131072;
-    zl.next_out=zbuf;
-    if ((ret=deflate(&zl,Z_FINISH))==Z_STREAM_ERROR) {
-      logE("zlib finish stream error!");
-      lastError=_("zlib finish stream error");
-      deflateEnd(&zl);
+    if (fwrite(zw->getFinalBuf(),1,zw->size(),outFile)!=zw->size()) {
+      logE("did not write entirely: %s!",strerror(errno));
+      lastError=strerror(errno);
       fclose(outFile);
+      zw->finish();
+      delete zw;
       w->finish();
-      return 2;
-    }
-    if (131072-zl.avail_out>0) {
-      if (fwrite(zbuf,1,131072-zl.avail_out,outFile)!=(131072-zl.avail_out)) {
-        logE("did not write entirely: %s!",strerror(errno));
-        lastError=strerror(errno);
-        deflateEnd(&zl);
-        fclose(outFile);
-        w->finish();
-        return 1;
-      }
+      return 1;
     }
-    deflateEnd(&zl);
+    zw->finish();
+    delete zw;
   } else {
     if (fwrite(w->getFinalBuf(),1,w->size(),outFile)!=w->size()) {
       logE("did not write entirely: %s!",strerror(errno));
@@ -2256,7 +2218,34 @@ int FurnaceGUI::save(String path, int dmfVersion) {
   return 0;
 }
 
-int FurnaceGUI::load(String path) {
+void FurnaceGUI::requestLoad(String path) {
+  pendingLoad=path;
+}
+
+void FurnaceGUI::drawLoadProgress() {
+  // the song may be replaced at any moment while loading, so nothing but the progress window is drawn
+  SDL_PumpEvents();
+  rend->newFrame();
+  ImGui_ImplSDL2_NewFrame(sdlWin);
+  ImGui::NewFrame();
+
+  ImGui::SetNextWindowPos(ImVec2(canvasW*0.5,canvasH*0.5),ImGuiCond_Always,ImVec2(0.5,0.5));
+  if (ImGui::Begin("Loading",NULL,ImGuiWindowFlags_NoDecoration|ImGuiWindowFlags_AlwaysAutoResize|ImGuiWindowFlags_NoMove|ImGuiWindowFlags_NoSavedSettings|ImGuiWindowFlags_NoDocking)) {
+    ImGui::Text(_("Loading..."));
+    float progress=e->getLoadProgress();
+    if (progress>=0.0f) {
+      ImGui::ProgressBar(progress,ImVec2(300.0f*dpiScale,0));
+    }
+  }
+  ImGui::End();
+
+  rend->clear(uiColors[GUI_COLOR_BACKGROUND]);
+  ImGui::Render();
+  rend->renderGUI();
+  rend->present();
+}
+
+int FurnaceGUI::load(String path, bool showProgress) {
   bool wasPlaying=e->isPlaying();
   if (!path.empty()) {
     logI("loading module...");
@@ -2305,7 +2294,30 @@ int FurnaceGUI::load(String path) {
       return 1;
     }
     fclose(f);
-    if (!e->load(file,(size_t)len,path.c_str())) {
+    bool loaded=false;
+    if (showProgress) {
+      // load on another thread and draw the progress of sample decoding meanwhile.
+      // only show it if loading takes a while, to prevent flicker.
+      std::atomic<bool> loadFinished(false);
+      loadingFile=true;
+      std::thread loadThread([this,file,len,&path,&loaded,&loadFinished]() {
+        loaded=e->load(file,(size_t)len,path.c_str());
+        loadFinished=true;
+      });
+      unsigned int loadStart=SDL_GetTicks();
+      while (!loadFinished) {
+        if (SDL_GetTicks()-loadStart>=100) {
+          drawLoadProgress();
+        }
+        SDL_Delay(10);
+      }
+      loadThread.join();
+      loadingFile=false;
+      WAKE_UP;
+    } else {
+      loaded=e->load(file,(size_t)len,path.c_str());
+    }
+    if (!loaded) {
       lastError=e->getLastError();
       logE("could not open file!");
       return 1;
@@ -2353,9 +2365,7 @@ void FurnaceGUI::openRecentFile(String path) {
     nextFile=path;
     showWarning(_("Unsaved changes! Save changes before opening file?"),GUI_WARN_OPEN_DROP);
   } else {
-    if (load(path)>0) {
-      showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-    }
+    requestLoad(path);
   }
 }
 
@@ -2385,7 +2395,7 @@ void FurnaceGUI::pushRecentSys(const char* path) {
 void FurnaceGUI::delFirstBackup(String name) {
   std::vector<String> listOfFiles;
 #ifdef _WIN32
-  String findPath=backupPath+String(DIR_SEPARATOR_STR)+name+String("*.fur");
+  String findPath=backupPath+String(DIR_SEPARATOR_STR)+name+String("*.fur*");
   WIN32_FIND_DATAW next;
   HANDLE backDir=FindFirstFileW(utf8To16(findPath.c_str()).c_str(),&next);
   if (backDir!=INVALID_HANDLE_VALUE) {
@@ -3168,6 +3178,7 @@ int _processEvent(void* instance, SDL_Event* event) {
 
 int FurnaceGUI::processEvent(SDL_Event* ev) {
   if (introPos<11.0 && !shortIntro) return 1;
+  if (loadingFile) return 1;
 #ifdef IS_MOBILE
   if (ev->type==SDL_APP_TERMINATING) {
     // TODO: save last song state here
@@ -3754,9 +3765,7 @@ bool FurnaceGUI::loop() {
               nextFile=ev.drop.file;
               showWarning(_("Unsaved changes! Save changes before opening file?"),GUI_WARN_OPEN_DROP);
             } else {
-              if (load(ev.drop.file)>0) {
-                showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-              }
+              requestLoad(ev.drop.file);
             }
             SDL_free(ev.drop.file);
           }
@@ -4166,6 +4175,16 @@ bool FurnaceGUI::loop() {
       if (pendingLayoutImport==NULL) pendingLayoutImportStep=0;
     }
 
+    // loads requested during the last frame happen here, outside of a frame,
+    // so that the loading progress can be drawn
+    if (!pendingLoad.empty()) {
+      String path=pendingLoad;
+      pendingLoad="";
+      if (load(path,true)>0) {
+        showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
+      }
+    }
+
     if (!rend->newFrame()) {
       fontsFailed=true;
     }
@@ -5032,7 +5051,7 @@ bool FurnaceGUI::loop() {
             checkExtension(".raw");
           }
           if (curFileDialog==GUI_FILE_EXPORT_VGM) {
-            checkExtension(".vgm");
+            checkExtensionDual(".vgm",".vgz",".vgm");
           }
           if (curFileDialog==GUI_FILE_EXPORT_ZSM) {
             checkExtension(".zsm");
@@ -5062,9 +5081,7 @@ bool FurnaceGUI::loop() {
           switch (curFileDialog) {
             case GUI_FILE_OPEN:
             case GUI_FILE_OPEN_BACKUP:
-              if (load(copyOfName)>0) {
-                showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-              }
+              requestLoad(copyOfName);
               break;
             case GUI_FILE_SAVE: {
               bool saveWasSuccessful=true;
@@ -5084,9 +5101,7 @@ bool FurnaceGUI::loop() {
                     openOpen=true;
                     break;
                   case GUI_WARN_OPEN_DROP:
-                    if (load(nextFile)>0) {
-                      showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-                    }
+                    requestLoad(nextFile);
                     nextFile="";
                     break;
                   case GUI_WARN_OPEN_BACKUP:
@@ -5378,7 +5393,21 @@ bool FurnaceGUI::loop() {
               break;
             }
             case GUI_FILE_EXPORT_VGM: {
-              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks);
+              SafeWriter* w=e->saveVGM(willExport,vgmExportLoop,vgmExportVersion,vgmExportPatternHints,vgmExportDirectStream,vgmExportTrailingTicks,vgmExportOptimize);
+              bool vgz=false;
+              if (copyOfName.size()>=4) {
+                String ext=copyOfName.substr(copyOfName.size()-4);
+                for (char& i: ext) {
+                  if (i>='A' && i<='Z') i+='a'-'A';
+                }
+                vgz=(ext==".vgz");
+              }
+              if (w!=NULL && vgz) {
+                SafeWriter* zw=deflateParallel(w->getFinalBuf(),w->size(),Z_BEST_COMPRESSION,0,true);
+                w->finish();
+                delete w;
+                w=zw;
+              }
               if (w!=NULL) {
                 FILE* f=ps_fopen(copyOfName.c_str(),"wb");
                 if (f!=NULL) {
@@ -5661,6 +5690,10 @@ bool FurnaceGUI::loop() {
     centerNextWindow(_("Rendering..."),canvasW,canvasH);
     if (ImGui::BeginPopupModal(_("Rendering..."),NULL,ImGuiWindowFlags_AlwaysAutoResize)) {
       ImGui::Text(_("Please wait..."));
+      float progress=e->getExportProgress();
+      if (progress>=0.0f) {
+        ImGui::ProgressBar(progress,ImVec2(300.0f*dpiScale,0));
+      }
       if (ImGui::Button(_("Abort"))) {
         if (e->haltAudioFile()) {
           ImGui::CloseCurrentPopup();
@@ -5845,9 +5878,7 @@ bool FurnaceGUI::loop() {
                 showError(fmt::sprintf(_("Error while saving file! (%s)"),lastError));
                 nextFile="";
               } else {
-                if (load(nextFile)>0) {
-                  showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-                }
+                requestLoad(nextFile);
                 nextFile="";
               }
             }
@@ -5855,9 +5886,7 @@ bool FurnaceGUI::loop() {
           ImGui::SameLine();
           if (ImGui::Button(_("No"))) {
             ImGui::CloseCurrentPopup();
-            if (load(nextFile)>0) {
-              showError(fmt::sprintf(_("Error while loading file! (%s)"),lastError));
-            }
+            requestLoad(nextFile);
             nextFile="";
           }
           ImGui::SameLine();
@@ -6490,13 +6519,17 @@ bool FurnaceGUI::loop() {
       if (backupTimer>0) {
         backupTimer=(backupTimer-ImGui::GetIO().DeltaTime);
         if (backupTimer<=0) {
-          backupTask=std::async(std::launch::async,[this]() -> bool {
+          // the song is copied here, since the GUI edits it without locking
+          DivSong* backupSong=e->makeSongSnapshot();
+          backupTask=std::async(std::launch::async,[this,backupSong]() -> bool {
             backupLock.lock();
             logV("backupPath: %s",backupPath);
             logV("curFileName: %s",curFileName);
             if (curFileName.find(backupPath)==0) {
               logD("backup file open. not saving backup.");
               backupTimer=settings.backupInterval;
+              backupSong->unload();
+              delete backupSong;
               backupLock.unlock();
               return true;
             }
@@ -6504,12 +6537,16 @@ bool FurnaceGUI::loop() {
               if (!makeDir(backupPath.c_str())) {
                 logW("could not create backup directory!");
                 backupTimer=settings.backupInterval;
+                backupSong->unload();
+                delete backupSong;
                 backupLock.unlock();
                 return false;
               }
             }
             logD("saving backup...");
-            SafeWriter* w=e->saveFur(true,true);
+            SafeWriter* w=e->saveFur(true,true,backupSong);
+            backupSong->unload();
+            delete backupSong;
             logV("writing file...");
 
             if (w!=NULL) {
@@ -6542,34 +6579,32 @@ bool FurnaceGUI::loop() {
 #ifdef _WIN32
               struct tm* tempTM=localtime(&curTime);
               if (tempTM==NULL) {
-                backupFileName+="-unknownTime.fur";
+                backupFileName+="-unknownTime" DIV_BACKUP_EXT;
               } else {
                 curTM=*tempTM;
-                backupFileName+=fmt::sprintf("-%d%.2d%.2d-%.2d%.2d%.2d.fur",curTM.tm_year+1900,curTM.tm_mon+1,curTM.tm_mday,curTM.tm_hour,curTM.tm_min,curTM.tm_sec);
+                backupFileName+=fmt::sprintf("-%d%.2d%.2d-%.2d%.2d%.2d" DIV_BACKUP_EXT,curTM.tm_year+1900,curTM.tm_mon+1,curTM.tm_mday,curTM.tm_hour,curTM.tm_min,curTM.tm_sec);
               }
 #else
               if (localtime_r(&curTime,&curTM)==NULL) {
-                backupFileName+="-unknownTime.fur";
+                backupFileName+="-unknownTime" DIV_BACKUP_EXT;
               } else {
-                backupFileName+=fmt::sprintf("-%d%.2d%.2d-%.2d%.2d%.2d.fur",curTM.tm_year+1900,curTM.tm_mon+1,curTM.tm_mday,curTM.tm_hour,curTM.tm_min,curTM.tm_sec);
+                backupFileName+=fmt::sprintf("-%d%.2d%.2d-%.2d%.2d%.2d" DIV_BACKUP_EXT,curTM.tm_year+1900,curTM.tm_mon+1,curTM.tm_mday,curTM.tm_hour,curTM.tm_min,curTM.tm_sec);
               }
 #endif
 
               String finalPath=backupPath+String(DIR_SEPARATOR_STR)+backupFileName;
-              
-              FILE* outFile=ps_fopen(finalPath.c_str(),"wb");
-              if (outFile!=NULL) {
-                if (fwrite(w->getFinalBuf(),1,w->size(),outFile)!=w->size()) {
-                  logW("did not write backup entirely: %s!",strerror(errno));
-                }
-                fclose(outFile);
-              } else {
-                logW("could not save backup: %s!",strerror(errno));
+
+              // only blocks which changed since the last backup are written
+              backupStore.setPath(backupPath);
+              if (!backupStore.save(w,finalPath)) {
+                logW("could not save backup!");
               }
               w->finish();
+              delete w;
 
               // delete previous backup if there are too many
               delFirstBackup(backupBaseName);
+              backupStore.collectGarbage();
             }
             logD("backup saved.");
             backupTimer=settings.backupInterval;
@@ -7699,6 +7734,7 @@ bool FurnaceGUI::finish(bool saveConfig) {
   if (chanOscWorkPool!=NULL) {
     delete chanOscWorkPool;
   }
+  freeChanOscFFT();
 
   return true;
 }
@@ -7738,6 +7774,7 @@ FurnaceGUI::FurnaceGUI():
   zsmExportOptimize(true),
   vgmExportPatternHints(false),
   vgmExportDirectStream(false),
+  vgmExportOptimize(true),
   displayInsTypeList(false),
   portrait(false),
   injectBackUp(false),
@@ -7977,6 +8014,7 @@ FurnaceGUI::FurnaceGUI():
   curWindowLast(GUI_WINDOW_NOTHING),
   curWindowThreadSafe(GUI_WINDOW_NOTHING),
   failedNoteOn(false),
+  loadingFile(false),
   lastPatternWidth(0.0f),
   longThreshold(0.48f),
   buttonLongThreshold(0.20f),
@@ -21,6 +21,7 @@
 #define _FUR_GUI_H
 
 #include "../engine/engine.h"
+#include "../engine/backupStore.h"
 #include "../engine/workPool.h"
 #include "../engine/waveSynth.h"
 #include "imgui.h"
@@ -70,6 +71,9 @@
 
 #define FM_PREVIEW_SIZE 512
 
+// number of channels per chan osc FFT batch
+#define FURNACE_FFT_BATCH 8
+
 enum FurnaceGUIRenderBackend {
   GUI_BACKEND_SDL=0,
   GUI_BACKEND_GL3,
@@ -1593,6 +1597,8 @@ class FurnaceGUI {
   String workingDirFont, workingDirColors, workingDirKeybinds;
   String workingDirLayout, workingDirROM, workingDirTest;
   String workingDirConfig;
+  // file to be loaded at the beginning of the next frame
+  String pendingLoad;
   String mmlString[32];
   String mmlStringW, grooveString, grooveListString, mmlStringModTable;
   String mmlStringSNES[DIV_MAX_CHIPS];
@@ -1608,7 +1614,7 @@ class FurnaceGUI {
   std::vector<String> availAudioDrivers;
 
   bool quit, warnQuit, willCommit, edit, editClone, isPatUnique, modified, displayError, displayExporting, vgmExportLoop, zsmExportLoop, zsmExportOptimize, vgmExportPatternHints;
-  bool vgmExportDirectStream, displayInsTypeList, displayWaveSizeList;
+  bool vgmExportDirectStream, vgmExportOptimize, displayInsTypeList, displayWaveSizeList;
   bool portrait, injectBackUp, mobileMenuOpen, warnColorPushed;
   bool wantCaptureKeyboard, oldWantCaptureKeyboard, displayMacroMenu;
   bool displayNew, displayExport, displayPalette, fullScreen, preserveChanPos, sysDupCloneChannels, sysDupEnd, noteInputPoly, notifyWaveChange;
@@ -1681,6 +1687,7 @@ class FurnaceGUI {
   std::atomic<double> backupTimer;
   std::future<bool> backupTask;
   std::mutex backupLock;
+  DivBackupStore backupStore;
   String backupPath;
 
   std::vector<FurnaceGUIBackupEntry> backupEntries;
@@ -1922,6 +1929,7 @@ class FurnaceGUI {
     int wasapiEx;
     int chanOscThreads;
     int renderPoolThreads;
+    int renderAhead;
     int writeInsNames;
     int readInsNames;
     int fontBackend;
@@ -1947,6 +1955,7 @@ class FurnaceGUI {
     int glStencilSize;
     int glBufferSize;
     int glDoubleBuffer;
+    int swRenderThreads;
     int backupEnable;
     int backupInterval;
     int backupMaxCopies;
@@ -2178,6 +2187,7 @@ class FurnaceGUI {
       wasapiEx(0),
       chanOscThreads(0),
       renderPoolThreads(0),
+      renderAhead(0),
       writeInsNames(0),
       readInsNames(1),
       fontBackend(1),
@@ -2203,6 +2213,7 @@ class FurnaceGUI {
       glStencilSize(0),
       glBufferSize(32),
       glDoubleBuffer(1),
+      swRenderThreads(0),
       backupEnable(1),
       backupInterval(30),
       backupMaxCopies(5),
@@ -2294,6 +2305,7 @@ class FurnaceGUI {
   FurnaceGUIWindows curWindow, nextWindow, curWindowLast;
   std::atomic<FurnaceGUIWindows> curWindowThreadSafe;
   std::atomic<bool> failedNoteOn;
+  std::atomic<bool> loadingFile;
   float peak[DIV_MAX_OUTPUTS];
   float patChanX[DIV_MAX_CHANS+1];
   float patChanSlideY[DIV_MAX_CHANS+1];
@@ -2542,9 +2554,10 @@ class FurnaceGUI {
   unsigned short lastNeedlePos[DIV_MAX_CHANS];
   unsigned short lastCorrPos[DIV_MAX_CHANS];
   struct ChanOscStatus {
-    double* inBuf;
-    fftw_complex* outBuf;
-    double* corrBuf;
+    // these point to this channel's slot in the batched FFT buffers
+    float* inBuf;
+    fftwf_complex* outBuf;
+    float* corrBuf;
     DivDispatchOscBuffer* relatedBuf;
     size_t inBufPos;
     double inBufPosFrac;
@@ -2552,9 +2565,10 @@ class FurnaceGUI {
     int waveLenBottom, waveLenTop, relatedCh;
     float pitch, windowSize, phaseOff;
     unsigned short needle;
-    bool ready, loudEnough, waveCorr;
-    fftw_plan plan;
-    fftw_plan planI;
+    // parameters of the last analysis, used to skip channels which did not change
+    unsigned short lastNeedle;
+    float lastWindowSize, lastPhaseOff;
+    bool ready, loudEnough, waveCorr, lastWaveCorr;
     PendingDrawOsc drawOp;
     float oscTex[2048];
     ChanOscStatus():
@@ -2572,12 +2586,53 @@ class FurnaceGUI {
       windowSize(1.0f),
       phaseOff(0.0f),
       needle(0),
+      lastNeedle(0),
+      lastWindowSize(0.0f),
+      lastPhaseOff(0.0f),
       ready(false),
       loudEnough(false),
       waveCorr(false),
-      plan(NULL),
-      planI(NULL) {}
+      lastWaveCorr(false) {}
   } chanOscChan[DIV_MAX_CHANS];
+  // batched FFT state (shared by all channels)
+  struct ChanOscFFT {
+    float* inBuf;
+    fftwf_complex* outBuf;
+    float* corrBuf;
+    fftwf_plan plan;
+    fftwf_plan planI;
+    size_t capacity;
+    // CPU time spent analyzing channels in the last frame (in nanoseconds)
+    std::atomic<uint64_t> cpuTime;
+    int lastProcessed;
+    ChanOscFFT():
+      inBuf(NULL),
+      outBuf(NULL),
+      corrBuf(NULL),
+      plan(NULL),
+      planI(NULL),
+      capacity(0),
+      cpuTime(0),
+      lastProcessed(0) {}
+  } chanOscFFT;
+  struct ChanOscBatch {
+    ChanOscFFT* fft;
+    ChanOscStatus* chans[FURNACE_FFT_BATCH];
+    size_t index;
+    int count;
+    bool dirty;
+    ChanOscBatch(ChanOscFFT* f, size_t i):
+      fft(f),
+      index(i),
+      count(0),
+      dirty(false) {
+      memset(chans,0,FURNACE_FFT_BATCH*sizeof(ChanOscStatus*));
+    }
+  };
+
+  // statistics
+  DivPerfSample statsPerf[DIV_PERF_HISTORY];
+  float statsPerfPlot[DIV_PERF_HISTORY];
 
   // x-y oscilloscope
   FurnaceGUITexture* xyOscPointTex;
@@ -2732,6 +2787,9 @@ class FurnaceGUI {
 
   void readOsc();
   void calcChanOsc();
+  bool prepareChanOscFFT(size_t chans);
+  static void processChanOscBatch(void* batch);
+  void freeChanOscFFT();
 
   void pushAccentColors(const ImVec4& one, const ImVec4& two, const ImVec4& border, const ImVec4& borderShadow);
   void popAccentColors();
@@ -2924,7 +2982,9 @@ class FurnaceGUI {
 
   void openFileDialog(FurnaceGUIFileDialogs type);
   int save(String path, int dmfVersion);
-  int load(String path);
+  int load(String path, bool showProgress=false);
+  void requestLoad(String path);
+  void drawLoadProgress();
   int loadStream(String path);
   void openRecentFile(String path);
   void pushRecentFile(String path);
@@ -49,6 +49,8 @@ bool FurnaceGUIRenderSoftware::lockTexture(FurnaceGUITexture* which, void** data
 }
 
 bool FurnaceGUIRenderSoftware::unlockTexture(FurnaceGUITexture* which) {
+  FurnaceSoftwareTexture* t=(FurnaceSoftwareTexture*)which;
+  t->tex->touch();
   return true;
 }
 
@@ -56,6 +58,7 @@ bool FurnaceGUIRenderSoftware::updateTexture(FurnaceGUITexture* which, void* dat
   FurnaceSoftwareTexture* t=(FurnaceSoftwareTexture*)which;
   if (!t->tex->managed) return false;
   memcpy(t->tex->pixels,data,pitch*t->tex->height);
+  t->tex->touch();
   return true;
 }
 
@@ -86,12 +89,23 @@ void FurnaceGUIRenderSoftware::setBlendMode(FurnaceGUIBlendMode mode) {
   // TODO
 }
 
+void FurnaceGUIRenderSoftware::resized(const SDL_Event& ev) {
+  if (guiInited) ImGui_ImplSW_InvalidateFrame();
+}
+
 void FurnaceGUIRenderSoftware::clear(ImVec4 color) {
-  SDL_Surface* surf=SDL_GetWindowSurface(sdlWin);
-  if (!surf) return;
   ImU32 clearToWhat=ImGui::ColorConvertFloat4ToU32(color);
   clearToWhat=(clearToWhat&0xff00ff00)|((clearToWhat&0xff)<<16)|((clearToWhat&0xff0000)>>16);
 
+  // the renderer clears each tile as it paints it (and skips unchanged ones)
+  if (guiInited) {
+    ImGui_ImplSW_SetClearColor(clearToWhat);
+    return;
+  }
+
+  SDL_Surface* surf=SDL_GetWindowSurface(sdlWin);
+  if (!surf) return;
+
   bool mustLock=SDL_MUSTLOCK(surf);
   if (mustLock) {
     if (SDL_LockSurface(surf)!=0) return;
@@ -115,6 +129,7 @@ bool FurnaceGUIRenderSoftware::canVSync() {
 
 void FurnaceGUIRenderSoftware::createFontsTexture() {
   ImGui_ImplSW_CreateFontsTexture();
+  if (guiInited) ImGui_ImplSW_InvalidateFrame();
 }
 
 void FurnaceGUIRenderSoftware::destroyFontsTexture() {
@@ -177,6 +192,7 @@ void FurnaceGUIRenderSoftware::setSwapInterval(int swapInterval) {
 }
 
 void FurnaceGUIRenderSoftware::preInit(const DivConfig& conf) {
+  renderThreads=conf.getInt("swRenderThreads",0);
 }
 
 bool FurnaceGUIRenderSoftware::init(SDL_Window* win, int swapInterval) {
@@ -187,11 +203,17 @@ bool FurnaceGUIRenderSoftware::init(SDL_Window* win, int swapInterval) {
 void FurnaceGUIRenderSoftware::initGUI(SDL_Window* win) {
   // hack
   ImGui_ImplSDL2_InitForMetal(win);
-  ImGui_ImplSW_Init(win);
+  if (ImGui_ImplSW_Init(win)) {
+    ImGui_ImplSW_SetThreads(renderThreads);
+    guiInited=true;
+  }
 }
 
 void FurnaceGUIRenderSoftware::quitGUI() {
-  ImGui_ImplSW_Shutdown();
+  if (guiInited) {
+    ImGui_ImplSW_Shutdown();
+    guiInited=false;
+  }
 }
 
 bool FurnaceGUIRenderSoftware::quit() {
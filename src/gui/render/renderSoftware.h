@@ -21,6 +21,8 @@
 
 class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
   SDL_Window* sdlWin;
+  int renderThreads;
+  bool guiInited;
   public:
     ImTextureID getTextureID(FurnaceGUITexture* which);
     FurnaceGUITextureFormat getTextureFormat(FurnaceGUITexture* which);
@@ -31,6 +33,7 @@ class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
     bool destroyTexture(FurnaceGUITexture* which);
     void setTextureBlendMode(FurnaceGUITexture* which, FurnaceGUIBlendMode mode);
     void setBlendMode(FurnaceGUIBlendMode mode);
+    void resized(const SDL_Event& ev);
     void clear(ImVec4 color);
     bool newFrame();
     bool canVSync();
@@ -55,5 +58,7 @@ class FurnaceGUIRenderSoftware: public FurnaceGUIRender {
     void quitGUI();
     bool quit();
     FurnaceGUIRenderSoftware():
-      sdlWin(NULL) {}
+      sdlWin(NULL),
+      renderThreads(0),
+      guiInited(false) {}
 };
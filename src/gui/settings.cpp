@@ -727,6 +727,17 @@ void FurnaceGUI::drawSettings() {
             }
 
             ImGui::TextWrapped(_("the following values are common (in red, green, blue, alpha order):\n- 24 bits: 8, 8, 8, 0\n- 16 bits: 5, 6, 5, 0\n- 32 bits (with alpha): 8, 8, 8, 8\n- 30 bits (deep): 10, 10, 10, 0"));
+          } else if (curRenderBackend=="Software") {
+            pushWarningColor(settings.swRenderThreads>cpuCores,settings.swRenderThreads>(cpuCores*2));
+            if (ImGui::InputInt(_("Render threads"),&settings.swRenderThreads)) {
+              if (settings.swRenderThreads<0) settings.swRenderThreads=0;
+              if (settings.swRenderThreads>64) settings.swRenderThreads=64;
+              settingsChanged=true;
+            }
+            if (ImGui::IsItemHovered()) {
+              ImGui::SetTooltip(_("number of threads used to paint the screen.\n0 means automatic.\nyou may need to restart Furnace for this setting to take effect."));
+            }
+            popWarningColor();
           } else {
             ImGui::Text(_("nothing to configure"));
           }
@@ -1435,13 +1446,36 @@ void FurnaceGUI::drawSettings() {
           popWarningColor();
         }
 
+        bool renderAheadB=(settings.renderAhead>0);
+        if (ImGui::Checkbox(_("Render ahead"),&renderAheadB)) {
+          if (renderAheadB) {
+            settings.renderAhead=2;
+          } else {
+            settings.renderAhead=0;
+          }
+          settingsChanged=true;
+        }
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip(_("renders audio on a separate thread, a few buffers ahead of the audio device.\nhelps avoid dropouts on heavy songs or small buffer sizes, at the cost of latency during playback."));
+        }
+
+        if (renderAheadB) {
+          if (ImGui::InputInt(_("Buffers ahead"),&settings.renderAhead)) {
+            if (settings.renderAhead<2) settings.renderAhead=2;
+            if (settings.renderAhead>DIV_RENDER_AHEAD_MAX) settings.renderAhead=DIV_RENDER_AHEAD_MAX;
+            settingsChanged=true;
+          }
+          ImGui::SameLine();
+          ImGui::Text(_("(latency: ~%.1fms)"),1000.0*(double)(settings.renderAhead*settings.audioBufSize)/(double)MAX(1,settings.audioRate));
+        }
+
         bool lowLatencyB=settings.lowLatency;
         if (ImGui::Checkbox(_("Low-latency mode"),&lowLatencyB)) {
           settings.lowLatency=lowLatencyB;
           settingsChanged=true;
         }
         if (ImGui::IsItemHovered()) {
-          ImGui::SetTooltip(_("reduces latency by running the engine faster than the tick rate.\nuseful for live playback/jam mode.\n\nwarning: only enable if your buffer size is small (10ms or less)."));
+          ImGui::SetTooltip(_("reduces latency by applying note input between ticks instead of waiting for the next one.\nuseful for live playback/jam mode.\n\nwarning: only enable if your buffer size is small (10ms or less)."));
         }
 
         bool forceMonoB=settings.forceMono;
@@ -4703,12 +4737,15 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     settings.glBufferSize=conf.getInt("glBufferSize",32);
     settings.glDoubleBuffer=conf.getInt("glDoubleBuffer",1);
 
+    settings.swRenderThreads=conf.getInt("swRenderThreads",0);
+
     settings.vsync=conf.getInt("vsync",1);
     settings.frameRateLimit=conf.getInt("frameRateLimit",100);
     settings.displayRenderTime=conf.getInt("displayRenderTime",0);
 
     settings.chanOscThreads=conf.getInt("chanOscThreads",0);
     settings.renderPoolThreads=conf.getInt("renderPoolThreads",0);
+    settings.renderAhead=conf.getInt("renderAhead",0);
     settings.shaderOsc=conf.getInt("shaderOsc",0);
     settings.writeInsNames=conf.getInt("writeInsNames",0);
     settings.readInsNames=conf.getInt("readInsNames",1);
@@ -5225,6 +5262,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.wasapiEx,0,1);
   clampSetting(settings.chanOscThreads,0,256);
   clampSetting(settings.renderPoolThreads,0,DIV_MAX_CHIPS);
+  clampSetting(settings.renderAhead,0,DIV_RENDER_AHEAD_MAX);
   clampSetting(settings.writeInsNames,0,1);
   clampSetting(settings.readInsNames,0,1);
   clampSetting(settings.fontBackend,0,1);
@@ -5252,6 +5290,7 @@ void FurnaceGUI::readConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
   clampSetting(settings.glDepthSize,0,128);
   clampSetting(settings.glStencilSize,0,32);
   clampSetting(settings.glDoubleBuffer,0,1);
+  clampSetting(settings.swRenderThreads,0,64);
   clampSetting(settings.backupEnable,0,1);
   clampSetting(settings.backupInterval,10,86400);
   clampSetting(settings.backupMaxCopies,1,100);
@@ -5288,12 +5327,15 @@ void FurnaceGUI::writeConfig(DivConfig& conf, FurnaceGUISettingGroups groups) {
     conf.set("glStencilSize",settings.glStencilSize);
     conf.set("glDoubleBuffer",settings.glDoubleBuffer);
 
+    conf.set("swRenderThreads",settings.swRenderThreads);
+
     conf.set("vsync",settings.vsync);
     conf.set("frameRateLimit",settings.frameRateLimit);
     conf.set("displayRenderTime",settings.displayRenderTime);
 
     conf.set("chanOscThreads",settings.chanOscThreads);
     conf.set("renderPoolThreads",settings.renderPoolThreads);
+    conf.set("renderAhead",settings.renderAhead);
     conf.set("shaderOsc",settings.shaderOsc);
     conf.set("writeInsNames",settings.writeInsNames);
     conf.set("readInsNames",settings.readInsNames);
@@ -36,6 +36,123 @@ void FurnaceGUI::drawStats() {
     ImGui::Text(_("Audio load"));
     ImGui::SameLine();
     ImGui::ProgressBar((double)lastProcTime/maxGot,ImVec2(-FLT_MIN,0),procStr.c_str());
+    if (chanOscOpen) {
+      ImGui::Text(_("Oscilloscope (per-channel) CPU time: %.2fms (%d channels analyzed)"),(double)chanOscFFT.cpuTime/1000000.0,chanOscFFT.lastProcessed);
+    }
+
+    size_t perfCount=e->getPerfHistory(statsPerf,DIV_PERF_HISTORY);
+    if (perfCount>0) {
+      int overruns=0;
+      unsigned int xruns=0;
+      double maxLoad=100.0;
+      double avgProc=0.0;
+      double peakProc=0.0;
+      double avgTicks=0.0;
+      double avgCmds=0.0;
+      double avgWrites=0.0;
+      double avgIdle=0.0;
+      double avgChip[DIV_MAX_CHIPS];
+      int chips=statsPerf[perfCount-1].chips;
+      memset(avgChip,0,DIV_MAX_CHIPS*sizeof(double));
+
+      for (size_t i=0; i<perfCount; i++) {
+        const DivPerfSample& p=statsPerf[i];
+        double load=(p.budget>0)?(100.0*(double)p.processTime/(double)p.budget):0.0;
+        statsPerfPlot[i]=load;
+        if (load>maxLoad) maxLoad=load;
+        if (p.processTime>p.budget) overruns++;
+        xruns+=p.xruns;
+        avgProc+=p.processTime;
+        if (p.processTime>peakProc) peakProc=p.processTime;
+        avgTicks+=p.ticks;
+        avgCmds+=p.cmds;
+        avgWrites+=p.regWrites;
+        avgIdle+=p.workerIdle;
+        for (int j=0; j<MIN(chips,p.chips); j++) {
+          avgChip[j]+=p.chipTime[j];
+        }
+      }
+      avgProc/=perfCount;
+      avgTicks/=perfCount;
+      avgCmds/=perfCount;
+      avgWrites/=perfCount;
+      avgIdle/=perfCount;
+      double budget=statsPerf[perfCount-1].budget;
+
+      ImGui::Separator();
+      ImGui::Text(_("Last %d buffers (%.2fms each):"),(int)perfCount,budget/1000000.0);
+
+      // load history. buffers which took longer than their duration are marked.
+      ImVec2 plotSize=ImVec2(ImGui::GetContentRegionAvail().x,80.0f*dpiScale);
+      ImGui::PlotLines("##PerfLoad",statsPerfPlot,perfCount,0,NULL,0.0f,maxLoad,plotSize);
+      if (overruns>0) {
+        ImDrawList* dl=ImGui::GetWindowDrawList();
+        ImVec2 plotMin=ImGui::GetItemRectMin();
+        ImVec2 plotMax=ImGui::GetItemRectMax();
+        ImU32 overrunColor=ImGui::GetColorU32(uiColors[GUI_COLOR_ERROR]);
+        for (size_t i=0; i<perfCount; i++) {
+          if (statsPerf[i].processTime<=statsPerf[i].budget) continue;
+          float x=plotMin.x+(plotMax.x-plotMin.x)*((float)i+0.5f)/(float)perfCount;
+          dl->AddLine(ImVec2(x,plotMin.y),ImVec2(x,plotMax.y),overrunColor,dpiScale);
+        }
+        // 100% line
+        float y=plotMax.y-(plotMax.y-plotMin.y)*(100.0f/maxLoad);
+        dl->AddLine(ImVec2(plotMin.x,y),ImVec2(plotMax.x,y),overrunColor,dpiScale);
+      }
+
+      if (overruns>0) {
+        ImGui::TextColored(uiColors[GUI_COLOR_ERROR],_("%d buffers took longer than their duration!"),overruns);
+      } else {
+        ImGui::Text(_("no buffer overruns."));
+      }
+      if (xruns>0) {
+        ImGui::TextColored(uiColors[GUI_COLOR_ERROR],_("the audio backend reported %d underruns/overruns."),xruns);
+      }
+
+      if (ImGui::BeginTable("PerfCounters",2,ImGuiTableFlags_Borders|ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text(_("Process time (average/peak)"));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3fms / %.3fms",avgProc/1000000.0,peakProc/1000000.0);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text(_("Ticks per buffer"));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f",avgTicks);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text(_("Commands per buffer"));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f",avgCmds);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text(_("Register writes per buffer"));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f",avgWrites);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text(_("Worker idle time"));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3fms",avgIdle/1000000.0);
+        ImGui::EndTable();
+      }
+
+      if (chips>0 && budget>0.0) {
+        ImGui::Text(_("Chip render time (average):"));
+        for (int i=0; i<chips && i<e->song.systemLen; i++) {
+          String chipStr=fmt::sprintf("%.3fms",avgChip[i]/(double)perfCount/1000000.0);
+          ImGui::AlignTextToFramePadding();
+          ImGui::Text("%d. %s",i+1,e->getSystemName(e->song.system[i]));
+          ImGui::SameLine();
+          ImGui::ProgressBar(avgChip[i]/(double)perfCount/budget,ImVec2(-FLT_MIN,0),chipStr.c_str());
+        }
+      }
+    }
   }
   if (ImGui::IsWindowFocused(ImGuiFocusedFlags_ChildWindows)) curWindow=GUI_WINDOW_STATS;
   ImGui::End();
@@ -62,16 +62,17 @@ const char* logTypes[5]={
 void appendLogBuf(const LogEntry& entry) {
   logFileLockI.lock();
 
-  std::string toWrite=fmt::sprintf(
-    "%02d:%02d:%02d [%s] %s\n",
-    entry.time.tm_hour,
-    entry.time.tm_min,
-    entry.time.tm_sec,
-    logTypes[entry.loglevel],
-    entry.text
-  );
-
-  const char* msg=toWrite.c_str();
+  // built in place, since the audio thread may log and must not allocate
+  char header[32];
+  int headerLen=snprintf(header,32,"%02d:%02d:%02d [%s] ",entry.time.tm_hour,entry.time.tm_min,entry.time.tm_sec,logTypes[entry.loglevel]);
+  if (headerLen<0) headerLen=0;
+  if (headerLen>31) headerLen=31;
+  fmt::memory_buffer toWrite;
+  toWrite.append(header,header+headerLen);
+  toWrite.append(entry.text.data(),entry.text.data()+entry.text.size());
+  toWrite.push_back('\n');
+
+  const char* msg=toWrite.data();
   size_t len=toWrite.size();
 
   int remaining=(logFilePosO-logFilePosI-1)&TA_LOGFILE_BUF_SIZE;
@@ -98,11 +99,11 @@ int writeLog(int level, const char* msg, fmt::printf_args args) {
   time_t thisMakesNoSense=time(NULL);
   int pos=(logPosition.fetch_add(1))&TA_LOG_MASK;
 
-#if FMT_VERSION >= 100100
-  logEntries[pos].text.assign(fmt::vsprintf(fmt::basic_string_view<char>(msg),args));
-#else
-  logEntries[pos].text.assign(fmt::vsprintf(msg,args));
-#endif
+  // fmt::vsprintf() would return a new string. format into a stack buffer and copy
+  // into the entry instead, so that logging doesn't allocate (unless the message is long)
+  fmt::memory_buffer formatted;
+  fmt::detail::vprintf(formatted,fmt::basic_string_view<char>(msg),args);
+  logEntries[pos].text.assign(formatted.data(),formatted.size());
   // why do I have to pass a pointer
   // can't I just pass the time_t directly?!
 #ifdef _WIN32
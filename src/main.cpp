@@ -26,6 +26,14 @@
 #include "ta-log.h"
 #include "fileutils.h"
 #include "engine/engine.h"
+#include "engine/exportBatch.h"
+#include "engine/oscRender.h"
+#include "engine/parallelDeflate.h"
+#include "engine/workPool.h"
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <math.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -38,6 +46,10 @@ typedef HRESULT (WINAPI *SPDA)(PROCESS_DPI_AWARENESS);
 #else
 #include <signal.h>
 #include <unistd.h>
+#include <dirent.h>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
 
 struct sigaction termsa;
 #endif
@@ -87,9 +99,13 @@ String outName;
 String vgmOutName;
 String zsmOutName;
 String cmdOutName;
+String oscOutName;
 int benchMode=0;
+String benchGoldenPath;
+bool benchUpdateGoldens=false;
 int subsong=-1;
 DivAudioExportOptions exportOptions;
+DivOscRenderOptions oscOptions;
 
 #ifdef HAVE_GUI
 bool consoleMode=false;
@@ -103,11 +119,14 @@ bool consoleNoControls=false;
 bool displayEngineFailError=false;
 bool displayLocaleFailError=false;
 bool vgmOutDirect=false;
+bool allSubSongs=false;
 
 bool safeMode=false;
 bool safeModeWithAudio=false;
 
 bool infoMode=false;
+bool infoJSONMode=false;
+bool infoDuration=false;
 
 std::vector<TAParam> params;
 
@@ -235,11 +254,28 @@ TAParamResult pDirect(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pAllSubSongs(String val) {
+  allSubSongs=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pInfo(String val) {
   infoMode=true;
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pInfoJSON(String val) {
+  infoJSONMode=true;
+  // keep standard output clean for the JSON
+  changeLogOutput(stderr);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pDuration(String val) {
+  infoDuration=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pLogLevel(String val) {
   if (val=="trace") {
     logLevel=LOGLEVEL_TRACE;
@@ -402,14 +438,28 @@ TAParamResult pBenchmark(String val) {
     benchMode=1;
   } else if (val=="seek") {
     benchMode=2;
+  } else if (val=="suite") {
+    benchMode=3;
+    // keep standard output clean for the report
+    changeLogOutput(stderr);
   } else {
-    logE("invalid value for benchmark! valid values are: render and seek.");
+    logE("invalid value for benchmark! valid values are: render, seek and suite.");
     return TA_PARAM_ERROR;
   }
   e.setAudio(DIV_AUDIO_DUMMY);
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pGolden(String val) {
+  benchGoldenPath=val;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pUpdateGolden(String val) {
+  benchUpdateGoldens=true;
+  return TA_PARAM_SUCCESS;
+}
+
 TAParamResult pOutput(String val) {
   outName=val;
   e.setAudio(DIV_AUDIO_DUMMY);
@@ -434,6 +484,51 @@ TAParamResult pCmdOut(String val) {
   return TA_PARAM_SUCCESS;
 }
 
+TAParamResult pOscOut(String val) {
+  oscOutName=val;
+  if (val=="-") changeLogOutput(stderr);
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pOscFormat(String val) {
+  if (val=="y4m") {
+    oscOptions.format=DIV_OSC_RENDER_Y4M;
+  } else if (val=="raw") {
+    oscOptions.format=DIV_OSC_RENDER_RAW;
+  } else {
+    logE("invalid value for oscformat! valid values are: y4m and raw.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pOscSize(String val) {
+  int w=0;
+  int h=0;
+  if (sscanf(val.c_str(),"%dx%d",&w,&h)!=2 || w<16 || h<16) {
+    logE("oscilloscope size shall be in WIDTHxHEIGHT format (e.g. 1280x720).");
+    return TA_PARAM_ERROR;
+  }
+  oscOptions.width=w;
+  oscOptions.height=h;
+  return TA_PARAM_SUCCESS;
+}
+
+TAParamResult pOscFPS(String val) {
+  try {
+    int v=std::stoi(val);
+    if (v<1 || v>240) {
+      logE("oscilloscope frame rate shall be between 1 and 240.");
+      return TA_PARAM_ERROR;
+    }
+    oscOptions.fps=v;
+  } catch (std::exception& e) {
+    logE("oscilloscope frame rate shall be a number.");
+    return TA_PARAM_ERROR;
+  }
+  return TA_PARAM_SUCCESS;
+}
+
 bool needsValue(String param) {
   for (size_t i=0; i<params.size(); i++) {
     if (params[i].name==param) {
@@ -448,13 +543,16 @@ void initParams() {
 
   params.push_back(TAParam("a","audio",true,pAudio,"jack|sdl|portaudio|pipe","set audio engine (SDL by default)"));
   params.push_back(TAParam("o","output",true,pOutput,"<filename>","output audio to file"));
-  params.push_back(TAParam("O","vgmout",true,pVGMOut,"<filename>","output .vgm data"));
+  params.push_back(TAParam("O","vgmout",true,pVGMOut,"<filename>","output .vgm data (or .vgz)"));
   params.push_back(TAParam("D","direct",false,pDirect,"","set VGM export direct stream mode"));
   params.push_back(TAParam("Z","zsmout",true,pZSMOut,"<filename>","output .zsm data for Commander X16 Zsound"));
   params.push_back(TAParam("C","cmdout",true,pCmdOut,"<filename>","output command stream"));
+  params.push_back(TAParam("","allsubsongs",false,pAllSubSongs,"","export every sub-song in parallel (with -output, -vgmout, -zsmout or -cmdout)"));
   params.push_back(TAParam("L","loglevel",true,pLogLevel,"debug|info|warning|error","set the log level (info by default)"));
   params.push_back(TAParam("v","view",true,pView,"pattern|commands|nothing","set visualization (nothing by default)"));
   params.push_back(TAParam("i","info",false,pInfo,"","get info about a song"));
+  params.push_back(TAParam("","infojson",false,pInfoJSON,"","print info about a .fur song (or every .fur song in a directory) as JSON lines, without loading it"));
+  params.push_back(TAParam("","duration",false,pDuration,"","also calculate song duration in -infojson mode"));
   params.push_back(TAParam("c","console",false,pConsole,"","enable console mode"));
   params.push_back(TAParam("n","nostatus",false,pNoStatus,"","disable playback status in console mode"));
   params.push_back(TAParam("N","nocontrols",false,pNoControls,"","disable standard input controls in console mode"));
@@ -465,12 +563,557 @@ void initParams() {
   params.push_back(TAParam("S","safemode",false,pSafeMode,"","enable safe mode (software rendering and no audio)"));
   params.push_back(TAParam("A","safeaudio",false,pSafeModeAudio,"","enable safe mode (with audio"));
 
-  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek","run performance test"));
+  params.push_back(TAParam("B","benchmark",true,pBenchmark,"render|seek|suite","run performance test (suite: render a song or every .fur song in a directory with every core, as JSON lines)"));
+  params.push_back(TAParam("","golden",true,pGolden,"<filename>","compare output hashes in -benchmark suite mode against this file"));
+  params.push_back(TAParam("","updategolden",false,pUpdateGolden,"","write the output hashes of -benchmark suite to the -golden file"));
+
+  params.push_back(TAParam("","oscout",true,pOscOut,"<filename>|-","render per-channel oscilloscope video while exporting audio (requires -output)"));
+  params.push_back(TAParam("","oscformat",true,pOscFormat,"y4m|raw","set oscilloscope video format (y4m by default; raw is RGB24)"));
+  params.push_back(TAParam("","oscsize",true,pOscSize,"<width>x<height>","set oscilloscope video size (1280x720 by default)"));
+  params.push_back(TAParam("","oscfps",true,pOscFPS,"<rate>","set oscilloscope video frame rate (60 by default)"));
 
   params.push_back(TAParam("V","version",false,pVersion,"","view information about Furnace."));
   params.push_back(TAParam("W","warranty",false,pWarranty,"","view warranty disclaimer."));
 }
 
+// song catalog (-infojson)
+struct SongInfoJob {
+  String path;
+  DivSongInfo info;
+  bool ok;
+};
+
+struct SongInfoQueue {
+  std::vector<SongInfoJob>* jobs;
+  std::atomic<size_t> next;
+};
+
+static void scanSongInfoJobs(void* q) {
+  SongInfoQueue* queue=(SongInfoQueue*)q;
+  while (true) {
+    size_t i=queue->next++;
+    if (i>=queue->jobs->size()) break;
+    SongInfoJob& job=(*queue->jobs)[i];
+    job.ok=e.scanSongInfo(job.path.c_str(),job.info,infoDuration);
+  }
+}
+
+static bool isSongFile(const String& name) {
+  if (name.size()<4) return false;
+  String ext=name.substr(name.size()-4);
+  for (char& i: ext) {
+    if (i>='A' && i<='Z') i+='a'-'A';
+  }
+  return ext==".fur";
+}
+
+static void collectSongFiles(const String& path, std::vector<String>& out) {
+#ifdef _WIN32
+  WIN32_FIND_DATAW de;
+  String findPath=path+DIR_SEPARATOR_STR+"*";
+  HANDLE d=FindFirstFileW(utf8To16(findPath.c_str()).c_str(),&de);
+  if (d==INVALID_HANDLE_VALUE) return;
+  do {
+    String u8Name=utf16To8(de.cFileName);
+    if (u8Name=="." || u8Name=="..") continue;
+    String newPath=path+DIR_SEPARATOR_STR+u8Name;
+    if (de.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY) {
+      collectSongFiles(newPath,out);
+    } else if (isSongFile(u8Name)) {
+      out.push_back(newPath);
+    }
+  } while (FindNextFileW(d,&de)!=0);
+  FindClose(d);
+#else
+  DIR* d=opendir(path.c_str());
+  if (d==NULL) return;
+  struct dirent* de=NULL;
+  while ((de=readdir(d))!=NULL) {
+    if (strcmp(de->d_name,".")==0 || strcmp(de->d_name,"..")==0) continue;
+    String newPath=path+DIR_SEPARATOR_STR+de->d_name;
+    if (de->d_type==DT_DIR || (de->d_type==DT_UNKNOWN && dirExists(newPath.c_str()))) {
+      collectSongFiles(newPath,out);
+    } else if (isSongFile(de->d_name)) {
+      out.push_back(newPath);
+    }
+  }
+  closedir(d);
+#endif
+}
+
+static String jsonString(const String& what) {
+  String ret="\"";
+  for (char i: what) {
+    switch (i) {
+      case '"':
+        ret+="\\\"";
+        break;
+      case '\\':
+        ret+="\\\\";
+        break;
+      case '\n':
+        ret+="\\n";
+        break;
+      case '\r':
+        ret+="\\r";
+        break;
+      case '\t':
+        ret+="\\t";
+        break;
+      default:
+        if ((unsigned char)i<0x20) {
+          ret+=fmt::sprintf("\\u%.4x",(int)i);
+        } else {
+          ret+=i;
+        }
+        break;
+    }
+  }
+  ret+="\"";
+  return ret;
+}
+
+static double jsonNumber(double what) {
+  if (!isfinite(what)) return 0.0;
+  return what;
+}
+
+// print one JSON object per song. directories are scanned recursively and in parallel.
+int printSongInfoJSON(const String& path) {
+  std::vector<String> files;
+  if (dirExists(path.c_str())) {
+    collectSongFiles(path,files);
+    std::sort(files.begin(),files.end());
+  } else {
+    files.push_back(path);
+  }
+
+  std::vector<SongInfoJob> jobs;
+  jobs.resize(files.size());
+  for (size_t i=0; i<files.size(); i++) {
+    jobs[i].path=files[i];
+    jobs[i].ok=false;
+  }
+
+  SongInfoQueue queue;
+  queue.jobs=&jobs;
+  queue.next=0;
+  unsigned int threads=std::thread::hardware_concurrency();
+  if (threads>jobs.size()) threads=jobs.size();
+  if (threads>1) {
+    logI("scanning %d songs on %d threads...",(int)jobs.size(),threads);
+    DivWorkPool* pool=new DivWorkPool(threads);
+    for (unsigned int i=0; i<threads; i++) {
+      pool->push(scanSongInfoJobs,&queue);
+    }
+    pool->wait();
+    delete pool;
+  } else {
+    scanSongInfoJobs(&queue);
+  }
+
+  int failed=0;
+  for (SongInfoJob& i: jobs) {
+    String line="{\"path\":"+jsonString(i.path);
+    if (!i.ok) {
+      line+=",\"error\":"+jsonString(i.info.error)+"}";
+      printf("%s\n",line.c_str());
+      failed++;
+      continue;
+    }
+    line+=fmt::sprintf(",\"version\":%d,\"compressed\":%s",i.info.version,i.info.compressed?"true":"false");
+    line+=",\"name\":"+jsonString(i.info.name);
+    line+=",\"author\":"+jsonString(i.info.author);
+    line+=",\"album\":"+jsonString(i.info.album);
+    line+=",\"system\":"+jsonString(i.info.systemName);
+    line+=",\"chips\":[";
+    for (size_t j=0; j<i.info.systems.size(); j++) {
+      if (j>0) line+=",";
+      line+=jsonString(e.getSystemName(i.info.systems[j]));
+    }
+    line+="]";
+    line+=fmt::sprintf(",\"instruments\":%d,\"wavetables\":%d,\"samples\":%d,\"patterns\":%d,\"subsongs\":%d",i.info.insLen,i.info.waveLen,i.info.sampleLen,i.info.patterns,i.info.subSongs);
+    line+=fmt::sprintf(",\"rows\":%d,\"orders\":%d,\"hz\":%g",i.info.patLen,i.info.ordersLen,jsonNumber(i.info.hz));
+    if (i.info.duration>=0.0) {
+      line+=fmt::sprintf(",\"duration\":%.3f,\"loops\":%s",jsonNumber(i.info.duration),i.info.loops?"true":"false");
+    }
+    line+="}";
+    printf("%s\n",line.c_str());
+  }
+  fflush(stdout);
+  return (failed>0 && failed==(int)jobs.size())?1:0;
+}
+
+// benchmark suite (-benchmark suite)
+struct BenchConfKey {
+  const char* key;
+  // number of cores (0 if this setting is only fixed)
+  int count;
+  int def;
+};
+
+// chip cores. songs are rendered with each alternative core of the chips they use.
+static const BenchConfKey benchCoreKeys[]={
+  {"ym2612Core",3,0},
+  {"snCore",2,0},
+  {"nesCore",2,0},
+  {"fdsCore",2,0},
+  {"c64Core",3,0},
+  {"arcadeCore",2,0},
+  {"ayCore",2,0},
+  {"opn1Core",3,1},
+  {"opnaCore",3,1},
+  {"opnbCore",3,1},
+  {"opl2Core",3,0},
+  {"opl3Core",3,0},
+  {"opllCore",2,0},
+  {"esfmCore",2,0},
+  {"pokeyCore",2,1},
+  {NULL,0,0}
+};
+
+// other settings which affect the output, so the results don't depend on the configuration
+static const BenchConfKey benchFixedKeys[]={
+  {"audioRate",0,44100},
+  {"audioQuality",0,0},
+  {"audioHiPass",0,1},
+  {"forceMono",0,0},
+  {"clampSamples",0,0},
+  {"lowLatency",0,0},
+  {"bubsysQuality",0,3},
+  {"dsidQuality",0,3},
+  {"gbQuality",0,3},
+  {"ndsQuality",0,3},
+  {"pceQuality",0,3},
+  {"pnQuality",0,3},
+  {"saaQuality",0,3},
+  {"sccQuality",0,3},
+  {"smQuality",0,3},
+  {"swanQuality",0,3},
+  {"vbQuality",0,3},
+  {NULL,0,0}
+};
+
+// the core setting used by a chip, or NULL
+static const char* benchCoreKeyOf(DivSystem sys) {
+  switch (sys) {
+    case DIV_SYSTEM_YM2612:
+    case DIV_SYSTEM_YM2612_EXT:
+    case DIV_SYSTEM_YM2612_CSM:
+    case DIV_SYSTEM_YM2612_DUALPCM:
+    case DIV_SYSTEM_YM2612_DUALPCM_EXT:
+      return "ym2612Core";
+    case DIV_SYSTEM_SMS:
+      return "snCore";
+    case DIV_SYSTEM_NES:
+    case DIV_SYSTEM_5E01:
+      return "nesCore";
+    case DIV_SYSTEM_FDS:
+      return "fdsCore";
+    case DIV_SYSTEM_C64_6581:
+    case DIV_SYSTEM_C64_8580:
+      return "c64Core";
+    case DIV_SYSTEM_YM2151:
+      return "arcadeCore";
+    case DIV_SYSTEM_AY8910:
+      return "ayCore";
+    case DIV_SYSTEM_YM2203:
+    case DIV_SYSTEM_YM2203_EXT:
+      return "opn1Core";
+    case DIV_SYSTEM_YM2608:
+    case DIV_SYSTEM_YM2608_EXT:
+      return "opnaCore";
+    case DIV_SYSTEM_YM2610:
+    case DIV_SYSTEM_YM2610_FULL:
+    case DIV_SYSTEM_YM2610_EXT:
+    case DIV_SYSTEM_YM2610_FULL_EXT:
+    case DIV_SYSTEM_YM2610B:
+    case DIV_SYSTEM_YM2610B_EXT:
+      return "opnbCore";
+    case DIV_SYSTEM_OPL:
+    case DIV_SYSTEM_OPL_DRUMS:
+    case DIV_SYSTEM_OPL2:
+    case DIV_SYSTEM_OPL2_DRUMS:
+    case DIV_SYSTEM_Y8950:
+    case DIV_SYSTEM_Y8950_DRUMS:
+      return "opl2Core";
+    case DIV_SYSTEM_OPL3:
+    case DIV_SYSTEM_OPL3_DRUMS:
+      return "opl3Core";
+    case DIV_SYSTEM_OPLL:
+    case DIV_SYSTEM_OPLL_DRUMS:
+    case DIV_SYSTEM_VRC7:
+      return "opllCore";
+    case DIV_SYSTEM_ESFM:
+      return "esfmCore";
+    case DIV_SYSTEM_POKEY:
+      return "pokeyCore";
+    default:
+      break;
+  }
+  return NULL;
+}
+
+// current resident set size of this process in KB, or -1 if unknown
+static long getCurrentRSS() {
+#if defined(_WIN32)
+  return -1;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count=MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(),MACH_TASK_BASIC_INFO,(task_info_t)&info,&count)!=KERN_SUCCESS) return -1;
+  return (long)(info.resident_size/1024);
+#else
+  FILE* f=fopen("/proc/self/statm","r");
+  if (f==NULL) return -1;
+  long pages=0;
+  long resident=0;
+  int got=fscanf(f,"%ld %ld",&pages,&resident);
+  fclose(f);
+  if (got!=2) return -1;
+  return resident*(sysconf(_SC_PAGESIZE)/1024);
+#endif
+}
+
+// reset the peak resident set size of this process, so that getPeakRSS() measures from now on.
+// returns false if this isn't possible (it only is on Linux)
+static bool resetPeakRSS() {
+#if defined(_WIN32) || defined(__APPLE__)
+  return false;
+#else
+  FILE* f=fopen("/proc/self/clear_refs","w");
+  if (f==NULL) return false;
+  bool ret=(fputs("5",f)>=0);
+  if (fclose(f)!=0) ret=false;
+  return ret;
+#endif
+}
+
+// peak resident set size of this process in KB since resetPeakRSS(), or -1 if unknown
+static long getPeakRSS() {
+#if defined(_WIN32) || defined(__APPLE__)
+  return -1;
+#else
+  FILE* f=fopen("/proc/self/status","r");
+  if (f==NULL) return -1;
+  char line[256];
+  long ret=-1;
+  while (fgets(line,256,f)!=NULL) {
+    if (sscanf(line,"VmHWM: %ld",&ret)==1) break;
+  }
+  fclose(f);
+  return ret;
+#endif
+}
+
+static unsigned char* readWholeFile(const String& path, size_t& len) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) return NULL;
+  if (fseek(f,0,SEEK_END)<0) {
+    fclose(f);
+    return NULL;
+  }
+  ssize_t size=ftell(f);
+  if (size<1 || fseek(f,0,SEEK_SET)<0) {
+    fclose(f);
+    return NULL;
+  }
+  unsigned char* ret=new unsigned char[size];
+  if (fread(ret,1,size,f)!=(size_t)size) {
+    fclose(f);
+    delete[] ret;
+    return NULL;
+  }
+  fclose(f);
+  len=size;
+  return ret;
+}
+
+// golden hashes: one "<hash> <cores> <path>" line per render
+static bool loadGoldens(const String& path, std::map<String,unsigned int>& out) {
+  FILE* f=ps_fopen(path.c_str(),"rb");
+  if (f==NULL) return false;
+  char line[4096];
+  while (fgets(line,4096,f)!=NULL) {
+    unsigned int hash=0;
+    char cores[256];
+    int pos=0;
+    if (sscanf(line,"%x %255s %n",&hash,cores,&pos)<2 || pos<=0) continue;
+    String name=line+pos;
+    while (!name.empty() && (name.back()=='\n' || name.back()=='\r')) name.pop_back();
+    out[name+"|"+cores]=hash;
+  }
+  fclose(f);
+  return true;
+}
+
+static bool saveGoldens(const String& path, const std::map<String,unsigned int>& goldens) {
+  FILE* f=ps_fopen(path.c_str(),"wb");
+  if (f==NULL) return false;
+  for (auto& i: goldens) {
+    size_t sep=i.first.rfind('|');
+    fprintf(f,"%.8x %s %s\n",i.second,i.first.substr(sep+1).c_str(),i.first.substr(0,sep).c_str());
+  }
+  fclose(f);
+  return true;
+}
+
+// render every song (in a directory) with every relevant chip core, and print one JSON
+// object per render. hashes are compared against (and optionally saved to) a golden file.
+int runBenchSuite(const String& path) {
+  std::vector<String> files;
+  String root;
+  if (dirExists(path.c_str())) {
+    collectSongFiles(path,files);
+    std::sort(files.begin(),files.end());
+    root=path+DIR_SEPARATOR_STR;
+  } else {
+    files.push_back(path);
+  }
+
+  std::map<String,unsigned int> goldens;
+  bool haveGoldens=false;
+  if (!benchGoldenPath.empty()) {
+    haveGoldens=loadGoldens(benchGoldenPath,goldens);
+    if (!haveGoldens && !benchUpdateGoldens) {
+      logW("could not open golden file %s!",benchGoldenPath);
+    }
+  }
+
+  int renders=0;
+  int failed=0;
+  int mismatched=0;
+  int added=0;
+  double totalTime=0.0;
+  double totalLength=0.0;
+  for (String& i: files) {
+    String name=i;
+    if (!root.empty() && name.find(root)==0) name=name.substr(root.size());
+    for (char& j: name) {
+      if (j=='\\') j='/';
+    }
+
+    size_t len=0;
+    unsigned char* data=readWholeFile(i,len);
+    if (data==NULL) {
+      printf("{\"path\":%s,\"error\":%s}\n",jsonString(name).c_str(),jsonString(strerror(errno)).c_str());
+      failed++;
+      continue;
+    }
+
+    // the first render uses the default cores. it also tells which chips are used
+    std::vector<std::pair<const char*,int>> variants;
+    variants.push_back(std::pair<const char*,int>(NULL,0));
+    for (size_t v=0; v<variants.size(); v++) {
+      DivConfig overrides;
+      for (int j=0; benchFixedKeys[j].key!=NULL; j++) {
+        overrides.set(benchFixedKeys[j].key,benchFixedKeys[j].def);
+      }
+      for (int j=0; benchCoreKeys[j].key!=NULL; j++) {
+        overrides.set(benchCoreKeys[j].key,benchCoreKeys[j].def);
+      }
+      String cores="default";
+      if (variants[v].first!=NULL) {
+        overrides.set(variants[v].first,variants[v].second);
+        cores=fmt::sprintf("%s=%d",variants[v].first,variants[v].second);
+      }
+
+      String line="{\"path\":"+jsonString(name)+",\"cores\":"+jsonString(cores);
+      unsigned char* copy=new unsigned char[len];
+      memcpy(copy,data,len);
+      bool peakReset=resetPeakRSS();
+      long rssBefore=getCurrentRSS();
+      DivEngine* r=new DivEngine;
+      if (!r->initRender(&e,copy,len,&overrides)) {
+        line+=",\"error\":"+jsonString(r->getLastError())+"}";
+        printf("%s\n",line.c_str());
+        fflush(stdout);
+        r->quit(false);
+        delete r;
+        failed++;
+        break;
+      }
+
+      if (v==0) {
+        std::vector<const char*> keys;
+        for (int j=0; j<r->song.systemLen; j++) {
+          const char* key=benchCoreKeyOf(r->song.system[j]);
+          if (key!=NULL && std::find(keys.begin(),keys.end(),key)==keys.end()) keys.push_back(key);
+        }
+        for (const char* key: keys) {
+          for (int j=0; benchCoreKeys[j].key!=NULL; j++) {
+            if (strcmp(benchCoreKeys[j].key,key)!=0) continue;
+            for (int k=0; k<benchCoreKeys[j].count; k++) {
+              if (k==benchCoreKeys[j].def) continue;
+              variants.push_back(std::pair<const char*,int>(benchCoreKeys[j].key,k));
+            }
+          }
+        }
+      }
+
+      DivBenchResult result;
+      bool ended=r->benchmarkRender(result);
+      long rssAfter=getCurrentRSS();
+      long rssPeak=peakReset?getPeakRSS():-1;
+      double length=(result.rate>0.0)?((double)result.samples/result.rate):0.0;
+      renders++;
+      totalTime+=result.renderTime;
+      totalLength+=length;
+
+      line+=fmt::sprintf(",\"hash\":\"%.8x\"",result.hash);
+      String key=name+"|"+cores;
+      auto golden=goldens.find(key);
+      if (golden==goldens.end()) {
+        line+=",\"golden\":\"new\"";
+        added++;
+      } else if (golden->second==result.hash) {
+        line+=",\"golden\":\"match\"";
+      } else {
+        line+=fmt::sprintf(",\"golden\":\"mismatch\",\"expected\":\"%.8x\"",golden->second);
+        mismatched++;
+      }
+      if (benchUpdateGoldens) goldens[key]=result.hash;
+
+      line+=fmt::sprintf(",\"length\":%.3f,\"ended\":%s,\"renderTime\":%.6f",length,ended?"true":"false",result.renderTime);
+      line+=fmt::sprintf(",\"samplesPerSecond\":%.0f,\"speed\":%.2f",jsonNumber(result.samples/result.renderTime),jsonNumber(length/result.renderTime));
+      if (rssBefore>=0 && rssAfter>=0) {
+        line+=fmt::sprintf(",\"rssGrowth\":%ld",rssAfter-rssBefore);
+      } else {
+        line+=",\"rssGrowth\":null";
+      }
+      if (rssPeak>=0) {
+        line+=fmt::sprintf(",\"peakRSS\":%ld",rssPeak);
+      } else {
+        line+=",\"peakRSS\":null";
+      }
+      line+=",\"chips\":[";
+      for (int j=0; j<result.chips; j++) {
+        if (j>0) line+=",";
+        line+="{\"chip\":"+jsonString(r->getSystemName(r->song.system[j]));
+        line+=fmt::sprintf(",\"time\":%.6f}",(double)result.chipTime[j]/1000000000.0);
+      }
+      line+="]}";
+      printf("%s\n",line.c_str());
+      fflush(stdout);
+
+      r->quit(false);
+      delete r;
+    }
+    delete[] data;
+  }
+
+  if (benchUpdateGoldens && !benchGoldenPath.empty()) {
+    if (!saveGoldens(benchGoldenPath,goldens)) {
+      logE("could not write golden file %s!",benchGoldenPath);
+      failed++;
+    }
+  }
+
+  printf("{\"summary\":true,\"files\":%d,\"renders\":%d,\"failed\":%d,\"mismatched\":%d,\"new\":%d,\"renderTime\":%.3f,\"length\":%.3f,\"speed\":%.2f}\n",(int)files.size(),renders,failed,mismatched,added,totalTime,totalLength,jsonNumber(totalLength/totalTime));
+  fflush(stdout);
+  return (failed>0 || mismatched>0)?1:0;
+}
+
 #ifdef _WIN32
 void reportError(String what) {
   logE("%s",what);
@@ -714,14 +1357,14 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  if (fileName.empty() && (benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
+  if (fileName.empty() && (benchMode || infoMode || infoJSONMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
     logE("provide a file!");
     return 1;
   }
 
 #ifdef HAVE_GUI
-  if (e.preInit(consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
-    if (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="") {
+  if (e.preInit(consoleMode || benchMode || infoMode || infoJSONMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
+    if (consoleMode || benchMode || infoMode || infoJSONMode || outName!="" || vgmOutName!="" || cmdOutName!="") {
       logW("engine wants safe mode, but Furnace GUI is not going to start.");
     } else {
       safeMode=true;
@@ -733,11 +1376,23 @@ int main(int argc, char** argv) {
   }
 #endif
 
-  if (safeMode && (consoleMode || benchMode || infoMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
+  if (safeMode && (consoleMode || benchMode || infoMode || infoJSONMode || outName!="" || vgmOutName!="" || cmdOutName!="")) {
     logE("you can't use safe mode and console/export mode together.");
     return 1;
   }
 
+  if (infoJSONMode) {
+    int ret=printSongInfoJSON(fileName);
+    finishLogFile();
+    return ret;
+  }
+
+  if (benchMode==3) {
+    int ret=runBenchSuite(fileName);
+    finishLogFile();
+    return ret;
+  }
+
   if (safeMode && !safeModeWithAudio) {
     e.setAudio(DIV_AUDIO_DUMMY);
   }
@@ -825,6 +1480,7 @@ int main(int argc, char** argv) {
 
   if (benchMode) {
     logI("starting benchmark!");
+    e.setOscCapture(false);
     if (benchMode==2) {
       e.benchmarkSeek();
     } else {
@@ -834,6 +1490,37 @@ int main(int argc, char** argv) {
     return 0;
   }
 
+  if (allSubSongs && (outName!="" || vgmOutName!="" || zsmOutName!="" || cmdOutName!="")) {
+    DivExportBatch batch(&e);
+    for (int i=0; i<(int)e.song.subsong.size(); i++) {
+      if (outName!="") {
+        DivExportJob job(DIV_EXPORT_JOB_AUDIO,i,DivExportBatch::subSongPath(outName,i));
+        job.audio=exportOptions;
+        batch.add(job);
+      }
+      if (vgmOutName!="") {
+        DivExportJob job(DIV_EXPORT_JOB_VGM,i,DivExportBatch::subSongPath(vgmOutName,i));
+        job.vgmDirectStream=vgmOutDirect;
+        batch.add(job);
+      }
+      if (zsmOutName!="") {
+        batch.add(DivExportJob(DIV_EXPORT_JOB_ZSM,i,DivExportBatch::subSongPath(zsmOutName,i)));
+      }
+      if (cmdOutName!="") {
+        batch.add(DivExportJob(DIV_EXPORT_JOB_CMD,i,DivExportBatch::subSongPath(cmdOutName,i)));
+      }
+    }
+    if (oscOutName!="") {
+      logW("-oscout can't be used with -allsubsongs. ignoring.");
+    }
+    bool batchOK=batch.run();
+    if (!batchOK) {
+      reportError(_("some files could not be exported!"));
+    }
+    finishLogFile();
+    return batchOK?0:1;
+  }
+
   if (outName!="" || vgmOutName!="" || cmdOutName!="") {
     if (cmdOutName!="") {
       SafeWriter* w=e.saveCommand();
@@ -853,6 +1540,20 @@ int main(int argc, char** argv) {
     }
     if (vgmOutName!="") {
       SafeWriter* w=e.saveVGM(NULL,true,0x171,false,vgmOutDirect);
+      bool vgz=false;
+      if (vgmOutName.size()>=4) {
+        String ext=vgmOutName.substr(vgmOutName.size()-4);
+        for (char& i: ext) {
+          if (i>='A' && i<='Z') i+='a'-'A';
+        }
+        vgz=(ext==".vgz");
+      }
+      if (w!=NULL && vgz) {
+        SafeWriter* zw=deflateParallel(w->getFinalBuf(),w->size(),Z_BEST_COMPRESSION,0,true);
+        w->finish();
+        delete w;
+        w=zw;
+      }
       if (w!=NULL) {
         FILE* f=fopen(vgmOutName.c_str(),"wb");
         if (f!=NULL) {
@@ -868,9 +1569,23 @@ int main(int argc, char** argv) {
       }
     }
     if (outName!="") {
+      DivOscRender* oscRender=NULL;
+      if (oscOutName!="") {
+        oscRender=new DivOscRender(&e);
+        if (oscRender->open(oscOutName.c_str(),oscOptions)) {
+          exportOptions.oscRender=oscRender;
+        } else {
+          reportError(_("could not open oscilloscope output!"));
+        }
+      }
       e.setConsoleMode(true);
       e.saveAudio(outName.c_str(),exportOptions);
       e.waitAudioFile();
+      if (oscRender!=NULL) {
+        delete oscRender;
+      }
+    } else if (oscOutName!="") {
+      logW("-oscout requires -output. ignoring.");
     }
     finishLogFile();
     return 0;
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// usage: assert_vgm_streams file.vgm [offset...]
+// checks that the DAC stream start commands (0x93 and 0x95) in a VGM file
+// point to the given offsets in their data bank, in order.
+// return values:
+// - 0: pass
+// - 1: fail (offsets differ)
+// - 2: command line error
+// - 3: file open/parse error
+
+#define MAX_BLOCKS 1024
+
+int main(int argc, char** argv) {
+  if (argc<2) return 2;
+
+  FILE* f=fopen(argv[1],"rb");
+  if (f==NULL) {
+    perror("open");
+    return 3;
+  }
+  fseek(f,0,SEEK_END);
+  long len=ftell(f);
+  fseek(f,0,SEEK_SET);
+  if (len<0x40) {
+    fprintf(stderr,"file too small\n");
+    fclose(f);
+    return 3;
+  }
+  unsigned char* buf=malloc(len);
+  if (fread(buf,1,len,f)!=(size_t)len) {
+    fprintf(stderr,"read error\n");
+    fclose(f);
+    free(buf);
+    return 3;
+  }
+  fclose(f);
+
+  if (memcmp(buf,"Vgm ",4)!=0) {
+    fprintf(stderr,"not a VGM file\n");
+    free(buf);
+    return 3;
+  }
+
+#define READ_INT(x) ((unsigned int)buf[x]|((unsigned int)buf[(x)+1]<<8)|((unsigned int)buf[(x)+2]<<16)|((unsigned int)buf[(x)+3]<<24))
+
+  unsigned int dataOff=READ_INT(0x34);
+  long pos=(dataOff==0)?0x40:(0x34+dataOff);
+  int index=0;
+  int ret=0;
+
+  // data blocks of every type, and the data bank of every stream
+  unsigned int blockStart[0x40][MAX_BLOCKS];
+  int blockCount[0x40];
+  unsigned int bankSize[0x40];
+  int streamBank[256];
+  memset(blockCount,0,sizeof(blockCount));
+  memset(bankSize,0,sizeof(bankSize));
+  memset(streamBank,0,sizeof(streamBank));
+
+  while (pos<len) {
+    unsigned char cmd=buf[pos];
+    if (cmd==0x66) break;
+    if (cmd==0x67) {
+      if (pos+7>len) break;
+      unsigned char type=buf[pos+2];
+      unsigned int size=READ_INT(pos+3);
+      if (type<0x40) {
+        if (blockCount[type]>=MAX_BLOCKS) {
+          fprintf(stderr,"too many data blocks\n");
+          free(buf);
+          return 3;
+        }
+        blockStart[type][blockCount[type]++]=bankSize[type];
+        bankSize[type]+=size;
+      }
+      pos+=7+size;
+      continue;
+    }
+    if (cmd==0x91) {
+      if (pos+5>len) break;
+      streamBank[buf[pos+1]]=buf[pos+2]&0x3f;
+      pos+=5;
+      continue;
+    }
+    if (cmd==0x93 || cmd==0x95) {
+      unsigned char stream=buf[pos+1];
+      unsigned int off=0;
+      if (cmd==0x93) {
+        if (pos+11>len) break;
+        off=READ_INT(pos+2);
+        pos+=11;
+      } else {
+        if (pos+5>len) break;
+        int block=buf[pos+2]|(buf[pos+3]<<8);
+        int bank=streamBank[stream];
+        if (block>=blockCount[bank]) {
+          fprintf(stderr,"stream %d starts block %d, which doesn't exist\n",stream,block);
+          ret=1;
+          off=0xffffffff;
+        } else {
+          off=blockStart[bank][block];
+        }
+        pos+=5;
+      }
+      printf("stream %d start: %u\n",stream,off);
+      if (index+2>=argc) {
+        fprintf(stderr,"unexpected stream start at %u\n",off);
+        ret=1;
+      } else if (strtoul(argv[index+2],NULL,0)!=off) {
+        fprintf(stderr,"stream start %d: expected %s, got %u\n",index,argv[index+2],off);
+        ret=1;
+      }
+      index++;
+      continue;
+    }
+    if (cmd>=0x70 && cmd<=0x8f) {
+      pos++;
+    } else if (cmd==0x62 || cmd==0x63) {
+      pos++;
+    } else if (cmd==0x61) {
+      pos+=3;
+    } else if (cmd==0x4f || cmd==0x50 || cmd==0x94 || (cmd>=0x30 && cmd<=0x3f)) {
+      pos+=2;
+    } else if ((cmd>=0x40 && cmd<=0x4e) || (cmd>=0x51 && cmd<=0x5f) || (cmd>=0xa0 && cmd<=0xbf)) {
+      pos+=3;
+    } else if (cmd>=0xc0 && cmd<=0xdf) {
+      pos+=4;
+    } else if (cmd==0x90 || cmd>=0xe0) {
+      pos+=5;
+    } else if (cmd==0x92) {
+      pos+=6;
+    } else {
+      fprintf(stderr,"unknown command %.2x at %lx\n",cmd,pos);
+      free(buf);
+      return 3;
+    }
+  }
+
+  if (index+2<argc) {
+    fprintf(stderr,"expected %d stream starts, got %d\n",argc-2,index);
+    ret=1;
+  }
+
+  free(buf);
+  return ret;
+}
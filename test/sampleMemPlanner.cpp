@@ -0,0 +1,114 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// checks that DivSampleMemPlanner never places a sample across a bank boundary,
+// into the reserved area of a bank or on top of another sample.
+// return values:
+// - 0: pass
+// - 1: fail
+
+#include "../src/engine/sampleMemPlanner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+struct PlannerCase {
+  size_t start, capacity, bank, align, resStart, resEnd;
+  int perBank;
+};
+
+static bool checkLayout(const PlannerCase& c, const std::vector<DivSampleMemItem>& items, const char* name) {
+  bool ret=true;
+  for (size_t i=0; i<items.size(); i++) {
+    const DivSampleMemItem& x=items[i];
+    if (!x.placed) continue;
+    size_t end=x.pos+x.len;
+    if (x.pos<c.start || end>c.capacity) {
+      printf("%s: sample %d (%zu bytes) at %zx is out of memory\n",name,x.index,x.len,x.pos);
+      ret=false;
+    }
+    if (x.pos%c.align) {
+      printf("%s: sample %d at %zx is not aligned\n",name,x.index,x.pos);
+      ret=false;
+    }
+    if (c.bank>0) {
+      size_t bankBegin=(x.pos/c.bank)*c.bank;
+      if (x.pos<bankBegin+c.resStart || end>bankBegin+c.bank-c.resEnd) {
+        printf("%s: sample %d (%zu bytes) at %zx crosses the end of bank %zu\n",name,x.index,x.len,x.pos,x.pos/c.bank);
+        ret=false;
+      }
+    }
+    for (size_t j=i+1; j<items.size(); j++) {
+      const DivSampleMemItem& y=items[j];
+      if (!y.placed) continue;
+      if (x.pos<y.pos+y.len && y.pos<end) {
+        printf("%s: samples %d and %d overlap\n",name,x.index,y.index);
+        ret=false;
+      }
+    }
+  }
+  return ret;
+}
+
+static bool runCase(const PlannerCase& c, const std::vector<size_t>& lens, const char* name) {
+  std::vector<DivSampleMemItem> items;
+  for (size_t i=0; i<lens.size(); i++) {
+    items.push_back(DivSampleMemItem((int)i,lens[i]));
+  }
+  DivSampleMemPlanner planner(c.start,c.capacity,c.bank,c.align,c.resStart,c.resEnd,c.perBank);
+  planner.plan(items);
+  return checkLayout(c,items,name);
+}
+
+int main() {
+  bool pass=true;
+
+  // samples 2 to 4 fill the first three banks and sample 1 goes in the last one.
+  // sample 0 fits in the space left after it, but once it is padded and placed before sample 1,
+  // sample 1 is pushed into the reserved end of the bank.
+  PlannerCase nearEnd={0,0x400,0x100,0x10,0,8,0};
+  if (!runCase(nearEnd,{0x71,0x80,0xf3,0xf0,0xe5},"near bank end")) pass=false;
+
+  // random unaligned lengths
+  srand(1);
+  char name[64];
+  for (int i=0; i<20000; i++) {
+    PlannerCase c;
+    c.align=(size_t)1<<(rand()%9);
+    c.bank=(rand()%4)?((size_t)0x1000<<(rand()%3)):0;
+    c.resStart=(rand()%3)?0:(rand()%0x40);
+    c.resEnd=(rand()%3)?0:(rand()%0x40);
+    c.start=rand()%0x100;
+    c.capacity=c.start+(rand()%0x10000)+0x400;
+    c.perBank=(rand()%4)?0:(1+rand()%8);
+    std::vector<size_t> lens;
+    int count=1+rand()%24;
+    for (int j=0; j<count; j++) {
+      lens.push_back(1+rand()%((c.bank>0)?c.bank:0x4000));
+    }
+    snprintf(name,64,"random case %d",i);
+    if (!runCase(c,lens,name)) {
+      pass=false;
+      break;
+    }
+  }
+
+  if (pass) printf("sampleMemPlanner: pass\n");
+  return pass?0:1;
+}
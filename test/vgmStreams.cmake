@@ -0,0 +1,13 @@
+# exports SONG to OUT with FURNACE and checks the DAC stream offsets in it (assert_vgm_streams).
+# usage: cmake -DFURNACE=... -DCHECK=... -DSONG=... -DOUT=... -DOFFSETS="..." -P vgmStreams.cmake
+
+execute_process(COMMAND ${FURNACE} -loglevel error -vgmout ${OUT} ${SONG} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "could not export ${SONG}")
+endif()
+
+separate_arguments(OFFSETS)
+execute_process(COMMAND ${CHECK} ${OUT} ${OFFSETS} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "stream offsets in ${OUT} are wrong")
+endif()
@@ -0,0 +1,246 @@
+/**
+ * Furnace Tracker - multi-system chiptune tracker
+ * Copyright (C) 2021-2024 tildearrow and contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// checks that the lane-based operator evaluation in ymfm (YMFM_LANES) is
+// bit-exact with the per-channel path, by feeding the same random register
+// writes to two chips and comparing their output and channel outputs.
+// pass -benchmark to time both paths instead.
+// return values:
+// - 0: pass
+// - 1: fail
+
+#include "../src/engine/platform/sound/ymfm/ymfm_opm.h"
+#include "../src/engine/platform/sound/ymfm/ymfm_opn.h"
+#include "../src/engine/platform/sound/ymfm/ymfm_opl.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !YMFM_LANES
+#error "this test must be built with YMFM_LANES=1"
+#endif
+
+// the register writes of one step
+struct LanesWrite {
+  unsigned char port, addr, data;
+};
+
+typedef void (*LanesWriteGen)(LanesWrite* w, int& count);
+
+// OPN family: key on/off and the FM registers of both ports
+static void genOPN(LanesWrite* w, int& count, bool twoPorts) {
+  count=0;
+  int n=1+rand()%8;
+  for (int i=0; i<n; i++) {
+    if (rand()%4==0) {
+      int ch=rand()%(twoPorts?6:3);
+      w[count++]={0,0x28,(unsigned char)((rand()&0xf0)|(ch<3?ch:ch+1))};
+    } else {
+      unsigned char port=twoPorts?(rand()&1):0;
+      unsigned char addr=0x30+rand()%(0xb8-0x30);
+      unsigned char data=rand();
+      // keep total levels low, so that most operators are audible
+      if ((addr&0xf0)==0x40) data&=0x1f;
+      w[count++]={port,addr,data};
+    }
+  }
+  // LFO
+  if (twoPorts && rand()%64==0) {
+    w[count++]={0,0x22,(unsigned char)(rand()&0x0f)};
+  }
+}
+
+static void genOPN1(LanesWrite* w, int& count) {
+  genOPN(w,count,false);
+}
+
+static void genOPN2(LanesWrite* w, int& count) {
+  genOPN(w,count,true);
+}
+
+static void genOPM(LanesWrite* w, int& count) {
+  count=0;
+  int n=1+rand()%8;
+  for (int i=0; i<n; i++) {
+    int what=rand()%16;
+    if (what<4) {
+      w[count++]={0,0x08,(unsigned char)((rand()&0x78)|(rand()&7))};
+    } else if (what==4) {
+      // noise and LFO
+      static const unsigned char lfoRegs[5]={0x0f,0x18,0x19,0x19,0x1b};
+      w[count++]={0,lfoRegs[rand()%5],(unsigned char)rand()};
+    } else {
+      unsigned char addr=0x20+rand()%0xe0;
+      unsigned char data=rand();
+      if ((addr&0xe0)==0x60) data&=0x1f;
+      w[count++]={0,addr,data};
+    }
+  }
+}
+
+static void genOPL3(LanesWrite* w, int& count) {
+  count=0;
+  int n=1+rand()%8;
+  for (int i=0; i<n; i++) {
+    int what=rand()%32;
+    unsigned char port=rand()&1;
+    if (what<6) {
+      w[count++]={port,(unsigned char)(0xb0+rand()%9),(unsigned char)rand()};
+    } else if (what==6) {
+      // 4-op connections
+      w[count++]={1,0x04,(unsigned char)(rand()&0x3f)};
+    } else if (what==7) {
+      // rhythm mode (rarely), vibrato/tremolo depth
+      w[count++]={0,0xbd,(unsigned char)(rand()&((rand()%8==0)?0xff:0xc0))};
+    } else {
+      unsigned char addr=0x20+rand()%(0xf6-0x20);
+      unsigned char data=rand();
+      if ((addr&0xe0)==0x40) data&=0xdf;
+      w[count++]={port,addr,data};
+    }
+  }
+}
+
+// the engine accessor isn't named the same in every chip
+template<class Chip> struct LanesEngine {
+  static typename Chip::fm_engine* get(Chip& chip) {
+    return chip.debug_fm_engine();
+  }
+};
+
+template<> struct LanesEngine<ymfm::ym3438> {
+  static ymfm::ym3438::fm_engine* get(ymfm::ym3438& chip) {
+    return chip.debug_engine();
+  }
+};
+
+template<> struct LanesEngine<ymfm::ym2151> {
+  static ymfm::ym2151::fm_engine* get(ymfm::ym2151& chip) {
+    return chip.debug_engine();
+  }
+};
+
+template<class Chip> struct LanesChip {
+  ymfm::ymfm_interface intf;
+  Chip chip;
+  LanesChip():
+    chip(intf) {
+    chip.reset();
+  }
+};
+
+template<class Chip> static bool runChip(const char* name, LanesWriteGen gen, int channels, const LanesWrite* init, int initCount, bool benchmark) {
+  LanesChip<Chip>* ref=new LanesChip<Chip>;
+  LanesChip<Chip>* lanes=new LanesChip<Chip>;
+  LanesEngine<Chip>::get(ref->chip)->set_lanes(false);
+  LanesEngine<Chip>::get(lanes->chip)->set_lanes(true);
+
+  typename Chip::output_data refOut[64];
+  typename Chip::output_data lanesOut[64];
+  LanesWrite w[16];
+  int count=0;
+  int audible=0;
+  bool pass=true;
+  double refTime=0.0, lanesTime=0.0;
+
+  srand(1);
+  for (int i=0; i<initCount; i++) {
+    ref->chip.write(init[i].port*2,init[i].addr);
+    ref->chip.write(init[i].port*2+1,init[i].data);
+    lanes->chip.write(init[i].port*2,init[i].addr);
+    lanes->chip.write(init[i].port*2+1,init[i].data);
+  }
+
+  for (int step=0; step<(benchmark?20000:4000); step++) {
+    gen(w,count);
+    for (int i=0; i<count; i++) {
+      ref->chip.write(w[i].port*2,w[i].addr);
+      ref->chip.write(w[i].port*2+1,w[i].data);
+      lanes->chip.write(w[i].port*2,w[i].addr);
+      lanes->chip.write(w[i].port*2+1,w[i].data);
+    }
+
+    std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+    ref->chip.generate(refOut,64);
+    std::chrono::steady_clock::time_point t1=std::chrono::steady_clock::now();
+    lanes->chip.generate(lanesOut,64);
+    std::chrono::steady_clock::time_point t2=std::chrono::steady_clock::now();
+    refTime+=std::chrono::duration<double>(t1-t0).count();
+    lanesTime+=std::chrono::duration<double>(t2-t1).count();
+
+    for (int i=0; i<64; i++) {
+      for (int j=0; j<Chip::OUTPUTS; j++) {
+        if (refOut[i].data[j]!=lanesOut[i].data[j]) {
+          printf("%s: step %d sample %d output %d: %d != %d\n",name,step,i,j,lanesOut[i].data[j],refOut[i].data[j]);
+          pass=false;
+          break;
+        }
+        if (refOut[i].data[j]!=0) audible++;
+      }
+      if (!pass) break;
+    }
+    for (int i=0; i<channels && pass; i++) {
+      for (int j=0; j<4; j++) {
+        int refChan=LanesEngine<Chip>::get(ref->chip)->debug_channel(i)->debug_output(j);
+        int lanesChan=LanesEngine<Chip>::get(lanes->chip)->debug_channel(i)->debug_output(j);
+        if (refChan!=lanesChan) {
+          printf("%s: step %d channel %d output %d: %d != %d\n",name,step,i,j,lanesChan,refChan);
+          pass=false;
+          break;
+        }
+      }
+    }
+    if (!pass) break;
+  }
+
+  // make sure this actually tested something
+  if (pass && audible<10000) {
+    printf("%s: only %d non-zero samples\n",name,audible);
+    pass=false;
+  }
+  if (benchmark) {
+    printf("%s: per-channel %.3fs, lanes %.3fs (%+.1f%%)\n",name,refTime,lanesTime,100.0*(lanesTime-refTime)/refTime);
+  }
+
+  delete ref;
+  delete lanes;
+  return pass;
+}
+
+int main(int argc, char** argv) {
+  bool benchmark=(argc>1 && strcmp(argv[1],"-benchmark")==0);
+  bool pass=true;
+
+  // enable OPL3 mode
+  static const LanesWrite opl3Init[1]={{1,0x05,0x01}};
+
+  if (!runChip<ymfm::ym2203>("OPN",genOPN1,3,NULL,0,benchmark)) pass=false;
+  if (!runChip<ymfm::ym3438>("OPN2",genOPN2,6,NULL,0,benchmark)) pass=false;
+  if (!runChip<ymfm::ym2608>("OPNA",genOPN2,6,NULL,0,benchmark)) pass=false;
+  if (!runChip<ymfm::ym2151>("OPM",genOPM,8,NULL,0,benchmark)) pass=false;
+  if (!runChip<ymfm::ymf262>("OPL3",genOPL3,18,opl3Init,1,benchmark)) pass=false;
+
+#if YMFM_LANES_AVX2
+  printf("ymfmLanes (AVX2): %s\n",pass?"pass":"FAIL");
+#else
+  printf("ymfmLanes: %s\n",pass?"pass":"FAIL");
+#endif
+  return pass?0:1;
+}